@@ -0,0 +1,181 @@
+/*	Throughput of the accessor conversion kernels (see AccessorConversion.h) on a single thread, SSE2 against the scalar reference, for the
+	accessor layouts glTF files commonly use: plain and interleaved float attributes, KHR_mesh_quantization's normalized integers, halves,
+	and 8/16/32-bit indices. GB/s counts the accessor bytes read.
+
+	Usage: AccessorConversionBenchmark [--smoke]
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AccessorConversion.h"
+#include "Benchmark.h"
+
+using std::vector;
+
+// Output stride of the float conversions, about the size of our Vertex, which attributes are written into one field at a time
+static constexpr size_t BENCHMARK_VERTEX_STRIDE = 48;
+
+struct AccessorCase
+{
+	const char* name;
+	AccessorComponentType component_type;
+	uint32_t component_count;
+	bool normalized;
+
+	// Bytes between elements, 0 for tightly packed
+	size_t stride;
+	uint32_t out_component_count;
+};
+
+// Fills in_size bytes with random data. Half and float components are kept finite so neither path goes down its NaN/infinity handling
+vector<uint8_t> make_accessor_data(const size_t in_size, const AccessorComponentType in_component_type)
+{
+	std::mt19937 rng(97531);
+	vector<uint8_t> data(in_size);
+	for (uint8_t& byte : data)
+	{
+		byte = (uint8_t) rng();
+	}
+
+	if (in_component_type == AccessorComponentType::Float)
+	{
+		std::uniform_real_distribution<float> value_distribution(-100.0f, 100.0f);
+		for (size_t offset = 0; offset + sizeof(float) <= in_size; offset += sizeof(float))
+		{
+			const float value = value_distribution(rng);
+			memcpy(data.data() + offset, &value, sizeof(value));
+		}
+	}
+	else if (in_component_type == AccessorComponentType::Half)
+	{
+		for (size_t offset = 1; offset < in_size; offset += sizeof(uint16_t))
+		{
+			// Clear the top exponent bit, which keeps the exponent short of all ones
+			data[offset] &= 0xBF;
+		}
+	}
+	return data;
+}
+
+void BenchmarkFloatConversion(const BenchmarkOptions& in_options)
+{
+	const AccessorCase cases[] =
+	{
+		{ "float3 position", AccessorComponentType::Float, 3, false, 0, 3 },
+		{ "float3 interleaved", AccessorComponentType::Float, 3, false, 32, 3 },
+		{ "float4 tangent", AccessorComponentType::Float, 4, false, 0, 4 },
+		{ "float2 texcoord", AccessorComponentType::Float, 2, false, 0, 2 },
+		{ "half4 color", AccessorComponentType::Half, 4, false, 0, 4 },
+		{ "snorm8x3 normal", AccessorComponentType::Int8, 3, true, 4, 3 },
+		{ "unorm16x2 texcoord", AccessorComponentType::UInt16, 2, true, 0, 2 },
+		{ "unorm8x4 color", AccessorComponentType::UInt8, 4, true, 0, 4 },
+		{ "int16x3 position", AccessorComponentType::Int16, 3, false, 8, 3 },
+	};
+
+	const size_t element_count = in_options.smoke ? 1000 : 4 * 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 5;
+#if !ACCESSOR_CONVERSION_SSE2
+	printf("  SSE2 isn't available, both columns are the scalar path\n");
+#endif
+	for (const AccessorCase& accessor_case : cases)
+	{
+		AccessorDesc accessor;
+		accessor.count = element_count;
+		accessor.component_type = accessor_case.component_type;
+		accessor.component_count = accessor_case.component_count;
+		accessor.normalized = accessor_case.normalized;
+		accessor.stride = accessor_case.stride > 0 ? accessor_case.stride : accessor.GetElementSize();
+		const vector<uint8_t> data = make_accessor_data(accessor.count * accessor.stride, accessor.component_type);
+		accessor.data = data.data();
+
+		vector<uint8_t> vectorized_vertices(element_count * BENCHMARK_VERTEX_STRIDE);
+		vector<uint8_t> scalar_vertices(element_count * BENCHMARK_VERTEX_STRIDE);
+		const double vectorized_time = benchmark_min_time(repetitions, [&]()
+		{
+			convert_accessor_to_float(accessor, vectorized_vertices.data(), BENCHMARK_VERTEX_STRIDE, accessor_case.out_component_count);
+		});
+		const double scalar_time = benchmark_min_time(repetitions, [&]()
+		{
+			convert_accessor_to_float_scalar(
+				accessor, 0, accessor.count, scalar_vertices.data(), BENCHMARK_VERTEX_STRIDE, accessor_case.out_component_count, ACCESSOR_FILL_ZERO);
+		});
+
+		if (vectorized_vertices != scalar_vertices)
+		{
+			printf("AccessorConversionBenchmark: SSE2 and scalar conversions of %s differ\n", accessor_case.name);
+			exit(1);
+		}
+
+		const double accessor_size = (double) accessor.GetSize();
+		printf(
+			"  %-20s SSE2 %8.3f ms %7.2f GB/s   scalar %8.3f ms %7.2f GB/s   %5.2fx\n",
+			accessor_case.name,
+			vectorized_time,
+			get_gigabytes_per_second(accessor_size, vectorized_time),
+			scalar_time,
+			get_gigabytes_per_second(accessor_size, scalar_time),
+			vectorized_time > 0.0 ? scalar_time / vectorized_time : 0.0
+		);
+	}
+}
+
+void BenchmarkIndexConversion(const BenchmarkOptions& in_options)
+{
+	const std::pair<AccessorComponentType, const char*> index_types[] =
+	{
+		{ AccessorComponentType::UInt8, "uint8 indices" },
+		{ AccessorComponentType::UInt16, "uint16 indices" },
+		{ AccessorComponentType::UInt32, "uint32 indices" },
+	};
+
+	const size_t index_count = in_options.smoke ? 1000 : 16 * 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 5;
+	for (const auto& [component_type, name] : index_types)
+	{
+		AccessorDesc accessor;
+		accessor.count = index_count;
+		accessor.component_type = component_type;
+		accessor.stride = accessor.GetElementSize();
+		const vector<uint8_t> data = make_accessor_data(accessor.GetSize(), component_type);
+		accessor.data = data.data();
+
+		vector<uint32_t> vectorized_indices(index_count);
+		vector<uint32_t> scalar_indices(index_count);
+		const double vectorized_time = benchmark_min_time(repetitions, [&]()
+		{
+			convert_accessor_to_indices(accessor, vectorized_indices.data());
+		});
+		const double scalar_time = benchmark_min_time(repetitions, [&]()
+		{
+			convert_accessor_to_indices_scalar(accessor, 0, accessor.count, scalar_indices.data());
+		});
+
+		if (vectorized_indices != scalar_indices)
+		{
+			printf("AccessorConversionBenchmark: SSE2 and scalar conversions of %s differ\n", name);
+			exit(1);
+		}
+
+		const double accessor_size = (double) accessor.GetSize();
+		printf(
+			"  %-20s SSE2 %8.3f ms %7.2f GB/s   scalar %8.3f ms %7.2f GB/s   %5.2fx\n",
+			name,
+			vectorized_time,
+			get_gigabytes_per_second(accessor_size, vectorized_time),
+			scalar_time,
+			get_gigabytes_per_second(accessor_size, scalar_time),
+			vectorized_time > 0.0 ? scalar_time / vectorized_time : 0.0
+		);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkFloatConversion, options);
+	BENCHMARK_RUN(BenchmarkIndexConversion, options);
+	return 0;
+}
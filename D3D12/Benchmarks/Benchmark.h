@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*	Minimal helpers for the benchmarks. Each benchmark is an executable of its own (see CMakeLists.txt) that runs its cases from main and
+	prints a table of results. Numbers only mean something in an optimized build.
+	CTest runs each one with --smoke, which shrinks every case to a single small iteration so the benchmarks keep building and working
+*/
+struct BenchmarkOptions
+{
+	bool smoke = false;
+
+	// Anything on the command line that isn't an option, e.g. asset files to benchmark instead of synthetic data
+	std::vector<std::string> files;
+};
+
+inline BenchmarkOptions parse_benchmark_arguments(const int argc, char** argv)
+{
+	BenchmarkOptions options;
+	for (int arg_idx = 1; arg_idx < argc; ++arg_idx)
+	{
+		if (strcmp(argv[arg_idx], "--smoke") == 0)
+		{
+			options.smoke = true;
+		}
+		else
+		{
+			options.files.push_back(argv[arg_idx]);
+		}
+	}
+	return options;
+}
+
+// Calls in_function once, returning how long it took in milliseconds
+template<typename Function>
+double benchmark_time(Function&& in_function)
+{
+	using milliseconds = std::chrono::duration<double, std::milli>;
+	const auto start_time = std::chrono::high_resolution_clock::now();
+	in_function();
+	return std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+}
+
+// Calls in_function once to warm up, then in_repetitions more times, returning the fastest call in milliseconds
+template<typename Function>
+double benchmark_min_time(const int in_repetitions, Function&& in_function)
+{
+	in_function();
+
+	double min_time = 0.0;
+	for (int repetition = 0; repetition < in_repetitions; ++repetition)
+	{
+		const double time = benchmark_time(in_function);
+		min_time = repetition == 0 ? time : (std::min)(min_time, time);
+	}
+	return min_time;
+}
+
+// Bytes per millisecond to GB/s
+inline double get_gigabytes_per_second(const double in_bytes, const double in_milliseconds)
+{
+	return in_milliseconds > 0.0 ? in_bytes / (in_milliseconds * 1.0e6) : 0.0;
+}
+
+// Total thread counts to scale across: 1, 2, 4... up to the hardware thread count, which is always included
+inline std::vector<size_t> get_benchmark_thread_counts()
+{
+	const size_t hardware_thread_count = (std::max)(std::thread::hardware_concurrency(), 1u);
+	std::vector<size_t> thread_counts;
+	for (size_t thread_count = 1; thread_count < hardware_thread_count; thread_count *= 2)
+	{
+		thread_counts.push_back(thread_count);
+	}
+	thread_counts.push_back(hardware_thread_count);
+	return thread_counts;
+}
+
+// Keeps the optimizer from throwing away a result nothing else reads
+template<typename T>
+void benchmark_keep(const T& in_value)
+{
+	static volatile uint8_t sink;
+	sink = *reinterpret_cast<const volatile uint8_t*>(&in_value);
+	(void) sink;
+}
+
+// Runs one benchmark case, printing its name first like TEST_RUN does
+#define BENCHMARK_RUN(benchmark_function, options) \
+{\
+	printf("%s\n", #benchmark_function);\
+	benchmark_function(options);\
+}\
+
@@ -0,0 +1,176 @@
+/*	FreeListAllocator as GeometryPool uses it: one allocation per mesh, GEOMETRY_POOL_ALIGNMENT aligned, out of 256MB pages.
+	Measures Allocate/Free throughput as the number of live allocations grows, and how fragmented a page gets under the churn of
+	streaming and hot reloads (free a random mesh, allocate a new one) at different occupancies.
+
+	Usage: FreeListAllocatorBenchmark [--smoke]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "FreeListAllocator.h"
+
+using std::vector;
+
+// Same as GeometryPoolDesc's defaults. Not included from there, GpuResources.h needs d3d12
+static constexpr uint64_t BENCHMARK_PAGE_SIZE = 256 * 1024 * 1024;
+static constexpr uint64_t BENCHMARK_ALIGNMENT = 16;
+
+// Mesh sizes spread evenly in log space between 1KB and 2MB, most meshes in a scene being small. Not multiples of the alignment
+struct MeshSizeDistribution
+{
+	uint64_t operator()(std::mt19937& io_rng)
+	{
+		return (uint64_t) std::exp2(m_log_size(io_rng)) + m_jitter(io_rng);
+	}
+
+	std::uniform_real_distribution<double> m_log_size { 10.0, 21.0 };
+	std::uniform_int_distribution<uint64_t> m_jitter { 0, 15 };
+};
+
+// Millions of operations per second
+double get_million_operations_per_second(const size_t in_operation_count, const double in_milliseconds)
+{
+	return in_milliseconds > 0.0 ? in_operation_count / (in_milliseconds * 1.0e3) : 0.0;
+}
+
+// Allocates each count of meshes into a page big enough for all of them, then frees them in a random order
+void BenchmarkThroughput(const BenchmarkOptions& in_options)
+{
+	const vector<size_t> live_counts = in_options.smoke ? vector<size_t> { 100 } : vector<size_t> { 1000, 10000, 100000 };
+	const int repetitions = in_options.smoke ? 1 : 5;
+	for (const size_t live_count : live_counts)
+	{
+		std::mt19937 rng(1357);
+		MeshSizeDistribution size_distribution;
+		vector<uint64_t> sizes(live_count);
+		uint64_t total_size = 0;
+		for (uint64_t& size : sizes)
+		{
+			size = size_distribution(rng);
+			total_size += size + BENCHMARK_ALIGNMENT;
+		}
+
+		vector<size_t> free_order(live_count);
+		for (size_t allocation_idx = 0; allocation_idx < live_count; ++allocation_idx)
+		{
+			free_order[allocation_idx] = allocation_idx;
+		}
+		std::shuffle(free_order.begin(), free_order.end(), rng);
+
+		vector<FreeListAllocation> allocations(live_count);
+		double allocate_time = 0.0;
+		double free_time = 0.0;
+		for (int repetition = 0; repetition < repetitions; ++repetition)
+		{
+			FreeListAllocator allocator(total_size);
+			const double repetition_allocate_time = benchmark_time([&]()
+			{
+				for (size_t allocation_idx = 0; allocation_idx < live_count; ++allocation_idx)
+				{
+					allocations[allocation_idx] = *allocator.Allocate(sizes[allocation_idx], BENCHMARK_ALIGNMENT);
+				}
+			});
+
+			const double repetition_free_time = benchmark_time([&]()
+			{
+				for (const size_t allocation_idx : free_order)
+				{
+					allocator.Free(allocations[allocation_idx]);
+				}
+			});
+
+			if (allocator.GetUsedSize() != 0 || allocator.GetFreeBlockCount() != 1)
+			{
+				printf("FreeListAllocatorBenchmark: Freeing every allocation didn't merge the page back into one block\n");
+				exit(1);
+			}
+
+			allocate_time = repetition == 0 ? repetition_allocate_time : (std::min)(allocate_time, repetition_allocate_time);
+			free_time = repetition == 0 ? repetition_free_time : (std::min)(free_time, repetition_free_time);
+		}
+
+		printf(
+			"  %7zu allocations: allocate %8.3f ms (%6.2f M/s), free %8.3f ms (%6.2f M/s)\n",
+			live_count,
+			allocate_time,
+			get_million_operations_per_second(live_count, allocate_time),
+			free_time,
+			get_million_operations_per_second(live_count, free_time)
+		);
+	}
+}
+
+// Fills a page to each occupancy, then replaces random meshes with new random ones. Fragmentation is FreeListAllocator::GetFragmentation
+void BenchmarkFragmentation(const BenchmarkOptions& in_options)
+{
+	const size_t churn_count = in_options.smoke ? 1000 : 200000;
+	for (const double occupancy : { 0.5, 0.75, 0.9 })
+	{
+		std::mt19937 rng(2468);
+		MeshSizeDistribution size_distribution;
+		FreeListAllocator allocator(BENCHMARK_PAGE_SIZE);
+		vector<FreeListAllocation> allocations;
+		while (allocator.GetUsedSize() < BENCHMARK_PAGE_SIZE * occupancy)
+		{
+			allocations.push_back(*allocator.Allocate(size_distribution(rng), BENCHMARK_ALIGNMENT));
+		}
+
+		// A failed allocation is one GeometryPool would have opened a new page for
+		size_t failed_count = 0;
+		float max_fragmentation = 0.0f;
+		const double churn_time = benchmark_time([&]()
+		{
+			for (size_t churn_idx = 0; churn_idx < churn_count; ++churn_idx)
+			{
+				const size_t victim_idx = std::uniform_int_distribution<size_t>(0, allocations.size() - 1)(rng);
+				allocator.Free(allocations[victim_idx]);
+				std::swap(allocations[victim_idx], allocations.back());
+				allocations.pop_back();
+
+				// Keep the page at its occupancy, so a failure means fragmentation rather than running out of space
+				while (allocator.GetUsedSize() < BENCHMARK_PAGE_SIZE * occupancy)
+				{
+					if (const optional<FreeListAllocation> allocation = allocator.Allocate(size_distribution(rng), BENCHMARK_ALIGNMENT))
+					{
+						allocations.push_back(*allocation);
+					}
+					else
+					{
+						++failed_count;
+						break;
+					}
+				}
+				max_fragmentation = (std::max)(max_fragmentation, allocator.GetFragmentation());
+			}
+		});
+
+		printf(
+			"  %2.0f%% full: %zu replacements in %.2f ms (%.2f M/s), %zu meshes, %zu free blocks, largest %.2f MB of %.2f MB free, "
+			"fragmentation %.3f (max %.3f), %zu failed\n",
+			occupancy * 100.0,
+			churn_count,
+			churn_time,
+			get_million_operations_per_second(churn_count, churn_time),
+			allocations.size(),
+			allocator.GetFreeBlockCount(),
+			allocator.GetLargestFreeBlock() / (1024.0 * 1024.0),
+			allocator.GetFreeSize() / (1024.0 * 1024.0),
+			allocator.GetFragmentation(),
+			max_fragmentation,
+			failed_count
+		);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkThroughput, options);
+	BENCHMARK_RUN(BenchmarkFragmentation, options);
+	return 0;
+}
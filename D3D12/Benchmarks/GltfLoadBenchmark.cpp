@@ -0,0 +1,198 @@
+/*	Load time of a gltf's geometry through each path GltfScene::Load can take (see load_gltf_geometry): parsing and converting the gltf,
+	or reading a cooked scene cache, uncompressed or deflated. Also how primitive conversion scales from 1 to every hardware thread.
+
+	Usage: GltfLoadBenchmark [--smoke] [file.gltf|file.glb]...
+
+	Without files, a synthetic scene is written to the temp directory. Benchmarking a file rewrites its scene cache (<file>.cooked)
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "GltfConversion.h"
+#include "TestGltf.h"
+#include "ThreadPool.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string;
+using std::vector;
+
+// Writes a scene of in_mesh_count distinct grid meshes to the temp directory, returning the gltf's path
+string write_synthetic_scene(const char* in_name, const uint32_t in_mesh_count, const uint32_t in_grid_size)
+{
+	TestGltfBuilder builder;
+	for (uint32_t mesh_idx = 0; mesh_idx < in_mesh_count; ++mesh_idx)
+	{
+		builder.AddNode(builder.AddMesh({ builder.AddGridPrimitive(in_grid_size, (float) mesh_idx) }), (float) mesh_idx * 12.0f);
+	}
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "GltfLoadBenchmark";
+	std::filesystem::create_directories(directory);
+	const string path = (directory / in_name).string();
+	if (!builder.Write(path))
+	{
+		printf("GltfLoadBenchmark: Failed to write %s\n", path.c_str());
+		exit(1);
+	}
+	return path;
+}
+
+// Loads in_file's geometry, exiting if that fails since every path would be timing the failure
+void load_geometry(const GltfGeometryDesc& in_desc, GltfGeometry& out_geometry)
+{
+	if (!load_gltf_geometry(in_desc, out_geometry))
+	{
+		printf("GltfLoadBenchmark: Failed to load %s\n", in_desc.file);
+		exit(1);
+	}
+}
+
+// The gltf path against the cooked path, both with every hardware thread
+void BenchmarkCookedVsGltf(const BenchmarkOptions& in_options)
+{
+	vector<string> files = in_options.files;
+	if (files.empty())
+	{
+		files.push_back(in_options.smoke ? write_synthetic_scene("smoke.gltf", 4, 8) : write_synthetic_scene("scene.gltf", 48, 96));
+	}
+
+	const int repetitions = in_options.smoke ? 1 : 5;
+	ThreadPool thread_pool((std::max)(std::thread::hardware_concurrency(), 1u) - 1);
+	for (const string& file : files)
+	{
+		GltfGeometryDesc desc =
+		{
+			.file = file.c_str(),
+			.use_scene_cache = false,
+			.thread_pool = &thread_pool,
+		};
+
+		size_t mesh_count = 0;
+		size_t instance_count = 0;
+		const double gltf_time = benchmark_min_time(repetitions, [&]()
+		{
+			GltfGeometry geometry;
+			load_geometry(desc, geometry);
+			mesh_count = geometry.meshes.size();
+			instance_count = geometry.instances.size();
+		});
+
+		printf("  %s: %zu meshes, %zu instances, %zu threads\n", file.c_str(), mesh_count, instance_count, thread_pool.GetThreadCount() + 1);
+		printf("    %-24s %10.2f ms\n", "gltf", gltf_time);
+
+		for (const SceneCacheCompression compression : { SceneCacheCompression::None, SceneCacheCompression::Deflate })
+		{
+			// Cook the cache with this compression, then only time loads that read it
+			desc.use_scene_cache = true;
+			desc.scene_cache_compression = compression;
+			std::filesystem::remove(get_scene_cache_path(file.c_str()));
+			{
+				GltfGeometry geometry;
+				load_geometry(desc, geometry);
+			}
+
+			bool loaded_from_cache = true;
+			const double cooked_time = benchmark_min_time(repetitions, [&]()
+			{
+				GltfGeometry geometry;
+				load_geometry(desc, geometry);
+				loaded_from_cache &= geometry.loaded_from_cache;
+			});
+
+			if (!loaded_from_cache)
+			{
+				printf("GltfLoadBenchmark: %s wasn't loaded from its scene cache\n", file.c_str());
+				exit(1);
+			}
+
+			printf(
+				"    %-24s %10.2f ms  %6.1fx faster\n",
+				compression == SceneCacheCompression::None ? "cooked" : "cooked (deflate)",
+				cooked_time,
+				cooked_time > 0.0 ? gltf_time / cooked_time : 0.0
+			);
+		}
+	}
+}
+
+// Wall time of convert_primitives on 1 to N threads. Output doesn't depend on the thread count, which is checked along the way
+void BenchmarkConversionThreadScaling(const BenchmarkOptions& in_options)
+{
+	vector<string> files = in_options.files;
+	if (files.empty())
+	{
+		files.push_back(in_options.smoke ? write_synthetic_scene("smoke.gltf", 4, 8) : write_synthetic_scene("scene.gltf", 48, 96));
+	}
+
+	const int repetitions = in_options.smoke ? 1 : 3;
+	for (const string& file : files)
+	{
+		cgltf_options options = {};
+		cgltf_data* data = nullptr;
+		if (cgltf_parse_file(&options, file.c_str(), &data) != cgltf_result_success || cgltf_load_buffers(&options, data, file.c_str()) != cgltf_result_success)
+		{
+			printf("GltfLoadBenchmark: Failed to load %s\n", file.c_str());
+			exit(1);
+		}
+		decode_meshopt_buffer_views(*data, nullptr);
+		const GltfSceneLayout scene_layout = extract_scene_layout(*data);
+
+		printf("  %s: %zu meshes\n", file.c_str(), scene_layout.meshes.size());
+		double single_thread_time = 0.0;
+		vector<uint64_t> single_thread_hashes;
+		for (const size_t thread_count : get_benchmark_thread_counts())
+		{
+			ThreadPool thread_pool(thread_count - 1);
+			vector<uint64_t> hashes;
+			const double time = benchmark_min_time(repetitions, [&]()
+			{
+				const GltfConvertedMeshes converted = convert_primitives(scene_layout.meshes, *data, VertexFormat::Compact, &thread_pool);
+				hashes.clear();
+				for (const GltfMeshData& mesh : converted.meshes)
+				{
+					uint64_t hash = mesh.source_hash;
+					for (const span<const uint8_t> section : mesh.GetView().GetSections())
+					{
+						for (const uint8_t byte : section)
+						{
+							hash = hash * 31 + byte;
+						}
+					}
+					hashes.push_back(hash);
+				}
+			});
+
+			if (thread_count == 1)
+			{
+				single_thread_time = time;
+				single_thread_hashes = hashes;
+			}
+			else if (hashes != single_thread_hashes)
+			{
+				printf("GltfLoadBenchmark: Converting on %zu threads gave different meshes than on 1\n", thread_count);
+				exit(1);
+			}
+
+			printf("    %3zu threads %10.2f ms  %5.2fx speedup\n", thread_count, time, time > 0.0 ? single_thread_time / time : 0.0);
+		}
+
+		cgltf_free(data);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkCookedVsGltf, options);
+	BENCHMARK_RUN(BenchmarkConversionThreadScaling, options);
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*	Throughput of the cook-time mesh processing passes (see MeshProcessing.h) on a single thread: vertex cache optimization, meshlet
+	generation and LOD chain generation, in millions of input triangles per second. convert_primitives runs them once per mesh, in
+	parallel across meshes, so this is also the per-thread rate of that part of a cook.
+
+	Usage: MeshProcessingBenchmark [--smoke]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "MeshProcessing.h"
+
+using std::vector;
+
+struct BenchmarkMesh
+{
+	vector<Vertex> vertices;
+	vector<uint32_t> indices;
+};
+
+// An in_size x in_size grid of quads over a bumpy height field, with its triangles shuffled like an unoptimized export
+BenchmarkMesh make_height_field(const uint32_t in_size)
+{
+	BenchmarkMesh mesh;
+	const uint32_t side = in_size + 1;
+	mesh.vertices.reserve((size_t) side * side);
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			const float u = (float) x / in_size;
+			const float v = (float) y / in_size;
+			const float height = 0.5f * std::sin(9.0f * u) * std::cos(7.0f * v) + 0.1f * std::sin(40.0f * u * v);
+			Vertex vertex(float3(u * 10.0f, height, v * 10.0f), float3(0.0f, 1.0f, 0.0f), float3(1.0f, 1.0f, 1.0f));
+			vertex.texcoord = float2(u, v);
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	vector<uint32_t> triangles;
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			const uint32_t corner = y * side + x;
+			triangles.insert(triangles.end(), { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 });
+		}
+	}
+
+	vector<uint32_t> triangle_order(triangles.size() / 3);
+	for (uint32_t triangle_idx = 0; triangle_idx < triangle_order.size(); ++triangle_idx)
+	{
+		triangle_order[triangle_idx] = triangle_idx;
+	}
+	std::shuffle(triangle_order.begin(), triangle_order.end(), std::mt19937(24680));
+
+	mesh.indices.reserve(triangles.size());
+	for (const uint32_t triangle_idx : triangle_order)
+	{
+		mesh.indices.insert(mesh.indices.end(), triangles.begin() + triangle_idx * 3, triangles.begin() + triangle_idx * 3 + 3);
+	}
+	return mesh;
+}
+
+// Millions of triangles per second
+double get_megatriangles_per_second(const size_t in_triangle_count, const double in_milliseconds)
+{
+	return in_milliseconds > 0.0 ? in_triangle_count / (in_milliseconds * 1.0e3) : 0.0;
+}
+
+// Each pass on its own, on the same shuffled meshes. Meshlets and LODs run on the vertex cache optimized mesh, like convert_primitives does
+void BenchmarkMeshPasses(const BenchmarkOptions& in_options)
+{
+	const vector<uint32_t> grid_sizes = in_options.smoke ? vector<uint32_t> { 8 } : vector<uint32_t> { 32, 128, 384 };
+	const int repetitions = in_options.smoke ? 1 : 3;
+	for (const uint32_t grid_size : grid_sizes)
+	{
+		const BenchmarkMesh mesh = make_height_field(grid_size);
+		const size_t triangle_count = mesh.indices.size() / 3;
+
+		vector<uint32_t> optimized_indices;
+		const double optimize_time = benchmark_min_time(repetitions, [&]()
+		{
+			optimized_indices = mesh.indices;
+			optimize_vertex_cache(optimized_indices, mesh.vertices.size());
+		});
+
+		size_t meshlet_count = 0;
+		const double meshlet_time = benchmark_min_time(repetitions, [&]()
+		{
+			const MeshletData meshlet_data = build_meshlets(optimized_indices, mesh.vertices);
+			meshlet_count = meshlet_data.meshlets.size();
+		});
+
+		vector<MeshLod> lods;
+		const double lod_time = benchmark_min_time(repetitions, [&]()
+		{
+			vector<uint32_t> lod_indices = optimized_indices;
+			lods = build_mesh_lods(lod_indices, mesh.vertices);
+		});
+
+		printf("  %ux%u grid: %zu triangles, %zu vertices\n", grid_size, grid_size, triangle_count, mesh.vertices.size());
+		printf("    %-22s %10.3f ms  %8.2f Mtris/s\n", "optimize_vertex_cache", optimize_time, get_megatriangles_per_second(triangle_count, optimize_time));
+		printf("    %-22s %10.3f ms  %8.2f Mtris/s  %zu meshlets\n", "build_meshlets", meshlet_time, get_megatriangles_per_second(triangle_count, meshlet_time), meshlet_count);
+		printf("    %-22s %10.3f ms  %8.2f Mtris/s  %zu lods:", "build_mesh_lods", lod_time, get_megatriangles_per_second(triangle_count, lod_time), lods.size());
+		for (const MeshLod& lod : lods)
+		{
+			printf(" %u (error %.4f)", lod.index_count / 3, lod.error);
+		}
+		printf("\n");
+	}
+}
+
+// simplify_mesh alone, to each target ratio of the full mesh, since LOD chains spend nearly all their time in it
+void BenchmarkSimplification(const BenchmarkOptions& in_options)
+{
+	const BenchmarkMesh mesh = make_height_field(in_options.smoke ? 8 : 256);
+	const size_t triangle_count = mesh.indices.size() / 3;
+	const int repetitions = in_options.smoke ? 1 : 3;
+	printf("  %zu triangles\n", triangle_count);
+	for (const float target_ratio : { 0.5f, 0.25f, 0.05f })
+	{
+		const size_t target_index_count = (size_t) (triangle_count * target_ratio) * 3;
+		size_t result_triangle_count = 0;
+		float error = 0.0f;
+		const double time = benchmark_min_time(repetitions, [&]()
+		{
+			result_triangle_count = simplify_mesh(mesh.indices, mesh.vertices, target_index_count, error).size() / 3;
+		});
+
+		printf(
+			"    to %5.1f%% %10.3f ms  %8.2f Mtris/s  %zu triangles, error %.4f\n",
+			target_ratio * 100.0f,
+			time,
+			get_megatriangles_per_second(triangle_count, time),
+			result_triangle_count,
+			error
+		);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkMeshPasses, options);
+	BENCHMARK_RUN(BenchmarkSimplification, options);
+	return 0;
+}
@@ -0,0 +1,274 @@
+/*	Decode throughput of the EXT_meshopt_compression bitstreams (see MeshoptDecoding.h) on a single thread, in GB/s of decoded data:
+	vertex buffers of a few common layouts, triangle and sequence index buffers, and the attribute filters.
+	Input comes from the reference encoders in Tests/MeshoptEncoding.h, which reach every decoder path but don't pick modes the way
+	meshoptimizer does, so compression ratios (and to a lesser degree the decode mix) differ from real files.
+
+	Usage: MeshoptDecodingBenchmark [--smoke]
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "MeshoptDecoding.h"
+#include "MeshoptEncoding.h"
+
+using std::vector;
+
+// 32 byte interleaved vertices of an in_size x in_size height field grid: float3 position, snorm8x4 normal, float2 texcoord, unorm16x4 color
+vector<uint8_t> make_grid_vertices(const uint32_t in_size)
+{
+	const uint32_t side = in_size + 1;
+	vector<uint8_t> vertices((size_t) side * side * 32);
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			const float u = (float) x / in_size;
+			const float v = (float) y / in_size;
+			const float position[3] = { u * 10.0f, 0.5f * std::sin(9.0f * u) * std::cos(7.0f * v), v * 10.0f };
+			const int8_t normal[4] = { (int8_t) (std::cos(9.0f * u) * 40.0f), 120, (int8_t) (std::sin(7.0f * v) * 40.0f), 0 };
+			const float texcoord[2] = { u, v };
+			const uint16_t color[4] = { (uint16_t) (u * 65535.0f), (uint16_t) (v * 65535.0f), 32768, 65535 };
+
+			uint8_t* vertex = vertices.data() + ((size_t) y * side + x) * 32;
+			memcpy(vertex, position, sizeof(position));
+			memcpy(vertex + 12, normal, sizeof(normal));
+			memcpy(vertex + 16, texcoord, sizeof(texcoord));
+			memcpy(vertex + 24, color, sizeof(color));
+		}
+	}
+	return vertices;
+}
+
+// The first in_vertex_size bytes of each 32 byte vertex, the way a file storing attributes in separate streams splits them up
+vector<uint8_t> get_vertex_prefix(const vector<uint8_t>& in_vertices, const size_t in_vertex_size)
+{
+	const size_t vertex_count = in_vertices.size() / 32;
+	vector<uint8_t> vertices(vertex_count * in_vertex_size);
+	for (size_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+	{
+		memcpy(vertices.data() + vertex_idx * in_vertex_size, in_vertices.data() + vertex_idx * 32, in_vertex_size);
+	}
+	return vertices;
+}
+
+// Also prints millions of triangles per second when given a triangle count
+void print_decode_result(const char* in_name, const size_t in_encoded_size, const size_t in_decoded_size, const double in_time, const size_t in_triangle_count = 0)
+{
+	printf(
+		"  %-26s %8.2f MB -> %8.2f MB %10.3f ms  %7.2f GB/s",
+		in_name,
+		in_encoded_size / (1024.0 * 1024.0),
+		in_decoded_size / (1024.0 * 1024.0),
+		in_time,
+		get_gigabytes_per_second((double) in_decoded_size, in_time)
+	);
+	if (in_triangle_count > 0)
+	{
+		printf("  %8.2f Mtris/s", in_time > 0.0 ? in_triangle_count / (in_time * 1.0e3) : 0.0);
+	}
+	printf("\n");
+}
+
+void BenchmarkVertexDecoding(const BenchmarkOptions& in_options)
+{
+	const vector<uint8_t> grid_vertices = make_grid_vertices(in_options.smoke ? 16 : 1023);
+	const int repetitions = in_options.smoke ? 1 : 5;
+	const std::pair<size_t, const char*> layouts[] =
+	{
+		{ 12, "12 byte (position)" },
+		{ 16, "16 byte (position, normal)" },
+		{ 32, "32 byte (interleaved)" },
+	};
+	for (const auto& [vertex_size, name] : layouts)
+	{
+		const vector<uint8_t> vertices = get_vertex_prefix(grid_vertices, vertex_size);
+		const size_t vertex_count = vertices.size() / vertex_size;
+		const vector<uint8_t> encoded = EncodeVertexBuffer(vertices, vertex_size);
+
+		vector<uint8_t> decoded(vertices.size());
+		bool decoded_ok = true;
+		const double time = benchmark_min_time(repetitions, [&]()
+		{
+			decoded_ok &= decode_meshopt_vertex_buffer(decoded.data(), vertex_count, vertex_size, encoded);
+		});
+
+		if (!decoded_ok || decoded != vertices)
+		{
+			printf("MeshoptDecodingBenchmark: %s vertices didn't round trip\n", name);
+			exit(1);
+		}
+		print_decode_result(name, encoded.size(), decoded.size(), time);
+	}
+}
+
+// A grid in strip order, as the index codec expects from vertex cache optimized meshes, decoded to 16 and 32-bit indices
+void BenchmarkIndexDecoding(const BenchmarkOptions& in_options)
+{
+	// 255x255 quads is the largest grid whose vertices 16-bit indices can address
+	const vector<uint32_t> indices = MakeGridIndices(in_options.smoke ? 16 : 255);
+	const int repetitions = in_options.smoke ? 1 : 5;
+	const size_t triangle_count = indices.size() / 3;
+
+	const vector<uint8_t> triangle_encoded = IndexEncoder().Encode(indices);
+	const vector<uint8_t> sequence_encoded = EncodeIndexSequence(indices);
+	const std::pair<const vector<uint8_t>*, const char*> encodings[] = { { &triangle_encoded, "triangles" }, { &sequence_encoded, "sequence" } };
+	for (const auto& [encoded, encoding_name] : encodings)
+	{
+		for (const size_t index_size : { sizeof(uint16_t), sizeof(uint32_t) })
+		{
+			vector<uint8_t> decoded(indices.size() * index_size);
+			bool decoded_ok = true;
+			const double time = benchmark_min_time(repetitions, [&]()
+			{
+				decoded_ok &= encoded == &triangle_encoded
+					? decode_meshopt_index_buffer(decoded.data(), indices.size(), index_size, *encoded)
+					: decode_meshopt_index_sequence(decoded.data(), indices.size(), index_size, *encoded);
+			});
+
+			char name[64];
+			snprintf(name, sizeof(name), "%s to %zu-bit", encoding_name, index_size * 8);
+			if (!decoded_ok)
+			{
+				printf("MeshoptDecodingBenchmark: %s indices failed to decode\n", name);
+				exit(1);
+			}
+			print_decode_result(name, encoded->size(), decoded.size(), time, triangle_count);
+		}
+	}
+}
+
+/*	What meshoptimizer's encoders would produce for in_filter: octahedral encoded random unit vectors, random rotations stored as their 3
+	smallest components, or random floats as 24-bit mantissas with a shared exponent
+*/
+vector<uint8_t> make_filter_input(const MeshoptFilter in_filter, const size_t in_stride, const size_t in_count, std::mt19937& io_rng)
+{
+	std::normal_distribution<float> normal_distribution;
+	vector<uint8_t> data(in_count * in_stride);
+	for (size_t element_idx = 0; element_idx < in_count; ++element_idx)
+	{
+		uint8_t* element = data.data() + element_idx * in_stride;
+		float v[4] = { normal_distribution(io_rng), normal_distribution(io_rng), normal_distribution(io_rng), normal_distribution(io_rng) };
+		switch (in_filter)
+		{
+			case MeshoptFilter::Octahedral:
+			{
+				const float length = std::fabs(v[0]) + std::fabs(v[1]) + std::fabs(v[2]) + 1.0e-6f;
+				float x = v[0] / length;
+				float y = v[1] / length;
+				if (v[2] < 0.0f)
+				{
+					const float folded_x = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+					y = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+					x = folded_x;
+				}
+
+				const int32_t max_value = in_stride == 4 ? 127 : 32767;
+				const int32_t encoded[4] = { (int32_t) std::lround(x * max_value), (int32_t) std::lround(y * max_value), max_value, 0 };
+				for (uint32_t component_idx = 0; component_idx < 4; ++component_idx)
+				{
+					if (in_stride == 4)
+					{
+						element[component_idx] = (uint8_t) (int8_t) encoded[component_idx];
+					}
+					else
+					{
+						const int16_t value = (int16_t) encoded[component_idx];
+						memcpy(element + component_idx * sizeof(int16_t), &value, sizeof(value));
+					}
+				}
+				break;
+			}
+			case MeshoptFilter::Quaternion:
+			{
+				const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]) + 1.0e-6f;
+				uint32_t max_component = 0;
+				for (uint32_t component_idx = 1; component_idx < 4; ++component_idx)
+				{
+					max_component = std::fabs(v[component_idx]) > std::fabs(v[max_component]) ? component_idx : max_component;
+				}
+
+				// The decoder writes w to the largest component's slot, then the stored components after it
+				const float sign = v[max_component] < 0.0f ? -1.0f : 1.0f;
+				int16_t encoded[4];
+				for (uint32_t component_idx = 0; component_idx < 3; ++component_idx)
+				{
+					const float value = v[(max_component + 1 + component_idx) & 3] * sign / length;
+					encoded[component_idx] = (int16_t) std::lround(value * std::sqrt(2.0f) * 32767.0f);
+				}
+				encoded[3] = (int16_t) ((32767 & ~3) | max_component);
+				memcpy(element, encoded, sizeof(encoded));
+				break;
+			}
+			case MeshoptFilter::Exponential:
+			{
+				for (size_t value_idx = 0; value_idx < in_stride / 4; ++value_idx)
+				{
+					const int32_t mantissa = (int32_t) (normal_distribution(io_rng) * (1 << 20));
+					const uint32_t value = ((uint32_t) mantissa & 0xFFFFFF) | ((uint32_t) (int32_t) -20 << 24);
+					memcpy(element + value_idx * 4, &value, sizeof(value));
+				}
+				break;
+			}
+			case MeshoptFilter::None:
+				break;
+		}
+	}
+	return data;
+}
+
+// Filters run in place after the vertex codec, over every element of the attribute
+void BenchmarkFilters(const BenchmarkOptions& in_options)
+{
+	const size_t element_count = in_options.smoke ? 1000 : 4 * 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 5;
+	std::mt19937 rng(86420);
+
+	struct FilterCase
+	{
+		const char* name;
+		MeshoptFilter filter;
+		size_t stride;
+	};
+	const FilterCase cases[] =
+	{
+		{ "octahedral snorm8x4", MeshoptFilter::Octahedral, 4 },
+		{ "octahedral snorm16x4", MeshoptFilter::Octahedral, 8 },
+		{ "quaternion snorm16x4", MeshoptFilter::Quaternion, 8 },
+		{ "exponential float3", MeshoptFilter::Exponential, 12 },
+	};
+	for (const FilterCase& filter_case : cases)
+	{
+		// Each repetition filters a fresh copy, which the timing includes
+		const vector<uint8_t> source = make_filter_input(filter_case.filter, filter_case.stride, element_count, rng);
+
+		vector<uint8_t> data(source.size());
+		bool filtered_ok = true;
+		const double time = benchmark_min_time(repetitions, [&]()
+		{
+			memcpy(data.data(), source.data(), source.size());
+			filtered_ok &= apply_meshopt_filter(data.data(), element_count, filter_case.stride, filter_case.filter);
+		});
+
+		if (!filtered_ok)
+		{
+			printf("MeshoptDecodingBenchmark: %s rejected its stride\n", filter_case.name);
+			exit(1);
+		}
+		benchmark_keep(data[0]);
+		print_decode_result(filter_case.name, source.size(), data.size(), time);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkVertexDecoding, options);
+	BENCHMARK_RUN(BenchmarkIndexDecoding, options);
+	BENCHMARK_RUN(BenchmarkFilters, options);
+	return 0;
+}
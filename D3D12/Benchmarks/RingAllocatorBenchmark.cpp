@@ -0,0 +1,267 @@
+/*	RingAllocator and StagingRing as UploadRing uses them, with a simulated GPU that completes each frame's fence a few frames later.
+	Measures Allocate/Submit/Retire throughput against malloc/free of the same uploads, and what a ring too small for the upload load costs:
+	fence waits under UploadRingFullBehavior::Block, overflow buffers under Overflow, and the GB/s staged either way (copies included).
+
+	Usage: RingAllocatorBenchmark [--smoke]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "RingAllocator.h"
+#include "StagingRing.h"
+
+using std::vector;
+
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, which texture uploads are aligned to. Not included from d3d12.h, this only needs the standard library
+static constexpr uint64_t BENCHMARK_UPLOAD_ALIGNMENT = 512;
+
+// Frames the simulated GPU lags behind the CPU, like the app's frame_count - 1 frames in flight
+static constexpr uint64_t BENCHMARK_FRAME_LATENCY = 2;
+
+// Upload sizes spread evenly in log space between in_min_size and in_max_size, most uploads being small
+struct UploadSizeDistribution
+{
+	UploadSizeDistribution(const double in_min_size, const double in_max_size)
+		: m_log_size(std::log2(in_min_size), std::log2(in_max_size))
+	{
+	}
+
+	uint64_t operator()(std::mt19937& io_rng)
+	{
+		return (uint64_t) std::exp2(m_log_size(io_rng));
+	}
+
+	std::uniform_real_distribution<double> m_log_size;
+};
+
+// Millions of operations per second
+double get_million_operations_per_second(const size_t in_operation_count, const double in_milliseconds)
+{
+	return in_milliseconds > 0.0 ? in_operation_count / (in_milliseconds * 1.0e3) : 0.0;
+}
+
+// Many small uploads a frame, each freed BENCHMARK_FRAME_LATENCY frames later, through a ring that fits them against malloc/free
+void BenchmarkAllocateThroughput(const BenchmarkOptions& in_options)
+{
+	const size_t allocation_count = in_options.smoke ? 4096 : 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 5;
+	for (const size_t uploads_per_frame : { 16, 256, 4096 })
+	{
+		const size_t frame_count = allocation_count / uploads_per_frame;
+		std::mt19937 rng(8642);
+		UploadSizeDistribution size_distribution(64.0, 64.0 * 1024.0);
+		vector<uint64_t> sizes(uploads_per_frame * frame_count);
+		uint64_t max_frame_size = 0;
+		for (size_t frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+		{
+			uint64_t frame_size = 0;
+			for (size_t upload_idx = 0; upload_idx < uploads_per_frame; ++upload_idx)
+			{
+				uint64_t& size = sizes[frame_idx * uploads_per_frame + upload_idx];
+				size = size_distribution(rng);
+				frame_size += size + BENCHMARK_UPLOAD_ALIGNMENT;
+			}
+			max_frame_size = (std::max)(max_frame_size, frame_size);
+		}
+
+		// Room for every frame in flight plus the one being recorded, so no allocation ever has to wait
+		bool allocations_fit = true;
+		const double ring_time = benchmark_min_time(repetitions, [&]()
+		{
+			RingAllocator ring(max_frame_size * (BENCHMARK_FRAME_LATENCY + 1));
+			uint64_t offset_sum = 0;
+			for (size_t frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+			{
+				const uint64_t fence_value = frame_idx + 1;
+				ring.Retire(fence_value > BENCHMARK_FRAME_LATENCY ? fence_value - BENCHMARK_FRAME_LATENCY : 0);
+				for (size_t upload_idx = 0; upload_idx < uploads_per_frame; ++upload_idx)
+				{
+					const optional<RingAllocation> allocation = ring.Allocate(sizes[frame_idx * uploads_per_frame + upload_idx], BENCHMARK_UPLOAD_ALIGNMENT);
+					allocations_fit &= allocation.has_value();
+					offset_sum += allocation ? allocation->offset : 0;
+				}
+				ring.Submit(fence_value);
+			}
+			benchmark_keep(offset_sum);
+		});
+
+		if (!allocations_fit)
+		{
+			printf("RingAllocatorBenchmark: A ring sized for every frame in flight ran out of space\n");
+			exit(1);
+		}
+
+		// The same lifetimes through the heap: each frame frees what was allocated BENCHMARK_FRAME_LATENCY frames before it
+		const double malloc_time = benchmark_min_time(repetitions, [&]()
+		{
+			vector<vector<void*>> frame_allocations(BENCHMARK_FRAME_LATENCY + 1);
+			for (size_t frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+			{
+				vector<void*>& allocations = frame_allocations[frame_idx % frame_allocations.size()];
+				for (void* allocation : allocations)
+				{
+					free(allocation);
+				}
+				allocations.clear();
+				for (size_t upload_idx = 0; upload_idx < uploads_per_frame; ++upload_idx)
+				{
+					allocations.push_back(malloc(sizes[frame_idx * uploads_per_frame + upload_idx]));
+				}
+				benchmark_keep(allocations.back());
+			}
+			for (const vector<void*>& allocations : frame_allocations)
+			{
+				for (void* allocation : allocations)
+				{
+					free(allocation);
+				}
+			}
+		});
+
+		printf(
+			"  %5zu uploads/frame: ring %8.3f ms (%7.2f M/s)   malloc/free %8.3f ms (%7.2f M/s)   %5.2fx\n",
+			uploads_per_frame,
+			ring_time,
+			get_million_operations_per_second(allocation_count, ring_time),
+			malloc_time,
+			get_million_operations_per_second(allocation_count, malloc_time),
+			ring_time > 0.0 ? malloc_time / ring_time : 0.0
+		);
+	}
+}
+
+// What one run of frames through a StagingRing cost
+struct StagingResult
+{
+	double time = 0.0;
+	uint64_t staged_size = 0;
+	size_t wait_count = 0;
+	size_t overflow_count = 0;
+	uint64_t max_overflow_size = 0;
+};
+
+/*	Stages in_upload_sizes (in_uploads_per_frame a frame) through a StagingRing over in_ring_memory, copying each upload from in_source.
+	Each upload is submitted on its own, like a batch UploadManager submits once it's full, so a blocked upload can wait on the ones before it.
+	The simulated GPU completes a frame's uploads BENCHMARK_FRAME_LATENCY frames later, or right away when waited on, which is what a stall
+	on the copy queue amounts to
+*/
+StagingResult stage_uploads(
+	const UploadRingFullBehavior in_full_behavior,
+	vector<uint8_t>& io_ring_memory,
+	const vector<uint64_t>& in_upload_sizes,
+	const size_t in_uploads_per_frame,
+	const vector<uint8_t>& in_source
+)
+{
+	StagingResult result;
+	result.time = benchmark_time([&]()
+	{
+		StagingRing<vector<uint8_t>> staging(io_ring_memory.size(), in_full_behavior);
+		uint64_t completed_fence_value = 0;
+		auto wait_for_fence = [&](const uint64_t in_fence_value)
+		{
+			completed_fence_value = (std::max)(completed_fence_value, in_fence_value);
+			++result.wait_count;
+		};
+		auto create_overflow_buffer = [&](const uint64_t in_size)
+		{
+			++result.overflow_count;
+			return vector<uint8_t>(in_size);
+		};
+
+		// One fence value per upload, so the last one of each frame is the frame's
+		const size_t frame_count = in_upload_sizes.size() / in_uploads_per_frame;
+		uint64_t fence_value = 0;
+		for (size_t frame_idx = 0; frame_idx < frame_count; ++frame_idx)
+		{
+			if (frame_idx >= BENCHMARK_FRAME_LATENCY)
+			{
+				completed_fence_value = (std::max)(completed_fence_value, (uint64_t) (frame_idx - BENCHMARK_FRAME_LATENCY + 1) * in_uploads_per_frame);
+			}
+
+			for (size_t upload_idx = 0; upload_idx < in_uploads_per_frame; ++upload_idx)
+			{
+				const uint64_t size = in_upload_sizes[frame_idx * in_uploads_per_frame + upload_idx];
+				const auto allocation = staging.Allocate(size, BENCHMARK_UPLOAD_ALIGNMENT, completed_fence_value, wait_for_fence, create_overflow_buffer);
+				if (!allocation)
+				{
+					printf("RingAllocatorBenchmark: Staging a %llu byte upload failed\n", (unsigned long long) size);
+					exit(1);
+				}
+
+				uint8_t* destination = allocation->overflow_buffer
+					? allocation->overflow_buffer->data()
+					: io_ring_memory.data() + allocation->ring_allocation.offset;
+				memcpy(destination, in_source.data(), size);
+				result.staged_size += size;
+				result.max_overflow_size = (std::max)(result.max_overflow_size, staging.GetOverflowSize());
+				staging.Submit(++fence_value);
+			}
+		}
+	});
+	return result;
+}
+
+// Rings from too small to roomy for the upload load, under both full behaviors
+void BenchmarkStagingPressure(const BenchmarkOptions& in_options)
+{
+	const size_t frame_count = in_options.smoke ? 10 : 500;
+	const int repetitions = in_options.smoke ? 1 : 3;
+	const size_t uploads_per_frame = 8;
+	const uint64_t max_upload_size = 2 * 1024 * 1024;
+
+	std::mt19937 rng(97531);
+	UploadSizeDistribution size_distribution(1024.0, (double) max_upload_size);
+	vector<uint64_t> upload_sizes(frame_count * uploads_per_frame);
+	uint64_t total_size = 0;
+	for (uint64_t& size : upload_sizes)
+	{
+		size = size_distribution(rng);
+		total_size += size;
+	}
+	const vector<uint8_t> source(max_upload_size, 0x5A);
+	printf("  %zu uploads/frame, %.2f MB/frame on average, GPU %llu frames behind\n",
+		uploads_per_frame,
+		total_size / (frame_count * 1024.0 * 1024.0),
+		(unsigned long long) BENCHMARK_FRAME_LATENCY);
+
+	for (const uint64_t ring_size : { 2, 4, 8, 16 })
+	{
+		vector<uint8_t> ring_memory(ring_size * 1024 * 1024);
+		for (const UploadRingFullBehavior full_behavior : { UploadRingFullBehavior::Block, UploadRingFullBehavior::Overflow })
+		{
+			// Once to fault the ring's memory in, then the fastest of a few runs. The counts are the same every run
+			StagingResult result = stage_uploads(full_behavior, ring_memory, upload_sizes, uploads_per_frame, source);
+			for (int repetition = 0; repetition < repetitions; ++repetition)
+			{
+				const StagingResult repetition_result = stage_uploads(full_behavior, ring_memory, upload_sizes, uploads_per_frame, source);
+				result = repetition == 0 || repetition_result.time < result.time ? repetition_result : result;
+			}
+			printf(
+				"    %3llu MB ring, %-8s %8.2f ms %6.2f GB/s  %6zu waits  %6zu overflow buffers (peak %7.2f MB)\n",
+				(unsigned long long) ring_size,
+				full_behavior == UploadRingFullBehavior::Block ? "block" : "overflow",
+				result.time,
+				get_gigabytes_per_second((double) result.staged_size, result.time),
+				result.wait_count,
+				result.overflow_count,
+				result.max_overflow_size / (1024.0 * 1024.0)
+			);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkAllocateThroughput, options);
+	BENCHMARK_RUN(BenchmarkStagingPressure, options);
+	return 0;
+}
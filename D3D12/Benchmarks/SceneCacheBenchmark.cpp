@@ -0,0 +1,224 @@
+/*	Opening a scene cache (see SceneCache.h): how deflated caches' decompression scales from 1 to every hardware thread, in GB/s of
+	decompressed body, and how long opening a deflated cache takes against an uncompressed one of the same scene.
+
+	Usage: SceneCacheBenchmark [--smoke] [file.gltf|file.glb]...
+
+	Without files, a synthetic scene is written to the temp directory. Files are converted once, and their caches written to the temp
+	directory, so their own scene caches are left alone
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.h"
+#include "GltfConversion.h"
+#include "TestGeometry.h"
+#include "TestGltf.h"
+#include "ThreadPool.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string;
+using std::vector;
+
+// Any file age works, as long as opening passes the one the cache was written with
+static constexpr int64_t BENCHMARK_SOURCE_FILE_AGE = 1;
+
+// Uncompressed and deflated caches of one scene, in the temp directory
+struct BenchmarkCaches
+{
+	string name;
+	string uncompressed_path;
+	string deflated_path;
+};
+
+// Converts each of in_options.files (or a synthetic scene) and writes both caches of it
+vector<BenchmarkCaches> write_benchmark_caches(const BenchmarkOptions& in_options)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "SceneCacheBenchmark";
+	std::filesystem::create_directories(directory);
+
+	vector<string> files = in_options.files;
+	if (files.empty())
+	{
+		TestGltfBuilder builder;
+		const uint32_t mesh_count = in_options.smoke ? 4 : 48;
+		for (uint32_t mesh_idx = 0; mesh_idx < mesh_count; ++mesh_idx)
+		{
+			builder.AddNode(builder.AddMesh({ builder.AddGridPrimitive(in_options.smoke ? 8 : 128, (float) mesh_idx) }), (float) mesh_idx * 12.0f);
+		}
+
+		const string path = (directory / "scene.gltf").string();
+		if (!builder.Write(path))
+		{
+			printf("SceneCacheBenchmark: Failed to write %s\n", path.c_str());
+			exit(1);
+		}
+		files.push_back(path);
+	}
+
+	ThreadPool thread_pool((std::max)(std::thread::hardware_concurrency(), 1u) - 1);
+	vector<BenchmarkCaches> caches;
+	for (const string& file : files)
+	{
+		GltfGeometry geometry;
+		if (!load_gltf_geometry(GltfGeometryDesc { .file = file.c_str(), .use_scene_cache = false, .thread_pool = &thread_pool }, geometry))
+		{
+			printf("SceneCacheBenchmark: Failed to load %s\n", file.c_str());
+			exit(1);
+		}
+
+		const string stem = std::filesystem::path(file).stem().string();
+		const BenchmarkCaches file_caches =
+		{
+			.name = file,
+			.uncompressed_path = (directory / (stem + ".uncompressed.cooked")).string(),
+			.deflated_path = (directory / (stem + ".deflated.cooked")).string(),
+		};
+
+		const vector<GltfMeshInstance> instances(geometry.instances.begin(), geometry.instances.end());
+		for (const auto& [path, compression] : { std::pair(file_caches.uncompressed_path, SceneCacheCompression::None), std::pair(file_caches.deflated_path, SceneCacheCompression::Deflate) })
+		{
+			if (!write_scene_cache(path, BENCHMARK_SOURCE_FILE_AGE, geometry.meshes, instances, 0, compression, &thread_pool))
+			{
+				printf("SceneCacheBenchmark: Failed to write %s\n", path.c_str());
+				exit(1);
+			}
+		}
+		caches.push_back(file_caches);
+	}
+	return caches;
+}
+
+// Opens in_path, exiting if that fails since every case would be timing the failure
+void open_cache(const string& in_path, ThreadPool* in_thread_pool, SceneCache& out_cache)
+{
+	if (!out_cache.Open(in_path, BENCHMARK_SOURCE_FILE_AGE, VertexFormat::Compact, nullptr, in_thread_pool))
+	{
+		printf("SceneCacheBenchmark: Failed to open %s\n", in_path.c_str());
+		exit(1);
+	}
+}
+
+// Decompression GB/s on 1 to N threads. The meshes don't depend on the thread count, which is checked against the uncompressed cache's
+void BenchmarkDecompressionThreadScaling(const BenchmarkOptions& in_options)
+{
+	const int repetitions = in_options.smoke ? 1 : 5;
+	for (const BenchmarkCaches& caches : write_benchmark_caches(in_options))
+	{
+		SceneCache uncompressed_cache;
+		open_cache(caches.uncompressed_path, nullptr, uncompressed_cache);
+
+		SceneCache deflated_cache;
+		open_cache(caches.deflated_path, nullptr, deflated_cache);
+		printf(
+			"  %s: %.2f MB body, %.2f MB deflated (%.1f%%)\n",
+			caches.name.c_str(),
+			deflated_cache.GetBodySize() / (1024.0 * 1024.0),
+			deflated_cache.GetFileSize() / (1024.0 * 1024.0),
+			deflated_cache.GetBodySize() > 0 ? 100.0 * deflated_cache.GetFileSize() / deflated_cache.GetBodySize() : 0.0
+		);
+
+		double single_thread_time = 0.0;
+		for (const size_t thread_count : get_benchmark_thread_counts())
+		{
+			ThreadPool thread_pool(thread_count - 1);
+
+			// Open times decompression itself, apart from mapping the file and validating its tables. The first Open warms up, like benchmark_min_time
+			open_cache(caches.deflated_path, &thread_pool, deflated_cache);
+			double decompress_time = 0.0;
+			for (int repetition = 0; repetition < repetitions; ++repetition)
+			{
+				open_cache(caches.deflated_path, &thread_pool, deflated_cache);
+				const double time = deflated_cache.GetDecompressTime();
+				decompress_time = repetition == 0 ? time : (std::min)(decompress_time, time);
+			}
+
+			const vector<GltfMeshView>& meshes = deflated_cache.GetMeshes();
+			bool meshes_match = meshes.size() == uncompressed_cache.GetMeshes().size();
+			for (size_t mesh_idx = 0; meshes_match && mesh_idx < meshes.size(); ++mesh_idx)
+			{
+				meshes_match = MeshEqual(meshes[mesh_idx], uncompressed_cache.GetMeshes()[mesh_idx]);
+			}
+			if (!meshes_match)
+			{
+				printf("SceneCacheBenchmark: Decompressing on %zu threads gave different meshes than the uncompressed cache\n", thread_count);
+				exit(1);
+			}
+
+			single_thread_time = thread_count == 1 ? decompress_time : single_thread_time;
+			printf(
+				"    %3zu threads %10.2f ms %7.2f GB/s  %5.2fx speedup\n",
+				thread_count,
+				decompress_time,
+				get_gigabytes_per_second((double) deflated_cache.GetBodySize(), decompress_time),
+				decompress_time > 0.0 ? single_thread_time / decompress_time : 0.0
+			);
+		}
+	}
+}
+
+// Sums every byte of the cache's meshes, as uploading them would read them. An uncompressed cache's Open only maps the file, this faults it in
+uint64_t read_cache_meshes(const SceneCache& in_cache)
+{
+	uint64_t sum = 0;
+	for (const GltfMeshView& mesh : in_cache.GetMeshes())
+	{
+		for (const span<const uint8_t> section : mesh.GetSections())
+		{
+			for (const uint8_t byte : section)
+			{
+				sum += byte;
+			}
+		}
+	}
+	return sum;
+}
+
+// Opening each cache on every hardware thread and reading its meshes, which is what a load does with it before uploading
+void BenchmarkCompressedVsUncompressed(const BenchmarkOptions& in_options)
+{
+	const int repetitions = in_options.smoke ? 1 : 5;
+	ThreadPool thread_pool((std::max)(std::thread::hardware_concurrency(), 1u) - 1);
+	for (const BenchmarkCaches& caches : write_benchmark_caches(in_options))
+	{
+		printf("  %s: %zu threads\n", caches.name.c_str(), thread_pool.GetThreadCount() + 1);
+
+		double uncompressed_time = 0.0;
+		for (const auto& [path, name] : { std::pair(caches.uncompressed_path, "uncompressed"), std::pair(caches.deflated_path, "deflated") })
+		{
+			size_t file_size = 0;
+			const double time = benchmark_min_time(repetitions, [&]()
+			{
+				SceneCache cache;
+				open_cache(path, &thread_pool, cache);
+				file_size = cache.GetFileSize();
+				benchmark_keep(read_cache_meshes(cache));
+			});
+
+			uncompressed_time = path == caches.uncompressed_path ? time : uncompressed_time;
+			printf(
+				"    %-14s %8.2f MB %10.3f ms  %6.2fx the uncompressed time\n",
+				name,
+				file_size / (1024.0 * 1024.0),
+				time,
+				uncompressed_time > 0.0 ? time / uncompressed_time : 0.0
+			);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkDecompressionThreadScaling, options);
+	BENCHMARK_RUN(BenchmarkCompressedVsUncompressed, options);
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*	streaming_memcpy (see StreamingCopy.h) against memcpy on a single thread, in GB/s copied, from a few hundred bytes to well past the
+	last level cache. Destinations here are ordinary cached memory, where non-temporal stores only pay off once a copy stops fitting in the
+	cache. Into a write-combined upload heap they pay off much sooner, see UploadHeapBenchmark (Windows only).
+
+	Usage: StreamingCopyBenchmark [--smoke]
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Benchmark.h"
+#include "StreamingCopy.h"
+
+using std::vector;
+
+// Copies in_size byte blocks from in_source into consecutive blocks of out_dest until in_total_size bytes are copied, wrapping around
+template<typename CopyFunction>
+void copy_blocks(uint8_t* out_dest, const size_t in_dest_size, const uint8_t* in_source, const size_t in_size, const size_t in_total_size, CopyFunction&& in_copy)
+{
+	size_t dest_offset = 0;
+	for (size_t copied_size = 0; copied_size < in_total_size; copied_size += in_size)
+	{
+		if (dest_offset + in_size > in_dest_size)
+		{
+			dest_offset = 0;
+		}
+		in_copy(out_dest + dest_offset, in_source, in_size);
+		dest_offset += in_size;
+	}
+}
+
+// Each size is copied over and over into a destination 4x the size of the copy (at least 1MB), at the given misalignment from 64 bytes
+void BenchmarkCopySizes(const BenchmarkOptions& in_options)
+{
+	const vector<size_t> sizes = in_options.smoke
+		? vector<size_t> { 256, 64 * 1024 }
+		: vector<size_t> { 256, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+	const size_t total_size = in_options.smoke ? 1024 * 1024 : 1024 * 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 3;
+
+#if !STREAMING_COPY_SSE2
+	printf("  SSE2 isn't available, both columns are memcpy\n");
+#endif
+	for (const size_t size : sizes)
+	{
+		const vector<uint8_t> source(size + 64, 0x5A);
+		const size_t dest_size = (std::max)(size * 4, (size_t) 1024 * 1024);
+		vector<uint8_t> dest(dest_size + 64);
+		for (const size_t misalignment : { 0, 8 })
+		{
+			uint8_t* dest_start = dest.data() + ((64 - (reinterpret_cast<uintptr_t>(dest.data()) & 63)) & 63) + misalignment;
+			const size_t copy_size = (std::max)(total_size, size);
+			std::fill(dest.begin(), dest.end(), 0);
+			const double streaming_time = benchmark_min_time(repetitions, [&]()
+			{
+				copy_blocks(dest_start, dest_size - 64, source.data(), size, copy_size, streaming_memcpy);
+			});
+			const bool streaming_matches = memcmp(dest_start, source.data(), size) == 0;
+
+			std::fill(dest.begin(), dest.end(), 0);
+			const double memcpy_time = benchmark_min_time(repetitions, [&]()
+			{
+				copy_blocks(dest_start, dest_size - 64, source.data(), size, copy_size, [](void* out_dest, const void* in_source, const size_t in_size)
+				{
+					memcpy(out_dest, in_source, in_size);
+				});
+			});
+
+			if (!streaming_matches || memcmp(dest_start, source.data(), size) != 0)
+			{
+				printf("StreamingCopyBenchmark: %zu byte copies don't match their source\n", size);
+				exit(1);
+			}
+
+			char name[64];
+			snprintf(name, sizeof(name), size < 1024 ? "%zu B%s" : "%zu KB%s", size < 1024 ? size : size / 1024, misalignment > 0 ? " misaligned" : "");
+			printf(
+				"  %-20s streaming %8.2f ms %7.2f GB/s   memcpy %8.2f ms %7.2f GB/s   %5.2fx\n",
+				name,
+				streaming_time,
+				get_gigabytes_per_second((double) copy_size, streaming_time),
+				memcpy_time,
+				get_gigabytes_per_second((double) copy_size, memcpy_time),
+				streaming_time > 0.0 ? memcpy_time / streaming_time : 0.0
+			);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkCopySizes, options);
+	return 0;
+}
@@ -0,0 +1,166 @@
+/*	Textures per second through the texture cooking path of a load (decode, mip generation, then block compression as the scene's
+	TextureCompression allows), spread across 1 to N threads one texture per job, the way GltfScene::Load batches them.
+
+	Usage: TextureProcessingBenchmark [--smoke] [image.png|image.jpg]...
+
+	Without files, synthetic PNGs are encoded in memory
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "TextureCompression.h"
+#include "TextureProcessing.h"
+#include "ThreadPool.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "microprofile/stb/stb_image.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "microprofile/stb/stb_image_write.h"
+
+#define STB_DXT_IMPLEMENTATION
+#include "microprofile/stb/stb_dxt.h"
+
+using std::optional;
+using std::string;
+using std::vector;
+
+// Smooth gradients plus some noise, so it compresses about as well as a real texture and block compression has work to do
+vector<uint8_t> make_synthetic_png(const uint32_t in_size, const uint32_t in_seed)
+{
+	vector<uint8_t> texels((size_t) in_size * in_size * TEXTURE_BYTES_PER_TEXEL);
+	uint32_t noise = in_seed * 2654435761u + 1;
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			const float u = (float) x / in_size;
+			const float v = (float) y / in_size;
+			uint8_t* texel = texels.data() + ((size_t) y * in_size + x) * TEXTURE_BYTES_PER_TEXEL;
+			texel[0] = (uint8_t) (127.5f + 127.5f * std::sin(11.0f * u + in_seed));
+			texel[1] = (uint8_t) (127.5f + 127.5f * std::cos(7.0f * v - in_seed));
+			texel[2] = (uint8_t) ((x ^ y) + (noise >> 28));
+			texel[3] = 255;
+		}
+	}
+
+	vector<uint8_t> png;
+	stbi_write_png_to_func([](void* io_context, void* in_data, int in_size)
+	{
+		vector<uint8_t>& out_png = *static_cast<vector<uint8_t>*>(io_context);
+		out_png.insert(out_png.end(), (const uint8_t*) in_data, (const uint8_t*) in_data + in_size);
+	}, &png, (int) in_size, (int) in_size, TEXTURE_BYTES_PER_TEXEL, texels.data(), (int) (in_size * TEXTURE_BYTES_PER_TEXEL));
+	return png;
+}
+
+vector<uint8_t> read_file(const string& in_path)
+{
+	vector<uint8_t> data;
+	FILE* file = fopen(in_path.c_str(), "rb");
+	if (file)
+	{
+		uint8_t chunk[64 * 1024];
+		for (size_t read_size; (read_size = fread(chunk, 1, sizeof(chunk), file)) > 0; )
+		{
+			data.insert(data.end(), chunk, chunk + read_size);
+		}
+		fclose(file);
+	}
+	return data;
+}
+
+// Same as GltfScene's cook_texture for a color texture. Compression runs on the calling thread, since textures are already spread across threads
+optional<TextureData> cook_texture(span<const uint8_t> in_encoded_data, const TextureCompression in_compression)
+{
+	optional<TextureData> texture = decode_image(in_encoded_data, true);
+	if (texture)
+	{
+		generate_mips(*texture);
+		const TextureFormat format = choose_texture_format(*texture, TextureUsage::Color, in_compression);
+		if (format != TextureFormat::RGBA8)
+		{
+			texture = compress_texture(*texture, format);
+		}
+	}
+	return texture;
+}
+
+void BenchmarkTextureCookThreadScaling(const BenchmarkOptions& in_options)
+{
+	vector<vector<uint8_t>> encoded_textures;
+	for (const string& file : in_options.files)
+	{
+		encoded_textures.push_back(read_file(file));
+	}
+	if (encoded_textures.empty())
+	{
+		const uint32_t texture_count = in_options.smoke ? 2 : 16;
+		for (uint32_t texture_idx = 0; texture_idx < texture_count; ++texture_idx)
+		{
+			encoded_textures.push_back(make_synthetic_png(in_options.smoke ? 64 : 512, texture_idx));
+		}
+	}
+
+	size_t encoded_size = 0;
+	for (const vector<uint8_t>& encoded_texture : encoded_textures)
+	{
+		encoded_size += encoded_texture.size();
+	}
+	printf("  %zu textures, %.2f MB encoded\n", encoded_textures.size(), encoded_size / (1024.0 * 1024.0));
+
+	const int repetitions = in_options.smoke ? 1 : 3;
+	const std::pair<TextureCompression, const char*> compressions[] =
+	{
+		{ TextureCompression::None, "decode + mips" },
+		{ TextureCompression::Fast, "+ BC1" },
+		{ TextureCompression::HighQuality, "+ BC7" },
+	};
+	for (const auto& [compression, compression_name] : compressions)
+	{
+		double single_thread_time = 0.0;
+		for (const size_t thread_count : get_benchmark_thread_counts())
+		{
+			ThreadPool thread_pool(thread_count - 1);
+			vector<optional<TextureData>> textures(encoded_textures.size());
+			const double time = benchmark_min_time(repetitions, [&]()
+			{
+				thread_pool.ParallelFor(encoded_textures.size(), [&](size_t texture_idx)
+				{
+					textures[texture_idx] = cook_texture(encoded_textures[texture_idx], compression);
+				});
+			});
+
+			for (const optional<TextureData>& texture : textures)
+			{
+				if (!texture)
+				{
+					printf("TextureProcessingBenchmark: Failed to decode a texture\n");
+					exit(1);
+				}
+			}
+
+			single_thread_time = thread_count == 1 ? time : single_thread_time;
+			printf(
+				"    %-14s %3zu threads %10.2f ms  %8.2f textures/s  %5.2fx speedup\n",
+				compression_name,
+				thread_count,
+				time,
+				time > 0.0 ? encoded_textures.size() * 1000.0 / time : 0.0,
+				time > 0.0 ? single_thread_time / time : 0.0
+			);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkTextureCookThreadScaling, options);
+	return 0;
+}
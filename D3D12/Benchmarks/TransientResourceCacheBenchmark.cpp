@@ -0,0 +1,172 @@
+/*	TransientResourceCache as TransientResourcePool uses it, fed the outputs of a deferred renderer's graph every frame while a simulated GPU
+	completes each frame's fence a couple of frames later. Reports how often acquires hit the pool and how many bytes that saved allocating,
+	under a steady resolution, occasional resizes, a window being dragged to a new size every frame, and a debug view toggled on and off.
+	Also times Acquire/Add/Evict per acquire.
+
+	Usage: TransientResourceCacheBenchmark [--smoke]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Benchmark.h"
+#include "TransientResourceCache.h"
+
+using std::vector;
+
+// Frames the simulated GPU lags behind the CPU, like the app's frame_count - 1 frames in flight
+static constexpr uint64_t BENCHMARK_FRAME_LATENCY = 2;
+
+// Same as TRANSIENT_RESOURCE_POOL_MAX_UNUSED_FRAMES, which isn't included from RenderGraph.h as that needs d3d12.h
+static constexpr uint64_t BENCHMARK_MAX_UNUSED_FRAMES = 8;
+
+// Stands in for RenderGraphTextureDesc: a render target's size and bytes per pixel
+struct BenchmarkTextureDesc
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t bytes_per_pixel = 0;
+
+	bool operator==(const BenchmarkTextureDesc& in_other) const
+	{
+		return width == in_other.width && height == in_other.height && bytes_per_pixel == in_other.bytes_per_pixel;
+	}
+
+	uint64_t Hash() const { return hash_combine(hash_combine(width, height), bytes_per_pixel); }
+	uint64_t GetSize() const { return (uint64_t) width * height * bytes_per_pixel; }
+};
+
+// Stands in for a pooled texture
+struct BenchmarkTexture
+{
+	uint64_t id = 0;
+};
+
+using BenchmarkCache = TransientResourceCache<BenchmarkTextureDesc, BenchmarkTexture>;
+
+// One frame's graph outputs at in_width x in_height, with the debug view's if it's on
+vector<BenchmarkTextureDesc> get_frame_outputs(const uint32_t in_width, const uint32_t in_height, const bool in_debug_view)
+{
+	vector<BenchmarkTextureDesc> outputs =
+	{
+		{ in_width, in_height, 8 },			// Visibility buffer
+		{ in_width, in_height, 4 },			// Depth
+		{ in_width, in_height, 4 },			// Albedo
+		{ in_width, in_height, 4 },			// Normals
+		{ in_width, in_height, 8 },			// Lighting
+		{ in_width / 2, in_height / 2, 8 },	// Bloom, ping-ponged
+		{ in_width / 2, in_height / 2, 8 },
+		{ in_width / 4, in_height / 4, 8 },
+		{ in_width, in_height, 4 },			// Tonemapped
+	};
+	if (in_debug_view)
+	{
+		outputs.push_back({ in_width, in_height, 4 });
+		outputs.push_back({ in_width, in_height, 16 });
+	}
+	return outputs;
+}
+
+// Resolution and debug view of each frame of a scenario
+struct BenchmarkFrame
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	bool debug_view = false;
+};
+
+struct BenchmarkScenario
+{
+	const char* name;
+	vector<BenchmarkFrame> frames;
+};
+
+vector<BenchmarkScenario> get_benchmark_scenarios(const size_t in_frame_count)
+{
+	BenchmarkScenario steady = { .name = "steady 1080p" };
+	BenchmarkScenario resizes = { .name = "resize every 250 frames" };
+	BenchmarkScenario window_drag = { .name = "window drag" };
+	BenchmarkScenario debug_view = { .name = "debug view every 30 frames" };
+	for (size_t frame_idx = 0; frame_idx < in_frame_count; ++frame_idx)
+	{
+		steady.frames.push_back({ 1920, 1080, false });
+
+		const bool is_large = (frame_idx / 250) % 2 == 0;
+		resizes.frames.push_back({ is_large ? 2560u : 1280u, is_large ? 1440u : 720u, false });
+
+		// A new size every frame for 60 frames out of every 500, like dragging the window's corner
+		const size_t drag_frame = frame_idx % 500;
+		const uint32_t drag_offset = drag_frame < 60 ? (uint32_t) (drag_frame + 1) * 8 : 0;
+		window_drag.frames.push_back({ 1920 - drag_offset, 1080 - drag_offset / 2, false });
+
+		debug_view.frames.push_back({ 1920, 1080, (frame_idx / 30) % 2 == 1 });
+	}
+	return { steady, resizes, window_drag, debug_view };
+}
+
+// Runs every frame of in_scenario through a fresh cache, returning its stats
+TransientResourceStats run_scenario(const BenchmarkScenario& in_scenario)
+{
+	BenchmarkCache cache(BENCHMARK_MAX_UNUSED_FRAMES);
+	uint64_t next_id = 0;
+	for (size_t frame_idx = 0; frame_idx < in_scenario.frames.size(); ++frame_idx)
+	{
+		// Frames start at 1, like fence values
+		const uint64_t frame_index = frame_idx + 1;
+		const uint64_t completed_frame_index = frame_index > BENCHMARK_FRAME_LATENCY ? frame_index - BENCHMARK_FRAME_LATENCY : 0;
+		cache.Evict(frame_index, completed_frame_index);
+
+		const BenchmarkFrame& frame = in_scenario.frames[frame_idx];
+		for (const BenchmarkTextureDesc& desc : get_frame_outputs(frame.width, frame.height, frame.debug_view))
+		{
+			const uint64_t hash = desc.Hash();
+			if (!cache.Acquire(hash, desc, frame_index, completed_frame_index))
+			{
+				cache.Add(hash, desc, BenchmarkTexture { .id = next_id++ }, desc.GetSize(), frame_index);
+			}
+		}
+	}
+	return cache.GetStats();
+}
+
+// Each scenario's hit rate and memory, and how long pooling took per acquire
+void BenchmarkScenarios(const BenchmarkOptions& in_options)
+{
+	const size_t frame_count = in_options.smoke ? 100 : 10000;
+	const int repetitions = in_options.smoke ? 1 : 5;
+	printf("  %zu frames each, GPU %llu frames behind, unused textures evicted after %llu frames\n",
+		frame_count,
+		(unsigned long long) BENCHMARK_FRAME_LATENCY,
+		(unsigned long long) BENCHMARK_MAX_UNUSED_FRAMES);
+
+	const vector<BenchmarkScenario> scenarios = get_benchmark_scenarios(frame_count);
+	for (size_t scenario_idx = 0; scenario_idx < scenarios.size(); ++scenario_idx)
+	{
+		const BenchmarkScenario& scenario = scenarios[scenario_idx];
+		TransientResourceStats stats;
+		const double time = benchmark_min_time(repetitions, [&]()
+		{
+			stats = run_scenario(scenario);
+		});
+
+		// At a steady resolution (the first scenario), each output needs a texture per frame the GPU can be behind plus the one being recorded
+		const size_t output_count = get_frame_outputs(1920, 1080, false).size();
+		if (scenario_idx == 0 && stats.allocation_count > output_count * (BENCHMARK_FRAME_LATENCY + 1))
+		{
+			printf("TransientResourceCacheBenchmark: A steady resolution allocated %llu textures\n", (unsigned long long) stats.allocation_count);
+			exit(1);
+		}
+
+		printf("  %s\n    ", scenario.name);
+		print_transient_resource_stats("textures", stats);
+		printf("    %.3f ms, %.1f ns per acquire\n", time, stats.acquire_count > 0 ? time * 1.0e6 / stats.acquire_count : 0.0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+	BENCHMARK_RUN(BenchmarkScenarios, options);
+	return 0;
+}
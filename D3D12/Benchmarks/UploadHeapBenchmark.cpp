@@ -0,0 +1,179 @@
+/*	Writing into a D3D12 upload heap (write-combined memory on most GPUs) the ways UploadManager and GpuBuffer could: Map/memcpy/Unmap around
+	every upload, against mapping once and keeping the pointer, and against a persistent mapping written with streaming_memcpy (see StreamingCopy.h).
+	Only the CPU side is measured, nothing is submitted to the GPU. Windows only, see StreamingCopyBenchmark for the same copies into cached memory.
+
+	Usage: UploadHeapBenchmark [--smoke]
+
+	Without a D3D12 device (e.g. on a headless build machine) it prints so and exits successfully
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <d3d12.h>
+#include <wrl.h>
+
+#include "Benchmark.h"
+#include "StreamingCopy.h"
+
+using Microsoft::WRL::ComPtr;
+using std::vector;
+
+// Exits on a failed D3D12 call, since every case after it would be timing the failure
+void check_hresult(const HRESULT in_result, const char* in_call)
+{
+	if (FAILED(in_result))
+	{
+		printf("UploadHeapBenchmark: %s failed: %x\n", in_call, (unsigned) in_result);
+		exit(1);
+	}
+}
+
+// A committed buffer in an upload heap, like UploadManager's staging buffers
+ComPtr<ID3D12Resource> create_upload_buffer(ID3D12Device* in_device, const uint64_t in_size)
+{
+	D3D12_HEAP_PROPERTIES heap_properties = {};
+	heap_properties.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+	D3D12_RESOURCE_DESC resource_desc = {};
+	resource_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resource_desc.Width = in_size;
+	resource_desc.Height = 1;
+	resource_desc.DepthOrArraySize = 1;
+	resource_desc.MipLevels = 1;
+	resource_desc.Format = DXGI_FORMAT_UNKNOWN;
+	resource_desc.SampleDesc.Count = 1;
+	resource_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	ComPtr<ID3D12Resource> buffer;
+	check_hresult(
+		in_device->CreateCommittedResource(
+			&heap_properties,
+			D3D12_HEAP_FLAG_NONE,
+			&resource_desc,
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(&buffer)
+		),
+		"CreateCommittedResource"
+	);
+	return buffer;
+}
+
+// Maps in_buffer for writing only, so the driver doesn't have to make its contents visible to the CPU first
+uint8_t* map_for_writing(ID3D12Resource* in_buffer)
+{
+	const D3D12_RANGE read_range = { 0, 0 };
+	void* mapped_data = nullptr;
+	check_hresult(in_buffer->Map(0, &read_range, &mapped_data), "Map");
+	return static_cast<uint8_t*>(mapped_data);
+}
+
+// Copies in_size byte uploads from in_source into consecutive ranges of an in_buffer_size byte buffer until in_total_size bytes are copied
+template<typename UploadFunction>
+void upload_blocks(const uint64_t in_buffer_size, const size_t in_size, const size_t in_total_size, UploadFunction&& in_upload)
+{
+	uint64_t offset = 0;
+	for (size_t uploaded_size = 0; uploaded_size < in_total_size; uploaded_size += in_size)
+	{
+		if (offset + in_size > in_buffer_size)
+		{
+			offset = 0;
+		}
+		in_upload(offset);
+		offset += in_size;
+	}
+}
+
+// Each upload size through the three ways of writing the heap
+void BenchmarkMapping(ID3D12Device* in_device, const BenchmarkOptions& in_options)
+{
+	const vector<size_t> sizes = in_options.smoke
+		? vector<size_t> { 4 * 1024, 64 * 1024 }
+		: vector<size_t> { 256, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+	const size_t total_size = in_options.smoke ? 1024 * 1024 : 1024 * 1024 * 1024;
+	const int repetitions = in_options.smoke ? 1 : 3;
+	const uint64_t buffer_size = in_options.smoke ? 1024 * 1024 : 64 * 1024 * 1024;
+
+	const ComPtr<ID3D12Resource> buffer = create_upload_buffer(in_device, buffer_size);
+	const vector<uint8_t> source(sizes.back(), 0x5A);
+	for (const size_t size : sizes)
+	{
+		const size_t copy_size = (std::max)(total_size, size);
+
+		// Written ranges are passed to Unmap, like a caller that knows what it wrote would
+		const double map_time = benchmark_min_time(repetitions, [&]()
+		{
+			upload_blocks(buffer_size, size, copy_size, [&](const uint64_t in_offset)
+			{
+				uint8_t* mapped_data = map_for_writing(buffer.Get());
+				memcpy(mapped_data + in_offset, source.data(), size);
+				const D3D12_RANGE written_range = { (SIZE_T) in_offset, (SIZE_T) (in_offset + size) };
+				buffer->Unmap(0, &written_range);
+			});
+		});
+
+		uint8_t* persistent_data = map_for_writing(buffer.Get());
+		const double persistent_time = benchmark_min_time(repetitions, [&]()
+		{
+			upload_blocks(buffer_size, size, copy_size, [&](const uint64_t in_offset)
+			{
+				memcpy(persistent_data + in_offset, source.data(), size);
+			});
+		});
+		const double streaming_time = benchmark_min_time(repetitions, [&]()
+		{
+			upload_blocks(buffer_size, size, copy_size, [&](const uint64_t in_offset)
+			{
+				streaming_memcpy(persistent_data + in_offset, source.data(), size);
+			});
+		});
+
+		// Reading back write-combined memory is slow, but only the first upload is checked
+		const bool uploads_match = memcmp(persistent_data, source.data(), size) == 0;
+		buffer->Unmap(0, nullptr);
+		if (!uploads_match)
+		{
+			printf("UploadHeapBenchmark: %zu byte uploads don't match their source\n", size);
+			exit(1);
+		}
+
+		char name[32];
+		snprintf(name, sizeof(name), size < 1024 ? "%zu B" : "%zu KB", size < 1024 ? size : size / 1024);
+		printf(
+			"  %-9s map/unmap %8.2f ms %7.2f GB/s   persistent %8.2f ms %7.2f GB/s   persistent streaming %8.2f ms %7.2f GB/s\n",
+			name,
+			map_time,
+			get_gigabytes_per_second((double) copy_size, map_time),
+			persistent_time,
+			get_gigabytes_per_second((double) copy_size, persistent_time),
+			streaming_time,
+			get_gigabytes_per_second((double) copy_size, streaming_time)
+		);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const BenchmarkOptions options = parse_benchmark_arguments(argc, argv);
+
+	ComPtr<ID3D12Device> device;
+	if (FAILED(D3D12CreateDevice(nullptr, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device))))
+	{
+		printf("UploadHeapBenchmark: No D3D12 device, skipping\n");
+		return 0;
+	}
+
+#if !STREAMING_COPY_SSE2
+	printf("SSE2 isn't available, streaming_memcpy is memcpy\n");
+#endif
+	printf("BenchmarkMapping\n");
+	BenchmarkMapping(device.Get(), options);
+	return 0;
+}
@@ -0,0 +1,317 @@
+/*	Headless asset cooker. Runs the CPU half of GltfScene::Load (buffer loading, meshopt decoding, instance extraction and mesh conversion)
+	on build machines, writing the same scene cache (<file>.cooked) the app would otherwise write on its first load. Needs no GPU, and builds on Linux.
+
+	Usage: Cooker [--full] [--uncompressed] [--force] [--report] [--threads <count>] <file.gltf|file.glb>...
+
+	Every cooked file reports its mesh memory and vertex cache statistics (ACMR/ATVR before and after optimize_mesh). --report converts and
+	reports without writing caches, so it can be run over shipped assets. Caches whose source content hash matches are skipped. Since file ages differ from machine to machine, the hash is also what lets the app
+	pick up a cache cooked somewhere else (see SceneCache::Open). Textures aren't cooked here, the app still cooks them into its texture cache
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GltfConversion.h"
+#include "SceneCache.h"
+#include "ThreadPool.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string;
+using std::vector;
+
+struct CookerOptions
+{
+	vector<string> files;
+
+	// Must match GltfInitData::vertex_format, caches written with another format are rejected at load
+	VertexFormat vertex_format = VertexFormat::Compact;
+
+	// Cooked caches are shipped, so they're smaller on disk by default. See SceneCacheCompression
+	SceneCacheCompression compression = SceneCacheCompression::Deflate;
+
+	// Cook even if the cache is up to date
+	bool force = false;
+
+	// Convert and print each file's statistics, but don't write caches
+	bool report = false;
+
+	// Worker threads, on top of the main thread
+	size_t thread_count = (std::max)(std::thread::hardware_concurrency(), 2u) - 1;
+};
+
+enum class CookResult
+{
+	Cooked,
+	UpToDate,
+	Failed,
+};
+
+// Wall time of each stage for one file, in milliseconds
+struct CookTimes
+{
+	float parse = 0.0f;
+	float hash = 0.0f;
+	float load_buffers = 0.0f;
+	float decode = 0.0f;
+	float extract_instances = 0.0f;
+	float convert = 0.0f;
+	float write = 0.0f;
+
+	// CPU time (summed across threads) of each pass inside convert
+	PrimitiveProcessingTimes primitive_times;
+};
+
+static void print_usage()
+{
+	printf(
+		"Usage: Cooker [--full] [--uncompressed] [--force] [--report] [--threads <count>] <file.gltf|file.glb>...\n"
+		"  --full          Cook full precision vertices instead of VertexFormat::Compact\n"
+		"  --uncompressed  Write caches the app can map in place instead of deflating them\n"
+		"  --force         Cook even if the existing cache is up to date\n"
+		"  --report        Convert and print statistics without writing caches\n"
+		"  --threads       Worker thread count (default: hardware threads - 1)\n"
+	);
+}
+
+static bool parse_arguments(const int argc, char** argv, CookerOptions& out_options)
+{
+	for (int arg_idx = 1; arg_idx < argc; ++arg_idx)
+	{
+		const char* arg = argv[arg_idx];
+		if (strcmp(arg, "--full") == 0)
+		{
+			out_options.vertex_format = VertexFormat::Full;
+		}
+		else if (strcmp(arg, "--uncompressed") == 0)
+		{
+			out_options.compression = SceneCacheCompression::None;
+		}
+		else if (strcmp(arg, "--force") == 0)
+		{
+			out_options.force = true;
+		}
+		else if (strcmp(arg, "--report") == 0)
+		{
+			out_options.report = true;
+		}
+		else if (strcmp(arg, "--threads") == 0 && arg_idx + 1 < argc)
+		{
+			out_options.thread_count = (size_t) strtoul(argv[++arg_idx], nullptr, 10);
+		}
+		else if (strncmp(arg, "--", 2) == 0)
+		{
+			printf("Cooker: Unknown option %s\n", arg);
+			return false;
+		}
+		else
+		{
+			out_options.files.push_back(arg);
+		}
+	}
+	return !out_options.files.empty();
+}
+
+static CookResult cook_file(const string& in_file, const CookerOptions& in_options, ThreadPool& in_thread_pool, CookTimes& out_times)
+{
+	using milliseconds = std::chrono::duration<float, std::milli>;
+	auto stage_start_time = std::chrono::high_resolution_clock::now();
+	auto end_stage = [&](float& out_stage_time)
+	{
+		const auto now = std::chrono::high_resolution_clock::now();
+		out_stage_time = std::chrono::duration_cast<milliseconds>(now - stage_start_time).count();
+		stage_start_time = now;
+	};
+
+	cgltf_options options = {};
+	cgltf_data* data = nullptr;
+	if (cgltf_parse_file(&options, in_file.c_str(), &data) != cgltf_result_success)
+	{
+		printf("Cooker: Failed to parse %s\n", in_file.c_str());
+		return CookResult::Failed;
+	}
+	end_stage(out_times.parse);
+
+	const vector<string> source_files = get_gltf_source_files(*data, in_file);
+	const uint64_t source_content_hash = hash_file_contents(source_files);
+	if (source_content_hash == 0)
+	{
+		printf("Cooker: Failed to read the sources of %s\n", in_file.c_str());
+		cgltf_free(data);
+		return CookResult::Failed;
+	}
+
+	// Only the content hash counts, file ages differ between machines. 0 is never a valid file age
+	const string scene_cache_path = get_scene_cache_path(in_file.c_str());
+	SceneCache existing_cache;
+	const bool up_to_date = !in_options.force && !in_options.report
+		&& existing_cache.Open(scene_cache_path, 0, in_options.vertex_format, [&]() { return source_content_hash; }, &in_thread_pool)
+		&& existing_cache.IsCompressed() == (in_options.compression != SceneCacheCompression::None);
+	existing_cache.Close();
+	end_stage(out_times.hash);
+	if (up_to_date)
+	{
+		cgltf_free(data);
+		return CookResult::UpToDate;
+	}
+
+	if (cgltf_load_buffers(&options, data, in_file.c_str()) != cgltf_result_success)
+	{
+		printf("Cooker: Failed to load buffers of %s\n", in_file.c_str());
+		cgltf_free(data);
+		return CookResult::Failed;
+	}
+	end_stage(out_times.load_buffers);
+
+	// Unlike a load, a cache with zeroed out geometry would stick around, so this is fatal
+	if (!decode_meshopt_buffer_views(*data, &in_thread_pool))
+	{
+		printf("Cooker: Failed to decode meshopt compressed buffer views in %s\n", in_file.c_str());
+		cgltf_free(data);
+		return CookResult::Failed;
+	}
+	end_stage(out_times.decode);
+
+	GltfSceneLayout scene_layout = extract_scene_layout(*data);
+	dedupe_scene_layout(*data, scene_layout, &in_thread_pool);
+	end_stage(out_times.extract_instances);
+
+	GltfConvertedMeshes converted = convert_primitives(scene_layout.meshes, *data, in_options.vertex_format, &in_thread_pool);
+	out_times.primitive_times = converted.times;
+	cgltf_free(data);
+	data = nullptr;
+	end_stage(out_times.convert);
+
+	vector<GltfMeshView> meshes;
+	meshes.reserve(converted.meshes.size());
+	for (const GltfMeshData& mesh_data : converted.meshes)
+	{
+		meshes.push_back(mesh_data.GetView());
+	}
+
+	// The app compares against its own source file's age first, so a cache cooked on the same machine is picked up without hashing
+	const int64_t source_file_age = get_file_age(in_file.c_str());
+	if (!in_options.report
+		&& !write_scene_cache(scene_cache_path, source_file_age, meshes, scene_layout.instances, source_content_hash, in_options.compression, &in_thread_pool))
+	{
+		printf("Cooker: Failed to write %s\n", scene_cache_path.c_str());
+		return CookResult::Failed;
+	}
+	end_stage(out_times.write);
+
+	std::error_code error;
+	const uint64_t cache_size = in_options.report ? 0 : std::filesystem::file_size(scene_cache_path, error);
+	const GltfMeshMemory memory = get_mesh_memory(meshes);
+	printf(
+		"Cooker: %s: %zu meshes, %zu instances, %.2f MB body, %.2f MB on disk\n"
+		"  memory: indices %.2f MB (%.2f MB as 32-bit, %.1f%% saved, %zu of %zu meshes 16-bit), vertices %.2f MB, meshlets and lods %.2f MB\n"
+		"  vertex cache (%u entry FIFO): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n"
+		"  parse %.2f ms, hash %.2f ms, load buffers %.2f ms, decode %.2f ms, extract instances %.2f ms, convert %.2f ms, write %.2f ms\n"
+		"  convert CPU time: convert + index widening %.2f ms, optimize %.2f ms, meshlets %.2f ms, lods %.2f ms, cook %.2f ms\n",
+		in_file.c_str(),
+		meshes.size(),
+		scene_layout.instances.size(),
+		scene_cache_body_size(meshes, scene_layout.instances) / (1024.0f * 1024.0f),
+		error ? 0.0f : cache_size / (1024.0f * 1024.0f),
+		memory.index_size / (1024.0f * 1024.0f),
+		memory.wide_index_size / (1024.0f * 1024.0f),
+		memory.GetIndexSavings() * 100.0f,
+		memory.narrow_index_mesh_count,
+		memory.mesh_count,
+		memory.vertex_size / (1024.0f * 1024.0f),
+		memory.meshlet_size / (1024.0f * 1024.0f),
+		VERTEX_CACHE_STATS_FIFO_SIZE,
+		converted.unoptimized_stats.GetACMR(),
+		converted.optimized_stats.GetACMR(),
+		converted.unoptimized_stats.GetATVR(),
+		converted.optimized_stats.GetATVR(),
+		out_times.parse,
+		out_times.hash,
+		out_times.load_buffers,
+		out_times.decode,
+		out_times.extract_instances,
+		out_times.convert,
+		out_times.write,
+		out_times.primitive_times.convert,
+		out_times.primitive_times.optimize,
+		out_times.primitive_times.meshlets,
+		out_times.primitive_times.lods,
+		out_times.primitive_times.cook
+	);
+	return CookResult::Cooked;
+}
+
+int main(int argc, char** argv)
+{
+	CookerOptions options;
+	if (!parse_arguments(argc, argv, options))
+	{
+		print_usage();
+		return 1;
+	}
+
+	const auto cook_start_time = std::chrono::high_resolution_clock::now();
+
+	// Files are cooked in parallel, and each file's meshes are converted in parallel on the same pool
+	ThreadPool thread_pool(options.thread_count);
+	vector<CookResult> results(options.files.size());
+	vector<CookTimes> times(options.files.size());
+	thread_pool.ParallelFor(options.files.size(), [&](size_t file_idx)
+	{
+		results[file_idx] = cook_file(options.files[file_idx], options, thread_pool, times[file_idx]);
+	});
+
+	size_t cooked_count = 0;
+	size_t up_to_date_count = 0;
+	size_t failed_count = 0;
+	CookTimes total_times;
+	for (size_t file_idx = 0; file_idx < options.files.size(); ++file_idx)
+	{
+		switch (results[file_idx])
+		{
+			case CookResult::Cooked:	++cooked_count;			break;
+			case CookResult::UpToDate:	++up_to_date_count;		break;
+			case CookResult::Failed:	++failed_count;			break;
+		}
+
+		total_times.parse += times[file_idx].parse;
+		total_times.hash += times[file_idx].hash;
+		total_times.load_buffers += times[file_idx].load_buffers;
+		total_times.decode += times[file_idx].decode;
+		total_times.extract_instances += times[file_idx].extract_instances;
+		total_times.convert += times[file_idx].convert;
+		total_times.write += times[file_idx].write;
+		total_times.primitive_times += times[file_idx].primitive_times;
+	}
+
+	using milliseconds = std::chrono::duration<float, std::milli>;
+	const float cook_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - cook_start_time).count();
+	printf(
+		"Cooker: %zu cooked, %zu up to date, %zu failed in %.2f ms on %zu threads\n"
+		"  totals: parse %.2f ms, hash %.2f ms, load buffers %.2f ms, decode %.2f ms, extract instances %.2f ms, convert %.2f ms (%.2f ms CPU), write %.2f ms\n",
+		cooked_count,
+		up_to_date_count,
+		failed_count,
+		cook_time,
+		thread_pool.GetThreadCount() + 1,
+		total_times.parse,
+		total_times.hash,
+		total_times.load_buffers,
+		total_times.decode,
+		total_times.extract_instances,
+		total_times.convert,
+		total_times.primitive_times.GetTotal(),
+		total_times.write
+	);
+
+	return failed_count > 0 ? 1 : 0;
+}
@@ -48,6 +48,57 @@ struct Vertex
 #endif
 };
 
+// Everything but position. Meshes store positions and attributes in separate streams,
+// so passes that only need positions (depth, visibility) only fetch the tightly packed position stream
+struct VertexAttributes
+{
+	float3 normal;
+	float3 color;
+	float2 texcoord;
+};
+
+#include "VertexCompression.h"
+
+// Meshlet limits. Common mesh shader guidance is 64 vertices and 126 triangles, rounded down to a multiple of 4 here
+static const uint MESHLET_MAX_VERTICES = 64;
+static const uint MESHLET_MAX_TRIANGLES = 124;
+
+// A cluster of up to MESHLET_MAX_TRIANGLES triangles referencing up to MESHLET_MAX_VERTICES vertices
+struct Meshlet
+{
+    // Into the mesh's meshlet vertex buffer, which holds indices into the mesh's vertex streams
+    uint vertex_offset;
+    uint vertex_count;
+
+    // Into the mesh's meshlet triangle buffer. Each triangle is 3 8-bit indices into this meshlet's vertices, packed into a uint
+    uint triangle_offset;
+    uint triangle_count;
+
+    // Bounding sphere, in mesh space
+    float3 center;
+    float radius;
+
+    // Normal cone, in mesh space. The meshlet is entirely backfacing from camera_position if
+    // dot(center - camera_position, cone_axis) >= cone_cutoff * length(center - camera_position) + radius * (1 + cone_cutoff)
+    // Meshlets that can't be cone culled have a zero cone_axis and a cone_cutoff of 1
+    float3 cone_axis;
+    float cone_cutoff;
+};
+
+// LOD 0 is the full detail mesh, each following LOD is simplified from the one before it
+static const uint MESH_MAX_LODS = 5;
+
+struct MeshLod
+{
+    // Range of the mesh's index buffer holding this LOD's triangles. All LODs share the mesh's vertex streams
+    uint index_offset;
+    uint index_count;
+
+    // Largest distance (in mesh space) this LOD's surface deviates from LOD 0. Never decreases from one LOD to the next
+    float error;
+    uint padding;
+};
+
 struct Viewport
 {
     float left;
@@ -56,13 +107,221 @@ struct Viewport
     float bottom;
 };
 
+// Marks an unused (or not yet resident) bindless resource slot
+static const uint INVALID_BINDLESS_INDEX = 0xFFFFFFFF;
+
+// glTF metallic-roughness material. Texture slots are bindless Texture2D indices, INVALID_BINDLESS_INDEX until the texture is resident
+struct GpuMaterialData
+{
+    float4 base_color_factor;
+    float3 emissive_factor;
+    float metallic_factor;
+    float roughness_factor;
+    float normal_scale;
+    float occlusion_strength;
+    float alpha_cutoff;
+
+    uint base_color_texture_index;
+    uint metallic_roughness_texture_index;
+    uint normal_texture_index;     // May be BC5 (XY only), see DecodeNormalMap
+    uint occlusion_texture_index;
+    uint emissive_texture_index;
+    uint padding[3];
+};
+
+// Instances whose mesh has no material use this as their material_index
+static const uint INVALID_MATERIAL_INDEX = 0xFFFFFFFF;
+
+// GpuInstanceData flags
+static const uint INSTANCE_FLAG_INDEX_16BIT = 1 << 0;
+static const uint INSTANCE_FLAG_COMPACT_VERTICES = 1 << 1;
+
 struct GpuInstanceData
 {
     float4x4 transform;
-    uint vertex_buffer_index;
-    uint index_buffer_index;
+
+    // Raw (ByteAddressBuffer) geometry pool page holding all of this instance's mesh data. Every *_offset below is a byte offset into it
+    uint geometry_buffer_index;
+    uint flags;
+
+    // Hold CompactVertexPosition/CompactVertexAttributes if INSTANCE_FLAG_COMPACT_VERTICES is set, otherwise float3/VertexAttributes
+    uint position_offset;
+    uint attribute_offset;
+
+    // Indices are 16 bit if INSTANCE_FLAG_INDEX_16BIT is set, otherwise 32 bit
+    uint index_offset;
+
+    // Mesh AABB that compact vertex positions are quantized against
+    float3 position_min;
+    float3 position_extent;
+
+    // Meshlets, and the meshlet vertices (uints) and packed meshlet triangles (uints) they reference
+    uint meshlet_offset;
+    uint meshlet_vertex_offset;
+    uint meshlet_triangle_offset;
+    uint meshlet_count;
+
+    // MeshLods, ordered from most to least detailed
+    uint lod_offset;
+    uint lod_count;
+
+    // StructuredBuffer<GpuMaterialData> holding this instance's material (INVALID_BINDLESS_INDEX if there isn't one), and the material's index in it
+    uint material_buffer_index;
+    uint material_index;
+};
+
+// World space bounds of an instance, at the same index as its GpuInstanceData. The bounding sphere shares the AABB's center
+struct GpuInstanceBounds
+{
+    float3 center;
+    float radius;
+
+    // Half the AABB's size along each axis
+    float3 extents;
+    uint padding;
 };
 
+static const uint INSTANCE_BOUNDS_STRIDE = 32;
+
+// Element strides for raw loads out of geometry pool pages
+static const uint GEOMETRY_POSITION_STRIDE = 12;
+static const uint GEOMETRY_ATTRIBUTE_STRIDE = 32;
+static const uint GEOMETRY_COMPACT_POSITION_STRIDE = 8;
+static const uint GEOMETRY_COMPACT_ATTRIBUTE_STRIDE = 12;
+static const uint GEOMETRY_MESHLET_STRIDE = 48;
+static const uint GEOMETRY_MESH_LOD_STRIDE = 16;
+
+#ifdef __cplusplus
+static_assert(sizeof(float3) == GEOMETRY_POSITION_STRIDE);
+static_assert(sizeof(VertexAttributes) == GEOMETRY_ATTRIBUTE_STRIDE);
+static_assert(sizeof(CompactVertexPosition) == GEOMETRY_COMPACT_POSITION_STRIDE);
+static_assert(sizeof(CompactVertexAttributes) == GEOMETRY_COMPACT_ATTRIBUTE_STRIDE);
+static_assert(sizeof(Meshlet) == GEOMETRY_MESHLET_STRIDE);
+static_assert(sizeof(MeshLod) == GEOMETRY_MESH_LOD_STRIDE);
+static_assert(sizeof(GpuInstanceBounds) == INSTANCE_BOUNDS_STRIDE);
+#endif
+
+#ifndef __cplusplus
+inline uint LoadIndex(GpuInstanceData instance, uint index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    if (instance.flags & INSTANCE_FLAG_INDEX_16BIT)
+    {
+        // Raw loads must be 4 byte aligned, so load the pair of indices containing ours
+        const uint packed_indices = geometry.Load(instance.index_offset + ((index * 2) & ~3u));
+        return (index & 1) ? (packed_indices >> 16) : (packed_indices & 0xFFFF);
+    }
+    return geometry.Load(instance.index_offset + index * 4);
+}
+
+// Only touches the position stream
+inline float3 LoadVertexPosition(GpuInstanceData instance, uint vertex_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    if (instance.flags & INSTANCE_FLAG_COMPACT_VERTICES)
+    {
+        const CompactVertexPosition compact_position = geometry.Load<CompactVertexPosition>(instance.position_offset + vertex_index * GEOMETRY_COMPACT_POSITION_STRIDE);
+        return DecodeCompactVertexPosition(compact_position, instance.position_min, instance.position_extent);
+    }
+
+    return geometry.Load<float3>(instance.position_offset + vertex_index * GEOMETRY_POSITION_STRIDE);
+}
+
+inline VertexAttributes LoadVertexAttributes(GpuInstanceData instance, uint vertex_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    if (instance.flags & INSTANCE_FLAG_COMPACT_VERTICES)
+    {
+        const CompactVertexAttributes compact_attributes = geometry.Load<CompactVertexAttributes>(instance.attribute_offset + vertex_index * GEOMETRY_COMPACT_ATTRIBUTE_STRIDE);
+        return DecodeCompactVertexAttributes(compact_attributes);
+    }
+
+    return geometry.Load<VertexAttributes>(instance.attribute_offset + vertex_index * GEOMETRY_ATTRIBUTE_STRIDE);
+}
+
+inline Meshlet LoadMeshlet(GpuInstanceData instance, uint meshlet_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    return geometry.Load<Meshlet>(instance.meshlet_offset + meshlet_index * GEOMETRY_MESHLET_STRIDE);
+}
+
+// Returns an index into the mesh's vertex streams
+inline uint LoadMeshletVertex(GpuInstanceData instance, Meshlet meshlet, uint meshlet_vertex_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    return geometry.Load(instance.meshlet_vertex_offset + (meshlet.vertex_offset + meshlet_vertex_index) * 4);
+}
+
+inline uint3 UnpackMeshletTriangle(uint packed_triangle)
+{
+    return uint3(packed_triangle & 0xFF, (packed_triangle >> 8) & 0xFF, (packed_triangle >> 16) & 0xFF);
+}
+
+// Returns indices into meshlet's vertices, see LoadMeshletVertex
+inline uint3 LoadMeshletTriangle(GpuInstanceData instance, Meshlet meshlet, uint meshlet_triangle_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    return UnpackMeshletTriangle(geometry.Load(instance.meshlet_triangle_offset + (meshlet.triangle_offset + meshlet_triangle_index) * 4));
+}
+
+// camera_position must be in the meshlet's mesh space
+inline bool IsMeshletBackfacing(Meshlet meshlet, float3 camera_position)
+{
+    const float3 view_vector = meshlet.center - camera_position;
+    return dot(view_vector, meshlet.cone_axis) >= meshlet.cone_cutoff * length(view_vector) + meshlet.radius * (1 + meshlet.cone_cutoff);
+}
+
+inline MeshLod LoadMeshLod(GpuInstanceData instance, uint lod_index)
+{
+    ByteAddressBuffer geometry = ResourceDescriptorHeap[instance.geometry_buffer_index];
+    return geometry.Load<MeshLod>(instance.lod_offset + lod_index * GEOMETRY_MESH_LOD_STRIDE);
+}
+
+// Picks the coarsest LOD whose error, projected to the screen, stays under max_screen_error.
+// error_to_screen_scale converts a mesh space error at distance 1 into screen units (e.g. viewport height / (2 * tan(fov_y / 2)), times the instance's scale)
+inline MeshLod SelectMeshLod(GpuInstanceData instance, float distance, float error_to_screen_scale, float max_screen_error)
+{
+    MeshLod selected_lod = LoadMeshLod(instance, 0);
+    for (uint lod_idx = 1; lod_idx < instance.lod_count; ++lod_idx)
+    {
+        const MeshLod lod = LoadMeshLod(instance, lod_idx);
+        if (lod.error * error_to_screen_scale > max_screen_error * max(distance, 1e-4))
+        {
+            break;
+        }
+        selected_lod = lod;
+    }
+    return selected_lod;
+}
+
+// Reassembles a full vertex from both streams
+inline Vertex LoadVertex(GpuInstanceData instance, uint vertex_index)
+{
+    const VertexAttributes attributes = LoadVertexAttributes(instance, vertex_index);
+
+    Vertex vertex;
+    vertex.position = LoadVertexPosition(instance, vertex_index);
+    vertex.normal = attributes.normal;
+    vertex.color = attributes.color;
+    vertex.texcoord = attributes.texcoord;
+    return vertex;
+}
+
+// Only valid if instance.material_buffer_index != INVALID_BINDLESS_INDEX. Check each texture slot against INVALID_BINDLESS_INDEX before sampling it
+inline GpuMaterialData LoadMaterial(GpuInstanceData instance)
+{
+    StructuredBuffer<GpuMaterialData> materials = ResourceDescriptorHeap[instance.material_buffer_index];
+    return materials[instance.material_index];
+}
+
+// Tangent space normal from a normal map texel. Only XY are read, since BC5 compressed normal maps don't store Z
+inline float3 DecodeNormalMap(float2 texel, float normal_scale)
+{
+    float2 xy = (texel * 2.0f - 1.0f) * normal_scale;
+    return normalize(float3(xy, sqrt(saturate(1.0f - dot(xy, xy)))));
+}
+#endif
+
 #ifdef __cplusplus
 #define INDIRECT_DRAW_ARGS D3D12_DRAW_ARGUMENTS
 #else
@@ -113,6 +372,6 @@ struct RayPayload
     float4 color;
 };
 
-static uint NUM_BINDLESS_DESCRIPTORS_PER_TYPE = 32768;
+static const uint NUM_BINDLESS_DESCRIPTORS_PER_TYPE = 32768;
 
 #endif // #ifndef HLSL_TYPES_H
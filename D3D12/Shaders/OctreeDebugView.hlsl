@@ -18,13 +18,10 @@ struct PsInput
 
 PsInput VertexShader(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
 {
-    //TODO: Common helper fn to fetch vertex from vertex_id and instance_id
 	StructuredBuffer<GpuInstanceData> instances = ResourceDescriptorHeap[draw_constants.instance_buffer_index];
 	GpuInstanceData instance = instances[0];
 
-    StructuredBuffer<uint> indices = ResourceDescriptorHeap[instance.index_buffer_index];
-    StructuredBuffer<Vertex> vertices = ResourceDescriptorHeap[instance.vertex_buffer_index];
-    Vertex vertex = vertices[indices[vertex_id]];
+    Vertex vertex = LoadVertex(instance, LoadIndex(instance, vertex_id));
 
 	StructuredBuffer<OctreeNode> octree = ResourceDescriptorHeap[global_constant_buffer.octree];
 	StructuredBuffer<uint> octree_leaf_nodes = ResourceDescriptorHeap[global_constant_buffer.octree_leaf_nodes];
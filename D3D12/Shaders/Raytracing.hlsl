@@ -72,15 +72,13 @@ void ClosestHit(inout RayPayload payload, in IntersectionAttributes attr)
 {
     StructuredBuffer<GpuInstanceData> instances = ResourceDescriptorHeap[global_constant_buffer.instance_buffer_index];
     GpuInstanceData instance = instances[0]; //TODO: Testing instances buffer
-    StructuredBuffer<uint> indices = ResourceDescriptorHeap[instance.index_buffer_index];
-    StructuredBuffer<Vertex> vertices = ResourceDescriptorHeap[instance.vertex_buffer_index];
 
     uint triangles_per_primitive = 3;
     uint first_index = PrimitiveIndex() * triangles_per_primitive;
 
-    Vertex vertex0 = vertices[indices[first_index + 0]];
-    Vertex vertex1 = vertices[indices[first_index + 1]];
-    Vertex vertex2 = vertices[indices[first_index + 2]];
+    Vertex vertex0 = LoadVertex(instance, LoadIndex(instance, first_index + 0));
+    Vertex vertex1 = LoadVertex(instance, LoadIndex(instance, first_index + 1));
+    Vertex vertex2 = LoadVertex(instance, LoadIndex(instance, first_index + 2));
     Vertex vertex_array[3] = { vertex0, vertex1, vertex2 };
     float3 hit_color = HIT_ATTRIBUTE(vertex_array, color, attr.barycentrics);
     float3 hit_normal = HIT_ATTRIBUTE(vertex_array, normal, attr.barycentrics);
@@ -0,0 +1,248 @@
+#ifndef VERTEX_COMPRESSION_H
+#define VERTEX_COMPRESSION_H
+
+// Expects Vertex, VertexAttributes and the float/uint vector types from HLSL_Types.h
+
+/*	Packed alternative to the float3 position + VertexAttributes streams (8 + 12 bytes vs. 12 + 32)
+	Positions are unorm16, relative to the owning mesh's AABB (see GpuInstanceData::position_min/position_extent)
+	Normals are octahedral encoded into two snorm16s
+	Texcoords are half precision
+	Color is rgba8 unorm
+*/
+struct CompactVertexPosition
+{
+	// x | y << 16
+	uint position_xy;
+	// z | unused << 16
+	uint position_z;
+};
+
+struct CompactVertexAttributes
+{
+	// x | y << 16
+	uint normal;
+	// u | v << 16
+	uint texcoord;
+	// r | g << 8 | b << 16 | a << 24
+	uint color;
+};
+
+#ifdef __cplusplus
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+inline uint16_t float_to_half(const float in_value)
+{
+	uint32_t bits;
+	memcpy(&bits, &in_value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+	// NaN stays NaN, Inf (and anything too large for a half) becomes Inf
+	if (abs_bits > 0x7F800000)
+	{
+		return (uint16_t) (sign | 0x7E00);
+	}
+	if (abs_bits >= 0x477FF000)
+	{
+		return (uint16_t) (sign | 0x7C00);
+	}
+
+	// Too small for a half denormal, flush to zero
+	if (abs_bits < 0x33000000)
+	{
+		return (uint16_t) sign;
+	}
+
+	const int32_t exponent = (int32_t) (abs_bits >> 23) - 127;
+	uint32_t mantissa = (abs_bits & 0x007FFFFF) | 0x00800000;
+
+	// Half denormals and normals, both rounded to nearest even
+	const uint32_t shift = exponent < -14 ? (uint32_t) (-exponent - 1) : 13;
+	const uint32_t half_exponent = exponent < -14 ? 0 : (uint32_t) (exponent + 15) << 10;
+	const uint32_t round_bit = 1u << (shift - 1);
+	const uint32_t sticky_mask = round_bit - 1;
+	uint32_t half_mantissa = mantissa >> shift;
+	if ((mantissa & round_bit) && ((mantissa & sticky_mask) || (half_mantissa & 1)))
+	{
+		++half_mantissa;
+	}
+
+	// For normals the implicit bit is folded into the exponent, and a mantissa carry correctly bumps the exponent
+	const uint32_t result = exponent < -14 ? half_mantissa : half_exponent + (half_mantissa - 0x400);
+	return (uint16_t) (sign | result);
+}
+
+inline float half_to_float(const uint16_t in_value)
+{
+	const uint32_t sign = (uint32_t) (in_value & 0x8000) << 16;
+	const uint32_t exponent = (in_value >> 10) & 0x1F;
+	const uint32_t mantissa = in_value & 0x3FF;
+
+	uint32_t bits;
+	if (exponent == 0x1F)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else
+	{
+		// Zero or denormal
+		const float value = std::ldexp((float) mantissa, -24);
+		return sign ? -value : value;
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+inline uint32_t quantize_unorm(const float in_value, const float in_max)
+{
+	return (uint32_t) std::lround(std::clamp(in_value, 0.0f, 1.0f) * in_max);
+}
+
+inline int32_t quantize_snorm(const float in_value, const float in_max)
+{
+	return (int32_t) std::lround(std::clamp(in_value, -1.0f, 1.0f) * in_max);
+}
+
+// Returns octahedral coordinates in [-1, 1]
+inline float2 oct_encode(float3 in_normal)
+{
+	const float length = std::abs(in_normal.x) + std::abs(in_normal.y) + std::abs(in_normal.z);
+	if (!(length > 0.0f))
+	{
+		return float2(0.0f, 0.0f);
+	}
+	in_normal /= length;
+
+	float2 result(in_normal.x, in_normal.y);
+	if (in_normal.z < 0.0f)
+	{
+		result.x = (1.0f - std::abs(in_normal.y)) * (in_normal.x >= 0.0f ? 1.0f : -1.0f);
+		result.y = (1.0f - std::abs(in_normal.x)) * (in_normal.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return result;
+}
+
+inline float3 oct_decode(const float2 in_encoded)
+{
+	float3 result(in_encoded.x, in_encoded.y, 1.0f - std::abs(in_encoded.x) - std::abs(in_encoded.y));
+	const float t = std::clamp(-result.z, 0.0f, 1.0f);
+	result.x += result.x >= 0.0f ? -t : t;
+	result.y += result.y >= 0.0f ? -t : t;
+	result.Normalize();
+	return result;
+}
+
+// in_position_extent is (AABB max - AABB min). Axes with zero extent always decode to in_position_min
+inline CompactVertexPosition EncodeCompactVertexPosition(const float3& in_position, const float3& in_position_min, const float3& in_position_extent)
+{
+	auto quantize_position = [](const float in_value, const float in_min, const float in_extent)
+	{
+		return in_extent > 0.0f ? quantize_unorm((in_value - in_min) / in_extent, 65535.0f) : 0u;
+	};
+
+	const uint32_t position_x = quantize_position(in_position.x, in_position_min.x, in_position_extent.x);
+	const uint32_t position_y = quantize_position(in_position.y, in_position_min.y, in_position_extent.y);
+	const uint32_t position_z = quantize_position(in_position.z, in_position_min.z, in_position_extent.z);
+
+	return CompactVertexPosition {
+		.position_xy = position_x | (position_y << 16),
+		.position_z = position_z,
+	};
+}
+
+inline CompactVertexAttributes EncodeCompactVertexAttributes(const VertexAttributes& in_attributes)
+{
+	const float2 oct_normal = oct_encode(in_attributes.normal);
+	const uint32_t normal_x = (uint16_t) (int16_t) quantize_snorm(oct_normal.x, 32767.0f);
+	const uint32_t normal_y = (uint16_t) (int16_t) quantize_snorm(oct_normal.y, 32767.0f);
+
+	return CompactVertexAttributes {
+		.normal = normal_x | (normal_y << 16),
+		.texcoord = (uint32_t) float_to_half(in_attributes.texcoord.x) | ((uint32_t) float_to_half(in_attributes.texcoord.y) << 16),
+		.color = quantize_unorm(in_attributes.color.x, 255.0f)
+			| (quantize_unorm(in_attributes.color.y, 255.0f) << 8)
+			| (quantize_unorm(in_attributes.color.z, 255.0f) << 16)
+			| (255u << 24),
+	};
+}
+
+// CPU mirrors of the HLSL decode functions below
+inline float3 DecodeCompactVertexPosition(const CompactVertexPosition& in_position, const float3& in_position_min, const float3& in_position_extent)
+{
+	const float3 position_unorm(
+		(in_position.position_xy & 0xFFFF) / 65535.0f,
+		(in_position.position_xy >> 16) / 65535.0f,
+		(in_position.position_z & 0xFFFF) / 65535.0f
+	);
+	return in_position_min + position_unorm * in_position_extent;
+}
+
+inline VertexAttributes DecodeCompactVertexAttributes(const CompactVertexAttributes& in_attributes)
+{
+	const float2 oct_normal(
+		(std::max)((int16_t) (in_attributes.normal & 0xFFFF) / 32767.0f, -1.0f),
+		(std::max)((int16_t) (in_attributes.normal >> 16) / 32767.0f, -1.0f)
+	);
+
+	VertexAttributes result;
+	result.normal = oct_decode(oct_normal);
+	result.color = float3(
+		(in_attributes.color & 0xFF) / 255.0f,
+		((in_attributes.color >> 8) & 0xFF) / 255.0f,
+		((in_attributes.color >> 16) & 0xFF) / 255.0f
+	);
+	result.texcoord = float2(half_to_float(in_attributes.texcoord & 0xFFFF), half_to_float(in_attributes.texcoord >> 16));
+	return result;
+}
+
+#else
+
+inline float3 OctDecode(float2 encoded)
+{
+	float3 result = float3(encoded.x, encoded.y, 1.0 - abs(encoded.x) - abs(encoded.y));
+	const float t = saturate(-result.z);
+	result.x += result.x >= 0.0 ? -t : t;
+	result.y += result.y >= 0.0 ? -t : t;
+	return normalize(result);
+}
+
+inline float3 DecodeCompactVertexPosition(CompactVertexPosition compact_position, float3 position_min, float3 position_extent)
+{
+	const float3 position_unorm = float3(
+		compact_position.position_xy & 0xFFFF,
+		compact_position.position_xy >> 16,
+		compact_position.position_z & 0xFFFF
+	) / 65535.0;
+	return position_min + position_unorm * position_extent;
+}
+
+inline VertexAttributes DecodeCompactVertexAttributes(CompactVertexAttributes compact_attributes)
+{
+	// Sign extend each snorm16
+	const int2 normal_snorm = int2(compact_attributes.normal << 16, compact_attributes.normal) >> 16;
+
+	VertexAttributes attributes;
+	attributes.normal = OctDecode(max(normal_snorm / 32767.0, -1.0));
+	attributes.color = float3(
+		compact_attributes.color & 0xFF,
+		(compact_attributes.color >> 8) & 0xFF,
+		(compact_attributes.color >> 16) & 0xFF
+	) / 255.0;
+	attributes.texcoord = f16tof32(uint2(compact_attributes.texcoord, compact_attributes.texcoord >> 16));
+	return attributes;
+}
+
+#endif
+
+#endif // #ifndef VERTEX_COMPRESSION_H
@@ -19,17 +19,13 @@ struct PsInput
 
 PsInput VertexShader(uint vertex_id : SV_VertexID, uint instance_id : SV_InstanceID)
 {
-    //TODO: Common helper fn to fetch vertex from vertex_id and instance_id
 	StructuredBuffer<GpuInstanceData> instances = ResourceDescriptorHeap[draw_constants.instance_buffer_index];
 	GpuInstanceData instance = instances[draw_constants.instance_id];
 
-    StructuredBuffer<uint> indices = ResourceDescriptorHeap[instance.index_buffer_index];
-    StructuredBuffer<Vertex> vertices = ResourceDescriptorHeap[instance.vertex_buffer_index];
-    Vertex vertex = vertices[indices[vertex_id]];
+    const float3 position = LoadVertexPosition(instance, LoadIndex(instance, vertex_id));
 
     const float4x4 proj_view = mul(global_constant_buffer.projection, global_constant_buffer.view);
-    const float4 world_position = mul(instance.transform, float4(vertex.position, 1));
-	const float4 world_normal = mul(instance.transform, float4(vertex.normal, 0)); //FCS TODO: just multiply this by rotation, not entire transform
+    const float4 world_position = mul(instance.transform, float4(position, 1));
     const float4 out_position = mul(proj_view, world_position);
 
     PsInput ps_input;
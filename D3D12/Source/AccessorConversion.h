@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define ACCESSOR_CONVERSION_SSE2 1
+#endif
+
+/*	Gathers vertex attributes and indices out of arbitrary (strided, interleaved, quantized) accessors into our own vertex and index arrays.
+	Nothing here knows about cgltf, so any accessor-like source can use it: describe the source with an AccessorDesc and convert it.
+
+	Every conversion has a scalar implementation (the reference) and an SSE2 one that converts a whole element at a time. Both produce
+	bit-identical results. The SSE2 path loads 4 components per element, so it falls back to scalar for trailing elements where that would
+	read past the end of the accessor.
+*/
+
+enum class AccessorComponentType : uint32_t
+{
+	Float,
+	Half,
+	Int8,
+	UInt8,
+	Int16,
+	UInt16,
+	UInt32,
+};
+
+inline uint32_t get_accessor_component_size(const AccessorComponentType in_type)
+{
+	switch (in_type)
+	{
+		case AccessorComponentType::Float:	return 4;
+		case AccessorComponentType::Half:	return 2;
+		case AccessorComponentType::Int8:	return 1;
+		case AccessorComponentType::UInt8:	return 1;
+		case AccessorComponentType::Int16:	return 2;
+		case AccessorComponentType::UInt16:	return 2;
+		case AccessorComponentType::UInt32:	return 4;
+	}
+	assert(false);
+	return 0;
+}
+
+struct AccessorDesc
+{
+	// First element
+	const uint8_t* data = nullptr;
+	size_t count = 0;
+
+	// Bytes from one element to the next. Larger than the element itself when the accessor is interleaved with others
+	size_t stride = 0;
+
+	AccessorComponentType component_type = AccessorComponentType::Float;
+	uint32_t component_count = 1;
+
+	// Integer components map to [0,1] (unsigned) or [-1,1] (signed) instead of converting to their integer value
+	bool normalized = false;
+
+	size_t GetElementSize() const { return get_accessor_component_size(component_type) * component_count; }
+
+	// Bytes from data to the end of the last element
+	size_t GetSize() const { return count > 0 ? (count - 1) * stride + GetElementSize() : 0; }
+};
+
+/* ---------------------------------------- Scalar ---------------------------------------- */
+
+// Converts a half to a float by rescaling its exponent with a multiply, which handles denormals for free. Infinities and NaNs are patched up after
+inline float convert_half_to_float(const uint16_t in_half)
+{
+	const uint32_t exponent_mantissa = in_half & 0x7FFF;
+	const uint32_t shifted_bits = exponent_mantissa << 13;
+	float shifted;
+	memcpy(&shifted, &shifted_bits, sizeof(float));
+
+	const uint32_t magic_bits = (254 - 15) << 23;
+	float magic;
+	memcpy(&magic, &magic_bits, sizeof(float));
+
+	uint32_t bits;
+	const float scaled = shifted * magic;
+	memcpy(&bits, &scaled, sizeof(float));
+	if (exponent_mantissa > 0x7BFF)
+	{
+		bits |= 255 << 23;
+	}
+	bits |= (uint32_t) (in_half & 0x8000) << 16;
+
+	float result;
+	memcpy(&result, &bits, sizeof(float));
+	return result;
+}
+
+inline float read_accessor_component(const uint8_t* in_data, const AccessorComponentType in_type, const bool in_normalized)
+{
+	switch (in_type)
+	{
+		case AccessorComponentType::Float:
+		{
+			float value;
+			memcpy(&value, in_data, sizeof(value));
+			return value;
+		}
+		case AccessorComponentType::Half:
+		{
+			uint16_t value;
+			memcpy(&value, in_data, sizeof(value));
+			return convert_half_to_float(value);
+		}
+		case AccessorComponentType::Int8:
+		{
+			const float value = (float) (int8_t) in_data[0];
+			return in_normalized ? (std::max)(value * (1.0f / 127.0f), -1.0f) : value;
+		}
+		case AccessorComponentType::UInt8:
+		{
+			const float value = (float) in_data[0];
+			return in_normalized ? value * (1.0f / 255.0f) : value;
+		}
+		case AccessorComponentType::Int16:
+		{
+			int16_t raw_value;
+			memcpy(&raw_value, in_data, sizeof(raw_value));
+			const float value = (float) raw_value;
+			return in_normalized ? (std::max)(value * (1.0f / 32767.0f), -1.0f) : value;
+		}
+		case AccessorComponentType::UInt16:
+		{
+			uint16_t raw_value;
+			memcpy(&raw_value, in_data, sizeof(raw_value));
+			const float value = (float) raw_value;
+			return in_normalized ? value * (1.0f / 65535.0f) : value;
+		}
+		case AccessorComponentType::UInt32:
+		{
+			uint32_t raw_value;
+			memcpy(&raw_value, in_data, sizeof(raw_value));
+			return (float) raw_value;
+		}
+	}
+	assert(false);
+	return 0.0f;
+}
+
+/*	Converts elements [in_first, in_last) of in_accessor to out_component_count floats each, written out_stride bytes apart starting at out_data.
+	Components out_data has room for but the accessor lacks are filled from in_fill
+*/
+inline void convert_accessor_to_float_scalar(
+	const AccessorDesc& in_accessor, const size_t in_first, const size_t in_last,
+	void* out_data, const size_t out_stride, const uint32_t out_component_count, const float in_fill[4])
+{
+	assert(out_component_count >= 1 && out_component_count <= 4);
+	const uint32_t component_size = get_accessor_component_size(in_accessor.component_type);
+	const uint32_t write_count = (std::min)(out_component_count, 4u);
+	const uint32_t read_count = (std::min)(in_accessor.component_count, write_count);
+	for (size_t element_idx = in_first; element_idx < in_last; ++element_idx)
+	{
+		const uint8_t* element = in_accessor.data + element_idx * in_accessor.stride;
+		float values[4];
+		for (uint32_t component_idx = 0; component_idx < write_count; ++component_idx)
+		{
+			values[component_idx] = component_idx < read_count
+				? read_accessor_component(element + component_idx * component_size, in_accessor.component_type, in_accessor.normalized)
+				: in_fill[component_idx];
+		}
+		memcpy((uint8_t*) out_data + element_idx * out_stride, values, write_count * sizeof(float));
+	}
+}
+
+inline void convert_accessor_to_indices_scalar(const AccessorDesc& in_accessor, const size_t in_first, const size_t in_last, uint32_t* out_indices)
+{
+	for (size_t element_idx = in_first; element_idx < in_last; ++element_idx)
+	{
+		const uint8_t* element = in_accessor.data + element_idx * in_accessor.stride;
+		switch (in_accessor.component_type)
+		{
+			case AccessorComponentType::UInt8:
+				out_indices[element_idx] = element[0];
+				break;
+			case AccessorComponentType::UInt16:
+			{
+				uint16_t index;
+				memcpy(&index, element, sizeof(index));
+				out_indices[element_idx] = index;
+				break;
+			}
+			case AccessorComponentType::UInt32:
+				memcpy(&out_indices[element_idx], element, sizeof(uint32_t));
+				break;
+			default:
+				assert(false);
+				break;
+		}
+	}
+}
+
+/* ---------------------------------------- SSE2 ---------------------------------------- */
+
+#if ACCESSOR_CONVERSION_SSE2
+
+// 4 halves, one in the low 16 bits of each lane. Same approach as convert_half_to_float
+inline __m128 convert_half_to_float_sse2(const __m128i in_halves)
+{
+	const __m128i exponent_mantissa = _mm_and_si128(in_halves, _mm_set1_epi32(0x7FFF));
+	const __m128i sign = _mm_slli_epi32(_mm_xor_si128(in_halves, exponent_mantissa), 16);
+	const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponent_mantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+	const __m128i was_inf_nan = _mm_cmpgt_epi32(exponent_mantissa, _mm_set1_epi32(0x7BFF));
+	const __m128 inf_nan_exponent = _mm_and_ps(_mm_castsi128_ps(was_inf_nan), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+	return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), inf_nan_exponent));
+}
+
+// Loads the first 4 components of an element as floats. Reads 4 components' worth of bytes regardless of the element's component count
+template<AccessorComponentType ComponentType, bool Normalized>
+inline __m128 load_accessor_element_sse2(const uint8_t* in_element)
+{
+	if constexpr (ComponentType == AccessorComponentType::Float)
+	{
+		return _mm_loadu_ps((const float*) in_element);
+	}
+	else if constexpr (ComponentType == AccessorComponentType::Half)
+	{
+		const __m128i halves = _mm_loadl_epi64((const __m128i*) in_element);
+		return convert_half_to_float_sse2(_mm_unpacklo_epi16(halves, _mm_setzero_si128()));
+	}
+	else if constexpr (ComponentType == AccessorComponentType::Int8 || ComponentType == AccessorComponentType::UInt8)
+	{
+		int32_t packed;
+		memcpy(&packed, in_element, sizeof(packed));
+		const __m128i bytes = _mm_cvtsi32_si128(packed);
+		__m128i values;
+		if constexpr (ComponentType == AccessorComponentType::Int8)
+		{
+			// Move each byte to the top of its lane, then sign extend it back down
+			const __m128i words = _mm_unpacklo_epi8(_mm_setzero_si128(), bytes);
+			values = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), words), 24);
+		}
+		else
+		{
+			values = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_setzero_si128());
+		}
+
+		const __m128 floats = _mm_cvtepi32_ps(values);
+		if constexpr (!Normalized)
+		{
+			return floats;
+		}
+		else if constexpr (ComponentType == AccessorComponentType::Int8)
+		{
+			return _mm_max_ps(_mm_mul_ps(floats, _mm_set1_ps(1.0f / 127.0f)), _mm_set1_ps(-1.0f));
+		}
+		else
+		{
+			return _mm_mul_ps(floats, _mm_set1_ps(1.0f / 255.0f));
+		}
+	}
+	else if constexpr (ComponentType == AccessorComponentType::Int16 || ComponentType == AccessorComponentType::UInt16)
+	{
+		const __m128i shorts = _mm_loadl_epi64((const __m128i*) in_element);
+		const __m128i values = ComponentType == AccessorComponentType::Int16
+			? _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), shorts), 16)
+			: _mm_unpacklo_epi16(shorts, _mm_setzero_si128());
+
+		const __m128 floats = _mm_cvtepi32_ps(values);
+		if constexpr (!Normalized)
+		{
+			return floats;
+		}
+		else if constexpr (ComponentType == AccessorComponentType::Int16)
+		{
+			return _mm_max_ps(_mm_mul_ps(floats, _mm_set1_ps(1.0f / 32767.0f)), _mm_set1_ps(-1.0f));
+		}
+		else
+		{
+			return _mm_mul_ps(floats, _mm_set1_ps(1.0f / 65535.0f));
+		}
+	}
+	else
+	{
+		static_assert(ComponentType == AccessorComponentType::UInt32, "Unhandled component type");
+
+		// Not a vertex attribute type in practice, and cvtepi32 is signed. Not worth a vector path
+		alignas(16) float values[4];
+		for (uint32_t component_idx = 0; component_idx < 4; ++component_idx)
+		{
+			values[component_idx] = read_accessor_component(in_element + component_idx * sizeof(uint32_t), ComponentType, Normalized);
+		}
+		return _mm_load_ps(values);
+	}
+}
+
+// Returns how many elements from the start of in_accessor can be loaded 4 components at a time without reading past its end
+inline size_t get_accessor_vector_safe_count(const AccessorDesc& in_accessor)
+{
+	const size_t load_size = get_accessor_component_size(in_accessor.component_type) * 4;
+	const size_t accessor_size = in_accessor.GetSize();
+	if (in_accessor.count == 0 || accessor_size < load_size)
+	{
+		return 0;
+	}
+
+	// Element i is safe if i * stride + load_size <= accessor_size
+	const size_t last_safe_offset = accessor_size - load_size;
+	return in_accessor.stride > 0 ? (std::min)(in_accessor.count, last_safe_offset / in_accessor.stride + 1) : in_accessor.count;
+}
+
+template<AccessorComponentType ComponentType, bool Normalized>
+inline void convert_accessor_to_float_sse2(
+	const AccessorDesc& in_accessor, const size_t in_count,
+	void* out_data, const size_t out_stride, const uint32_t out_component_count, const float in_fill[4])
+{
+	// Lanes past the accessor's component count come from in_fill instead
+	alignas(16) uint32_t keep_mask[4];
+	for (uint32_t component_idx = 0; component_idx < 4; ++component_idx)
+	{
+		keep_mask[component_idx] = component_idx < in_accessor.component_count ? UINT32_MAX : 0;
+	}
+	const __m128 keep = _mm_load_ps((const float*) keep_mask);
+	const __m128 fill = _mm_andnot_ps(keep, _mm_loadu_ps(in_fill));
+
+	const uint8_t* element = in_accessor.data;
+	uint8_t* out_element = (uint8_t*) out_data;
+	for (size_t element_idx = 0; element_idx < in_count; ++element_idx)
+	{
+		const __m128 values = _mm_or_ps(_mm_and_ps(load_accessor_element_sse2<ComponentType, Normalized>(element), keep), fill);
+
+		// Only ever write out_component_count floats, output elements are usually one field of a larger vertex
+		float* out_floats = (float*) out_element;
+		switch (out_component_count)
+		{
+			case 1:
+				_mm_store_ss(out_floats, values);
+				break;
+			case 2:
+				_mm_storel_pi((__m64*) out_floats, values);
+				break;
+			case 3:
+				_mm_storel_pi((__m64*) out_floats, values);
+				_mm_store_ss(out_floats + 2, _mm_movehl_ps(values, values));
+				break;
+			default:
+				_mm_storeu_ps(out_floats, values);
+				break;
+		}
+
+		element += in_accessor.stride;
+		out_element += out_stride;
+	}
+}
+
+#endif // ACCESSOR_CONVERSION_SSE2
+
+/* ---------------------------------------- Dispatch ---------------------------------------- */
+
+static constexpr float ACCESSOR_FILL_ZERO[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+/*	Converts every element of in_accessor to out_component_count (1-4) floats, written out_stride bytes apart starting at out_data.
+	Extra accessor components are dropped, missing ones are filled from in_fill
+*/
+inline void convert_accessor_to_float(
+	const AccessorDesc& in_accessor, void* out_data, const size_t out_stride, const uint32_t out_component_count, const float in_fill[4] = ACCESSOR_FILL_ZERO)
+{
+	assert(in_accessor.component_count >= 1 && in_accessor.component_count <= 4);
+	assert(out_component_count >= 1 && out_component_count <= 4);
+
+	size_t vector_count = 0;
+#if ACCESSOR_CONVERSION_SSE2
+	vector_count = get_accessor_vector_safe_count(in_accessor);
+	if (vector_count > 0)
+	{
+		#define CONVERT_ACCESSOR_SSE2(component_type, normalized) \
+			convert_accessor_to_float_sse2<component_type, normalized>(in_accessor, vector_count, out_data, out_stride, out_component_count, in_fill)
+
+		switch (in_accessor.component_type)
+		{
+			case AccessorComponentType::Float:	CONVERT_ACCESSOR_SSE2(AccessorComponentType::Float, false); break;
+			case AccessorComponentType::Half:	CONVERT_ACCESSOR_SSE2(AccessorComponentType::Half, false); break;
+			case AccessorComponentType::Int8:	in_accessor.normalized ? CONVERT_ACCESSOR_SSE2(AccessorComponentType::Int8, true) : CONVERT_ACCESSOR_SSE2(AccessorComponentType::Int8, false); break;
+			case AccessorComponentType::UInt8:	in_accessor.normalized ? CONVERT_ACCESSOR_SSE2(AccessorComponentType::UInt8, true) : CONVERT_ACCESSOR_SSE2(AccessorComponentType::UInt8, false); break;
+			case AccessorComponentType::Int16:	in_accessor.normalized ? CONVERT_ACCESSOR_SSE2(AccessorComponentType::Int16, true) : CONVERT_ACCESSOR_SSE2(AccessorComponentType::Int16, false); break;
+			case AccessorComponentType::UInt16:	in_accessor.normalized ? CONVERT_ACCESSOR_SSE2(AccessorComponentType::UInt16, true) : CONVERT_ACCESSOR_SSE2(AccessorComponentType::UInt16, false); break;
+			case AccessorComponentType::UInt32:	CONVERT_ACCESSOR_SSE2(AccessorComponentType::UInt32, false); break;
+		}
+
+		#undef CONVERT_ACCESSOR_SSE2
+	}
+#endif
+
+	convert_accessor_to_float_scalar(in_accessor, vector_count, in_accessor.count, out_data, out_stride, out_component_count, in_fill);
+}
+
+// Widens an index accessor (8, 16 or 32-bit unsigned scalars) to 32-bit indices
+inline void convert_accessor_to_indices(const AccessorDesc& in_accessor, uint32_t* out_indices)
+{
+	assert(in_accessor.component_count == 1);
+	if (in_accessor.count == 0)
+	{
+		return;
+	}
+
+	const uint32_t index_size = get_accessor_component_size(in_accessor.component_type);
+	if (in_accessor.stride != index_size)
+	{
+		// Interleaved index data is legal, but rare enough not to bother vectorizing
+		convert_accessor_to_indices_scalar(in_accessor, 0, in_accessor.count, out_indices);
+		return;
+	}
+
+	size_t index_idx = 0;
+	switch (in_accessor.component_type)
+	{
+		case AccessorComponentType::UInt32:
+			memcpy(out_indices, in_accessor.data, in_accessor.count * sizeof(uint32_t));
+			index_idx = in_accessor.count;
+			break;
+#if ACCESSOR_CONVERSION_SSE2
+		case AccessorComponentType::UInt16:
+			for (; index_idx + 8 <= in_accessor.count; index_idx += 8)
+			{
+				const __m128i indices = _mm_loadu_si128((const __m128i*) (in_accessor.data + index_idx * sizeof(uint16_t)));
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx), _mm_unpacklo_epi16(indices, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx + 4), _mm_unpackhi_epi16(indices, _mm_setzero_si128()));
+			}
+			break;
+		case AccessorComponentType::UInt8:
+			for (; index_idx + 16 <= in_accessor.count; index_idx += 16)
+			{
+				const __m128i indices = _mm_loadu_si128((const __m128i*) (in_accessor.data + index_idx));
+				const __m128i low_words = _mm_unpacklo_epi8(indices, _mm_setzero_si128());
+				const __m128i high_words = _mm_unpackhi_epi8(indices, _mm_setzero_si128());
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx), _mm_unpacklo_epi16(low_words, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx + 4), _mm_unpackhi_epi16(low_words, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx + 8), _mm_unpacklo_epi16(high_words, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*) (out_indices + index_idx + 12), _mm_unpackhi_epi16(high_words, _mm_setzero_si128()));
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+
+	convert_accessor_to_indices_scalar(in_accessor, index_idx, in_accessor.count, out_indices);
+}
+
+/* ---------------------------------------- Narrowing ---------------------------------------- */
+
+// Meshes with at most this many vertices can address all of them with 16-bit indices
+static constexpr size_t MAX_VERTICES_FOR_16BIT_INDICES = 65536;
+
+// Bytes per index a mesh of in_vertex_count vertices is stored with: 2 whenever every vertex fits, 4 otherwise
+inline uint32_t get_index_stride(const size_t in_vertex_count)
+{
+	return in_vertex_count <= MAX_VERTICES_FOR_16BIT_INDICES ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+/*	The inverse of convert_accessor_to_indices: stores in_count 32-bit indices at in_index_stride (2 or 4) bytes each, starting at out_data.
+	Indices must fit in that stride, see get_index_stride
+*/
+inline void narrow_indices(const uint32_t* in_indices, const size_t in_count, const uint32_t in_index_stride, uint8_t* out_data)
+{
+	assert(in_index_stride == sizeof(uint16_t) || in_index_stride == sizeof(uint32_t));
+	if (in_count == 0)
+	{
+		return;
+	}
+
+	if (in_index_stride == sizeof(uint32_t))
+	{
+		memcpy(out_data, in_indices, in_count * sizeof(uint32_t));
+		return;
+	}
+
+	for (size_t index_idx = 0; index_idx < in_count; ++index_idx)
+	{
+		assert(in_indices[index_idx] < MAX_VERTICES_FOR_16BIT_INDICES);
+		const uint16_t index = static_cast<uint16_t>(in_indices[index_idx]);
+		memcpy(out_data + index_idx * sizeof(uint16_t), &index, sizeof(index));
+	}
+}
@@ -6,7 +6,10 @@ template<typename Key, typename Value>
 using HashMap = ankerl::unordered_dense::map<Key, Value>;
 
 #include <cassert>
+#include <cstdint>
 
+// Everything that touches Windows or D3D12 is kept out of non-Windows builds (the asset cooker)
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <wrl.h>
@@ -28,6 +31,7 @@ using Microsoft::WRL::ComPtr;
 #else
 #define NAME_D3D12_OBJECT(obj, name) 
 #endif
+#endif
 
 #define XOR(a,b) a ? !b : b
 
@@ -49,6 +53,7 @@ using Microsoft::WRL::ComPtr;
 	CLASS(CLASS&&) = default;                  \
 	CLASS& operator=(CLASS&&) = default
 
+#ifdef _WIN32
 inline void wait_gpu_idle(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandQueue> command_queue)
 {
 	ComPtr<ID3D12Fence> fence;
@@ -61,6 +66,41 @@ inline void wait_gpu_idle(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandQueue
 	HR_CHECK(fence->SetEventOnCompletion(1, fence_event));
 	WaitForSingleObject(fence_event, INFINITE);
 }
+#endif
+
+// alignment must be a power of two
+inline size_t align_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Capacity for a container that has to hold required_size: capacity doubled (starting from min_capacity) until it fits.
+// Returns capacity unchanged if it already does. Doubling keeps the total cost of repeated growth linear in the final size.
+// Where doubling again would overflow, returns required_size itself
+inline size_t grow_capacity(size_t capacity, size_t required_size, size_t min_capacity = 1)
+{
+	if (required_size <= capacity)
+	{
+		return capacity;
+	}
+
+	size_t new_capacity = capacity > 0 ? capacity : (min_capacity > 0 ? min_capacity : 1);
+	while (new_capacity < required_size)
+	{
+		if (new_capacity > SIZE_MAX / 2)
+		{
+			return required_size;
+		}
+		new_capacity *= 2;
+	}
+	return new_capacity;
+}
+
+// Folds in_value into in_hash
+inline uint64_t hash_combine(const uint64_t in_hash, const uint64_t in_value)
+{
+	return ankerl::unordered_dense::detail::wyhash::mix(in_hash ^ in_value, UINT64_C(0x9E3779B97F4A7C15));
+}
 
 inline float randf()
 {
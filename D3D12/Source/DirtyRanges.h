@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using std::span;
+using std::vector;
+
+struct DirtyRange
+{
+	uint64_t offset = 0;
+	uint64_t size = 0;
+};
+
+/*	Byte ranges of a buffer written since they were last uploaded. Kept sorted by offset, with overlapping and touching ranges merged,
+	so each Get() range is one copy. Add is O(n) in the number of disjoint ranges, which stays small for the buffers this tracks
+*/
+struct DirtyRanges
+{
+	void Add(const uint64_t in_offset, const uint64_t in_size)
+	{
+		if (in_size == 0)
+		{
+			return;
+		}
+
+		DirtyRange merged = { .offset = in_offset, .size = in_size };
+		uint64_t merged_end = in_offset + in_size;
+
+		// First range that ends at or after in_offset, i.e. the first one we might touch
+		auto first_it = std::lower_bound(m_ranges.begin(), m_ranges.end(), in_offset, [](const DirtyRange& in_range, const uint64_t in_value)
+		{
+			return in_range.offset + in_range.size < in_value;
+		});
+
+		auto last_it = first_it;
+		for (; last_it != m_ranges.end() && last_it->offset <= merged_end; ++last_it)
+		{
+			merged.offset = (std::min)(merged.offset, last_it->offset);
+			merged_end = (std::max)(merged_end, last_it->offset + last_it->size);
+		}
+		merged.size = merged_end - merged.offset;
+
+		first_it = m_ranges.erase(first_it, last_it);
+		m_ranges.insert(first_it, merged);
+	}
+
+	void Clear() { m_ranges.clear(); }
+	bool IsEmpty() const { return m_ranges.empty(); }
+	span<const DirtyRange> Get() const { return m_ranges; }
+
+	uint64_t GetTotalSize() const
+	{
+		uint64_t total_size = 0;
+		for (const DirtyRange& range : m_ranges)
+		{
+			total_size += range.size;
+		}
+		return total_size;
+	}
+
+protected:
+	vector<DirtyRange> m_ranges;
+};
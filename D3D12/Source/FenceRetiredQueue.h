@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+/*	Holds objects the GPU may still be using (replaced buffers, textures...) until a fence value says it's done with them.
+	Push tags an object with the last fence value that can still reference it, Retire releases everything up to a completed fence value,
+	oldest first. Doesn't touch D3D12 itself, so T can be anything movable.
+*/
+template<typename T>
+struct FenceRetiredQueue
+{
+	// Fence values must not decrease
+	void Push(T&& in_object, const uint64_t in_fence_value)
+	{
+		assert(m_entries.empty() || m_entries.back().fence_value <= in_fence_value);
+		m_entries.push_back(Entry {
+			.object = std::move(in_object),
+			.fence_value = in_fence_value,
+		});
+	}
+
+	// Calls in_on_retire on each object whose fence value is <= in_completed_fence_value, then destroys it. Returns how many were retired
+	template<typename OnRetire>
+	size_t Retire(const uint64_t in_completed_fence_value, OnRetire&& in_on_retire)
+	{
+		size_t retired_count = 0;
+		while (!m_entries.empty() && m_entries.front().fence_value <= in_completed_fence_value)
+		{
+			in_on_retire(m_entries.front().object);
+			m_entries.pop_front();
+			++retired_count;
+		}
+		return retired_count;
+	}
+
+	size_t Retire(const uint64_t in_completed_fence_value)
+	{
+		return Retire(in_completed_fence_value, [](T&) {});
+	}
+
+	bool IsEmpty() const { return m_entries.empty(); }
+	size_t GetCount() const { return m_entries.size(); }
+
+protected:
+	struct Entry
+	{
+		T object;
+		uint64_t fence_value = 0;
+	};
+
+	// Oldest first
+	std::deque<Entry> m_entries;
+};
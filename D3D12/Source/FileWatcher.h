@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Common.h"
+
+/*	Reports when any of a set of files changes on disk. Directories are watched rather than the files themselves, since editors and exporters
+	often save by writing a temporary file and renaming it over the original. ReadDirectoryChangesW on Windows, inotify on Linux.
+
+	A change is only reported once PollChanges has seen no new events for its file for in_settle_time, so a file that's still being written
+	(or a .gltf whose .bin hasn't been written yet) isn't picked up halfway.
+*/
+struct FileWatcher
+{
+	explicit FileWatcher(const std::chrono::milliseconds in_settle_time = std::chrono::milliseconds(250))
+		: m_settle_time(in_settle_time)
+	{
+#if defined(__linux__)
+		m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	}
+
+	~FileWatcher()
+	{
+#if defined(_WIN32)
+		for (const std::unique_ptr<WatchedDirectory>& directory : m_directories)
+		{
+			// The pending read writes into the directory's buffer, so it has to finish (or be cancelled) before that's freed
+			CancelIoEx(directory->handle, &directory->overlapped);
+			DWORD bytes_transferred = 0;
+			GetOverlappedResult(directory->handle, &directory->overlapped, &bytes_transferred, TRUE);
+			CloseHandle(directory->overlapped.hEvent);
+			CloseHandle(directory->handle);
+		}
+#elif defined(__linux__)
+		if (m_inotify_fd >= 0)
+		{
+			close(m_inotify_fd);
+		}
+#endif
+	}
+
+	DISALLOW_COPY(FileWatcher);
+
+	// Returns false if in_file's directory can't be watched
+	bool AddFile(const std::filesystem::path& in_file)
+	{
+		std::error_code error;
+		const std::filesystem::path file = std::filesystem::absolute(in_file, error).lexically_normal();
+		if (error)
+		{
+			return false;
+		}
+
+		const std::filesystem::path directory_path = file.parent_path();
+		auto directory_it = std::find_if(m_directories.begin(), m_directories.end(), [&](const std::unique_ptr<WatchedDirectory>& in_directory)
+		{
+			return in_directory->path == directory_path;
+		});
+
+		if (directory_it == m_directories.end())
+		{
+			std::unique_ptr<WatchedDirectory> directory = std::make_unique<WatchedDirectory>();
+			directory->path = directory_path;
+			if (!WatchDirectory(*directory))
+			{
+				return false;
+			}
+			m_directories.push_back(std::move(directory));
+			directory_it = m_directories.end() - 1;
+		}
+
+		vector<std::filesystem::path>& file_names = (*directory_it)->file_names;
+		if (std::find(file_names.begin(), file_names.end(), file.filename()) == file_names.end())
+		{
+			file_names.push_back(file.filename());
+		}
+		return true;
+	}
+
+	// Non-blocking. Returns every watched file (as an absolute path) that changed and has since settled, each once
+	vector<std::filesystem::path> PollChanges()
+	{
+		const Clock::time_point now = Clock::now();
+		ReadEvents(now);
+
+		vector<std::filesystem::path> changed_files;
+		std::erase_if(m_unsettled_changes, [&](const std::pair<std::filesystem::path, Clock::time_point>& in_change)
+		{
+			if (now - in_change.second < m_settle_time)
+			{
+				return false;
+			}
+			changed_files.push_back(in_change.first);
+			return true;
+		});
+		return changed_files;
+	}
+
+protected:
+	using Clock = std::chrono::steady_clock;
+
+	struct WatchedDirectory
+	{
+		std::filesystem::path path;
+
+		// Names of the watched files in this directory
+		vector<std::filesystem::path> file_names;
+
+#if defined(_WIN32)
+		HANDLE handle = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped = {};
+
+		// FILE_NOTIFY_INFORMATION records, which need DWORD alignment
+		vector<DWORD> buffer = vector<DWORD>(16 * 1024 / sizeof(DWORD));
+#elif defined(__linux__)
+		int watch_descriptor = -1;
+#endif
+	};
+
+	// Restarts the settle time of in_file_name if it's one of in_directory's watched files
+	void OnFileEvent(const WatchedDirectory& in_directory, const std::filesystem::path& in_file_name, const Clock::time_point in_now)
+	{
+		for (const std::filesystem::path& file_name : in_directory.file_names)
+		{
+#if defined(_WIN32)
+			// Windows file names are case-insensitive
+			const bool matches = _wcsicmp(file_name.c_str(), in_file_name.c_str()) == 0;
+#else
+			const bool matches = file_name == in_file_name;
+#endif
+			if (matches)
+			{
+				OnFileChanged(in_directory.path / file_name, in_now);
+			}
+		}
+	}
+
+	// For when the OS dropped events and we can't tell which files changed
+	void OnDirectoryChanged(const WatchedDirectory& in_directory, const Clock::time_point in_now)
+	{
+		for (const std::filesystem::path& file_name : in_directory.file_names)
+		{
+			OnFileChanged(in_directory.path / file_name, in_now);
+		}
+	}
+
+	void OnFileChanged(const std::filesystem::path& in_file, const Clock::time_point in_now)
+	{
+		auto change_it = std::find_if(m_unsettled_changes.begin(), m_unsettled_changes.end(), [&](const std::pair<std::filesystem::path, Clock::time_point>& in_change)
+		{
+			return in_change.first == in_file;
+		});
+
+		if (change_it != m_unsettled_changes.end())
+		{
+			change_it->second = in_now;
+		}
+		else
+		{
+			m_unsettled_changes.emplace_back(in_file, in_now);
+		}
+	}
+
+#if defined(_WIN32)
+	bool WatchDirectory(WatchedDirectory& io_directory)
+	{
+		io_directory.handle = CreateFileW(
+			io_directory.path.c_str(),
+			FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr,
+			OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			nullptr
+		);
+		if (io_directory.handle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		io_directory.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		if (!io_directory.overlapped.hEvent || !IssueRead(io_directory))
+		{
+			if (io_directory.overlapped.hEvent)
+			{
+				CloseHandle(io_directory.overlapped.hEvent);
+			}
+			CloseHandle(io_directory.handle);
+			return false;
+		}
+		return true;
+	}
+
+	bool IssueRead(WatchedDirectory& io_directory)
+	{
+		return ReadDirectoryChangesW(
+			io_directory.handle,
+			io_directory.buffer.data(),
+			(DWORD) (io_directory.buffer.size() * sizeof(DWORD)),
+			FALSE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+			nullptr,
+			&io_directory.overlapped,
+			nullptr
+		) != 0;
+	}
+
+	void ReadEvents(const Clock::time_point in_now)
+	{
+		for (const std::unique_ptr<WatchedDirectory>& directory : m_directories)
+		{
+			DWORD bytes_transferred = 0;
+			if (!GetOverlappedResult(directory->handle, &directory->overlapped, &bytes_transferred, FALSE))
+			{
+				// ERROR_IO_INCOMPLETE: nothing happened since the last poll
+				continue;
+			}
+
+			if (bytes_transferred == 0)
+			{
+				// The buffer overflowed, so the individual events are lost
+				OnDirectoryChanged(*directory, in_now);
+			}
+			else
+			{
+				const uint8_t* record = reinterpret_cast<const uint8_t*>(directory->buffer.data());
+				while (true)
+				{
+					const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+					OnFileEvent(*directory, std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)), in_now);
+					if (info->NextEntryOffset == 0)
+					{
+						break;
+					}
+					record += info->NextEntryOffset;
+				}
+			}
+
+			ResetEvent(directory->overlapped.hEvent);
+			IssueRead(*directory);
+		}
+	}
+#elif defined(__linux__)
+	bool WatchDirectory(WatchedDirectory& io_directory)
+	{
+		if (m_inotify_fd < 0)
+		{
+			return false;
+		}
+
+		// IN_CLOSE_WRITE for files written in place, IN_MOVED_TO for files renamed over the original
+		io_directory.watch_descriptor = inotify_add_watch(m_inotify_fd, io_directory.path.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO);
+		return io_directory.watch_descriptor >= 0;
+	}
+
+	void ReadEvents(const Clock::time_point in_now)
+	{
+		if (m_inotify_fd < 0)
+		{
+			return;
+		}
+
+		alignas(inotify_event) char buffer[16 * 1024];
+		while (true)
+		{
+			const ssize_t bytes_read = read(m_inotify_fd, buffer, sizeof(buffer));
+			if (bytes_read <= 0)
+			{
+				// EAGAIN: no more events
+				break;
+			}
+
+			for (ssize_t offset = 0; offset < bytes_read;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+
+				for (const std::unique_ptr<WatchedDirectory>& directory : m_directories)
+				{
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						// The queue overflowed, so the individual events are lost
+						OnDirectoryChanged(*directory, in_now);
+					}
+					else if (directory->watch_descriptor == event->wd && event->len > 0)
+					{
+						OnFileEvent(*directory, std::filesystem::path(event->name), in_now);
+					}
+				}
+			}
+		}
+	}
+#else
+	bool WatchDirectory(WatchedDirectory& io_directory) { return false; }
+	void ReadEvents(const Clock::time_point in_now) {}
+#endif
+
+	std::chrono::milliseconds m_settle_time;
+
+	// Stable addresses, the OS writes into each directory's OVERLAPPED and buffer
+	vector<std::unique_ptr<WatchedDirectory>> m_directories;
+
+	// Changed files that haven't settled yet, and when their last event arrived
+	vector<std::pair<std::filesystem::path, Clock::time_point>> m_unsettled_changes;
+
+#if defined(__linux__)
+	int m_inotify_fd = -1;
+#endif
+};
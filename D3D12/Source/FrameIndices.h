@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+/*	Frame index bookkeeping for a swapchain of FrameCount backbuffers. Each backbuffer remembers the index of the frame last rendered to it,
+	which is also the fence value that frame signals. Doesn't touch D3D12 itself: FrameData signals and waits on the values it hands out.
+
+	Frame indices only ever increase, resizes included, so systems that retire resources against them (FenceRetiredQueue, the TransientResourcePool...)
+	never see one go backwards. They start at 1, as the fence starts out having completed 0
+*/
+template<uint32_t FrameCount>
+struct FrameIndices
+{
+	FrameIndices()
+	{
+		m_frame_indices[m_backbuffer_index] = 1;
+	}
+
+	uint64_t GetCurrentFrame() const { return m_frame_indices[m_backbuffer_index]; }
+	uint32_t GetBackbufferIndex() const { return m_backbuffer_index; }
+
+	// Frame last rendered to in_backbuffer_index
+	uint64_t GetFrame(const uint32_t in_backbuffer_index) const { return m_frame_indices[in_backbuffer_index]; }
+
+	/*	Moves on to the next frame, rendered to in_backbuffer_index, once the current frame has been submitted and its index signaled.
+		Returns the frame that last rendered to that backbuffer, which has to complete (and can then be retired) before the new frame starts
+	*/
+	uint64_t BeginNextFrame(const uint32_t in_backbuffer_index)
+	{
+		assert(in_backbuffer_index < FrameCount);
+		const uint64_t next_frame = GetCurrentFrame() + 1;
+		m_backbuffer_index = in_backbuffer_index;
+		const uint64_t previous_frame = m_frame_indices[in_backbuffer_index];
+		m_frame_indices[in_backbuffer_index] = next_frame;
+		return previous_frame;
+	}
+
+	// Every frame before the current one has to complete before the backbuffers can be recreated, and the others' frames can then be retired
+	uint64_t GetLastSubmittedFrame() const { return GetCurrentFrame() - 1; }
+
+	/*	The backbuffers were recreated, and in_backbuffer_index is now current. The current frame keeps its index,
+		and the other backbuffers point at the (completed) frame before it
+	*/
+	void OnResize(const uint32_t in_backbuffer_index)
+	{
+		assert(in_backbuffer_index < FrameCount);
+		const uint64_t current_frame = GetCurrentFrame();
+		std::fill(m_frame_indices, m_frame_indices + FrameCount, current_frame - 1);
+		m_backbuffer_index = in_backbuffer_index;
+		m_frame_indices[in_backbuffer_index] = current_frame;
+	}
+
+protected:
+	uint32_t m_backbuffer_index = 0;
+	uint64_t m_frame_indices[FrameCount] = {};
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+using std::optional;
+using std::nullopt;
+
+struct FreeListAllocation
+{
+	uint64_t offset = 0;
+	uint64_t size = 0;
+};
+
+/*	Offset allocator for sub-allocating ranges out of a fixed size block (e.g. a large GpuBuffer). Doesn't touch any memory itself.
+	Best fit: each allocation takes the smallest free block it fits in (alignment included), and freed blocks are merged with their free neighbors.
+	Allocate and Free are O(log n) in the number of free blocks.
+*/
+struct FreeListAllocator
+{
+	FreeListAllocator() = default;
+
+	explicit FreeListAllocator(const uint64_t in_capacity)
+		: m_capacity(in_capacity)
+	{
+		if (in_capacity > 0)
+		{
+			AddFreeBlock(0, in_capacity);
+		}
+	}
+
+	// in_alignment must be a power of two. Returns nullopt if no free block can hold in_size bytes at that alignment
+	optional<FreeListAllocation> Allocate(const uint64_t in_size, const uint64_t in_alignment = 1)
+	{
+		assert(in_alignment > 0 && (in_alignment & (in_alignment - 1)) == 0);
+		if (in_size == 0)
+		{
+			return nullopt;
+		}
+
+		// Smallest blocks first. Blocks of exactly in_size may still fail due to alignment, so keep looking
+		for (auto size_it = m_free_blocks_by_size.lower_bound({ in_size, 0 }); size_it != m_free_blocks_by_size.end(); ++size_it)
+		{
+			const auto [block_size, block_offset] = *size_it;
+			const uint64_t aligned_offset = (block_offset + in_alignment - 1) & ~(in_alignment - 1);
+			const uint64_t alignment_padding = aligned_offset - block_offset;
+			if (alignment_padding + in_size > block_size)
+			{
+				continue;
+			}
+
+			RemoveFreeBlock(m_free_blocks.find(block_offset));
+
+			// Give back whatever this allocation doesn't use on either side
+			if (alignment_padding > 0)
+			{
+				AddFreeBlock(block_offset, alignment_padding);
+			}
+			const uint64_t tail_size = block_size - alignment_padding - in_size;
+			if (tail_size > 0)
+			{
+				AddFreeBlock(aligned_offset + in_size, tail_size);
+			}
+
+			m_used_size += in_size;
+			++m_allocation_count;
+			return FreeListAllocation {
+				.offset = aligned_offset,
+				.size = in_size,
+			};
+		}
+
+		return nullopt;
+	}
+
+	void Free(const FreeListAllocation& in_allocation)
+	{
+		assert(in_allocation.size > 0 && in_allocation.offset + in_allocation.size <= m_capacity);
+		assert(m_used_size >= in_allocation.size && m_allocation_count > 0);
+
+		uint64_t offset = in_allocation.offset;
+		uint64_t size = in_allocation.size;
+
+		// Merge with the free block after this one...
+		auto next_it = m_free_blocks.lower_bound(offset);
+		assert(next_it == m_free_blocks.end() || next_it->first >= offset + size);
+		if (next_it != m_free_blocks.end() && next_it->first == offset + size)
+		{
+			size += next_it->second;
+			next_it = RemoveFreeBlock(next_it);
+		}
+
+		// ...and the one before it
+		if (next_it != m_free_blocks.begin())
+		{
+			auto previous_it = std::prev(next_it);
+			assert(previous_it->first + previous_it->second <= offset);
+			if (previous_it->first + previous_it->second == offset)
+			{
+				offset = previous_it->first;
+				size += previous_it->second;
+				RemoveFreeBlock(previous_it);
+			}
+		}
+
+		AddFreeBlock(offset, size);
+		m_used_size -= in_allocation.size;
+		--m_allocation_count;
+	}
+
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedSize() const { return m_used_size; }
+	uint64_t GetFreeSize() const { return m_capacity - m_used_size; }
+	size_t GetAllocationCount() const { return m_allocation_count; }
+	size_t GetFreeBlockCount() const { return m_free_blocks.size(); }
+	uint64_t GetLargestFreeBlock() const { return m_free_blocks_by_size.empty() ? 0 : m_free_blocks_by_size.rbegin()->first; }
+
+	// 0 when all free space is one contiguous block, approaching 1 as it gets split into many small blocks
+	float GetFragmentation() const
+	{
+		const uint64_t free_size = GetFreeSize();
+		return free_size > 0 ? 1.0f - (float) GetLargestFreeBlock() / (float) free_size : 0.0f;
+	}
+
+protected:
+	using FreeBlockMap = std::map<uint64_t, uint64_t>;
+
+	void AddFreeBlock(const uint64_t in_offset, const uint64_t in_size)
+	{
+		m_free_blocks.emplace(in_offset, in_size);
+		m_free_blocks_by_size.emplace(in_size, in_offset);
+	}
+
+	// Returns the free block after in_block_it
+	FreeBlockMap::iterator RemoveFreeBlock(FreeBlockMap::iterator in_block_it)
+	{
+		m_free_blocks_by_size.erase({ in_block_it->second, in_block_it->first });
+		return m_free_blocks.erase(in_block_it);
+	}
+
+	uint64_t m_capacity = 0;
+	uint64_t m_used_size = 0;
+	size_t m_allocation_count = 0;
+
+	// Free blocks keyed by offset (for merging neighbors), and as (size, offset) pairs (for best fit lookups)
+	FreeBlockMap m_free_blocks;
+	std::set<std::pair<uint64_t, uint64_t>> m_free_blocks_by_size;
+};
@@ -0,0 +1,898 @@
+#pragma once
+
+#include "cgltf/cgltf.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::optional;
+using std::nullopt;
+using std::span;
+using std::string;
+using std::vector;
+
+#include "AccessorConversion.h"
+#include "Common.h"
+#include "../Shaders/HLSL_Types.h"
+#include "MeshBounds.h"
+#include "MeshoptDecoding.h"
+#include "MeshProcessing.h"
+#include "SceneCache.h"
+#include "ThreadPool.h"
+#include "VertexStreams.h"
+
+/*	The CPU half of loading a gltf: flattening its scene into unique meshes and instances, and converting each mesh into our GPU formats.
+	Nothing here touches D3D12, so both GltfScene and the standalone asset cooker build on it.
+*/
+
+// CPU-side result of converting a single gltf primitive into our vertex/index format. Shared by every instance of that primitive
+struct GltfMeshData
+{
+	// Every LOD's indices, back to back. See lods
+	vector<uint32_t> indices;
+	vector<Vertex> vertices;
+
+	// GPU-ready index data, filled out by cook_mesh
+	uint32_t index_stride = sizeof(uint32_t);
+	vector<uint8_t> index_data;
+
+	// GPU-ready split vertex streams, filled out by cook_mesh
+	VertexFormat vertex_format = VertexFormat::Full;
+	vector<uint8_t> position_data;
+	vector<uint8_t> attribute_data;
+	float3 position_min;
+	float3 position_extent;
+
+	// Mesh space, filled out by cook_mesh
+	Bounds bounds;
+
+	// Built from the optimized triangle order of LOD 0 by build_meshlets
+	MeshletData meshlet_data;
+
+	// Ranges of indices, filled out by build_mesh_lods
+	vector<MeshLod> lods;
+
+	// Index into the gltf's materials, or INVALID_MATERIAL_INDEX
+	uint32_t material_index = INVALID_MATERIAL_INDEX;
+
+	// See hash_primitive
+	uint64_t source_hash = 0;
+
+	GltfMeshView GetView() const
+	{
+		return GltfMeshView {
+			.index_stride = index_stride,
+			.index_count = indices.size(),
+			.index_data = index_data,
+			.vertex_format = vertex_format,
+			.vertex_count = vertices.size(),
+			.position_data = position_data,
+			.attribute_data = attribute_data,
+			.position_min = position_min,
+			.position_extent = position_extent,
+			.bounds = bounds,
+			.meshlets = meshlet_data.meshlets,
+			.meshlet_vertices = meshlet_data.meshlet_vertices,
+			.meshlet_triangles = meshlet_data.meshlet_triangles,
+			.lods = lods,
+			.material_index = material_index,
+			.source_hash = source_hash,
+		};
+	}
+};
+
+cgltf_attribute* FindAttribute(cgltf_primitive& in_primitive, cgltf_attribute_type in_type)
+{
+	for (cgltf_size attr_idx = 0; attr_idx < in_primitive.attributes_count; ++attr_idx)
+	{
+		cgltf_attribute* attribute = &in_primitive.attributes[attr_idx];
+		if (attribute->type == in_type)
+		{
+			return attribute;
+		}
+	}
+	return nullptr;
+};
+
+MeshoptFilter get_meshopt_filter(const cgltf_meshopt_compression_filter in_filter)
+{
+	switch (in_filter)
+	{
+		case cgltf_meshopt_compression_filter_octahedral:	return MeshoptFilter::Octahedral;
+		case cgltf_meshopt_compression_filter_quaternion:	return MeshoptFilter::Quaternion;
+		case cgltf_meshopt_compression_filter_exponential:	return MeshoptFilter::Exponential;
+		default:											return MeshoptFilter::None;
+	}
+}
+
+/*	Decodes every EXT_meshopt_compression buffer view into memory of its own, which cgltf reads accessors from instead of the (usually empty)
+	fallback buffer, and frees in cgltf_free. Views decode in parallel on in_thread_pool if it's set. Returns false if any view failed to decode
+*/
+bool decode_meshopt_buffer_views(cgltf_data& io_data, ThreadPool* in_thread_pool)
+{
+	vector<cgltf_buffer_view*> compressed_views;
+	for (cgltf_size view_idx = 0; view_idx < io_data.buffer_views_count; ++view_idx)
+	{
+		cgltf_buffer_view& buffer_view = io_data.buffer_views[view_idx];
+		if (buffer_view.has_meshopt_compression && !buffer_view.data)
+		{
+			compressed_views.push_back(&buffer_view);
+		}
+	}
+
+	if (compressed_views.empty())
+	{
+		return true;
+	}
+
+	const auto decode_start_time = std::chrono::high_resolution_clock::now();
+	vector<uint8_t> decoded(compressed_views.size(), false);
+	auto decode_job = [&](size_t compressed_view_idx)
+	{
+		cgltf_buffer_view& buffer_view = *compressed_views[compressed_view_idx];
+		const cgltf_meshopt_compression& compression = buffer_view.meshopt_compression;
+		const cgltf_buffer* buffer = compression.buffer;
+		if (!buffer || !buffer->data || compression.offset + compression.size > buffer->size || compression.count * compression.stride != buffer_view.size)
+		{
+			return;
+		}
+
+		// cgltf frees this with its default allocator
+		void* decoded_data = malloc(buffer_view.size);
+		const span<const uint8_t> encoded_data((const uint8_t*) buffer->data + compression.offset, compression.size);
+		bool success = false;
+		switch (compression.mode)
+		{
+			case cgltf_meshopt_compression_mode_attributes:
+				success = decode_meshopt_vertex_buffer(decoded_data, compression.count, compression.stride, encoded_data);
+				break;
+			case cgltf_meshopt_compression_mode_triangles:
+				success = decode_meshopt_index_buffer(decoded_data, compression.count, compression.stride, encoded_data);
+				break;
+			case cgltf_meshopt_compression_mode_indices:
+				success = decode_meshopt_index_sequence(decoded_data, compression.count, compression.stride, encoded_data);
+				break;
+			default:
+				break;
+		}
+
+		success = success && apply_meshopt_filter(decoded_data, compression.count, compression.stride, get_meshopt_filter(compression.filter));
+		if (!success)
+		{
+			free(decoded_data);
+			return;
+		}
+
+		buffer_view.data = decoded_data;
+		decoded[compressed_view_idx] = true;
+	};
+
+	if (in_thread_pool)
+	{
+		in_thread_pool->ParallelFor(compressed_views.size(), decode_job);
+	}
+	else
+	{
+		for (size_t compressed_view_idx = 0; compressed_view_idx < compressed_views.size(); ++compressed_view_idx)
+		{
+			decode_job(compressed_view_idx);
+		}
+	}
+
+	size_t encoded_size = 0;
+	size_t decoded_size = 0;
+	size_t decoded_count = 0;
+	for (size_t compressed_view_idx = 0; compressed_view_idx < compressed_views.size(); ++compressed_view_idx)
+	{
+		if (decoded[compressed_view_idx])
+		{
+			encoded_size += compressed_views[compressed_view_idx]->meshopt_compression.size;
+			decoded_size += compressed_views[compressed_view_idx]->size;
+			++decoded_count;
+		}
+	}
+
+	using milliseconds = std::chrono::duration<float, std::milli>;
+	const float decode_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - decode_start_time).count();
+	printf(
+		"GltfScene: Decoded %zu/%zu meshopt compressed buffer views (%.2f MiB -> %.2f MiB) in %.2f ms (%.2f GB/s)\n",
+		decoded_count,
+		compressed_views.size(),
+		encoded_size / (1024.0f * 1024.0f),
+		decoded_size / (1024.0f * 1024.0f),
+		decode_time,
+		decode_time > 0.0f ? decoded_size / (decode_time * 1e6f) : 0.0f
+	);
+	return decoded_count == compressed_views.size();
+}
+
+// Describes an accessor's data for AccessorConversion.h. Null for sparse accessors and accessors without a buffer view, see read_accessor_floats
+optional<AccessorDesc> get_accessor_desc(const cgltf_accessor* in_accessor)
+{
+	const uint8_t* buffer_view_data = in_accessor && in_accessor->buffer_view ? cgltf_buffer_view_data(in_accessor->buffer_view) : nullptr;
+	if (!buffer_view_data || in_accessor->is_sparse)
+	{
+		return nullopt;
+	}
+
+	AccessorComponentType component_type;
+	switch (in_accessor->component_type)
+	{
+		case cgltf_component_type_r_8:		component_type = AccessorComponentType::Int8; break;
+		case cgltf_component_type_r_8u:		component_type = AccessorComponentType::UInt8; break;
+		case cgltf_component_type_r_16:		component_type = AccessorComponentType::Int16; break;
+		case cgltf_component_type_r_16u:	component_type = AccessorComponentType::UInt16; break;
+		case cgltf_component_type_r_32u:	component_type = AccessorComponentType::UInt32; break;
+		case cgltf_component_type_r_32f:	component_type = AccessorComponentType::Float; break;
+		default:							return nullopt;
+	}
+
+	const uint32_t component_count = (uint32_t) cgltf_num_components(in_accessor->type);
+	if (component_count < 1 || component_count > 4)
+	{
+		return nullopt;
+	}
+
+	return AccessorDesc {
+		.data = buffer_view_data + in_accessor->offset,
+		.count = in_accessor->count,
+		.stride = in_accessor->stride,
+		.component_type = component_type,
+		.component_count = component_count,
+		.normalized = in_accessor->normalized != 0,
+	};
+}
+
+// Converts a vertex attribute accessor into out_component_count floats per vertex, written out_stride bytes apart
+void read_accessor_floats(const cgltf_accessor* in_accessor, void* out_data, const size_t out_stride, const uint32_t out_component_count, const float in_fill[4])
+{
+	if (optional<AccessorDesc> accessor_desc = get_accessor_desc(in_accessor))
+	{
+		convert_accessor_to_float(*accessor_desc, out_data, out_stride, out_component_count, in_fill);
+		return;
+	}
+
+	// Sparse (or zero-initialized) accessors are rare, let cgltf resolve them into a tightly packed float array first
+	const uint32_t component_count = (uint32_t) cgltf_num_components(in_accessor->type);
+	vector<float> unpacked(in_accessor->count * component_count);
+	cgltf_accessor_unpack_floats(in_accessor, unpacked.data(), unpacked.size());
+
+	const AccessorDesc unpacked_desc = {
+		.data = (const uint8_t*) unpacked.data(),
+		.count = in_accessor->count,
+		.stride = component_count * sizeof(float),
+		.component_type = AccessorComponentType::Float,
+		.component_count = component_count,
+	};
+	convert_accessor_to_float(unpacked_desc, out_data, out_stride, out_component_count, in_fill);
+}
+
+const cgltf_accessor* FindAttributeAccessor(cgltf_primitive& in_primitive, cgltf_attribute_type in_type)
+{
+	cgltf_attribute* attribute = FindAttribute(in_primitive, in_type);
+	return attribute ? attribute->data : nullptr;
+}
+
+// Unique primitives in the scene, plus every node's reference to one of them
+struct GltfSceneLayout
+{
+	vector<cgltf_primitive*> meshes;
+	vector<GltfMeshInstance> instances;
+
+	// Maps a primitive to its index in meshes, so nodes sharing a gltf mesh share our mesh data too
+	HashMap<const cgltf_primitive*, uint32_t> mesh_lookup;
+
+	// hash_primitive of each of meshes. Only filled out by dedupe_scene_layout
+	vector<uint64_t> mesh_hashes;
+};
+
+// Flattens the node hierarchy into unique meshes and per-node instances, in depth-first order
+void recurse_node(cgltf_node* in_node, const Matrix& in_matrix, GltfSceneLayout& result)
+{	
+	// Nodes are either a matrix or translation/rotation/scale. Quantized meshes (KHR_mesh_quantization) rely on the latter to dequantize
+	float local_matrix[16];
+	cgltf_node_transform_local(in_node, local_matrix);
+	Matrix current_matrix = Matrix(local_matrix) * in_matrix;
+
+	if (in_node->mesh)
+	{
+		for (cgltf_size primtive_idx = 0; primtive_idx < in_node->mesh->primitives_count; ++primtive_idx)
+		{
+			cgltf_primitive* primitive = &in_node->mesh->primitives[primtive_idx];
+
+			auto [mesh_it, inserted] = result.mesh_lookup.try_emplace(primitive, (uint32_t) result.meshes.size());
+			if (inserted)
+			{
+				result.meshes.push_back(primitive);
+			}
+
+			result.instances.emplace_back(GltfMeshInstance {
+				.transform = current_matrix,
+				.mesh_index = mesh_it->second,
+			});
+		}
+	}
+
+	for (cgltf_size child_node_idx = 0; child_node_idx < in_node->children_count; ++child_node_idx)
+	{
+		recurse_node(in_node->children[child_node_idx], current_matrix, result);
+	}
+}
+
+/*	Quantized texcoords (KHR_mesh_quantization) are dequantized by a KHR_texture_transform on the material's textures, which in practice all
+	share the same one. We only have one set of texcoords, so the first texture's transform is baked into the vertices
+*/
+const cgltf_texture_transform* find_texture_transform(const cgltf_material* in_material)
+{
+	if (!in_material)
+	{
+		return nullptr;
+	}
+
+	const cgltf_texture_view* texture_views[] =
+	{
+		&in_material->pbr_metallic_roughness.base_color_texture,
+		&in_material->pbr_metallic_roughness.metallic_roughness_texture,
+		&in_material->normal_texture,
+		&in_material->occlusion_texture,
+		&in_material->emissive_texture,
+	};
+	for (const cgltf_texture_view* texture_view : texture_views)
+	{
+		if (texture_view->texture && texture_view->has_transform)
+		{
+			return &texture_view->transform;
+		}
+	}
+	return nullptr;
+}
+
+// uv' = translation * rotation * scale * uv, as KHR_texture_transform defines it
+void apply_texture_transform(const cgltf_texture_transform& in_transform, vector<Vertex>& io_vertices)
+{
+	const float cos_rotation = std::cos(in_transform.rotation);
+	const float sin_rotation = std::sin(in_transform.rotation);
+	for (Vertex& vertex : io_vertices)
+	{
+		const float u = vertex.texcoord.x * in_transform.scale[0];
+		const float v = vertex.texcoord.y * in_transform.scale[1];
+		vertex.texcoord = float2(
+			cos_rotation * u + sin_rotation * v + in_transform.offset[0],
+			-sin_rotation * u + cos_rotation * v + in_transform.offset[1]
+		);
+	}
+}
+
+// Widens indices and interleaves vertex attributes for a single primitive. Only reads from the primitive, so this is safe to run in parallel
+GltfMeshData convert_primitive(cgltf_primitive& primitive)
+{
+	GltfMeshData primitive_data;
+
+	if (primitive.indices)
+	{
+		primitive_data.indices.resize(primitive.indices->count);
+		if (optional<AccessorDesc> indices_desc = get_accessor_desc(primitive.indices))
+		{
+			convert_accessor_to_indices(*indices_desc, primitive_data.indices.data());
+		}
+		else
+		{
+			for (cgltf_size index_idx = 0; index_idx < primitive.indices->count; ++index_idx)
+			{
+				primitive_data.indices[index_idx] = (uint32_t) cgltf_accessor_read_index(primitive.indices, index_idx);
+			}
+		}
+	}
+
+	//FCS TODO: if gltf doesn't give us index data, flag instance and avoid index lookup in shader
+	assert(primitive_data.indices.size() > 0);
+
+	// Each attribute is gathered straight into its field of every vertex. Missing attributes are left zeroed
+	const cgltf_accessor* positions = FindAttributeAccessor(primitive, cgltf_attribute_type_position);
+	if (positions && positions->count > 0)
+	{
+		std::vector<Vertex>& vertices = primitive_data.vertices;
+		vertices.resize(positions->count);
+		read_accessor_floats(positions, &vertices[0].position, sizeof(Vertex), 3, ACCESSOR_FILL_ZERO);
+
+		const cgltf_accessor* normals = FindAttributeAccessor(primitive, cgltf_attribute_type_normal);
+		const cgltf_accessor* colors = FindAttributeAccessor(primitive, cgltf_attribute_type_color);
+		const cgltf_accessor* texcoords = FindAttributeAccessor(primitive, cgltf_attribute_type_texcoord);
+		if (normals && normals->count == positions->count)
+		{
+			read_accessor_floats(normals, &vertices[0].normal, sizeof(Vertex), 3, ACCESSOR_FILL_ZERO);
+		}
+		if (colors && colors->count == positions->count)
+		{
+			// RGBA colors drop their alpha, Vertex::color is RGB
+			read_accessor_floats(colors, &vertices[0].color, sizeof(Vertex), 3, ACCESSOR_FILL_ZERO);
+		}
+		if (texcoords && texcoords->count == positions->count)
+		{
+			read_accessor_floats(texcoords, &vertices[0].texcoord, sizeof(Vertex), 2, ACCESSOR_FILL_ZERO);
+			if (const cgltf_texture_transform* texture_transform = find_texture_transform(primitive.material))
+			{
+				apply_texture_transform(*texture_transform, vertices);
+			}
+		}
+	}
+
+	return primitive_data;
+}
+
+// Hashes an accessor's format and data. Returns 0 for a null accessor
+uint64_t hash_accessor(const cgltf_accessor* in_accessor)
+{
+	if (!in_accessor)
+	{
+		return 0;
+	}
+
+	uint64_t hash = hash_combine(in_accessor->count, ((uint64_t) in_accessor->component_type << 32) | ((uint64_t) in_accessor->type << 1) | in_accessor->normalized);
+	if (optional<AccessorDesc> desc = get_accessor_desc(in_accessor))
+	{
+		// Every byte from the first element to the end of the last. With interleaved data that covers other attributes too, which at worst
+		// makes an unrelated change look like a change to this accessor
+		const size_t element_size = cgltf_calc_size(in_accessor->type, in_accessor->component_type);
+		const size_t data_size = desc->count > 0 ? (desc->count - 1) * desc->stride + element_size : 0;
+		return hash_combine(hash_combine(hash, desc->stride), ankerl::unordered_dense::detail::wyhash::hash(desc->data, data_size));
+	}
+
+	// Sparse accessors and accessors without a buffer view are hashed by value
+	vector<float> unpacked(in_accessor->count * cgltf_num_components(in_accessor->type));
+	cgltf_accessor_unpack_floats(in_accessor, unpacked.data(), unpacked.size());
+	return hash_combine(hash, ankerl::unordered_dense::detail::wyhash::hash(unpacked.data(), unpacked.size() * sizeof(float)));
+}
+
+/*	Hashes everything process_primitive reads from a primitive, so a primitive whose hash hasn't changed converts to the same mesh.
+	Only reads from the primitive, so this is safe to run in parallel
+*/
+uint64_t hash_primitive(cgltf_primitive& in_primitive, const uint32_t in_material_index)
+{
+	uint64_t hash = hash_combine(hash_accessor(in_primitive.indices), in_material_index);
+	for (const cgltf_attribute_type attribute_type : { cgltf_attribute_type_position, cgltf_attribute_type_normal, cgltf_attribute_type_color, cgltf_attribute_type_texcoord })
+	{
+		hash = hash_combine(hash, hash_accessor(FindAttributeAccessor(in_primitive, attribute_type)));
+	}
+
+	if (const cgltf_texture_transform* texture_transform = find_texture_transform(in_primitive.material))
+	{
+		const float transform[] = { texture_transform->offset[0], texture_transform->offset[1], texture_transform->rotation, texture_transform->scale[0], texture_transform->scale[1] };
+		hash = hash_combine(hash, ankerl::unordered_dense::detail::wyhash::hash(transform, sizeof(transform)));
+	}
+	return hash;
+}
+
+// Reorders triangles for post-transform cache locality, then vertices into first-use order for fetch locality
+void optimize_mesh(GltfMeshData& io_mesh)
+{
+	optimize_vertex_cache(io_mesh.indices, io_mesh.vertices.size());
+	optimize_vertex_fetch(io_mesh.indices, io_mesh.vertices);
+}
+
+// Packs indices and vertices into their GPU format. 
+// Indices stay at 16 bits whenever the mesh's vertex count allows it. 
+// Vertices are split into position and attribute streams, and quantized against the mesh's AABB for VertexFormat::Compact
+void cook_mesh(GltfMeshData& io_mesh, const VertexFormat in_vertex_format)
+{
+	const size_t index_count = io_mesh.indices.size();
+	io_mesh.index_stride = get_index_stride(io_mesh.vertices.size());
+
+	// Pad to 4 bytes so the index buffer can be viewed as a raw buffer
+	io_mesh.index_data.assign(align_up(index_count * io_mesh.index_stride, 4), 0);
+	narrow_indices(io_mesh.indices.data(), index_count, io_mesh.index_stride, io_mesh.index_data.data());
+
+	io_mesh.vertex_format = in_vertex_format;
+	const VertexStreams streams = split_vertex_streams(io_mesh.vertices);
+	io_mesh.bounds = compute_bounds(streams.positions);
+	if (in_vertex_format == VertexFormat::Full)
+	{
+		const span<const float3> positions = streams.positions;
+		const span<const VertexAttributes> attributes = streams.attributes;
+		io_mesh.position_data.assign((const uint8_t*) positions.data(), (const uint8_t*) positions.data() + positions.size_bytes());
+		io_mesh.attribute_data.assign((const uint8_t*) attributes.data(), (const uint8_t*) attributes.data() + attributes.size_bytes());
+	}
+	else if (io_mesh.vertices.size() > 0)
+	{
+		io_mesh.position_min = io_mesh.bounds.aabb_min;
+		io_mesh.position_extent = io_mesh.bounds.aabb_max - io_mesh.bounds.aabb_min;
+
+		io_mesh.position_data.resize(streams.size() * sizeof(CompactVertexPosition));
+		io_mesh.attribute_data.resize(streams.size() * sizeof(CompactVertexAttributes));
+		CompactVertexPosition* out_positions = reinterpret_cast<CompactVertexPosition*>(io_mesh.position_data.data());
+		CompactVertexAttributes* out_attributes = reinterpret_cast<CompactVertexAttributes*>(io_mesh.attribute_data.data());
+		for (size_t i = 0; i < streams.size(); ++i)
+		{
+			out_positions[i] = EncodeCompactVertexPosition(streams.positions[i], io_mesh.position_min, io_mesh.position_extent);
+			out_attributes[i] = EncodeCompactVertexAttributes(streams.attributes[i]);
+		}
+	}
+}
+
+// CPU time process_primitive spends in each of its passes, in milliseconds
+struct PrimitiveProcessingTimes
+{
+	// Reading accessors into vertices and (widened to 32-bit) indices, plus hashing them
+	float convert = 0.0f;
+
+	// Vertex cache and fetch optimization, including the before and after vertex cache analysis
+	float optimize = 0.0f;
+	float meshlets = 0.0f;
+	float lods = 0.0f;
+
+	// Index narrowing, vertex stream splitting and quantization, and bounds
+	float cook = 0.0f;
+
+	float GetTotal() const { return convert + optimize + meshlets + lods + cook; }
+
+	PrimitiveProcessingTimes& operator+=(const PrimitiveProcessingTimes& in_other)
+	{
+		convert += in_other.convert;
+		optimize += in_other.optimize;
+		meshlets += in_other.meshlets;
+		lods += in_other.lods;
+		cook += in_other.cook;
+		return *this;
+	}
+};
+
+/*	Runs every pass a primitive goes through on its way to the GPU: conversion, optimization, meshlets, LODs and cooking.
+	Vertex cache stats before and after optimization and the time spent in each pass are written to the optional out_* parameters. Safe to run in parallel
+*/
+GltfMeshData process_primitive(
+	cgltf_primitive& in_primitive, 
+	const cgltf_data& in_data, 
+	const VertexFormat in_vertex_format, 
+	VertexCacheStats* out_unoptimized_stats = nullptr, 
+	VertexCacheStats* out_optimized_stats = nullptr,
+	PrimitiveProcessingTimes* out_times = nullptr
+)
+{
+	using milliseconds = std::chrono::duration<float, std::milli>;
+	auto pass_start_time = std::chrono::high_resolution_clock::now();
+	auto end_pass = [&](float PrimitiveProcessingTimes::* in_pass)
+	{
+		const auto now = std::chrono::high_resolution_clock::now();
+		if (out_times)
+		{
+			out_times->*in_pass += std::chrono::duration_cast<milliseconds>(now - pass_start_time).count();
+		}
+		pass_start_time = now;
+	};
+
+	GltfMeshData mesh_data = convert_primitive(in_primitive);
+	if (const cgltf_material* material = in_primitive.material)
+	{
+		mesh_data.material_index = (uint32_t) (material - in_data.materials);
+	}
+	mesh_data.source_hash = hash_primitive(in_primitive, mesh_data.material_index);
+	end_pass(&PrimitiveProcessingTimes::convert);
+
+	if (out_unoptimized_stats)
+	{
+		*out_unoptimized_stats = analyze_vertex_cache(mesh_data.indices, mesh_data.vertices.size());
+	}
+	optimize_mesh(mesh_data);
+	if (out_optimized_stats)
+	{
+		*out_optimized_stats = analyze_vertex_cache(mesh_data.indices, mesh_data.vertices.size());
+	}
+	end_pass(&PrimitiveProcessingTimes::optimize);
+
+	mesh_data.meshlet_data = build_meshlets(mesh_data.indices, mesh_data.vertices);
+	end_pass(&PrimitiveProcessingTimes::meshlets);
+
+	mesh_data.lods = build_mesh_lods(mesh_data.indices, mesh_data.vertices);
+	end_pass(&PrimitiveProcessingTimes::lods);
+
+	cook_mesh(mesh_data, in_vertex_format);
+	end_pass(&PrimitiveProcessingTimes::cook);
+	return mesh_data;
+}
+
+// Flattens the default scene into unique meshes and per-node instances. Transforms don't include GltfInitData::transform, so cooked scenes don't depend on it
+GltfSceneLayout extract_scene_layout(const cgltf_data& in_data)
+{
+	GltfSceneLayout scene_layout;
+	if (const cgltf_scene* scene = in_data.scene)
+	{
+		for (cgltf_size root_node_idx = 0; root_node_idx < scene->nodes_count; ++root_node_idx)
+		{
+			recurse_node(scene->nodes[root_node_idx], Matrix::Identity(), scene_layout);
+		}
+	}
+	return scene_layout;
+}
+
+/*	Collapses meshes whose primitives hash the same (see hash_primitive) into the first of them, pointing their instances at it.
+	Catches gltfs that repeat a primitive's data, or its accessors, under another mesh instead of referencing the same mesh, which
+	recurse_node can't tell apart. Needs the buffers loaded. Hashing is spread across in_thread_pool's threads, if there is one
+*/
+void dedupe_scene_layout(const cgltf_data& in_data, GltfSceneLayout& io_layout, ThreadPool* in_thread_pool)
+{
+	const size_t primitive_count = io_layout.meshes.size();
+	vector<uint64_t> primitive_hashes(primitive_count);
+	auto hash_job = [&](size_t primitive_idx)
+	{
+		cgltf_primitive& primitive = *io_layout.meshes[primitive_idx];
+		const uint32_t material_index = primitive.material ? (uint32_t) (primitive.material - in_data.materials) : INVALID_MATERIAL_INDEX;
+		primitive_hashes[primitive_idx] = hash_primitive(primitive, material_index);
+	};
+
+	if (in_thread_pool)
+	{
+		in_thread_pool->ParallelFor(primitive_count, hash_job);
+	}
+	else
+	{
+		for (size_t primitive_idx = 0; primitive_idx < primitive_count; ++primitive_idx)
+		{
+			hash_job(primitive_idx);
+		}
+	}
+
+	HashMap<uint64_t, uint32_t> hash_lookup;
+	vector<uint32_t> mesh_remap(primitive_count);
+	vector<cgltf_primitive*> unique_meshes;
+	io_layout.mesh_hashes.clear();
+	for (size_t primitive_idx = 0; primitive_idx < primitive_count; ++primitive_idx)
+	{
+		auto [hash_it, inserted] = hash_lookup.try_emplace(primitive_hashes[primitive_idx], (uint32_t) unique_meshes.size());
+		if (inserted)
+		{
+			unique_meshes.push_back(io_layout.meshes[primitive_idx]);
+			io_layout.mesh_hashes.push_back(primitive_hashes[primitive_idx]);
+		}
+		mesh_remap[primitive_idx] = hash_it->second;
+	}
+
+	for (auto& [primitive, mesh_index] : io_layout.mesh_lookup)
+	{
+		mesh_index = mesh_remap[mesh_index];
+	}
+	for (GltfMeshInstance& instance : io_layout.instances)
+	{
+		instance.mesh_index = mesh_remap[instance.mesh_index];
+	}
+	io_layout.meshes = std::move(unique_meshes);
+}
+
+struct GltfConvertedMeshes
+{
+	vector<GltfMeshData> meshes;
+	VertexCacheStats unoptimized_stats;
+	VertexCacheStats optimized_stats;
+
+	// Summed over every mesh, so this is CPU time rather than wall time when meshes are converted in parallel
+	PrimitiveProcessingTimes times;
+};
+
+// Runs process_primitive on every one of in_primitives, in parallel if there's a thread pool. Meshes are in the same order as in_primitives
+GltfConvertedMeshes convert_primitives(span<cgltf_primitive* const> in_primitives, const cgltf_data& in_data, const VertexFormat in_vertex_format, ThreadPool* in_thread_pool)
+{
+	GltfConvertedMeshes result;
+	result.meshes.resize(in_primitives.size());
+	vector<VertexCacheStats> unoptimized_stats(in_primitives.size());
+	vector<VertexCacheStats> optimized_stats(in_primitives.size());
+	vector<PrimitiveProcessingTimes> times(in_primitives.size());
+	auto convert_job = [&](size_t mesh_idx)
+	{
+		result.meshes[mesh_idx] = process_primitive(*in_primitives[mesh_idx], in_data, in_vertex_format, &unoptimized_stats[mesh_idx], &optimized_stats[mesh_idx], &times[mesh_idx]);
+	};
+
+	if (in_thread_pool)
+	{
+		in_thread_pool->ParallelFor(in_primitives.size(), convert_job);
+	}
+	else
+	{
+		for (size_t mesh_idx = 0; mesh_idx < in_primitives.size(); ++mesh_idx)
+		{
+			convert_job(mesh_idx);
+		}
+	}
+
+	for (size_t mesh_idx = 0; mesh_idx < in_primitives.size(); ++mesh_idx)
+	{
+		result.unoptimized_stats += unoptimized_stats[mesh_idx];
+		result.optimized_stats += optimized_stats[mesh_idx];
+		result.times += times[mesh_idx];
+	}
+	return result;
+}
+
+// Which meshes of a reloaded scene can keep what was converted for them last time, see plan_scene_reload
+struct GltfReloadPlan
+{
+	// For each mesh of the reloaded layout, the loaded mesh it reuses, or UINT32_MAX if it has to be converted
+	vector<uint32_t> reused_meshes;
+
+	// Meshes of the reloaded layout that have to be converted, in order
+	vector<uint32_t> changed_meshes;
+
+	// For each loaded mesh, whether the reloaded layout still uses it. The others can be freed
+	vector<bool> kept_meshes;
+};
+
+/*	Matches the meshes of in_layout (after dedupe_scene_layout) up with the loaded ones by hash, so moved or reordered primitives are found
+	again and only new or edited ones are converted. in_loaded_mesh_hashes are the mesh_hashes the loaded meshes were deduplicated with
+*/
+GltfReloadPlan plan_scene_reload(const GltfSceneLayout& in_layout, span<const uint64_t> in_loaded_mesh_hashes)
+{
+	HashMap<uint64_t, uint32_t> loaded_mesh_lookup;
+	for (uint32_t loaded_mesh_idx = 0; loaded_mesh_idx < in_loaded_mesh_hashes.size(); ++loaded_mesh_idx)
+	{
+		loaded_mesh_lookup.try_emplace(in_loaded_mesh_hashes[loaded_mesh_idx], loaded_mesh_idx);
+	}
+
+	GltfReloadPlan plan;
+	plan.reused_meshes.resize(in_layout.mesh_hashes.size(), UINT32_MAX);
+	plan.kept_meshes.resize(in_loaded_mesh_hashes.size(), false);
+	for (uint32_t mesh_idx = 0; mesh_idx < in_layout.mesh_hashes.size(); ++mesh_idx)
+	{
+		auto loaded_mesh_it = loaded_mesh_lookup.find(in_layout.mesh_hashes[mesh_idx]);
+		if (loaded_mesh_it != loaded_mesh_lookup.end())
+		{
+			plan.reused_meshes[mesh_idx] = loaded_mesh_it->second;
+			plan.kept_meshes[loaded_mesh_it->second] = true;
+		}
+		else
+		{
+			plan.changed_meshes.push_back(mesh_idx);
+		}
+	}
+	return plan;
+}
+
+// The gltf itself and every external buffer it references. Everything a cooked scene is converted from
+vector<string> get_gltf_source_files(const cgltf_data& in_data, const string& in_file)
+{
+	vector<string> source_files = { in_file };
+	for (cgltf_size buffer_idx = 0; buffer_idx < in_data.buffers_count; ++buffer_idx)
+	{
+		const char* uri = in_data.buffers[buffer_idx].uri;
+		if (uri && strncmp(uri, "data:", 5) != 0)
+		{
+			string decoded_uri = uri;
+			decoded_uri.resize(cgltf_decode_uri(decoded_uri.data()));
+			source_files.push_back((std::filesystem::path(in_file).parent_path() / decoded_uri).string());
+		}
+	}
+	return source_files;
+}
+
+// Where load_gltf_geometry reads a gltf's geometry from, and what it converts it into
+struct GltfGeometryDesc
+{
+	const char* file = nullptr;
+
+	// Load from (and write out) a cooked binary cache next to file, skipping buffer loading and mesh conversion when it's up to date
+	bool use_scene_cache = true;
+
+	// Compression of a scene cache written by the load. Compressed caches are read regardless of this
+	SceneCacheCompression scene_cache_compression = SceneCacheCompression::None;
+
+	VertexFormat vertex_format = VertexFormat::Compact;
+
+	// Optional. If set, cache decompression and primitive conversion are spread across this pool's threads
+	ThreadPool* thread_pool = nullptr;
+};
+
+/*	A gltf's parsed JSON plus its unique meshes and instances, filled out by load_gltf_geometry.
+	meshes and instances are views into either scene_cache or converted_meshes/scene_layout, whichever the geometry was loaded from,
+	so this can't be copied or moved
+*/
+struct GltfGeometry
+{
+	GltfGeometry() = default;
+	~GltfGeometry() { cgltf_free(data); }
+	DISALLOW_COPY(GltfGeometry);
+	DISALLOW_MOVE(GltfGeometry);
+
+	// Always parsed, since materials aren't cached. Buffers are only loaded if buffers_loaded
+	cgltf_data* data = nullptr;
+	bool buffers_loaded = false;
+
+	// The gltf and any external buffers, see get_gltf_source_files
+	vector<string> source_files;
+
+	vector<GltfMeshView> meshes;
+	span<const GltfMeshInstance> instances;
+
+	bool loaded_from_cache = false;
+	SceneCache scene_cache;
+
+	// Only filled out when the geometry was converted rather than loaded from the cache
+	GltfSceneLayout scene_layout;
+	vector<GltfMeshData> converted_meshes;
+	VertexCacheStats unoptimized_stats;
+	VertexCacheStats optimized_stats;
+
+	// Wall time of the conversion, in milliseconds
+	float convert_time = 0.0f;
+};
+
+/*	The CPU half of GltfScene::Load: parses in_desc.file, then either opens its scene cache or loads, decodes and converts its buffers
+	(writing a new cache if use_scene_cache is set). Failing to write the cache isn't fatal.
+	Returns false, with out_geometry left empty, if the gltf can't be parsed or its buffers can't be loaded
+*/
+bool load_gltf_geometry(const GltfGeometryDesc& in_desc, GltfGeometry& out_geometry)
+{
+	cgltf_options options = {};
+	if (cgltf_parse_file(&options, in_desc.file, &out_geometry.data) != cgltf_result_success)
+	{
+		printf("GltfScene: Failed to parse %s\n", in_desc.file);
+		out_geometry.data = nullptr;
+		return false;
+	}
+
+	cgltf_data& data = *out_geometry.data;
+	out_geometry.source_files = get_gltf_source_files(data, in_desc.file);
+
+	const string scene_cache_path = get_scene_cache_path(in_desc.file);
+	const int64_t source_file_age = get_file_age(in_desc.file);
+	auto get_source_content_hash = [&]() { return hash_file_contents(out_geometry.source_files); };
+	out_geometry.loaded_from_cache = in_desc.use_scene_cache
+		&& out_geometry.scene_cache.Open(scene_cache_path, source_file_age, in_desc.vertex_format, get_source_content_hash, in_desc.thread_pool);
+	if (out_geometry.loaded_from_cache)
+	{
+		out_geometry.meshes = out_geometry.scene_cache.GetMeshes();
+		out_geometry.instances = out_geometry.scene_cache.GetInstances();
+		return true;
+	}
+
+	if (cgltf_load_buffers(&options, &data, in_desc.file) != cgltf_result_success)
+	{
+		printf("GltfScene: Failed to load buffers of %s\n", in_desc.file);
+		cgltf_free(out_geometry.data);
+		out_geometry.data = nullptr;
+		out_geometry.source_files.clear();
+		return false;
+	}
+	out_geometry.buffers_loaded = true;
+
+	// Accessors in compressed buffer views read zeros if they fail to decode
+	if (!decode_meshopt_buffer_views(data, in_desc.thread_pool))
+	{
+		printf("GltfScene: Failed to decode meshopt compressed buffer views in %s\n", in_desc.file);
+	}
+
+	// Phase 1: Flatten default scene into unique meshes and instances
+	GltfSceneLayout& scene_layout = out_geometry.scene_layout;
+	scene_layout = extract_scene_layout(data);
+	dedupe_scene_layout(data, scene_layout, in_desc.thread_pool);
+
+	// Phase 2: Convert each unique mesh once, in the same order as scene_layout.meshes
+	const auto convert_start_time = std::chrono::high_resolution_clock::now();
+	GltfConvertedMeshes converted = convert_primitives(scene_layout.meshes, data, in_desc.vertex_format, in_desc.thread_pool);
+	out_geometry.converted_meshes = std::move(converted.meshes);
+	out_geometry.unoptimized_stats = converted.unoptimized_stats;
+	out_geometry.optimized_stats = converted.optimized_stats;
+
+	using milliseconds = std::chrono::duration<float, std::milli>;
+	out_geometry.convert_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - convert_start_time).count();
+
+	scene_layout.meshes.clear();
+	scene_layout.mesh_lookup.clear();
+	scene_layout.mesh_hashes.clear();
+
+	out_geometry.meshes.reserve(out_geometry.converted_meshes.size());
+	for (const GltfMeshData& mesh_data : out_geometry.converted_meshes)
+	{
+		out_geometry.meshes.push_back(mesh_data.GetView());
+	}
+	out_geometry.instances = scene_layout.instances;
+
+	if (in_desc.use_scene_cache
+		&& !write_scene_cache(scene_cache_path, source_file_age, out_geometry.meshes, scene_layout.instances, get_source_content_hash(), in_desc.scene_cache_compression, in_desc.thread_pool))
+	{
+		printf("GltfScene: Failed to write scene cache %s\n", scene_cache_path.c_str());
+	}
+	return true;
+}
@@ -2,375 +2,1358 @@
 
 #include "cgltf/cgltf.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <deque>
+#include <filesystem>
 #include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 using std::optional;
 using std::nullopt;
 
+#include "GltfConversion.h"
 #include "GpuResources.h"
 #include "SimpleMath/SimpleMath.h"
 using namespace DirectX::SimpleMath;
 #include "../Shaders/HLSL_Types.h"
+#include "SceneCache.h"
+#include "StreamingCopy.h"
+#include "TextureCache.h"
+#include "TextureCompression.h"
+#include "TextureProcessing.h"
+#include "TextureStreaming.h"
+#include "ThreadPool.h"
+#include "UploadManager.h"
+#include "VertexStreams.h"
 
 struct GltfInitData
 {
 	const char* file = nullptr;
 	Matrix transform = Matrix::Identity();
-	ComPtr<ID3D12Device5> device = nullptr;
+
+	// Load from (and write out) a cooked binary cache next to file, skipping buffer loading and mesh conversion when it's up to date.
+	// The gltf's JSON is still parsed for its materials
+	bool use_scene_cache = true;
+
+	// Compression of a scene cache written on load. Compressed caches (e.g. from the Cooker) are read regardless of this
+	SceneCacheCompression scene_cache_compression = SceneCacheCompression::None;
+
+	// Decode, mip and upload the images referenced by the scene's materials. Without them materials only have their constant factors
+	bool load_textures = true;
+
+	// Block compression applied to textures when they're cooked. With use_scene_cache they're only cooked once and then loaded from a texture cache
+	TextureCompression texture_compression = TextureCompression::HighQuality;
+
+	// Bytes of detailed texture mips allowed on the GPU, streamed in and out with UpdateTextureStreaming. 0 keeps every mip resident
+	uint64_t texture_streaming_budget = 256ull * 1024 * 1024;
+
+	// Added to the mip each instance's screen size asks for. Negative makes up for textures that tile across their mesh
+	float texture_streaming_mip_bias = -1.0f;
+
+	// Compact trades a little precision for less than half the vertex memory and fetch bandwidth
+	VertexFormat vertex_format = VertexFormat::Compact;
+
 	D3D12MA::Allocator* allocator = nullptr;
-	ComPtr<ID3D12CommandQueue> command_queue = nullptr;
 	BindlessResourceManager* bindless_resource_manager = nullptr;
+
+	// Every geometry and texture upload goes through this, on the loading thread and (with texture streaming) the render thread.
+	// Must outlive the scene, and be idle before the scene is destroyed
+	UploadManager* upload_manager = nullptr;
+
+	// Every mesh's GPU data is sub-allocated from here
+	GeometryPool* geometry_pool = nullptr;
+
+	// Optional. If set, primitive conversion and texture cooking are spread across this pool's threads
+	ThreadPool* thread_pool = nullptr;
 };
 
 struct GltfLoadContext
 {
 	// Passed via GltfInitData 
-	ComPtr<ID3D12Device5> device = nullptr;
 	D3D12MA::Allocator* allocator = nullptr;
-	ComPtr<ID3D12CommandQueue> command_queue = nullptr;
 	BindlessResourceManager* bindless_resource_manager = nullptr;
+	GeometryPool* geometry_pool = nullptr;
 
-	// Setup using above
-	ComPtr<ID3D12CommandAllocator> command_allocator;
-	ComPtr<ID3D12GraphicsCommandList> command_list;
-
-	// Pending Uploads
-	vector<BufferUploadResult> pending_buffer_uploads;
+	// Every geometry and texture upload goes through this
+	UploadManager* upload_manager = nullptr;
 };
 
-// Holds the actual vertex/index buffer
+// GPU-side location of a single unique mesh's data, plus what's needed to build its instances and draws
 struct GltfRenderData
 {
-	Matrix transform;
-	GpuBuffer vertex_buffer;
-	optional<GpuBuffer> index_buffer;
+	// Every section of the mesh (see GltfMeshView::GetSections) lives in this one allocation
+	GeometryAllocation geometry;
+	uint32_t geometry_buffer_index;
+
+	// Byte offsets of each section in the geometry pool page
+	uint32_t index_offset;
+	uint32_t position_offset;
+	uint32_t attribute_offset;
+	uint32_t meshlet_offset;
+	uint32_t meshlet_vertex_offset;
+	uint32_t meshlet_triangle_offset;
+	uint32_t lod_offset;
+
 	size_t indices_count;
+	uint32_t index_stride;
+
+	VertexFormat vertex_format;
+	float3 position_min;
+	float3 position_extent;
+
+	// Mesh space. Instances transform these into their GpuInstanceBounds
+	Bounds bounds;
+
+	uint32_t meshlet_count;
+
+	// CPU copy of the mesh's LOD table, for CPU draw generation
+	vector<MeshLod> lods;
+
+	uint32_t material_index;
 };
 
-cgltf_attribute* FindAttribute(cgltf_primitive& in_primitive, cgltf_attribute_type in_type)
+// Sub-allocates a single geometry pool range for all of a mesh's sections and queues their uploads into it
+GltfRenderData upload_mesh(GltfLoadContext& load_ctx, const GltfMeshView& in_mesh)
 {
-	for (int32_t attr_idx = 0; attr_idx < in_primitive.attributes_count; ++attr_idx)
+	const std::array<span<const uint8_t>, GltfMeshView::SECTION_COUNT> sections = in_mesh.GetSections();
+
+	std::array<uint64_t, GltfMeshView::SECTION_COUNT> section_offsets;
+	uint64_t geometry_size = 0;
+	for (size_t section_idx = 0; section_idx < sections.size(); ++section_idx)
+	{
+		section_offsets[section_idx] = geometry_size;
+		geometry_size = align_up(geometry_size + sections[section_idx].size_bytes(), GEOMETRY_POOL_ALIGNMENT);
+	}
+
+	const GeometryAllocation geometry = load_ctx.geometry_pool->Allocate(geometry_size);
+	GpuBuffer& page_buffer = load_ctx.geometry_pool->GetPageBuffer(geometry.page_index);
+	for (size_t section_idx = 0; section_idx < sections.size(); ++section_idx)
 	{
-		cgltf_attribute* attribute = &in_primitive.attributes[attr_idx];
-		if (attribute->type == in_type)
+		section_offsets[section_idx] += geometry.offset;
+		if (sections[section_idx].size_bytes() > 0)
 		{
-			return attribute;
+			load_ctx.upload_manager->Upload(page_buffer, section_offsets[section_idx], sections[section_idx].data(), sections[section_idx].size_bytes());
 		}
 	}
-	return nullptr;
+
+	return GltfRenderData {
+		.geometry = geometry,
+		.geometry_buffer_index = load_ctx.geometry_pool->GetPageBindlessIndex(geometry.page_index),
+		.index_offset = (uint32_t) section_offsets[0],
+		.position_offset = (uint32_t) section_offsets[1],
+		.attribute_offset = (uint32_t) section_offsets[2],
+		.meshlet_offset = (uint32_t) section_offsets[3],
+		.meshlet_vertex_offset = (uint32_t) section_offsets[4],
+		.meshlet_triangle_offset = (uint32_t) section_offsets[5],
+		.lod_offset = (uint32_t) section_offsets[6],
+		.indices_count = in_mesh.index_count,
+		.index_stride = in_mesh.index_stride,
+		.vertex_format = in_mesh.vertex_format,
+		.position_min = in_mesh.position_min,
+		.position_extent = in_mesh.position_extent,
+		.bounds = in_mesh.bounds,
+		.meshlet_count = (uint32_t) in_mesh.meshlets.size(),
+		.lods = vector<MeshLod>(in_mesh.lods.begin(), in_mesh.lods.end()),
+		.material_index = in_mesh.material_index,
+	};
+}
+
+// A unique (image, usage) pair referenced by the scene's materials
+struct GltfTextureSource
+{
+	// Either an image file next to the gltf, or encoded image data embedded in the gltf itself (buffer view or data URI)
+	string path;
+	vector<uint8_t> embedded_data;
+	TextureUsage usage = TextureUsage::Color;
+
+	// Material texture slots to point at this texture once it's resident
+	vector<std::pair<uint32_t, uint32_t GpuMaterialData::*>> material_slots;
 };
 
-struct GltfBufferData
+struct GltfMaterialSet
 {
-	uint8_t* buffer;
-	cgltf_size count;
-	cgltf_size stride;
+	// Indexed by gltf material index. Texture slots all start out as INVALID_BINDLESS_INDEX
+	vector<GpuMaterialData> materials;
+	vector<GltfTextureSource> textures;
 };
 
-optional<GltfBufferData> GetAccessorBuffer(cgltf_accessor* accessor)
+// Embedded images are read out of the gltf's buffers, so those need loading first
+bool has_embedded_images(const cgltf_data& in_data)
+{
+	for (cgltf_size image_idx = 0; image_idx < in_data.images_count; ++image_idx)
+	{
+		if (in_data.images[image_idx].buffer_view)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Converts every gltf material to a GpuMaterialData and gathers the images they reference.
+// Images used in slots with different usages (e.g. as both sRGB color and linear data) are loaded once for each
+GltfMaterialSet parse_materials(const cgltf_data& in_data, const char* in_gltf_path)
 {
-	if (accessor && !accessor->is_sparse)
+	GltfMaterialSet material_set;
+	material_set.materials.reserve(in_data.materials_count);
+
+	// (image index, usage) -> index in material_set.textures
+	HashMap<uint64_t, uint32_t> texture_lookup;
+	const std::filesystem::path gltf_directory = std::filesystem::path(in_gltf_path).parent_path();
+
+	for (cgltf_size material_idx = 0; material_idx < in_data.materials_count; ++material_idx)
 	{
-		uint8_t* buffer = (uint8_t*) accessor->buffer_view->buffer->data;
-		buffer += accessor->offset + accessor->buffer_view->offset;
-		cgltf_size stride = accessor->stride;
-
-		GltfBufferData out_data = {
-			.buffer = buffer,
-			.count = accessor->count,
-			.stride = stride,
+		const cgltf_material& material = in_data.materials[material_idx];
+		const cgltf_pbr_metallic_roughness& pbr = material.pbr_metallic_roughness;
+
+		GpuMaterialData gpu_material = {
+			.base_color_factor = material.has_pbr_metallic_roughness ? float4(pbr.base_color_factor) : float4(1.0f, 1.0f, 1.0f, 1.0f),
+			.emissive_factor = float3(material.emissive_factor),
+			.metallic_factor = material.has_pbr_metallic_roughness ? pbr.metallic_factor : 1.0f,
+			.roughness_factor = material.has_pbr_metallic_roughness ? pbr.roughness_factor : 1.0f,
+			.normal_scale = material.normal_texture.texture ? material.normal_texture.scale : 1.0f,
+			.occlusion_strength = material.occlusion_texture.texture ? material.occlusion_texture.scale : 1.0f,
+			.alpha_cutoff = material.alpha_mode == cgltf_alpha_mode_mask ? material.alpha_cutoff : 0.0f,
+			.base_color_texture_index = INVALID_BINDLESS_INDEX,
+			.metallic_roughness_texture_index = INVALID_BINDLESS_INDEX,
+			.normal_texture_index = INVALID_BINDLESS_INDEX,
+			.occlusion_texture_index = INVALID_BINDLESS_INDEX,
+			.emissive_texture_index = INVALID_BINDLESS_INDEX,
+		};
+		if (material.has_emissive_strength)
+		{
+			gpu_material.emissive_factor *= material.emissive_strength.emissive_strength;
+		}
+		material_set.materials.push_back(gpu_material);
+
+		auto add_texture = [&](const cgltf_texture_view& in_texture_view, uint32_t GpuMaterialData::* in_slot, const TextureUsage in_usage)
+		{
+			const cgltf_image* image = in_texture_view.texture ? in_texture_view.texture->image : nullptr;
+			if (!image)
+			{
+				return;
+			}
+
+			const uint64_t texture_key = ((uint64_t) (image - in_data.images) << 2) | (uint64_t) in_usage;
+			auto [texture_it, inserted] = texture_lookup.try_emplace(texture_key, (uint32_t) material_set.textures.size());
+			if (inserted)
+			{
+				GltfTextureSource texture_source;
+				texture_source.usage = in_usage;
+				if (image->buffer_view)
+				{
+					// Null if the gltf's buffers weren't loaded, in which case decoding this texture just fails
+					if (const uint8_t* image_data = cgltf_buffer_view_data(image->buffer_view))
+					{
+						texture_source.embedded_data.assign(image_data, image_data + image->buffer_view->size);
+					}
+				}
+				else if (image->uri && strncmp(image->uri, "data:", 5) == 0)
+				{
+					// Base64 data URI: "data:image/png;base64,..."
+					if (const char* base64 = strstr(image->uri, ";base64,"))
+					{
+						base64 += strlen(";base64,");
+						const size_t base64_size = strlen(base64);
+						const size_t padding_size = (base64_size > 0 && base64[base64_size - 1] == '=') + (base64_size > 1 && base64[base64_size - 2] == '=');
+						const size_t decoded_size = base64_size / 4 * 3 - padding_size;
+
+						cgltf_options options = {};
+						void* decoded_data = nullptr;
+						if (cgltf_load_buffer_base64(&options, decoded_size, base64, &decoded_data) == cgltf_result_success)
+						{
+							texture_source.embedded_data.assign((const uint8_t*) decoded_data, (const uint8_t*) decoded_data + decoded_size);
+							free(decoded_data);
+						}
+					}
+				}
+				else if (image->uri)
+				{
+					// URIs may be percent-encoded
+					string uri = image->uri;
+					uri.resize(cgltf_decode_uri(uri.data()));
+					texture_source.path = (gltf_directory / uri).string();
+				}
+				material_set.textures.push_back(std::move(texture_source));
+			}
+
+			material_set.textures[texture_it->second].material_slots.emplace_back((uint32_t) material_idx, in_slot);
 		};
 
-		return out_data;
+		if (material.has_pbr_metallic_roughness)
+		{
+			add_texture(pbr.base_color_texture, &GpuMaterialData::base_color_texture_index, TextureUsage::Color);
+			add_texture(pbr.metallic_roughness_texture, &GpuMaterialData::metallic_roughness_texture_index, TextureUsage::Data);
+		}
+		add_texture(material.normal_texture, &GpuMaterialData::normal_texture_index, TextureUsage::NormalMap);
+		add_texture(material.occlusion_texture, &GpuMaterialData::occlusion_texture_index, TextureUsage::Data);
+		add_texture(material.emissive_texture, &GpuMaterialData::emissive_texture_index, TextureUsage::Color);
 	}
 
-	return nullopt;
+	return material_set;
 }
 
-optional<GltfBufferData> GetAttributeBuffer(cgltf_primitive& in_primitive, cgltf_attribute_type in_type)
+/*	Decodes a texture source, generates its full mip chain and block compresses it as in_compression allows. Safe to run in parallel.
+	If in_thread_pool is set, compression is also spread across its threads
+*/
+optional<TextureData> cook_texture(const GltfTextureSource& in_source, const TextureCompression in_compression, ThreadPool* in_thread_pool)
 {
-	if (cgltf_attribute* attribute = FindAttribute(in_primitive, in_type))
+	const bool srgb = in_source.usage == TextureUsage::Color;
+	optional<TextureData> texture = in_source.embedded_data.empty()
+		? decode_image_file(in_source.path.c_str(), srgb)
+		: decode_image(in_source.embedded_data, srgb);
+
+	if (texture)
 	{
-		return GetAccessorBuffer(attribute->data);
+		generate_mips(*texture);
+
+		const TextureFormat format = choose_texture_format(*texture, in_source.usage, in_compression);
+		if (format != TextureFormat::RGBA8)
+		{
+			texture = compress_texture(*texture, format, in_thread_pool);
+		}
 	}
-	return nullopt;
-};
+	return texture;
+}
 
-// Simple wrapper around more generic staging_upload_helper
-BufferUploadResult gltf_staging_upload_helper(
-	const GltfLoadContext& in_load_ctx, 
-	const GpuBufferDesc& in_buffer_desc, 
-	void* in_data, 
-	size_t in_data_size
-)
+DXGI_FORMAT get_dxgi_format(const TextureFormat in_format, const bool in_srgb)
 {
-	BufferUploadDesc upload_desc = 
+	switch (in_format)
 	{
-		.device = in_load_ctx.device,
-		.allocator = in_load_ctx.allocator,
-		.command_list = in_load_ctx.command_list,
-		.upload_data = {
-			.buffer_desc = in_buffer_desc,
-			.buffer_data = in_data,
-			.buffer_data_size = in_data_size,
-		},
-	};
+		case TextureFormat::RGBA8:	return in_srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+		case TextureFormat::BC1:	return in_srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+		case TextureFormat::BC3:	return in_srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+		case TextureFormat::BC5:	assert(!in_srgb); return DXGI_FORMAT_BC5_UNORM;
+		case TextureFormat::BC7:	return in_srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+	}
+	assert(false);
+	return DXGI_FORMAT_UNKNOWN;
+}
 
-	return staging_upload_helper(upload_desc);
+// Creates a texture holding in_texture's mips from in_first_mip on, queues their uploads and registers its SRV
+GpuTexture upload_texture(GltfLoadContext& load_ctx, const TextureView& in_texture, const uint32_t in_first_mip = 0)
+{
+	const TextureMip& first_mip = in_texture.mips[in_first_mip];
+	GpuTexture texture(GpuTextureDesc{
+		.allocator = load_ctx.allocator,
+		.width = first_mip.width,
+		.height = first_mip.height,
+		.mip_levels = (UINT16) (in_texture.mips.size() - in_first_mip),
+		.format = get_dxgi_format(in_texture.format, in_texture.srgb),
+		.resource_flags = D3D12_RESOURCE_FLAG_NONE,
+		.resource_state = D3D12_RESOURCE_STATE_COMMON,
+	});
+
+	const uint32_t block_dim = get_texture_block_dim(in_texture.format);
+	for (uint32_t mip_idx = in_first_mip; mip_idx < in_texture.mips.size(); ++mip_idx)
+	{
+		const TextureMip& mip = in_texture.mips[mip_idx];
+		load_ctx.upload_manager->UploadTexture(texture, mip_idx - in_first_mip, mip.width, in_texture.GetMipData(mip_idx).data(), mip.row_size, mip.row_count, block_dim);
+	}
+
+	load_ctx.bindless_resource_manager->RegisterSRV(texture);
+	return texture;
+}
+
+// Mips this size (in texels, along their longest side) or smaller are always resident when texture streaming is enabled
+static constexpr uint32_t TEXTURE_STREAMING_TAIL_SIZE = 128;
+
+/*	First mip of in_texture's always resident tail. Every mip before it must be able to start a texture of its own,
+	which block compressed formats only allow when its size is a multiple of the block size. 0 means nothing is worth streaming
+*/
+uint32_t get_texture_streaming_tail_mip(const TextureView& in_texture)
+{
+	const uint32_t block_dim = get_texture_block_dim(in_texture.format);
+	uint32_t tail_mip = 0;
+	while (tail_mip + 1 < in_texture.mips.size())
+	{
+		const TextureMip& mip = in_texture.mips[tail_mip];
+		const TextureMip& next_mip = in_texture.mips[tail_mip + 1];
+		if ((std::max)(mip.width, mip.height) <= TEXTURE_STREAMING_TAIL_SIZE || next_mip.width % block_dim != 0 || next_mip.height % block_dim != 0)
+		{
+			break;
+		}
+		++tail_mip;
+	}
+	return tail_mip;
 }
 
-void recurse_node(GltfLoadContext& load_ctx, cgltf_node* in_node, const Matrix& in_matrix, std::vector<GltfRenderData>& result)
-{	
-	Matrix current_matrix = in_node->has_matrix ? Matrix(in_node->matrix) * in_matrix : in_matrix;
+/*	Loading streams the scene to the GPU in chunks, publishing each mesh's draws as soon as its data is resident. 
+	Load is meant to run on a worker thread while the render thread keeps drawing the first GetPublishedDrawCount() draws.
+	A gltf that fails to parse (or whose buffers fail to load) is logged and leaves the scene empty
+*/
+struct GltfScene
+{
+	GltfScene() = default;
+	DISALLOW_COPY(GltfScene);
 
-	if (in_node->mesh)
+	// Returns false, without loading anything, if the gltf can't be parsed or its buffers can't be loaded
+	bool Load(const GltfInitData& init_data)
 	{
-		for (int32_t primtive_idx = 0; primtive_idx < in_node->mesh->primitives_count; ++primtive_idx)
+		const auto load_start_time = std::chrono::high_resolution_clock::now();
+
+		// Parsing the JSON is cheap, and we always need it for materials. Buffers are only loaded when there's something to read out of them
+		GltfGeometry geometry;
+		const GltfGeometryDesc geometry_desc =
+		{
+			.file = init_data.file,
+			.use_scene_cache = init_data.use_scene_cache,
+			.scene_cache_compression = init_data.scene_cache_compression,
+			.vertex_format = init_data.vertex_format,
+			.thread_pool = init_data.thread_pool,
+		};
+		if (!load_gltf_geometry(geometry_desc, geometry))
 		{
-			cgltf_primitive& primitive = in_node->mesh->primitives[primtive_idx];
+			return false;
+		}
+
+		// Kept for Reload. The gltf and any external buffers are what a reload needs to watch
+		m_file = init_data.file;
+		m_init_data = init_data;
+		m_init_data.file = m_file.c_str();
+		m_source_files = geometry.source_files;
 
-			optional<GpuBuffer> index_buffer;
-			cgltf_size indices_count = 0;
-			if (optional<GltfBufferData> indices_data = GetAccessorBuffer(primitive.indices))
+		cgltf_options options = {};
+		cgltf_data* data = geometry.data;
+		const int64_t source_file_age = get_file_age(init_data.file);
+		const vector<GltfMeshView>& meshes = geometry.meshes;
+		const span<const GltfMeshInstance> instances = geometry.instances;
+		if (geometry.loaded_from_cache)
+		{
+			const SceneCache& scene_cache = geometry.scene_cache;
+			if (scene_cache.IsCompressed())
 			{
-				uint32_t* index_data = (uint32_t*) calloc(indices_data->count, sizeof(uint32_t));
+				const float decompress_time = scene_cache.GetDecompressTime();
+				printf(
+					"GltfScene: Decompressed %.2f MB scene cache (%.2f MB on disk) on %zu threads in %.2f ms (%.2f GB/s)\n",
+					scene_cache.GetBodySize() / (1024.0f * 1024.0f),
+					scene_cache.GetFileSize() / (1024.0f * 1024.0f),
+					init_data.thread_pool ? init_data.thread_pool->GetThreadCount() + 1 : 1,
+					decompress_time,
+					decompress_time > 0.0f ? scene_cache.GetBodySize() / (decompress_time * 1.0e6f) : 0.0f
+				);
+			}
+		}
+		else
+		{
+			printf(
+				"GltfScene: Converted %zu meshes on %zu threads in %.2f ms\n",
+				meshes.size(),
+				init_data.thread_pool ? init_data.thread_pool->GetThreadCount() + 1 : 1,
+				geometry.convert_time
+			);
 
-				for (int i = 0; i < indices_data->count; ++i)
-				{
-					if (indices_data->stride == 2)
-					{
-						memcpy(&index_data[i], indices_data->buffer, indices_data->stride);
-					}
-					else if (indices_data->stride == 4)
-					{
-						memcpy(&index_data[i], indices_data->buffer, indices_data->stride);
-					}
+			printf(
+				"GltfScene: Vertex cache (%u entry FIFO) ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+				VERTEX_CACHE_STATS_FIFO_SIZE,
+				geometry.unoptimized_stats.GetACMR(),
+				geometry.optimized_stats.GetACMR(),
+				geometry.unoptimized_stats.GetATVR(),
+				geometry.optimized_stats.GetATVR()
+			);
+		}
+
+		const GltfMeshMemory mesh_memory = get_mesh_memory(meshes);
+		printf(
+			"GltfScene: Mesh memory %.2f MB: indices %.2f MB (%.2f MB as 32-bit, %.1f%% saved, %zu of %zu meshes 16-bit), vertices %.2f MB, meshlets and lods %.2f MB\n",
+			mesh_memory.GetTotalSize() / (1024.0f * 1024.0f),
+			mesh_memory.index_size / (1024.0f * 1024.0f),
+			mesh_memory.wide_index_size / (1024.0f * 1024.0f),
+			mesh_memory.GetIndexSavings() * 100.0f,
+			mesh_memory.narrow_index_mesh_count,
+			mesh_memory.mesh_count,
+			mesh_memory.vertex_size / (1024.0f * 1024.0f),
+			mesh_memory.meshlet_size / (1024.0f * 1024.0f)
+		);
+
+		GltfMaterialSet material_set = parse_materials(*data, init_data.file);
+		if (!init_data.load_textures)
+		{
+			material_set.textures.clear();
+		}
+
+		// Textures are cooked once, then loaded straight out of the texture cache until the gltf or one of their images changes
+		vector<TextureCacheSource> texture_cache_sources;
+		texture_cache_sources.reserve(material_set.textures.size());
+		for (const GltfTextureSource& texture_source : material_set.textures)
+		{
+			texture_cache_sources.push_back(TextureCacheSource {
+				.source_file_age = texture_source.path.empty() ? 0 : get_file_age(texture_source.path.c_str()),
+				.usage = texture_source.usage,
+			});
+		}
+
+		const string texture_cache_path = get_texture_cache_path(init_data.file);
+		const bool textures_from_cache = init_data.use_scene_cache && !material_set.textures.empty()
+			&& m_texture_cache.Open(texture_cache_path, source_file_age, init_data.texture_compression, texture_cache_sources);
+
+		// Embedded images are read out of the gltf's buffers, which loading from the scene cache skips.
+		// If they can't be loaded, embedded textures have no data and fail to decode below, leaving their material slots untextured
+		bool skipped_embedded_textures = false;
+		if (!textures_from_cache && !geometry.buffers_loaded && !material_set.textures.empty() && has_embedded_images(*data))
+		{
+			if (cgltf_load_buffers(&options, data, init_data.file) == cgltf_result_success)
+			{
+				material_set.textures = parse_materials(*data, init_data.file).textures;
+			}
+			else
+			{
+				printf("GltfScene: Failed to load buffers of %s, skipping its embedded textures\n", init_data.file);
+				skipped_embedded_textures = true;
+			}
+		}
+
+		// Nothing below needs the gltf itself, only the meshes, which don't point into it
+		cgltf_free(geometry.data);
+		geometry.data = nullptr;
+		data = nullptr;
+
+		if (instances.size() > 0)
+		{
+			UploadManager& upload_manager = *init_data.upload_manager;
+
+			GltfLoadContext load_ctx = 
+			{
+				.allocator = init_data.allocator,
+				.bindless_resource_manager = init_data.bindless_resource_manager,
+				.geometry_pool = init_data.geometry_pool,
+				.upload_manager = &upload_manager,
+			};
+			m_load_ctx = load_ctx;
+
+			size_t index_data_size = 0;
+			size_t widened_index_data_size = 0;
+			size_t position_data_size = 0;
+			size_t vertex_data_size = 0;
+			size_t full_vertex_data_size = 0;
+			for (const GltfMeshView& mesh : meshes)
+			{
+				index_data_size += mesh.index_data.size_bytes();
+				widened_index_data_size += mesh.index_count * sizeof(uint32_t);
+				position_data_size += mesh.position_data.size_bytes();
+				vertex_data_size += mesh.position_data.size_bytes() + mesh.attribute_data.size_bytes();
+				full_vertex_data_size += mesh.vertex_count * sizeof(Vertex);
+			}
+			printf(
+				"GltfScene: Index data %.2f MiB (%.2f MiB saved vs. 32-bit indices)\n",
+				index_data_size / (1024.0f * 1024.0f),
+				(widened_index_data_size - index_data_size) / (1024.0f * 1024.0f)
+			);
+			printf(
+				"GltfScene: Vertex data %.2f MiB (%.2f MiB saved vs. full precision vertices)\n",
+				vertex_data_size / (1024.0f * 1024.0f),
+				(full_vertex_data_size - vertex_data_size) / (1024.0f * 1024.0f)
+			);
+			printf(
+				"GltfScene: Position stream %.2f MiB (%.0f%% of vertex data fetched by position-only passes)\n",
+				position_data_size / (1024.0f * 1024.0f),
+				vertex_data_size > 0 ? 100.0f * position_data_size / vertex_data_size : 0.0f
+			);
 
-					indices_data->buffer += indices_data->stride;
+			size_t meshlet_count = 0;
+			size_t meshlet_triangle_count = 0;
+			for (const GltfMeshView& mesh : meshes)
+			{
+				meshlet_count += mesh.meshlets.size();
+				meshlet_triangle_count += mesh.meshlet_triangles.size();
+			}
+			printf(
+				"GltfScene: %zu meshlets (%.1f triangles per meshlet on average)\n",
+				meshlet_count,
+				meshlet_count > 0 ? (float) meshlet_triangle_count / meshlet_count : 0.0f
+			);
+
+			size_t lod_count = 0;
+			size_t lod0_triangle_count = 0;
+			size_t lod_triangle_count = 0;
+			for (const GltfMeshView& mesh : meshes)
+			{
+				lod_count += mesh.lods.size();
+				lod0_triangle_count += mesh.lods[0].index_count / 3;
+				for (const MeshLod& lod : mesh.lods)
+				{
+					lod_triangle_count += lod.index_count / 3;
 				}
+			}
+			printf(
+				"GltfScene: %zu LODs (%.2f per mesh), LOD triangles add %.0f%% to LOD 0\n",
+				lod_count,
+				(float) lod_count / meshes.size(),
+				lod0_triangle_count > 0 ? 100.0f * (lod_triangle_count - lod0_triangle_count) / lod0_triangle_count : 0.0f
+			);
 
-				cgltf_size index_buffer_size = indices_data->count * sizeof(uint32_t);
+			const uint num_instances = (uint) instances.size();
 
-				GpuBufferDesc index_buffer_desc = {
+			// Entries are only written once their mesh is resident, so the GPU never reads a slot we're writing
+			CreateInstanceBuffers(num_instances);
+
+			// Bounds don't reference any geometry, so every instance's are written up front
+			instance_bounds_array.resize(num_instances);
+			for (uint instance_index = 0; instance_index < num_instances; ++instance_index)
+			{
+				instance_bounds_array[instance_index] = MakeInstanceBounds(instances[instance_index], meshes[instances[instance_index].mesh_index].bounds);
+				m_mapped_instance_bounds[instance_index] = instance_bounds_array[instance_index];
+			}
+			m_scene_bounds = merge_instance_bounds(instance_bounds_array);
+
+			// Materials are written up front with their constant factors. Texture slots are patched in as each texture becomes resident
+			materials_array = std::move(material_set.materials);
+			GpuMaterialData*& mapped_materials = m_mapped_materials;
+			if (!materials_array.empty())
+			{
+				materials_gpu_buffer = GpuBuffer(GpuBufferDesc{
 					.allocator = load_ctx.allocator,
-					.size = index_buffer_size,
-					.heap_type = D3D12_HEAP_TYPE_DEFAULT,
+					.size = materials_array.size() * sizeof(GpuMaterialData),
+					.heap_type = D3D12_HEAP_TYPE_UPLOAD,
 					.resource_flags = D3D12_RESOURCE_FLAG_NONE,
 					.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
-				};
-				BufferUploadResult index_buffer_upload_result = gltf_staging_upload_helper(load_ctx, index_buffer_desc, index_data, index_buffer_size);
-				index_buffer = index_buffer_upload_result.result_buffer;
-				indices_count = indices_data->count;
+				});
+				m_material_buffer_index = load_ctx.bindless_resource_manager->RegisterSRV(materials_gpu_buffer, (UINT32) materials_array.size(), sizeof(GpuMaterialData));
+				materials_gpu_buffer.Map(reinterpret_cast<void**>(&mapped_materials));
+				streaming_memcpy(mapped_materials, materials_array.data(), materials_array.size() * sizeof(GpuMaterialData));
+			}
+
+			instances_array.resize(num_instances);
+			indirect_draw_array.reserve(num_instances);
+			m_instance_count.store(num_instances, std::memory_order_release);
 
-				free(index_data);
+			vector<vector<uint32_t>> mesh_instance_indices(meshes.size());
+			for (uint instance_index = 0; instance_index < num_instances; ++instance_index)
+			{
+				mesh_instance_indices[instances[instance_index].mesh_index].push_back(instance_index);
+			}
 
-				// Add to pending uploads array
-				load_ctx.pending_buffer_uploads.push_back(index_buffer_upload_result);
+			// Meshes whose uploads have been queued, in upload order, along with the ticket that marks them resident
+			struct PendingMesh
+			{
+				uint32_t mesh_index;
+				UploadTicket ticket;
+			};
+			std::deque<PendingMesh> pending_meshes;
+
+			float first_publish_time = 0.0f;
+
+			// Writes instance data and appends draws for every instance of each now-resident mesh, then makes those draws visible
+			auto publish_resident_meshes = [&]()
+			{
+				const size_t previous_draw_count = indirect_draw_array.size();
+				while (!pending_meshes.empty() && upload_manager.IsComplete(pending_meshes.front().ticket))
+				{
+					const uint32_t mesh_index = pending_meshes.front().mesh_index;
+					pending_meshes.pop_front();
 
-				// Finally, register index buffer with bindless resource manager
-				load_ctx.bindless_resource_manager->RegisterSRV(*index_buffer, (uint32_t) indices_data->count, sizeof(uint32_t));
+					const GltfRenderData& render_data = render_data_array[mesh_index];
+					for (const uint32_t instance_index : mesh_instance_indices[mesh_index])
+					{
+						const GpuInstanceData gpu_instance_data = MakeInstanceData(instances[instance_index], render_data);
+						instances_array[instance_index] = gpu_instance_data;
+						m_mapped_instances[instance_index] = gpu_instance_data;
+
+						const IndirectDrawData indirect_draw_data = MakeIndirectDraw(instance_index, render_data);
+						m_mapped_indirect_draws[indirect_draw_array.size()] = indirect_draw_data;
+						indirect_draw_array.emplace_back(indirect_draw_data);
+					}
+				}
+
+				if (indirect_draw_array.size() != previous_draw_count)
+				{
+					if (previous_draw_count == 0)
+					{
+						using milliseconds = std::chrono::duration<float, std::milli>;
+						first_publish_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - load_start_time).count();
+					}
+					m_published_draw_count.store((uint32_t) indirect_draw_array.size(), std::memory_order_release);
+				}
+			};
+
+			m_mesh_hashes.reserve(meshes.size());
+			for (const GltfMeshView& mesh : meshes)
+			{
+				m_mesh_hashes.push_back(mesh.source_hash);
 			}
 
-			//FCS TODO: if gltf doesn't give us index data, flag instance and avoid index lookup in shader
-			assert(index_buffer.has_value());
-			assert(indices_count > 0);
+			// Each unique mesh is uploaded (and registered) exactly once, regardless of how many nodes reference it
+			render_data_array.reserve(meshes.size());
+			for (uint32_t mesh_index = 0; mesh_index < meshes.size() && !m_cancel_load; ++mesh_index)
+			{
+				render_data_array.emplace_back(upload_mesh(load_ctx, meshes[mesh_index]));
+				pending_meshes.push_back(PendingMesh {
+					.mesh_index = mesh_index,
+					.ticket = upload_manager.GetPendingTicket(),
+				});
+
+				// Full chunks are submitted as they fill up. Don't let the copy queue sit idle while a partial chunk waits for more data
+				if (upload_manager.IsIdle())
+				{
+					upload_manager.Flush();
+				}
+
+				publish_resident_meshes();
+			}
 
-			GpuBuffer vertex_buffer;
-			std::vector<Vertex> vertices;
+			upload_manager.Flush();
+			while (!pending_meshes.empty())
+			{
+				upload_manager.WaitForTicket(pending_meshes.front().ticket);
+				publish_resident_meshes();
+			}
 
-			const float3 instance_color = float3(rand_norm(), rand_norm(), rand_norm());
-			if (optional<GltfBufferData> positions_data = GetAttributeBuffer(primitive, cgltf_attribute_type_position))
+			// Textures stream in after geometry, so the scene is drawable (with constant material factors) as early as possible.
+			// Each batch is cooked in parallel (unless it's coming from the texture cache), then uploaded while the copy queue works through the previous batch
+			struct PendingTexture
 			{
-				optional<GltfBufferData> normals_data = GetAttributeBuffer(primitive, cgltf_attribute_type_normal);
-				optional<GltfBufferData> color_data = GetAttributeBuffer(primitive, cgltf_attribute_type_color);
-				optional<GltfBufferData> texcoord_data = GetAttributeBuffer(primitive, cgltf_attribute_type_texcoord);
+				uint32_t texture_index;
+				UploadTicket ticket;
+			};
+			std::deque<PendingTexture> pending_textures;
 
-				cgltf_size vertices_count = positions_data->count;
-				vertices.reserve(vertices_count);
-				for (int32_t i = 0; i < vertices_count; ++i)
+			auto publish_resident_textures = [&]()
+			{
+				while (!pending_textures.empty() && upload_manager.IsComplete(pending_textures.front().ticket))
 				{
-					Vertex new_vertex;
+					const uint32_t texture_index = pending_textures.front().texture_index;
+					pending_textures.pop_front();
 
-					memcpy(&new_vertex.position, positions_data->buffer, positions_data->stride);
-					positions_data->buffer += positions_data->stride;
+					const uint32_t texture_bindless_index = textures[texture_index].GetBindlessResourceIndex();
+					for (const auto& [material_index, material_slot] : material_set.textures[texture_index].material_slots)
+					{
+						materials_array[material_index].*material_slot = texture_bindless_index;
+						mapped_materials[material_index].*material_slot = texture_bindless_index;
+					}
+				}
+			};
+
+			const auto texture_start_time = std::chrono::high_resolution_clock::now();
+			const size_t texture_thread_count = init_data.thread_pool ? init_data.thread_pool->GetThreadCount() + 1 : 1;
+			const size_t texture_batch_size = 2 * texture_thread_count;
+			size_t texture_data_size = 0;
+			size_t texture_rgba8_size = 0;
+
+			// Cooked textures are held on to until they've been written to the texture cache. A cache missing the skipped textures would
+			// keep them missing until the gltf changes, so there's no cache this time
+			const bool cache_cooked_textures = init_data.use_scene_cache && !textures_from_cache && !skipped_embedded_textures;
+			vector<optional<TextureData>>& cooked_textures = m_cooked_textures;
+			cooked_textures.resize(textures_from_cache ? 0 : material_set.textures.size());
+
+			// With streaming, textures start out with just their tail mips. Their views (into the texture cache or cooked_textures) are kept for
+			// UpdateTextureStreaming to upload the rest from
+			const bool stream_textures = init_data.texture_streaming_budget > 0;
+			m_texture_streaming = TextureStreamingPolicy(TextureStreamingDesc { .budget = init_data.texture_streaming_budget });
+			m_texture_streaming_mip_bias = init_data.texture_streaming_mip_bias;
+			m_material_streamed_textures.resize(materials_array.size());
+
+			auto get_texture_view = [&](const size_t in_texture_index) -> optional<TextureView>
+			{
+				if (textures_from_cache)
+				{
+					const TextureView& cached_texture = m_texture_cache.GetTextures()[in_texture_index];
+					return cached_texture.mips.empty() ? nullopt : optional<TextureView>(cached_texture);
+				}
+				const optional<TextureData>& cooked_texture = cooked_textures[in_texture_index];
+				return cooked_texture ? optional<TextureView>(cooked_texture->GetView()) : nullopt;
+			};
+
+			textures.reserve(material_set.textures.size());
+			for (size_t batch_start = 0; batch_start < material_set.textures.size() && !m_cancel_load; batch_start += texture_batch_size)
+			{
+				const size_t batch_count = (std::min)(texture_batch_size, material_set.textures.size() - batch_start);
+				if (!textures_from_cache)
+				{
+					auto cook_job = [&](size_t batch_idx)
+					{
+						cooked_textures[batch_start + batch_idx] = cook_texture(material_set.textures[batch_start + batch_idx], init_data.texture_compression, init_data.thread_pool);
+					};
+
+					if (init_data.thread_pool)
+					{
+						init_data.thread_pool->ParallelFor(batch_count, cook_job);
+					}
+					else
+					{
+						for (size_t batch_idx = 0; batch_idx < batch_count; ++batch_idx)
+						{
+							cook_job(batch_idx);
+						}
+					}
+				}
+
+				for (size_t batch_idx = 0; batch_idx < batch_count; ++batch_idx)
+				{
+					const uint32_t texture_index = (uint32_t) textures.size();
+					const optional<TextureView> texture_view = get_texture_view(texture_index);
+					if (!texture_view)
+					{
+						// Leave the texture invalid, its material slots stay INVALID_BINDLESS_INDEX
+						printf("GltfScene: Failed to decode texture %u %s\n", texture_index, material_set.textures[texture_index].path.c_str());
+						textures.emplace_back();
+						continue;
+					}
 
-					if (normals_data)
+					const uint32_t tail_mip = stream_textures ? get_texture_streaming_tail_mip(*texture_view) : 0;
+					textures.emplace_back(upload_texture(load_ctx, *texture_view, tail_mip));
+					texture_data_size += texture_view->data.size();
+					for (const TextureMip& mip : texture_view->mips)
 					{
-						memcpy(&new_vertex.normal, normals_data->buffer, normals_data->stride);
-						normals_data->buffer += normals_data->stride;
+						texture_rgba8_size += (size_t) mip.width * mip.height * TEXTURE_BYTES_PER_TEXEL;
 					}
 
-					if (color_data)
+					if (tail_mip > 0)
+					{
+						vector<uint64_t> mip_sizes;
+						mip_sizes.reserve(texture_view->mips.size());
+						for (const TextureMip& mip : texture_view->mips)
+						{
+							mip_sizes.push_back(mip.GetSize());
+						}
+
+						const uint32_t streamed_texture_id = m_texture_streaming.AddTexture(mip_sizes, tail_mip);
+						m_streamed_textures.push_back(StreamedTextureSource {
+							.texture_index = texture_index,
+							.view = *texture_view,
+						});
+						for (const auto& [material_index, material_slot] : material_set.textures[texture_index].material_slots)
+						{
+							m_material_streamed_textures[material_index].push_back(streamed_texture_id);
+						}
+					}
+					else if (!cache_cooked_textures && !textures_from_cache)
 					{
-						memcpy(&new_vertex.color, color_data->buffer, color_data->stride);
-						color_data->buffer += color_data->stride;
+						cooked_textures[texture_index].reset();
 					}
+					pending_textures.push_back(PendingTexture {
+						.texture_index = texture_index,
+						.ticket = upload_manager.GetPendingTicket(),
+					});
 
-					if (texcoord_data)
+					if (upload_manager.IsIdle())
 					{
-						memcpy(&new_vertex.texcoord, texcoord_data->buffer, texcoord_data->stride);
-						texcoord_data->buffer += texcoord_data->stride;
+						upload_manager.Flush();
 					}
 
-					vertices.emplace_back(new_vertex);
+					publish_resident_textures();
 				}
+			}
 
-				cgltf_size vertex_buffer_size = vertices.size() * sizeof(Vertex);
+			upload_manager.Flush();
+			while (!pending_textures.empty())
+			{
+				upload_manager.WaitForTicket(pending_textures.front().ticket);
+				publish_resident_textures();
+			}
 
-				GpuBufferDesc vertex_buffer_desc = {
-					.allocator = load_ctx.allocator,
-					.size = vertex_buffer_size,
-					.heap_type = D3D12_HEAP_TYPE_DEFAULT,
-					.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-					.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
-				};
-				BufferUploadResult vertex_buffer_upload_result = gltf_staging_upload_helper(load_ctx, vertex_buffer_desc, vertices.data(), vertex_buffer_size);
-				vertex_buffer = vertex_buffer_upload_result.result_buffer;
+			if (cache_cooked_textures && !m_cancel_load && !cooked_textures.empty())
+			{
+				vector<TextureView> cooked_texture_views;
+				cooked_texture_views.reserve(cooked_textures.size());
+				for (const optional<TextureData>& cooked_texture : cooked_textures)
+				{
+					cooked_texture_views.push_back(cooked_texture ? cooked_texture->GetView() : TextureView{});
+				}
 
-				load_ctx.pending_buffer_uploads.push_back(vertex_buffer_upload_result);
-				load_ctx.bindless_resource_manager->RegisterSRV(vertex_buffer, (uint32_t) vertices_count, sizeof(Vertex));
+				if (!write_texture_cache(texture_cache_path, source_file_age, init_data.texture_compression, texture_cache_sources, cooked_texture_views))
+				{
+					printf("GltfScene: Failed to write texture cache %s\n", texture_cache_path.c_str());
+				}
 			}
 
-			result.emplace_back(GltfRenderData {
-				.transform = current_matrix,
-				.vertex_buffer = vertex_buffer,
-				.index_buffer = index_buffer,
-				.indices_count = indices_count,
-			});
+			if (!textures.empty())
+			{
+				using milliseconds = std::chrono::duration<float, std::milli>;
+				const float texture_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - texture_start_time).count();
+				printf(
+					"GltfScene: Loaded %zu textures from %s (%.2f MiB with mips, %.2f MiB as RGBA8) for %zu materials on %zu threads in %.2f ms (%.1f textures/s)\n",
+					textures.size(),
+					textures_from_cache ? "texture cache" : "source images",
+					texture_data_size / (1024.0f * 1024.0f),
+					texture_rgba8_size / (1024.0f * 1024.0f),
+					materials_array.size(),
+					texture_thread_count,
+					texture_time,
+					texture_time > 0.0f ? textures.size() * 1000.0f / texture_time : 0.0f
+				);
+			}
+
+			if (m_texture_streaming.GetTextureCount() > 0 && !m_cancel_load)
+			{
+				printf(
+					"GltfScene: Streaming %zu textures, %.2f MiB of tail mips always resident, %.2f MiB budget for the rest\n",
+					m_texture_streaming.GetTextureCount(),
+					m_texture_streaming.GetTailSize() / (1024.0f * 1024.0f),
+					m_texture_streaming.GetBudget() / (1024.0f * 1024.0f)
+				);
+
+				m_texture_material_slots.reserve(material_set.textures.size());
+				for (GltfTextureSource& texture_source : material_set.textures)
+				{
+					m_texture_material_slots.push_back(std::move(texture_source.material_slots));
+				}
+				m_texture_streaming_ready.store(true, std::memory_order_release);
+			}
+
+			printf(
+				"GltfScene: Geometry pool holds %.2f MiB in %zu allocations across %zu pages\n",
+				init_data.geometry_pool->GetUsedSize() / (1024.0f * 1024.0f),
+				init_data.geometry_pool->GetAllocationCount(),
+				init_data.geometry_pool->GetPageCount()
+			);
+			printf(
+				"GltfScene: Streamed %zu meshes through %.2f MiB of staging memory, first draws published after %.2f ms\n",
+				render_data_array.size(),
+				upload_manager.GetStagingBudget() / (1024.0f * 1024.0f),
+				first_publish_time
+			);
 		}
-	}
 
-	for (int32_t child_node_idx = 0; child_node_idx < in_node->children_count; ++child_node_idx)
-	{
-		recurse_node(load_ctx, in_node->children[child_node_idx], current_matrix, result);
+		// Nothing left to stream, so there's no reason to keep any texture data around
+		if (!m_texture_streaming_ready.load(std::memory_order_relaxed))
+		{
+			m_texture_cache.Close();
+			m_cooked_textures.clear();
+			m_streamed_textures.clear();
+		}
+
+		using milliseconds = std::chrono::duration<float, std::milli>;
+		const float load_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - load_start_time).count();
+		printf(
+			"GltfScene: Loaded %s (%zu unique meshes, %zu instances) from %s in %.2f ms\n", 
+			init_data.file, 
+			meshes.size(), 
+			instances.size(),
+			geometry.loaded_from_cache ? "scene cache" : "gltf", 
+			load_time
+		);
+		return true;
 	}
-}
 
-struct GltfScene
-{
-	GltfScene(const GltfInitData& init_data)
+	// Makes an in-progress Load stop queueing meshes. Load still waits for the uploads already in flight before returning
+	void CancelLoad() { m_cancel_load = true; }
+
+	// Number of draws at the start of indirect_draw_gpu_buffer that are safe to execute. Only grows during Load. 
+	// Safe to call from any thread, and once it's non-zero instances_gpu_buffer and indirect_draw_gpu_buffer are safe to use from any thread
+	uint32_t GetPublishedDrawCount() const { return m_published_draw_count.load(std::memory_order_acquire); }
+
+	// Total instance count, known before any draws are published
+	uint32_t GetInstanceCount() const { return m_instance_count.load(std::memory_order_acquire); }
+
+	// World space bounds of every instance. Like instance_bounds_gpu_buffer, safe to read from any thread once GetInstanceCount is non-zero
+	const Bounds& GetSceneBounds() const { return m_scene_bounds; }
+
+	/*	Streams detailed texture mips in and out based on how large each instance is on screen. Call once per frame from the render thread,
+		before recording anything that samples textures. Does nothing until Load has finished (or if streaming is disabled).
+		in_frame_index is the fence value the current frame signals, in_completed_frame_index the last one the GPU has reached.
+
+		Feedback is a CPU estimate from each instance's bounding sphere and distance, regardless of whether it's on screen.
+		Textures are rebuilt with their new mip range and re-uploaded from the texture cache (or cooked data), and swapped in once their uploads land.
+		Replaced textures are kept alive until the last frame that could sample them has completed
+	*/
+	void UpdateTextureStreaming(
+		const Vector3& in_camera_position, const float in_fov_y, const float in_viewport_height, const uint64_t in_frame_index, const uint64_t in_completed_frame_index)
 	{
-		cgltf_options options = {};
-		cgltf_data* data = NULL;
-		assert(cgltf_parse_file(&options, init_data.file, &data) == cgltf_result_success);
-		assert(cgltf_load_buffers(&options, data, init_data.file) == cgltf_result_success);
-		// Process default scene
-		if (const cgltf_scene* scene = data->scene)
+		if (!m_texture_streaming_ready.load(std::memory_order_acquire))
 		{
-			// Set up command allocator/list for staging buffer copies
-			ComPtr<ID3D12CommandAllocator> command_allocator;
-			HR_CHECK(init_data.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&command_allocator)));
+			return;
+		}
 
-			ComPtr<ID3D12GraphicsCommandList> command_list;
-			HR_CHECK(init_data.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, command_allocator.Get(), nullptr, IID_PPV_ARGS(&command_list)));
-			HR_CHECK(command_list->Close());
-			HR_CHECK(command_list->Reset(command_allocator.Get(), nullptr));
+		m_retired_textures.Retire(in_completed_frame_index, [](GpuTexture& in_texture)
+		{
+			in_texture.UnregisterBindlessResource();
+		});
 
-			GltfLoadContext load_ctx = 
+		// Swap in textures whose uploads have landed. Frames already in flight may still sample the old ones
+		while (!m_pending_texture_swaps.empty() && m_load_ctx.upload_manager->IsComplete(m_pending_texture_swaps.front().ticket))
+		{
+			PendingTextureSwap& swap = m_pending_texture_swaps.front();
+			const uint32_t texture_index = m_streamed_textures[swap.streamed_texture_id].texture_index;
+			m_retired_textures.Push(std::move(textures[texture_index]), in_frame_index);
+			textures[texture_index] = std::move(swap.texture);
+
+			const uint32_t texture_bindless_index = textures[texture_index].GetBindlessResourceIndex();
+			for (const auto& [material_index, material_slot] : m_texture_material_slots[texture_index])
 			{
-				.device = init_data.device,
-				.allocator = init_data.allocator,
-				.command_queue = init_data.command_queue,
-				.bindless_resource_manager = init_data.bindless_resource_manager,
-				.command_allocator = command_allocator,
-				.command_list = command_list,
-			};
+				materials_array[material_index].*material_slot = texture_bindless_index;
+				m_mapped_materials[material_index].*material_slot = texture_bindless_index;
+			}
 
-			for (int32_t root_node_idx = 0; root_node_idx < scene->nodes_count; ++root_node_idx)
+			m_texture_streaming.OnChangeComplete(swap.streamed_texture_id);
+			m_pending_texture_swaps.pop_front();
+		}
+
+		// A sphere of radius r at distance d covers about r * viewport_height / (d * tan(fov_y / 2)) pixels across
+		const float pixels_per_unit = in_viewport_height / std::tan(in_fov_y * 0.5f);
+		for (size_t instance_index = 0; instance_index < instances_array.size(); ++instance_index)
+		{
+			const GpuInstanceData& instance = instances_array[instance_index];
+			if (instance.material_index >= m_material_streamed_textures.size() || m_material_streamed_textures[instance.material_index].empty())
 			{
-				recurse_node(load_ctx, scene->nodes[root_node_idx], init_data.transform, render_data_array);
+				continue;
 			}
 
-			const uint num_instances = (uint) render_data_array.size();
+			const GpuInstanceBounds& bounds = instance_bounds_array[instance_index];
+			const float radius = bounds.radius;
+			const float distance = Vector3::Distance(bounds.center, in_camera_position);
 
-			//Create this first and register as bindless resource so we can reference it in indirect draw args
-			const size_t instances_buffer_size = num_instances * sizeof(GpuInstanceData);
-			instances_gpu_buffer = GpuBuffer(GpuBufferDesc{
-				.allocator = load_ctx.allocator,
-				.size = instances_buffer_size,
-				.heap_type = D3D12_HEAP_TYPE_UPLOAD,
-				.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-				.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ
-			});
-			load_ctx.bindless_resource_manager->RegisterSRV(instances_gpu_buffer, num_instances, sizeof(GpuInstanceData));
+			// Inside the bounds, the mesh can fill the whole screen
+			const float screen_size = distance > radius ? radius * pixels_per_unit / distance : in_viewport_height;
+			for (const uint32_t streamed_texture_id : m_material_streamed_textures[instance.material_index])
+			{
+				const TextureView& view = m_streamed_textures[streamed_texture_id].view;
+				const uint32_t requested_mip = estimate_requested_mip((std::max)(view.width, view.height), screen_size, m_texture_streaming_mip_bias, (uint32_t) view.mips.size());
+				m_texture_streaming.RequestMip(streamed_texture_id, requested_mip);
+			}
+		}
 
-			// Create our gpu_instance_data and indirect_draw_data from our GltfRenderData
-			instances_array.reserve(num_instances);
-			indirect_draw_array.reserve(num_instances);
-			for (uint render_data_index = 0; render_data_index < num_instances; ++render_data_index)
+		// Loads and evictions are carried out the same way, by rebuilding the texture starting at its new first mip
+		const TextureStreamingUpdate update = m_texture_streaming.Update(in_frame_index);
+		for (const span<const TextureStreamingChange> changes : { span<const TextureStreamingChange>(update.evictions), span<const TextureStreamingChange>(update.loads) })
+		{
+			for (const TextureStreamingChange& change : changes)
 			{
-				const GltfRenderData& render_data = render_data_array[render_data_index];
-
-				GpuInstanceData gpu_instance_data = {
-					.transform = render_data.transform,
-					.vertex_buffer_index = render_data.vertex_buffer.GetBindlessResourceIndex(),
-					.index_buffer_index = render_data.index_buffer->GetBindlessResourceIndex(),
-				};
-				
-				instances_array.emplace_back(gpu_instance_data);
-
-				IndirectDrawData indirect_draw_data = {
-					.instance_buffer_index = instances_gpu_buffer.GetBindlessResourceIndex(),
-					.instance_id = render_data_index,
-					.draw_arguments = {
-						.VertexCountPerInstance = (uint32_t) render_data.index_buffer->GetSize() / sizeof(uint32_t),
-						.InstanceCount = 1,
-						.StartVertexLocation = 0,
-						.StartInstanceLocation = 0,
-					},
-				};
-				indirect_draw_array.emplace_back(indirect_draw_data);
+				m_pending_texture_swaps.push_back(PendingTextureSwap {
+					.streamed_texture_id = change.texture,
+					.texture = upload_texture(m_load_ctx, m_streamed_textures[change.texture].view, change.first_mip),
+					.ticket = m_load_ctx.upload_manager->GetPendingTicket(),
+				});
 			}
+		}
 
-			//Create and upload indirect draw buffer
-			const size_t indirect_draw_buffer_size = num_instances * sizeof(IndirectDrawData);
-			GpuBufferDesc indirect_draw_buffer_desc = {
-				.allocator = load_ctx.allocator,
-				.size = indirect_draw_buffer_size,
-				.heap_type = D3D12_HEAP_TYPE_DEFAULT,
-				.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-				.resource_state = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-			};
-			BufferUploadResult indirect_draw_upload_result = gltf_staging_upload_helper(
-				load_ctx, 
-				indirect_draw_buffer_desc, 
-				indirect_draw_array.data(), 
-				indirect_draw_buffer_size
-			);
-			indirect_draw_gpu_buffer = indirect_draw_upload_result.result_buffer;
+		if (!update.loads.empty() || !update.evictions.empty())
+		{
+			m_load_ctx.upload_manager->Flush();
+		}
+	}
+
+	const TextureStreamingPolicy& GetTextureStreaming() const { return m_texture_streaming; }
 
-			load_ctx.pending_buffer_uploads.push_back(indirect_draw_upload_result);
+	// Releases instance buffers and geometry replaced by Reload that no frame up to in_completed_frame_index can still read. Call once per frame from the render thread
+	void ReleaseRetiredBuffers(const uint64_t in_completed_frame_index)
+	{
+		m_retired_geometry.Retire(in_completed_frame_index, [&](const GeometryAllocation& in_geometry)
+		{
+			m_init_data.geometry_pool->Free(in_geometry);
+		});
+
+		// Instance buffers belong to the loading thread until GetInstanceCount is non-zero
+		if (GetInstanceCount() == 0)
+		{
+			return;
+		}
 
-			// Write out GPU Data for instances
-			instances_gpu_buffer.Write(instances_array.data(), instances_buffer_size);
+		instances_gpu_buffer.ReleaseRetiredBuffers(in_completed_frame_index);
+		instance_bounds_gpu_buffer.ReleaseRetiredBuffers(in_completed_frame_index);
+		indirect_draw_gpu_buffer.ReleaseRetiredBuffers(in_completed_frame_index);
+	}
+
+	// The gltf and its external buffers. Watch these (see FileWatcher) and call Reload when they change
+	const vector<string>& GetSourceFiles() const { return m_source_files; }
+
+	/*	Re-reads the gltf after it (or one of its buffers) changed on disk. Primitives are hashed (see hash_primitive) and only those whose hash
+		isn't already loaded are converted and uploaded again. Everything else keeps its geometry, and instance data and draws are patched in place.
+		Only geometry and node transforms are reloaded. Materials and textures stay as they were loaded.
+
+		Call from the render thread once Load has returned, before recording frame in_frame_index. Frames still in flight keep drawing the scene
+		as it was: instance data and draws are written into new buffers, and the old buffers and any geometry that went away are released by
+		ReleaseRetiredBuffers once in_frame_index has completed.
+		Re-converted geometry is submitted to the upload manager but not waited on: the direct queue has to wait for it (see UploadManager::WaitOnQueue)
+		before drawing the reloaded scene.
+		Returns false (leaving the scene as it was) if the gltf can't be parsed, which is expected while it's still being written.
+		The scene cache isn't rewritten, the next Load converts everything once
+	*/
+	bool Reload(const uint64_t in_frame_index)
+	{
+		const auto reload_start_time = std::chrono::high_resolution_clock::now();
+
+		cgltf_options options = {};
+		cgltf_data* data = NULL;
+		if (cgltf_parse_file(&options, m_file.c_str(), &data) != cgltf_result_success)
+		{
+			printf("GltfScene: Failed to parse %s for reload\n", m_file.c_str());
+			return false;
+		}
+		if (cgltf_load_buffers(&options, data, m_file.c_str()) != cgltf_result_success)
+		{
+			printf("GltfScene: Failed to load buffers of %s for reload\n", m_file.c_str());
+			cgltf_free(data);
+			return false;
+		}
+		if (!decode_meshopt_buffer_views(*data, m_init_data.thread_pool))
+		{
+			printf("GltfScene: Failed to decode meshopt compressed buffer views in %s\n", m_file.c_str());
+		}
 
-			HR_CHECK(command_list->Close());
-			ID3D12CommandList* ppCommandLists[] = { command_list.Get() };
-			load_ctx.command_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+		GltfSceneLayout scene_layout = extract_scene_layout(*data);
+		dedupe_scene_layout(*data, scene_layout, m_init_data.thread_pool);
+		const GltfReloadPlan reload_plan = plan_scene_reload(scene_layout, m_mesh_hashes);
 
-			wait_gpu_idle(load_ctx.device, load_ctx.command_queue);
-			load_ctx.pending_buffer_uploads.clear();
+		vector<GltfRenderData> new_render_data_array(scene_layout.meshes.size());
+		for (size_t mesh_idx = 0; mesh_idx < scene_layout.meshes.size(); ++mesh_idx)
+		{
+			if (reload_plan.reused_meshes[mesh_idx] != UINT32_MAX)
+			{
+				new_render_data_array[mesh_idx] = std::move(render_data_array[reload_plan.reused_meshes[mesh_idx]]);
+			}
 		}
 
+		vector<cgltf_primitive*> changed_primitives;
+		changed_primitives.reserve(reload_plan.changed_meshes.size());
+		for (const uint32_t mesh_idx : reload_plan.changed_meshes)
+		{
+			changed_primitives.push_back(scene_layout.meshes[mesh_idx]);
+		}
+		vector<GltfMeshData> converted_meshes = convert_primitives(changed_primitives, *data, m_init_data.vertex_format, m_init_data.thread_pool).meshes;
 		cgltf_free(data);
+		data = nullptr;
+
+		GltfLoadContext load_ctx = {
+			.allocator = m_init_data.allocator,
+			.bindless_resource_manager = m_init_data.bindless_resource_manager,
+			.geometry_pool = m_init_data.geometry_pool,
+			.upload_manager = m_init_data.upload_manager,
+		};
+
+		for (size_t changed_idx = 0; changed_idx < reload_plan.changed_meshes.size(); ++changed_idx)
+		{
+			new_render_data_array[reload_plan.changed_meshes[changed_idx]] = upload_mesh(load_ctx, converted_meshes[changed_idx].GetView());
+		}
+		m_init_data.upload_manager->Flush();
+
+		for (size_t old_mesh_idx = 0; old_mesh_idx < render_data_array.size(); ++old_mesh_idx)
+		{
+			if (!reload_plan.kept_meshes[old_mesh_idx])
+			{
+				m_retired_geometry.Push(GeometryAllocation(render_data_array[old_mesh_idx].geometry), in_frame_index);
+			}
+		}
+		render_data_array = std::move(new_render_data_array);
+		m_mesh_hashes = std::move(scene_layout.mesh_hashes);
+
+		// Every instance slot is rewritten, into new buffers since frames in flight still read the old ones
+		const uint32_t instance_count = (uint32_t) scene_layout.instances.size();
+		ReplaceInstanceBuffers(instance_count, in_frame_index);
+
+		instances_array.resize(instance_count);
+		instance_bounds_array.resize(instance_count);
+		indirect_draw_array.clear();
+		for (uint32_t instance_index = 0; instance_index < instance_count; ++instance_index)
+		{
+			const GltfMeshInstance& instance = scene_layout.instances[instance_index];
+
+			const GltfRenderData& render_data = render_data_array[instance.mesh_index];
+			instances_array[instance_index] = MakeInstanceData(instance, render_data);
+			m_mapped_instances[instance_index] = instances_array[instance_index];
+
+			instance_bounds_array[instance_index] = MakeInstanceBounds(instance, render_data.bounds);
+			m_mapped_instance_bounds[instance_index] = instance_bounds_array[instance_index];
+
+			indirect_draw_array.emplace_back(MakeIndirectDraw(instance_index, render_data));
+			m_mapped_indirect_draws[instance_index] = indirect_draw_array.back();
+		}
+		m_scene_bounds = merge_instance_bounds(instance_bounds_array);
+		m_instance_count.store(instance_count, std::memory_order_release);
+		m_published_draw_count.store(instance_count, std::memory_order_release);
+
+		using milliseconds = std::chrono::duration<float, std::milli>;
+		const float reload_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - reload_start_time).count();
+		printf(
+			"GltfScene: Reloaded %s (re-converted %zu of %zu unique meshes, %u instances) in %.2f ms\n",
+			m_file.c_str(),
+			reload_plan.changed_meshes.size(),
+			render_data_array.size(),
+			instance_count,
+			reload_time
+		);
+		return true;
 	}
 
-	/* Manages/Holds the actual render resources for each primitive */
+	/* Everything below is owned by the loading thread until Load returns, other than the GPU buffers (see GetPublishedDrawCount) */
+
+	/* Manages/Holds the actual render resources for each unique mesh. Indexed by GltfMeshInstance::mesh_index */
 	std::vector<GltfRenderData> render_data_array;
 
 	/* Sent to the GPU to allow bindless access to vtx/idx buffer in render_data_array */
 	std::vector<GpuInstanceData> instances_array;
 
 	/* Buffer that holds our gpu scene instance data */
-	GpuBuffer instances_gpu_buffer;
+	GrowableGpuBuffer instances_gpu_buffer;
+
+	/* World space bounds of each instance, indexed like instances_array. Unlike instance data, all of them are written before GetInstanceCount becomes non-zero */
+	std::vector<GpuInstanceBounds> instance_bounds_array;
+
+	/* StructuredBuffer<GpuInstanceBounds> for culling on the GPU */
+	GrowableGpuBuffer instance_bounds_gpu_buffer;
 
 	/* Indirect Draw Args */
 	std::vector<IndirectDrawData> indirect_draw_array;
 
-	/* Buffer for indirect_draw_data */
-	GpuBuffer indirect_draw_gpu_buffer;
+	/* Buffer for indirect_draw_data. Draws are in the order they were published, not instance order */
+	GrowableGpuBuffer indirect_draw_gpu_buffer;
+
+	/* Indexed by gltf material index. Texture slots are INVALID_BINDLESS_INDEX until that texture is resident */
+	std::vector<GpuMaterialData> materials_array;
+
+	/* StructuredBuffer<GpuMaterialData> referenced by every instance with a material */
+	GpuBuffer materials_gpu_buffer;
+
+	/* Every texture referenced by materials_array. Textures that failed to decode are left invalid. Streamed textures are replaced as their mips change */
+	std::vector<GpuTexture> textures;
+
+protected:
+	// Instance data and indirect draws live in persistently mapped upload heaps, with room for in_instance_count instances
+	void CreateInstanceBuffers(const uint32_t in_instance_count)
+	{
+		const uint32_t instance_capacity = (std::max)(in_instance_count, 1u);
+		instances_gpu_buffer = GrowableGpuBuffer(GrowableGpuBufferDesc{
+			.allocator = m_init_data.allocator,
+			.bindless_resource_manager = m_init_data.bindless_resource_manager,
+			.element_size = sizeof(GpuInstanceData),
+			.initial_capacity = instance_capacity * sizeof(GpuInstanceData),
+			.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+		});
+		instance_bounds_gpu_buffer = GrowableGpuBuffer(GrowableGpuBufferDesc{
+			.allocator = m_init_data.allocator,
+			.bindless_resource_manager = m_init_data.bindless_resource_manager,
+			.element_size = sizeof(GpuInstanceBounds),
+			.initial_capacity = instance_capacity * sizeof(GpuInstanceBounds),
+			.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+		});
+		indirect_draw_gpu_buffer = GrowableGpuBuffer(GrowableGpuBufferDesc{
+			.allocator = m_init_data.allocator,
+			.element_size = sizeof(IndirectDrawData),
+			.initial_capacity = instance_capacity * sizeof(IndirectDrawData),
+			.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+		});
+		MapInstanceBuffers();
+	}
+
+	/*	New upload heaps with room for in_instance_count instances, for the caller to fill. The old ones are kept until in_frame_index completes.
+		Their mappings, and the instance buffer's bindless index, change
+	*/
+	void ReplaceInstanceBuffers(const uint32_t in_instance_count, const uint64_t in_frame_index)
+	{
+		instances_gpu_buffer.Replace(in_instance_count * sizeof(GpuInstanceData), in_frame_index);
+		instance_bounds_gpu_buffer.Replace(in_instance_count * sizeof(GpuInstanceBounds), in_frame_index);
+		indirect_draw_gpu_buffer.Replace(in_instance_count * sizeof(IndirectDrawData), in_frame_index);
+		MapInstanceBuffers();
+	}
+
+	void MapInstanceBuffers()
+	{
+		m_mapped_instances = reinterpret_cast<GpuInstanceData*>(instances_gpu_buffer.GetMappedData());
+		m_mapped_instance_bounds = reinterpret_cast<GpuInstanceBounds*>(instance_bounds_gpu_buffer.GetMappedData());
+		m_mapped_indirect_draws = reinterpret_cast<IndirectDrawData*>(indirect_draw_gpu_buffer.GetMappedData());
+	}
+
+	// Same world transform as MakeInstanceData
+	GpuInstanceBounds MakeInstanceBounds(const GltfMeshInstance& in_instance, const Bounds& in_mesh_bounds) const
+	{
+		return transform_bounds(in_mesh_bounds, in_instance.transform * m_init_data.transform);
+	}
+
+	GpuInstanceData MakeInstanceData(const GltfMeshInstance& in_instance, const GltfRenderData& in_render_data) const
+	{
+		const bool has_material = in_render_data.material_index < materials_array.size();
+		return GpuInstanceData {
+			.transform = in_instance.transform * m_init_data.transform,
+			.geometry_buffer_index = in_render_data.geometry_buffer_index,
+			.flags = (in_render_data.index_stride == sizeof(uint16_t) ? INSTANCE_FLAG_INDEX_16BIT : 0)
+				| (in_render_data.vertex_format == VertexFormat::Compact ? INSTANCE_FLAG_COMPACT_VERTICES : 0),
+			.position_offset = in_render_data.position_offset,
+			.attribute_offset = in_render_data.attribute_offset,
+			.index_offset = in_render_data.index_offset,
+			.position_min = in_render_data.position_min,
+			.position_extent = in_render_data.position_extent,
+			.meshlet_offset = in_render_data.meshlet_offset,
+			.meshlet_vertex_offset = in_render_data.meshlet_vertex_offset,
+			.meshlet_triangle_offset = in_render_data.meshlet_triangle_offset,
+			.meshlet_count = in_render_data.meshlet_count,
+			.lod_offset = in_render_data.lod_offset,
+			.lod_count = (uint32_t) in_render_data.lods.size(),
+			.material_buffer_index = has_material ? m_material_buffer_index : INVALID_BINDLESS_INDEX,
+			.material_index = has_material ? in_render_data.material_index : INVALID_MATERIAL_INDEX,
+		};
+	}
+
+	// Draws start out at full detail. Picking a LOD only means changing the draw's index range, see SelectMeshLod
+	IndirectDrawData MakeIndirectDraw(const uint32_t in_instance_index, const GltfRenderData& in_render_data) const
+	{
+		const MeshLod& lod = in_render_data.lods[0];
+		return IndirectDrawData {
+			.instance_buffer_index = instances_gpu_buffer.GetBindlessResourceIndex(),
+			.instance_id = in_instance_index,
+			.draw_arguments = {
+				.VertexCountPerInstance = lod.index_count,
+				.InstanceCount = 1,
+				.StartVertexLocation = lod.index_offset,
+				.StartInstanceLocation = 0,
+			},
+		};
+	}
+
+	std::atomic<uint32_t> m_published_draw_count = 0;
+	std::atomic<uint32_t> m_instance_count = 0;
+	std::atomic<bool> m_cancel_load = false;
+
+	/* Texture streaming state. Owned by the loading thread until m_texture_streaming_ready is set, then by UpdateTextureStreaming */
+
+	struct StreamedTextureSource
+	{
+		// Index into textures
+		uint32_t texture_index;
+
+		// Every mip, pointing into m_texture_cache or m_cooked_textures
+		TextureView view;
+	};
+
+	struct PendingTextureSwap
+	{
+		uint32_t streamed_texture_id;
+		GpuTexture texture;
+		UploadTicket ticket;
+	};
+
+	std::atomic<bool> m_texture_streaming_ready = false;
+	TextureStreamingPolicy m_texture_streaming;
+	float m_texture_streaming_mip_bias = 0.0f;
+	TextureCache m_texture_cache;
+	vector<optional<TextureData>> m_cooked_textures;
+
+	// Indexed by the policy's texture ids
+	vector<StreamedTextureSource> m_streamed_textures;
+
+	// Streamed texture ids each material samples, indexed by material index
+	vector<vector<uint32_t>> m_material_streamed_textures;
+
+	// Material slots each texture is bound to, indexed like textures
+	vector<vector<std::pair<uint32_t, uint32_t GpuMaterialData::*>>> m_texture_material_slots;
+	GpuMaterialData* m_mapped_materials = nullptr;
+
+	// Replaced textures, tagged with the last frame that can still sample them
+	FenceRetiredQueue<GpuTexture> m_retired_textures;
+
+	// Geometry of meshes Reload dropped, tagged with the last frame that can still draw them
+	FenceRetiredQueue<GeometryAllocation> m_retired_geometry;
+	std::deque<PendingTextureSwap> m_pending_texture_swaps;
+
+	GltfLoadContext m_load_ctx;
+
+	/* Kept from Load for Reload */
+
+	GltfInitData m_init_data;
+	string m_file;
+	vector<string> m_source_files;
+
+	// Indexed like render_data_array, see hash_primitive
+	vector<uint64_t> m_mesh_hashes;
+
+	uint32_t m_material_buffer_index = INVALID_BINDLESS_INDEX;
+	GpuInstanceData* m_mapped_instances = nullptr;
+	GpuInstanceBounds* m_mapped_instance_bounds = nullptr;
+	IndirectDrawData* m_mapped_indirect_draws = nullptr;
+
+	Bounds m_scene_bounds;
 };
 
 //FCS TODO:
@@ -380,22 +1363,3 @@ struct GltfScene
 // 4. Replace single SG with SG Basis and debug vis that
 // 5. Again, randomly generate
 // 6. Actually compute "real" values for each SGBasis, using raytracing
-
-//FCS TODO: properly handle instances (i.e. multiple nodes pointing to the same mesh)
-// ^ A new instance will be added with its own xform, but the vertex/index buffer bindless indices will be shared
-
-/* 	FCS TODO: Prefer loading binary. Load GLTF and Re-Save to Binary if
- * 		- Binary doesn't exist
- * 		- GLTF File Age has changed
- * 		- Binary format version bump
- * 
- * 	Binary Format
- * 	GLTF File Age
- * 	Primitive Count
- *  Max Contiguous Size (size of largest vertex or index buffer in file, useful for preallocating staging buffer)
- * 	For each primitive ...
- * 		Total Primitive Data Size
- * 		Primitive Transform
- * 		Primitive Indices
- * 		Primitive Vertices (a change in vertex format will require a re-load of GLTF and re-save of binary data)
- */
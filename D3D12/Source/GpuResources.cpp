@@ -1,4 +1,6 @@
 #include "GpuResources.h"
+#include "GpuCommands.h"
+#include "StreamingCopy.h"
 
 GpuBuffer::GpuBuffer(const GpuBufferDesc& in_desc)
 {
@@ -39,24 +41,26 @@ void GpuBuffer::UnregisterBindlessResource()
 
 void GpuBuffer::Map(void** ppData)
 {
+	if (m_mapped_data)
+	{
+		*ppData = m_mapped_data;
+		return;
+	}
+
 	D3D12_RANGE read_range = { 0, 0 };
 	HR_CHECK(m_resource->Map(0, &read_range, ppData));
 }
 
-void GpuBuffer::Write(void* in_data, size_t data_size)
+void GpuBuffer::Write(const void* in_data, size_t data_size)
 {
-	if (data_size > GetSize())
-	{
-		Resize(data_size);
-	}
+	WriteRange(0, in_data, data_size);
+}
 
-	assert(m_buffer_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD);
-	assert(data_size <= GetSize());
-	UINT8* mapped_data = nullptr;
-	D3D12_RANGE read_range = { 0, 0 };
-	HR_CHECK(m_resource->Map(0, &read_range, reinterpret_cast<void**>(&mapped_data)));
-	memcpy(mapped_data, in_data, data_size);
-	m_resource->Unmap(0, nullptr);
+void GpuBuffer::WriteRange(size_t in_offset, const void* in_data, size_t in_size)
+{
+	assert(m_buffer_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD && m_mapped_data);
+	assert(in_offset + in_size <= GetSize());
+	streaming_memcpy(m_mapped_data + in_offset, in_data, in_size);
 }
 
 void GpuBuffer::Resize(size_t new_size)
@@ -75,6 +79,176 @@ void GpuBuffer::Resize(size_t new_size)
 		&m_allocation,
 		IID_PPV_ARGS(&m_resource)
 	));
+
+	// Mapping is ref counted per resource, so the previous resource (if any) keeps its mapping for as long as other copies of this GpuBuffer hold it
+	m_mapped_data = nullptr;
+	if (m_buffer_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD)
+	{
+		D3D12_RANGE read_range = { 0, 0 };
+		HR_CHECK(m_resource->Map(0, &read_range, reinterpret_cast<void**>(&m_mapped_data)));
+	}
+}
+
+// ---------------------------------------- GpuMirroredBuffer -------------------------------------------------//
+GpuMirroredBuffer::GpuMirroredBuffer(const GpuBufferDesc& in_desc)
+	: m_allocator(in_desc.allocator)
+	, m_read_state(in_desc.resource_state)
+{
+	GpuBufferDesc buffer_desc = in_desc;
+	buffer_desc.heap_type = D3D12_HEAP_TYPE_DEFAULT;
+	buffer_desc.resource_state = D3D12_RESOURCE_STATE_COMMON;
+	m_buffer = GpuBuffer(buffer_desc);
+
+	m_upload_buffer = CreateUploadBuffer();
+}
+
+void GpuMirroredBuffer::WriteRange(size_t in_offset, const void* in_data, size_t in_size)
+{
+	// The last flush may still be copying out of the upload copy. Every range it copied has been flushed, so a new one only needs what's written from here on
+	if (m_upload_flush_frame_index > m_completed_frame_index)
+	{
+		assert(m_dirty_ranges.IsEmpty());
+		m_retired_upload_buffers.Push(std::move(m_upload_buffer), m_upload_flush_frame_index);
+		m_upload_buffer = CreateUploadBuffer();
+		m_upload_flush_frame_index = 0;
+	}
+
+	m_upload_buffer.WriteRange(in_offset, in_data, in_size);
+	m_dirty_ranges.Add(in_offset, in_size);
+}
+
+void GpuMirroredBuffer::FlushDirtyRanges(ID3D12GraphicsCommandList* in_command_list, uint64_t in_frame_index)
+{
+	if (m_dirty_ranges.IsEmpty())
+	{
+		return;
+	}
+
+	const D3D12_RESOURCE_BARRIER to_copy_dest = Transition(m_buffer.GetResource(), m_state, D3D12_RESOURCE_STATE_COPY_DEST);
+	in_command_list->ResourceBarrier(1, &to_copy_dest);
+
+	for (const DirtyRange& range : m_dirty_ranges.Get())
+	{
+		in_command_list->CopyBufferRegion(m_buffer.GetResource(), range.offset, m_upload_buffer.GetResource(), range.offset, range.size);
+	}
+
+	const D3D12_RESOURCE_BARRIER to_read_state = Transition(m_buffer.GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, m_read_state);
+	in_command_list->ResourceBarrier(1, &to_read_state);
+	m_state = m_read_state;
+	m_dirty_ranges.Clear();
+
+	assert(in_frame_index >= m_upload_flush_frame_index);
+	m_upload_flush_frame_index = in_frame_index;
+}
+
+void GpuMirroredBuffer::ReleaseRetiredBuffers(uint64_t in_completed_frame_index)
+{
+	m_completed_frame_index = (std::max)(m_completed_frame_index, in_completed_frame_index);
+	m_retired_upload_buffers.Retire(m_completed_frame_index);
+}
+
+GpuBuffer GpuMirroredBuffer::CreateUploadBuffer() const
+{
+	return GpuBuffer(GpuBufferDesc{
+		.allocator = m_allocator,
+		.size = m_buffer.GetSize(),
+		.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+		.resource_flags = D3D12_RESOURCE_FLAG_NONE,
+		.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
+	});
+}
+
+// ---------------------------------------- GrowableGpuBuffer -------------------------------------------------//
+GrowableGpuBuffer::GrowableGpuBuffer(const GrowableGpuBufferDesc& in_desc)
+	: m_desc(in_desc)
+{
+	assert(m_desc.allocator);
+	assert(m_desc.initial_capacity > 0);
+
+	// Doubling from a multiple of the view's stride keeps every capacity one
+	const uint64_t view_stride = m_desc.element_size > 0 ? m_desc.element_size : sizeof(uint32_t);
+	const uint64_t initial_capacity = (m_desc.initial_capacity + view_stride - 1) / view_stride * view_stride;
+
+	m_buffer = CreateBuffer(initial_capacity);
+	m_state = m_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON;
+}
+
+bool GrowableGpuBuffer::Reserve(uint64_t in_required_size, ID3D12GraphicsCommandList* in_command_list, uint64_t in_frame_index, span<const uint8_t> in_shadow_data)
+{
+	const uint64_t old_capacity = GetCapacity();
+	const uint64_t new_capacity = grow_capacity(old_capacity, in_required_size);
+	if (new_capacity == old_capacity)
+	{
+		return false;
+	}
+
+	GpuBuffer new_buffer = CreateBuffer(new_capacity);
+	if (m_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD)
+	{
+		// Never read back from the old mapping, it's write-combined
+		assert(in_shadow_data.size() <= old_capacity);
+		if (!in_shadow_data.empty())
+		{
+			streaming_memcpy(new_buffer.GetMappedData(), in_shadow_data.data(), in_shadow_data.size());
+		}
+	}
+	else
+	{
+		assert(in_command_list);
+
+		// New buffers are created in COMMON
+		const D3D12_RESOURCE_BARRIER to_copy[] =
+		{
+			Transition(m_buffer.GetResource(), m_state, D3D12_RESOURCE_STATE_COPY_SOURCE),
+			Transition(new_buffer.GetResource(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
+		};
+		in_command_list->ResourceBarrier(_countof(to_copy), to_copy);
+
+		in_command_list->CopyBufferRegion(new_buffer.GetResource(), 0, m_buffer.GetResource(), 0, old_capacity);
+
+		const D3D12_RESOURCE_BARRIER to_resource_state = Transition(new_buffer.GetResource(), D3D12_RESOURCE_STATE_COPY_DEST, m_desc.resource_state);
+		in_command_list->ResourceBarrier(1, &to_resource_state);
+		m_state = m_desc.resource_state;
+	}
+
+	m_retired_buffers.Push(std::move(m_buffer), in_frame_index);
+	m_buffer = std::move(new_buffer);
+	return true;
+}
+
+void GrowableGpuBuffer::Replace(uint64_t in_required_size, uint64_t in_frame_index)
+{
+	GpuBuffer new_buffer = CreateBuffer(grow_capacity(GetCapacity(), in_required_size));
+	m_state = m_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON;
+
+	m_retired_buffers.Push(std::move(m_buffer), in_frame_index);
+	m_buffer = std::move(new_buffer);
+}
+
+void GrowableGpuBuffer::ReleaseRetiredBuffers(uint64_t in_completed_frame_index)
+{
+	m_retired_buffers.Retire(in_completed_frame_index, [](GpuBuffer& in_buffer)
+	{
+		in_buffer.UnregisterBindlessResource();
+	});
+}
+
+GpuBuffer GrowableGpuBuffer::CreateBuffer(uint64_t in_capacity)
+{
+	GpuBuffer buffer(GpuBufferDesc{
+		.allocator = m_desc.allocator,
+		.size = in_capacity,
+		.heap_type = m_desc.heap_type,
+		.resource_flags = m_desc.resource_flags,
+		.resource_state = m_desc.heap_type == D3D12_HEAP_TYPE_UPLOAD ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON,
+	});
+
+	if (m_desc.bindless_resource_manager)
+	{
+		const uint64_t view_stride = m_desc.element_size > 0 ? m_desc.element_size : sizeof(uint32_t);
+		m_desc.bindless_resource_manager->RegisterSRV(buffer, (UINT32) (in_capacity / view_stride), m_desc.element_size);
+	}
+	return buffer;
 }
 
 // ---------------------------------------- GpuTexture -------------------------------------------------//
@@ -83,6 +257,7 @@ GpuTexture::GpuTexture(const GpuTextureDesc& in_desc)
 	assert(in_desc.allocator);
 	assert(in_desc.width > 0);
 	assert(in_desc.height > 0);
+	assert(in_desc.mip_levels > 0);
 
 	D3D12MA::ALLOCATION_DESC alloc_desc = {};
 	alloc_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
@@ -93,7 +268,7 @@ GpuTexture::GpuTexture(const GpuTextureDesc& in_desc)
 	m_resource_desc.Width = in_desc.width;
 	m_resource_desc.Height = in_desc.height;
 	m_resource_desc.DepthOrArraySize = 1;
-	m_resource_desc.MipLevels = 1;
+	m_resource_desc.MipLevels = in_desc.mip_levels;
 	m_resource_desc.Format = in_desc.format;
 	m_resource_desc.SampleDesc.Count = 1;
 	m_resource_desc.SampleDesc.Quality = 0;
@@ -129,4 +304,125 @@ void GpuTexture::UnregisterBindlessResource()
 	{
 		bindless_resource_data->manager->UnregisterResource(*this);
 	}
-}
\ No newline at end of file
+}
+
+// ---------------------------------------- GeometryPool -------------------------------------------------//
+GeometryPool::GeometryPool(const GeometryPoolDesc& in_desc)
+	: m_desc(in_desc)
+{
+	assert(m_desc.allocator);
+	assert(m_desc.bindless_resource_manager);
+
+	assert(m_desc.page_size > 0 && m_desc.page_size <= GEOMETRY_POOL_MAX_PAGE_SIZE);
+}
+
+GeometryAllocation GeometryPool::Allocate(uint64_t in_size)
+{
+	std::lock_guard scope_lock(m_mutex);
+
+	for (uint32_t page_index = 0; page_index < m_pages.size(); ++page_index)
+	{
+		if (optional<FreeListAllocation> allocation = m_pages[page_index].allocator.Allocate(in_size, GEOMETRY_POOL_ALIGNMENT))
+		{
+			return GeometryAllocation {
+				.page_index = page_index,
+				.offset = allocation->offset,
+				.size = allocation->size,
+			};
+		}
+	}
+
+	// Round dedicated pages up to D3D12's 64KiB resource alignment, they'd take up that much memory anyway.
+	// Anything past GEOMETRY_POOL_MAX_PAGE_SIZE couldn't be addressed by shaders, so a mesh that large has to be split before it gets here
+	const uint64_t page_size = (std::max)(m_desc.page_size, (uint64_t) align_up(in_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+	assert(page_size <= GEOMETRY_POOL_MAX_PAGE_SIZE);
+	const uint32_t page_index = CreatePage(page_size);
+	optional<FreeListAllocation> allocation = m_pages[page_index].allocator.Allocate(in_size, GEOMETRY_POOL_ALIGNMENT);
+	assert(allocation);
+
+	return GeometryAllocation {
+		.page_index = page_index,
+		.offset = allocation->offset,
+		.size = allocation->size,
+	};
+}
+
+void GeometryPool::Free(const GeometryAllocation& in_allocation)
+{
+	std::lock_guard scope_lock(m_mutex);
+	assert(in_allocation.IsValid() && in_allocation.page_index < m_pages.size());
+	m_pages[in_allocation.page_index].allocator.Free(FreeListAllocation {
+		.offset = in_allocation.offset,
+		.size = in_allocation.size,
+	});
+}
+
+GpuBuffer& GeometryPool::GetPageBuffer(uint32_t in_page_index)
+{
+	std::lock_guard scope_lock(m_mutex);
+	return m_pages[in_page_index].buffer;
+}
+
+uint32_t GeometryPool::GetPageBindlessIndex(uint32_t in_page_index) const
+{
+	std::lock_guard scope_lock(m_mutex);
+	return m_pages[in_page_index].buffer.GetBindlessResourceIndex();
+}
+
+size_t GeometryPool::GetPageCount() const
+{
+	std::lock_guard scope_lock(m_mutex);
+	return m_pages.size();
+}
+
+uint64_t GeometryPool::GetUsedSize() const
+{
+	std::lock_guard scope_lock(m_mutex);
+	uint64_t used_size = 0;
+	for (const Page& page : m_pages)
+	{
+		used_size += page.allocator.GetUsedSize();
+	}
+	return used_size;
+}
+
+uint64_t GeometryPool::GetCapacity() const
+{
+	std::lock_guard scope_lock(m_mutex);
+	uint64_t capacity = 0;
+	for (const Page& page : m_pages)
+	{
+		capacity += page.allocator.GetCapacity();
+	}
+	return capacity;
+}
+
+size_t GeometryPool::GetAllocationCount() const
+{
+	std::lock_guard scope_lock(m_mutex);
+	size_t allocation_count = 0;
+	for (const Page& page : m_pages)
+	{
+		allocation_count += page.allocator.GetAllocationCount();
+	}
+	return allocation_count;
+}
+
+uint32_t GeometryPool::CreatePage(uint64_t in_size)
+{
+	Page page = {
+		.buffer = GpuBuffer(GpuBufferDesc{
+			.allocator = m_desc.allocator,
+			.size = in_size,
+			.heap_type = D3D12_HEAP_TYPE_DEFAULT,
+			.resource_flags = D3D12_RESOURCE_FLAG_NONE,
+			.resource_state = D3D12_RESOURCE_STATE_COMMON,
+		}),
+		.allocator = FreeListAllocator(in_size),
+	};
+	assert(in_size <= GEOMETRY_POOL_MAX_PAGE_SIZE);
+	m_desc.bindless_resource_manager->RegisterSRV(page.buffer, (UINT32) (in_size / sizeof(uint32_t)), 0);
+
+	m_pages.push_back(std::move(page));
+	return (uint32_t) (m_pages.size() - 1);
+}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <deque>
 #include <windows.h>
 #include <d3d12.h>
 #include <vector>
 #include <optional>
+#include <span>
 #include <wrl.h>
 #include <cstdint>
 #include <mutex>
@@ -12,6 +15,9 @@
 #include "Common.h"
 #include "../Shaders/HLSL_Types.h"
 #include "D3D12MemAlloc/D3D12MemAlloc.h"
+#include "DirtyRanges.h"
+#include "FenceRetiredQueue.h"
+#include "FreeListAllocator.h"
 
 using STL_IMPL::optional;
 using STL_IMPL::vector;
@@ -50,8 +56,22 @@ public:
 
 	uint32_t GetBindlessResourceIndex() const;
 	void UnregisterBindlessResource();
+
+	// Upload heap buffers are mapped once when they're created and stay mapped, so this just hands out that mapping
 	void Map(void** ppData);
-	void Write(void* in_data, size_t data_size);
+	uint8_t* GetMappedData() const { return m_mapped_data; }
+
+	// Upload heap only. Both assert the data fits, use GrowableGpuBuffer for data that can outgrow its buffer
+	void Write(const void* in_data, size_t data_size);
+	void WriteRange(size_t in_offset, const void* in_data, size_t in_size);
+
+	template<typename T>
+	void WriteElements(const size_t in_first_element, span<const T> in_elements)
+	{
+		WriteRange(in_first_element * sizeof(T), in_elements.data(), in_elements.size_bytes());
+	}
+
+	// Recreates the resource with new_size bytes. Contents, mapping and any bindless view of the old resource are not carried over
 	void Resize(size_t new_size);
 
 protected:
@@ -59,17 +79,137 @@ protected:
 	D3D12_RESOURCE_DESC m_resource_desc = {};
 	ComPtr<ID3D12Resource> m_resource;
 	ComPtr<D3D12MA::Allocation> m_allocation;
+	uint8_t* m_mapped_data = nullptr;
 
 	optional<BindlessResourceData> bindless_resource_data = std::nullopt;
 
 	friend struct BindlessResourceManager;
 };
 
+/*	A default heap buffer (fast for the GPU to read) written through a persistently mapped upload heap copy of it. Writes land in the
+	upload copy and are remembered as dirty ranges, FlushDirtyRanges then copies just those ranges across in one batch.
+	Writing while the last flush may still be executing swaps in a new upload copy rather than overwriting what that flush reads,
+	and the old one is released by ReleaseRetiredBuffers once the flush's frame has completed. So writes never wait on the GPU, but
+	each write after a flush can cost a new upload heap. For data rewritten every frame, use an upload heap GpuBuffer per frame in flight instead
+*/
+struct GpuMirroredBuffer
+{
+	GpuMirroredBuffer() = default;
+
+	// in_desc describes the default heap buffer. Its resource_state is the (read) state it's left in after each flush
+	GpuMirroredBuffer(const GpuBufferDesc& in_desc);
+
+	void WriteRange(size_t in_offset, const void* in_data, size_t in_size);
+
+	template<typename T>
+	void WriteElements(const size_t in_first_element, span<const T> in_elements)
+	{
+		WriteRange(in_first_element * sizeof(T), in_elements.data(), in_elements.size_bytes());
+	}
+
+	// Records copies of every dirty range into the default heap buffer, between transitions into and back out of COPY_DEST.
+	// in_frame_index is the frame (fence value) in_command_list executes in, and must only increase from one call to the next
+	void FlushDirtyRanges(ID3D12GraphicsCommandList* in_command_list, uint64_t in_frame_index);
+	bool HasDirtyRanges() const { return !m_dirty_ranges.IsEmpty(); }
+
+	// Releases upload copies replaced by WriteRange once in_completed_frame_index has reached the flush that last read them
+	void ReleaseRetiredBuffers(uint64_t in_completed_frame_index);
+	size_t GetRetiredBufferCount() const { return m_retired_upload_buffers.GetCount(); }
+
+	// What shaders read. Register this one with the BindlessResourceManager
+	GpuBuffer& GetBuffer() { return m_buffer; }
+	size_t GetSize() const { return m_buffer.GetSize(); }
+
+protected:
+	GpuBuffer CreateUploadBuffer() const;
+
+	D3D12MA::Allocator* m_allocator = nullptr;
+	GpuBuffer m_buffer;
+	GpuBuffer m_upload_buffer;
+	DirtyRanges m_dirty_ranges;
+	D3D12_RESOURCE_STATES m_read_state = D3D12_RESOURCE_STATE_COMMON;
+	D3D12_RESOURCE_STATES m_state = D3D12_RESOURCE_STATE_COMMON;
+
+	// Frame of the last flush that read m_upload_buffer (0 if none has), and the last completed frame ReleaseRetiredBuffers was given
+	uint64_t m_upload_flush_frame_index = 0;
+	uint64_t m_completed_frame_index = 0;
+	FenceRetiredQueue<GpuBuffer> m_retired_upload_buffers;
+};
+
+struct GrowableGpuBufferDesc
+{
+	D3D12MA::Allocator* allocator = nullptr;
+
+	// Optional. If set, the buffer keeps a bindless SRV covering its whole capacity, re-registered each time it grows
+	BindlessResourceManager* bindless_resource_manager = nullptr;
+
+	// Stride of the bindless SRV. 0 makes it a raw (ByteAddressBuffer) view. Capacity is always a multiple of it
+	uint32_t element_size = 0;
+
+	// Capacity of the first resource, which doubles from there
+	uint64_t initial_capacity = 64 * 1024;
+
+	D3D12_HEAP_TYPE heap_type = D3D12_HEAP_TYPE_DEFAULT;
+	D3D12_RESOURCE_FLAGS resource_flags = D3D12_RESOURCE_FLAG_NONE;
+
+	// State the buffer is left in between growths. Upload heap buffers are always GENERIC_READ
+	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
+};
+
+/*	A GpuBuffer that can outgrow itself without losing its contents. Reserve doubles the capacity until the requested size fits,
+	creating a new resource and copying the old one's contents across: on the GPU for default heaps, from the caller's CPU copy of the contents
+	for upload heaps (the GPU can't write to those, and reading back their write-combined memory is slow). The bindless SRV is re-registered
+	on the new resource, so anything that baked in the old descriptor index or mapping has to fetch them again after a growth. The old resource
+	(and its descriptor) is kept alive until the frame passed to Reserve has completed, see ReleaseRetiredBuffers.
+	Not thread-safe.
+*/
+struct GrowableGpuBuffer
+{
+	GrowableGpuBuffer() = default;
+	GrowableGpuBuffer(const GrowableGpuBufferDesc& in_desc);
+	DISALLOW_COPY(GrowableGpuBuffer);
+	DEFAULT_MOVE(GrowableGpuBuffer);
+
+	/*	Grows the buffer until it holds at least in_required_size bytes. Returns true if a new resource was created.
+		Default heap buffers record the copy of their old contents into in_command_list, which must execute before anything reads the new resource.
+		Upload heap buffers are filled from in_shadow_data instead, the CPU copy of what was written to the old one. Anything past it is left undefined.
+		in_frame_index is the last frame (fence value) that can still use the old resource, and must only increase from one call to the next
+	*/
+	bool Reserve(uint64_t in_required_size, ID3D12GraphicsCommandList* in_command_list, uint64_t in_frame_index, span<const uint8_t> in_shadow_data = {});
+
+	/*	Swaps in a new resource of at least in_required_size bytes (grown like Reserve, never shrunk) with undefined contents, retiring the
+		current one the same way. For rewriting a buffer whole while frames still in flight read its old contents
+	*/
+	void Replace(uint64_t in_required_size, uint64_t in_frame_index);
+
+	// Releases buffers (and descriptors) replaced by Reserve or Replace once in_completed_frame_index has reached the frame they were retired on
+	void ReleaseRetiredBuffers(uint64_t in_completed_frame_index);
+
+	GpuBuffer& GetBuffer() { return m_buffer; }
+	ID3D12Resource* GetResource() const { return m_buffer.GetResource(); }
+	uint64_t GetCapacity() const { return m_buffer.GetSize(); }
+	uint32_t GetBindlessResourceIndex() const { return m_buffer.GetBindlessResourceIndex(); }
+
+	// Upload heaps only. Changes whenever the buffer grows
+	uint8_t* GetMappedData() const { return m_buffer.GetMappedData(); }
+
+	size_t GetRetiredBufferCount() const { return m_retired_buffers.GetCount(); }
+
+protected:
+	GpuBuffer CreateBuffer(uint64_t in_capacity);
+
+	GrowableGpuBufferDesc m_desc;
+	GpuBuffer m_buffer;
+	D3D12_RESOURCE_STATES m_state = D3D12_RESOURCE_STATE_COMMON;
+	FenceRetiredQueue<GpuBuffer> m_retired_buffers;
+};
+
 struct GpuTextureDesc
 {
 	D3D12MA::Allocator* allocator = nullptr;
 	UINT64 width = 0;
 	UINT height = 0;
+	UINT16 mip_levels = 1;
 	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
 	D3D12_RESOURCE_FLAGS resource_flags = D3D12_RESOURCE_FLAG_NONE;
 	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
@@ -85,9 +225,15 @@ public:
 	bool IsValid() { return m_resource != nullptr; }
 	ID3D12Resource* GetResource() const { return m_resource.Get(); }
 	DXGI_FORMAT GetFormat() const { return m_resource_desc.Format; }
+	UINT64 GetWidth() const { return m_resource_desc.Width; }
+	UINT GetHeight() const { return m_resource_desc.Height; }
+	UINT16 GetMipLevels() const { return m_resource_desc.MipLevels; }
 	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return GetResource()->GetGPUVirtualAddress(); }
 	uint32_t GetBindlessResourceIndex() const;
 	void UnregisterBindlessResource();
+
+	// Memory the texture takes up, including the layout's padding and alignment
+	UINT64 GetAllocationSize() const { return m_allocation ? m_allocation->GetSize() : 0; }
 protected:
 	D3D12_RESOURCE_DESC m_resource_desc = {};
 	ComPtr<ID3D12Resource> m_resource;
@@ -98,66 +244,6 @@ protected:
 	friend struct BindlessResourceManager;
 };
 
-// Actual data we want to upload
-struct BufferUploadData
-{
-	GpuBufferDesc buffer_desc;
-	void* buffer_data;
-	size_t buffer_data_size;
-};
-
-struct BufferUploadDesc
-{
-	ComPtr<ID3D12Device5> device;
-	D3D12MA::Allocator* allocator;
-	ComPtr<ID3D12GraphicsCommandList> command_list;
-	BufferUploadData upload_data;
-};
-
-struct BufferUploadResult
-{
-	GpuBuffer staging_buffer;
-	GpuBuffer result_buffer;
-};
-
-// This function assumes in_upload_desc.command_list is in a valid, recordable state
-inline BufferUploadResult staging_upload_helper(const BufferUploadDesc& in_upload_desc)
-{
-	const BufferUploadData& upload_data = in_upload_desc.upload_data;
-
-	const bool needs_staging_buffer = !(upload_data.buffer_desc.heap_type & D3D12_HEAP_TYPE_UPLOAD);
-	assert(needs_staging_buffer);
-
-	GpuBuffer staging_buffer = GpuBuffer(GpuBufferDesc{
-		.allocator = in_upload_desc.allocator,
-		.size = upload_data.buffer_data_size,
-		.heap_type = D3D12_HEAP_TYPE_UPLOAD,
-		.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-		.resource_state = D3D12_RESOURCE_STATE_COPY_SOURCE,
-	});
-	staging_buffer.Write(
-		in_upload_desc.upload_data.buffer_data, 
-		in_upload_desc.upload_data.buffer_data_size
-	);
-
-	GpuBufferDesc modified_buffer_desc = upload_data.buffer_desc;
-	modified_buffer_desc.resource_state |= D3D12_RESOURCE_STATE_COPY_DEST;
-	GpuBuffer result_buffer(modified_buffer_desc);
-
-	in_upload_desc.command_list->CopyBufferRegion(
-		result_buffer.GetResource(), 0, 
-		staging_buffer.GetResource(), 0, 
-		upload_data.buffer_data_size
-	);
-
-	BufferUploadResult upload_result = {
-		.staging_buffer = staging_buffer,
-		.result_buffer = result_buffer,
-	};
-
-	return upload_result;
-}
-
 struct BindlessResourceManager
 {
 public:
@@ -313,24 +399,25 @@ public:
 
 		if (element_size == 0)
 		{
+			// num_elements is in 32-bit units for raw (ByteAddressBuffer) views
 			srv_desc.Format = DXGI_FORMAT_R32_TYPELESS;
-			srv_desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
 			srv_desc.Buffer =
 			{
 				.FirstElement = 0,
 				.NumElements = num_elements,
 				.StructureByteStride = 0,
+				.Flags = D3D12_BUFFER_SRV_FLAG_RAW,
 			};
 		}
 		else
 		{
 			srv_desc.Format = DXGI_FORMAT_UNKNOWN;
-			srv_desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
 			srv_desc.Buffer =
 			{
 				.FirstElement = 0,
 				.NumElements = num_elements,
 				.StructureByteStride = element_size,
+				.Flags = D3D12_BUFFER_SRV_FLAG_NONE,
 			};
 		}
 		m_device->CreateShaderResourceView(in_buffer.GetResource(), &srv_desc, srv_cpu_handle);
@@ -349,18 +436,18 @@ public:
 		};
 		D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc =
 		{
-			.Format = DXGI_FORMAT_UNKNOWN,
+			.Format = in_texture.GetFormat(),
 			.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
 			.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
 			.Texture2D = 
 			{
 				.MostDetailedMip = 0,
-				.MipLevels = 1,
+				.MipLevels = in_texture.GetMipLevels(),
 				.PlaneSlice = 0,
 				.ResourceMinLODClamp = 0,
 			}
 		};
-		m_device->CreateShaderResourceView(nullptr, &srv_desc, srv_cpu_handle);
+		m_device->CreateShaderResourceView(in_texture.GetResource(), &srv_desc, srv_cpu_handle);
 		return in_texture.bindless_resource_data->descriptor_index;
 	}
 
@@ -449,6 +536,71 @@ protected:
 	FreeList default_free_list;
 };
 
+// Alignment of every GeometryPool allocation. Keeps raw buffer loads 4 byte aligned and lets sections inside an allocation stay 16 byte aligned
+static constexpr uint64_t GEOMETRY_POOL_ALIGNMENT = 16;
+
+// Largest page a GeometryPool can create, shared pages and dedicated ones alike. GpuInstanceData addresses pages with 32-bit byte offsets and
+// the raw SRV counts 32-bit elements, and D3D12 caps buffers at 2GiB anyway
+static constexpr uint64_t GEOMETRY_POOL_MAX_PAGE_SIZE = (uint64_t) D3D12_REQ_RESOURCE_SIZE_IN_MEGABYTES_EXPRESSION_C_TERM * 1024 * 1024;
+
+struct GeometryPoolDesc
+{
+	D3D12MA::Allocator* allocator = nullptr;
+	BindlessResourceManager* bindless_resource_manager = nullptr;
+
+	// Size of each backing buffer. Allocations larger than this get a dedicated page of their own
+	uint64_t page_size = 256 * 1024 * 1024;
+};
+
+// A byte range in one of a GeometryPool's pages
+struct GeometryAllocation
+{
+	uint32_t page_index = UINT32_MAX;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+
+	bool IsValid() const { return page_index != UINT32_MAX; }
+};
+
+/*	Sub-allocates geometry (vertex streams, indices, meshlets...) out of a few large raw buffers ("pages"), each with a single bindless SRV,
+	instead of giving every mesh its own committed buffers and descriptors. Shaders address data by page descriptor + byte offset.
+	Pages live in COMMON so they can be written on the copy queue while other ranges of the same page are being read on the direct queue.
+	Thread-safe.
+*/
+struct GeometryPool
+{
+	GeometryPool(const GeometryPoolDesc& in_desc);
+	DISALLOW_COPY(GeometryPool);
+
+	// Never fails: a new page is created whenever the existing ones are too full. in_size can't exceed GEOMETRY_POOL_MAX_PAGE_SIZE
+	GeometryAllocation Allocate(uint64_t in_size);
+	void Free(const GeometryAllocation& in_allocation);
+
+	// Buffer to copy an allocation's data into, and its raw SRV for shaders
+	GpuBuffer& GetPageBuffer(uint32_t in_page_index);
+	uint32_t GetPageBindlessIndex(uint32_t in_page_index) const;
+
+	size_t GetPageCount() const;
+	uint64_t GetUsedSize() const;
+	uint64_t GetCapacity() const;
+	size_t GetAllocationCount() const;
+
+protected:
+	struct Page
+	{
+		GpuBuffer buffer;
+		FreeListAllocator allocator;
+	};
+
+	uint32_t CreatePage(uint64_t in_size);
+
+	GeometryPoolDesc m_desc;
+
+	// Deque so references from GetPageBuffer stay valid while other threads add pages
+	std::deque<Page> m_pages;
+	mutable std::mutex m_mutex;
+};
+
 //FCS TODO: Support for using BindlessResourceManager during rendering
 //FCS TODO: BindlessResourceManager needs to persist bindless bindings until they aren't needed any more
 //FCS TODO: Need to Create array of free-lists tagged by their allocation frame
\ No newline at end of file
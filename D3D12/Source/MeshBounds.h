@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+using std::span;
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESH_BOUNDS_SSE2 1
+#endif
+
+#include "../Shaders/HLSL_Types.h"
+
+/*	Bounding volumes for meshes, instances and whole scenes. Each is an AABB plus a bounding sphere centered on the AABB's center, which stays
+	centered on it under any affine transform. So a single center works for both the AABB and the sphere once they're in world space (see GpuInstanceBounds).
+
+	compute_bounds has a scalar implementation (the reference) and an SSE2 one that transposes 4 positions at a time into x, y and z registers.
+	Both reduce the same values in the same order, so their results are equal (see MeshBoundsTests), up to the sign of a zero coordinate.
+	That holds as long as the compiler doesn't fuse the distance's multiply-adds, which it may do differently in each: MSVC's default /fp:precise
+	never does, GCC and Clang only can when targeting FMA (e.g. -march=native)
+*/
+
+struct Bounds
+{
+	float3 aabb_min = float3(0.0f, 0.0f, 0.0f);
+	float3 aabb_max = float3(0.0f, 0.0f, 0.0f);
+
+	// Of the sphere around GetCenter()
+	float radius = 0.0f;
+
+	float3 GetCenter() const { return (aabb_min + aabb_max) * 0.5f; }
+	float3 GetExtents() const { return (aabb_max - aabb_min) * 0.5f; }
+};
+
+inline Bounds compute_bounds_scalar(span<const float3> in_positions)
+{
+	Bounds bounds;
+	if (in_positions.empty())
+	{
+		return bounds;
+	}
+
+	bounds.aabb_min = in_positions[0];
+	bounds.aabb_max = in_positions[0];
+	for (const float3& position : in_positions)
+	{
+		bounds.aabb_min = Vector3::Min(bounds.aabb_min, position);
+		bounds.aabb_max = Vector3::Max(bounds.aabb_max, position);
+	}
+
+	const float3 center = bounds.GetCenter();
+	float max_distance_squared = 0.0f;
+	for (const float3& position : in_positions)
+	{
+		const float dx = position.x - center.x;
+		const float dy = position.y - center.y;
+		const float dz = position.z - center.z;
+		max_distance_squared = (std::max)(max_distance_squared, dx * dx + dy * dy + dz * dz);
+	}
+	bounds.radius = std::sqrt(max_distance_squared);
+	return bounds;
+}
+
+#if MESH_BOUNDS_SSE2
+namespace mesh_bounds_sse2
+{
+	// 4 tightly packed float3s (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) into x0 x1 x2 x3, y0 y1 y2 y3, z0 z1 z2 z3
+	inline void load_positions(const float3* in_positions, __m128& out_x, __m128& out_y, __m128& out_z)
+	{
+		const float* floats = &in_positions[0].x;
+		const __m128 a = _mm_loadu_ps(floats);
+		const __m128 b = _mm_loadu_ps(floats + 4);
+		const __m128 c = _mm_loadu_ps(floats + 8);
+
+		out_x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		out_y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		out_z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	inline float horizontal_min(const __m128 in_value)
+	{
+		const __m128 pairs = _mm_min_ps(in_value, _mm_shuffle_ps(in_value, in_value, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(_mm_min_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(2, 3, 0, 1))));
+	}
+
+	inline float horizontal_max(const __m128 in_value)
+	{
+		const __m128 pairs = _mm_max_ps(in_value, _mm_shuffle_ps(in_value, in_value, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(2, 3, 0, 1))));
+	}
+}
+#endif
+
+inline Bounds compute_bounds(span<const float3> in_positions)
+{
+#if MESH_BOUNDS_SSE2
+	using namespace mesh_bounds_sse2;
+	static_assert(sizeof(float3) == 3 * sizeof(float));
+
+	const size_t simd_count = in_positions.size() & ~size_t(3);
+	if (simd_count == 0)
+	{
+		return compute_bounds_scalar(in_positions);
+	}
+
+	__m128 min_x, min_y, min_z;
+	load_positions(in_positions.data(), min_x, min_y, min_z);
+	__m128 max_x = min_x, max_y = min_y, max_z = min_z;
+	for (size_t i = 4; i < simd_count; i += 4)
+	{
+		__m128 x, y, z;
+		load_positions(in_positions.data() + i, x, y, z);
+		min_x = _mm_min_ps(min_x, x);
+		min_y = _mm_min_ps(min_y, y);
+		min_z = _mm_min_ps(min_z, z);
+		max_x = _mm_max_ps(max_x, x);
+		max_y = _mm_max_ps(max_y, y);
+		max_z = _mm_max_ps(max_z, z);
+	}
+
+	Bounds bounds;
+	bounds.aabb_min = float3(horizontal_min(min_x), horizontal_min(min_y), horizontal_min(min_z));
+	bounds.aabb_max = float3(horizontal_max(max_x), horizontal_max(max_y), horizontal_max(max_z));
+	for (size_t i = simd_count; i < in_positions.size(); ++i)
+	{
+		bounds.aabb_min = Vector3::Min(bounds.aabb_min, in_positions[i]);
+		bounds.aabb_max = Vector3::Max(bounds.aabb_max, in_positions[i]);
+	}
+
+	const float3 center = bounds.GetCenter();
+	const __m128 center_x = _mm_set1_ps(center.x);
+	const __m128 center_y = _mm_set1_ps(center.y);
+	const __m128 center_z = _mm_set1_ps(center.z);
+	__m128 max_distance_squared = _mm_setzero_ps();
+	for (size_t i = 0; i < simd_count; i += 4)
+	{
+		__m128 x, y, z;
+		load_positions(in_positions.data() + i, x, y, z);
+		const __m128 dx = _mm_sub_ps(x, center_x);
+		const __m128 dy = _mm_sub_ps(y, center_y);
+		const __m128 dz = _mm_sub_ps(z, center_z);
+		const __m128 distance_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		max_distance_squared = _mm_max_ps(max_distance_squared, distance_squared);
+	}
+
+	float max_distance_squared_scalar = horizontal_max(max_distance_squared);
+	for (size_t i = simd_count; i < in_positions.size(); ++i)
+	{
+		const float dx = in_positions[i].x - center.x;
+		const float dy = in_positions[i].y - center.y;
+		const float dz = in_positions[i].z - center.z;
+		max_distance_squared_scalar = (std::max)(max_distance_squared_scalar, dx * dx + dy * dy + dz * dz);
+	}
+	bounds.radius = std::sqrt(max_distance_squared_scalar);
+	return bounds;
+#else
+	return compute_bounds_scalar(in_positions);
+#endif
+}
+
+/*	Local bounds under in_transform (row vectors, like the rest of SimpleMath). The AABB is Arvo's: each world axis' extent is the local extents
+	projected onto it, so it's the tightest AABB around the transformed local AABB. The radius scales with the largest axis scale
+*/
+inline GpuInstanceBounds transform_bounds(const Bounds& in_bounds, const Matrix& in_transform)
+{
+	const float3 extents = in_bounds.GetExtents();
+	const float3 world_extents(
+		std::abs(in_transform._11) * extents.x + std::abs(in_transform._21) * extents.y + std::abs(in_transform._31) * extents.z,
+		std::abs(in_transform._12) * extents.x + std::abs(in_transform._22) * extents.y + std::abs(in_transform._32) * extents.z,
+		std::abs(in_transform._13) * extents.x + std::abs(in_transform._23) * extents.y + std::abs(in_transform._33) * extents.z
+	);
+	const float max_scale = (std::max)((std::max)(in_transform.Right().Length(), in_transform.Up().Length()), in_transform.Backward().Length());
+
+	return GpuInstanceBounds {
+		.center = Vector3::Transform(in_bounds.GetCenter(), in_transform),
+		.radius = in_bounds.radius * max_scale,
+		.extents = world_extents,
+	};
+}
+
+// World space bounds around every one of in_instance_bounds
+inline Bounds merge_instance_bounds(span<const GpuInstanceBounds> in_instance_bounds)
+{
+	Bounds bounds;
+	if (in_instance_bounds.empty())
+	{
+		return bounds;
+	}
+
+	bounds.aabb_min = in_instance_bounds[0].center - in_instance_bounds[0].extents;
+	bounds.aabb_max = in_instance_bounds[0].center + in_instance_bounds[0].extents;
+	for (const GpuInstanceBounds& instance_bounds : in_instance_bounds)
+	{
+		bounds.aabb_min = Vector3::Min(bounds.aabb_min, instance_bounds.center - instance_bounds.extents);
+		bounds.aabb_max = Vector3::Max(bounds.aabb_max, instance_bounds.center + instance_bounds.extents);
+	}
+
+	// Each instance's sphere is usually tighter than its AABB's corners, so use whichever reaches less far
+	const float3 center = bounds.GetCenter();
+	for (const GpuInstanceBounds& instance_bounds : in_instance_bounds)
+	{
+		const float sphere_reach = Vector3::Distance(center, instance_bounds.center) + instance_bounds.radius;
+		const float3 farthest_corner(
+			std::abs(instance_bounds.center.x - center.x) + instance_bounds.extents.x,
+			std::abs(instance_bounds.center.y - center.y) + instance_bounds.extents.y,
+			std::abs(instance_bounds.center.z - center.z) + instance_bounds.extents.z
+		);
+		const float aabb_reach = farthest_corner.Length();
+		bounds.radius = (std::max)(bounds.radius, (std::min)(sphere_reach, aabb_reach));
+	}
+	return bounds;
+}
@@ -0,0 +1,849 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using std::span;
+using std::vector;
+
+#include "../Shaders/HLSL_Types.h"
+
+/*	Offline mesh processing passes (optimization, meshlet generation, simplification) run while cooking a scene. All passes are deterministic and only touch the mesh
+	they're given, so they're safe to run on many meshes in parallel.
+*/
+
+// Size of the LRU cache modelled by optimize_vertex_cache
+static constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+
+// Size of the FIFO cache simulated by analyze_vertex_cache. Roughly matches the post-transform cache of current GPUs
+static constexpr uint32_t VERTEX_CACHE_STATS_FIFO_SIZE = 16;
+
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation" scoring. Returns < 0 for vertices with no triangles left
+inline float forsyth_vertex_score(const int32_t in_cache_position, const uint32_t in_remaining_triangles)
+{
+	if (in_remaining_triangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (in_cache_position >= 0)
+	{
+		// The last triangle's vertices get a fixed score, so we don't favor any particular one of them
+		score = in_cache_position < 3
+			? 0.75f
+			: std::pow(1.0f - (in_cache_position - 3) / (float) (FORSYTH_CACHE_SIZE - 3), 1.5f);
+	}
+
+	// Boost vertices with few triangles left, so we finish off fans instead of leaving lone triangles behind
+	score += 2.0f / std::sqrt((float) in_remaining_triangles);
+	return score;
+}
+
+// Reorders triangles for post-transform cache locality. Vertex indices themselves are unchanged
+inline void optimize_vertex_cache(span<uint32_t> io_indices, const size_t in_vertex_count)
+{
+	const size_t triangle_count = io_indices.size() / 3;
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// Vertex -> triangle adjacency. Each vertex's active triangles are kept at the front of its range
+	vector<uint32_t> adjacency_offsets(in_vertex_count + 1, 0);
+	for (const uint32_t index : io_indices)
+	{
+		assert(index < in_vertex_count);
+		++adjacency_offsets[index + 1];
+	}
+	for (size_t vertex_idx = 0; vertex_idx < in_vertex_count; ++vertex_idx)
+	{
+		adjacency_offsets[vertex_idx + 1] += adjacency_offsets[vertex_idx];
+	}
+
+	vector<uint32_t> adjacency(triangle_count * 3);
+	vector<uint32_t> remaining_triangles(in_vertex_count, 0);
+	for (size_t triangle_idx = 0; triangle_idx < triangle_count; ++triangle_idx)
+	{
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = io_indices[triangle_idx * 3 + corner];
+			adjacency[adjacency_offsets[vertex] + remaining_triangles[vertex]++] = (uint32_t) triangle_idx;
+		}
+	}
+
+	vector<int32_t> cache_positions(in_vertex_count, -1);
+	vector<float> vertex_scores(in_vertex_count);
+	for (size_t vertex_idx = 0; vertex_idx < in_vertex_count; ++vertex_idx)
+	{
+		vertex_scores[vertex_idx] = forsyth_vertex_score(-1, remaining_triangles[vertex_idx]);
+	}
+
+	auto get_triangle_score = [&](const size_t triangle_idx)
+	{
+		return vertex_scores[io_indices[triangle_idx * 3 + 0]]
+			 + vertex_scores[io_indices[triangle_idx * 3 + 1]]
+			 + vertex_scores[io_indices[triangle_idx * 3 + 2]];
+	};
+
+	vector<bool> triangle_emitted(triangle_count, false);
+	int64_t best_triangle = 0;
+	float best_score = -1.0f;
+	for (size_t triangle_idx = 0; triangle_idx < triangle_count; ++triangle_idx)
+	{
+		const float triangle_score = get_triangle_score(triangle_idx);
+		if (triangle_score > best_score)
+		{
+			best_score = triangle_score;
+			best_triangle = (int64_t) triangle_idx;
+		}
+	}
+
+	// Cache has room for the new triangle's vertices on top of FORSYTH_CACHE_SIZE, so we can see what gets evicted
+	vector<uint32_t> cache;
+	vector<uint32_t> new_cache;
+	cache.reserve(FORSYTH_CACHE_SIZE + 3);
+	new_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+	vector<uint32_t> output_indices;
+	output_indices.reserve(io_indices.size());
+	size_t fallback_cursor = 0;
+
+	while (best_triangle >= 0)
+	{
+		const size_t emitted_triangle = (size_t) best_triangle;
+		triangle_emitted[emitted_triangle] = true;
+
+		new_cache.clear();
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = io_indices[emitted_triangle * 3 + corner];
+			output_indices.push_back(vertex);
+			new_cache.push_back(vertex);
+
+			// Move the emitted triangle out of this vertex's active range
+			uint32_t* active_begin = &adjacency[adjacency_offsets[vertex]];
+			uint32_t* active_end = active_begin + remaining_triangles[vertex];
+			for (uint32_t* it = active_begin; it != active_end; ++it)
+			{
+				if (*it == emitted_triangle)
+				{
+					std::swap(*it, *(active_end - 1));
+					--remaining_triangles[vertex];
+					break;
+				}
+			}
+		}
+
+		for (const uint32_t vertex : cache)
+		{
+			if (vertex != new_cache[0] && vertex != new_cache[1] && vertex != new_cache[2])
+			{
+				new_cache.push_back(vertex);
+			}
+		}
+
+		for (size_t cache_idx = 0; cache_idx < new_cache.size(); ++cache_idx)
+		{
+			const uint32_t vertex = new_cache[cache_idx];
+			cache_positions[vertex] = cache_idx < FORSYTH_CACHE_SIZE ? (int32_t) cache_idx : -1;
+			vertex_scores[vertex] = forsyth_vertex_score(cache_positions[vertex], remaining_triangles[vertex]);
+		}
+
+		// Only triangles touching the cache changed score, so the next best triangle is most likely one of them
+		best_triangle = -1;
+		best_score = -1.0f;
+		for (const uint32_t vertex : new_cache)
+		{
+			const uint32_t* active_begin = &adjacency[adjacency_offsets[vertex]];
+			for (uint32_t active_idx = 0; active_idx < remaining_triangles[vertex]; ++active_idx)
+			{
+				const uint32_t triangle_idx = active_begin[active_idx];
+				const float triangle_score = get_triangle_score(triangle_idx);
+				if (triangle_score > best_score)
+				{
+					best_score = triangle_score;
+					best_triangle = triangle_idx;
+				}
+			}
+		}
+
+		if (new_cache.size() > FORSYTH_CACHE_SIZE)
+		{
+			new_cache.resize(FORSYTH_CACHE_SIZE);
+		}
+		std::swap(cache, new_cache);
+
+		// Nothing connected to the cache. Start over at the next triangle in the original order
+		if (best_triangle < 0)
+		{
+			while (fallback_cursor < triangle_count && triangle_emitted[fallback_cursor])
+			{
+				++fallback_cursor;
+			}
+			if (fallback_cursor < triangle_count)
+			{
+				best_triangle = (int64_t) fallback_cursor;
+			}
+		}
+	}
+
+	assert(output_indices.size() == triangle_count * 3);
+	std::copy(output_indices.begin(), output_indices.end(), io_indices.begin());
+}
+
+// Reorders vertices into the order they're first referenced by io_indices and remaps io_indices to match.
+// Unreferenced vertices are dropped
+template<typename VertexType>
+void optimize_vertex_fetch(span<uint32_t> io_indices, vector<VertexType>& io_vertices)
+{
+	static constexpr uint32_t UNMAPPED = ~0u;
+	vector<uint32_t> remap(io_vertices.size(), UNMAPPED);
+
+	vector<VertexType> remapped_vertices;
+	remapped_vertices.reserve(io_vertices.size());
+
+	for (uint32_t& index : io_indices)
+	{
+		assert(index < io_vertices.size());
+		if (remap[index] == UNMAPPED)
+		{
+			remap[index] = (uint32_t) remapped_vertices.size();
+			remapped_vertices.push_back(io_vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	io_vertices = std::move(remapped_vertices);
+}
+
+struct VertexCacheStats
+{
+	size_t triangle_count = 0;
+	size_t vertex_count = 0;
+	size_t cache_misses = 0;
+
+	// Average cache miss ratio: vertex shader invocations per triangle. 0.5 is the ideal for large regular meshes, 3 is the worst case
+	float GetACMR() const { return triangle_count > 0 ? (float) cache_misses / triangle_count : 0.0f; }
+
+	// Average transform to vertex ratio: vertex shader invocations per vertex. 1 is ideal
+	float GetATVR() const { return vertex_count > 0 ? (float) cache_misses / vertex_count : 0.0f; }
+
+	VertexCacheStats& operator+=(const VertexCacheStats& in_other)
+	{
+		triangle_count += in_other.triangle_count;
+		vertex_count += in_other.vertex_count;
+		cache_misses += in_other.cache_misses;
+		return *this;
+	}
+};
+
+// Simulates a FIFO post-transform cache over in_indices
+inline VertexCacheStats analyze_vertex_cache(span<const uint32_t> in_indices, const size_t in_vertex_count, const uint32_t in_cache_size = VERTEX_CACHE_STATS_FIFO_SIZE)
+{
+	VertexCacheStats stats = {
+		.triangle_count = in_indices.size() / 3,
+		.vertex_count = in_vertex_count,
+	};
+
+	// A vertex is in the cache if fewer than in_cache_size misses happened since it was last loaded
+	vector<size_t> load_timestamps(in_vertex_count, 0);
+	size_t timestamp = in_cache_size + 1;
+	for (const uint32_t index : in_indices)
+	{
+		assert(index < in_vertex_count);
+		if (timestamp - load_timestamps[index] > in_cache_size)
+		{
+			load_timestamps[index] = timestamp++;
+			++stats.cache_misses;
+		}
+	}
+
+	return stats;
+}
+
+// Meshlets for a single mesh, see Meshlet
+struct MeshletData
+{
+	vector<Meshlet> meshlets;
+	vector<uint32_t> meshlet_vertices;
+	vector<uint32_t> meshlet_triangles;
+};
+
+inline uint32_t pack_meshlet_triangle(const uint32_t in_a, const uint32_t in_b, const uint32_t in_c)
+{
+	assert(in_a < MESHLET_MAX_VERTICES && in_b < MESHLET_MAX_VERTICES && in_c < MESHLET_MAX_VERTICES);
+	return in_a | (in_b << 8) | (in_c << 16);
+}
+
+// Computes meshlet's bounding sphere and normal cone from the vertices and triangles it references
+inline void compute_meshlet_bounds(Meshlet& io_meshlet, const MeshletData& in_meshlet_data, span<const Vertex> in_vertices)
+{
+	const span<const uint32_t> meshlet_vertices = span(in_meshlet_data.meshlet_vertices).subspan(io_meshlet.vertex_offset, io_meshlet.vertex_count);
+	const span<const uint32_t> meshlet_triangles = span(in_meshlet_data.meshlet_triangles).subspan(io_meshlet.triangle_offset, io_meshlet.triangle_count);
+
+	// Sphere around the AABB center. Not minimal, but cheap and stable
+	Vector3 position_min = in_vertices[meshlet_vertices[0]].position;
+	Vector3 position_max = position_min;
+	for (const uint32_t vertex_idx : meshlet_vertices)
+	{
+		position_min = Vector3::Min(position_min, in_vertices[vertex_idx].position);
+		position_max = Vector3::Max(position_max, in_vertices[vertex_idx].position);
+	}
+
+	io_meshlet.center = (position_min + position_max) * 0.5f;
+	io_meshlet.radius = 0.0f;
+	for (const uint32_t vertex_idx : meshlet_vertices)
+	{
+		io_meshlet.radius = (std::max)(io_meshlet.radius, Vector3::Distance(io_meshlet.center, in_vertices[vertex_idx].position));
+	}
+
+	// Normal cone around the average face normal. Degenerate triangles don't contribute
+	vector<Vector3> face_normals;
+	face_normals.reserve(meshlet_triangles.size());
+	for (const uint32_t packed_triangle : meshlet_triangles)
+	{
+		const Vector3& a = in_vertices[meshlet_vertices[packed_triangle & 0xFF]].position;
+		const Vector3& b = in_vertices[meshlet_vertices[(packed_triangle >> 8) & 0xFF]].position;
+		const Vector3& c = in_vertices[meshlet_vertices[(packed_triangle >> 16) & 0xFF]].position;
+
+		Vector3 face_normal = (b - a).Cross(c - a);
+		const float face_normal_length = face_normal.Length();
+		if (face_normal_length > 0.0f)
+		{
+			face_normals.push_back(face_normal / face_normal_length);
+		}
+	}
+
+	Vector3 cone_axis = Vector3::Zero;
+	for (const Vector3& face_normal : face_normals)
+	{
+		cone_axis += face_normal;
+	}
+
+	const float cone_axis_length = cone_axis.Length();
+	float min_dot = cone_axis_length > 1e-6f ? 1.0f : -1.0f;
+	if (cone_axis_length > 1e-6f)
+	{
+		cone_axis /= cone_axis_length;
+		for (const Vector3& face_normal : face_normals)
+		{
+			min_dot = (std::min)(min_dot, cone_axis.Dot(face_normal));
+		}
+	}
+
+	// A cone spanning a hemisphere or more can never be entirely backfacing
+	if (min_dot <= 0.0f)
+	{
+		io_meshlet.cone_axis = Vector3::Zero;
+		io_meshlet.cone_cutoff = 1.0f;
+	}
+	else
+	{
+		// sin of the cone's half angle
+		io_meshlet.cone_axis = cone_axis;
+		io_meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+	}
+}
+
+// Splits a mesh into meshlets of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles.
+// Triangles are consumed in index order, so running optimize_vertex_cache first gives much tighter meshlets
+inline MeshletData build_meshlets(span<const uint32_t> in_indices, span<const Vertex> in_vertices)
+{
+	MeshletData result;
+
+	static constexpr uint32_t NOT_IN_MESHLET = ~0u;
+	vector<uint32_t> local_vertex_indices(in_vertices.size(), NOT_IN_MESHLET);
+
+	Meshlet current_meshlet = {};
+	auto finish_meshlet = [&]()
+	{
+		if (current_meshlet.triangle_count == 0)
+		{
+			return;
+		}
+
+		compute_meshlet_bounds(current_meshlet, result, in_vertices);
+		for (uint32_t local_idx = 0; local_idx < current_meshlet.vertex_count; ++local_idx)
+		{
+			local_vertex_indices[result.meshlet_vertices[current_meshlet.vertex_offset + local_idx]] = NOT_IN_MESHLET;
+		}
+
+		result.meshlets.push_back(current_meshlet);
+		current_meshlet = Meshlet {
+			.vertex_offset = (uint32_t) result.meshlet_vertices.size(),
+			.triangle_offset = (uint32_t) result.meshlet_triangles.size(),
+		};
+	};
+
+	for (size_t index_idx = 0; index_idx + 2 < in_indices.size(); index_idx += 3)
+	{
+		const uint32_t triangle[3] = { in_indices[index_idx], in_indices[index_idx + 1], in_indices[index_idx + 2] };
+
+		uint32_t new_vertex_count = 0;
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			assert(triangle[corner] < in_vertices.size());
+			const bool seen_earlier_in_triangle = (corner > 0 && triangle[corner] == triangle[0]) || (corner > 1 && triangle[corner] == triangle[1]);
+			if (local_vertex_indices[triangle[corner]] == NOT_IN_MESHLET && !seen_earlier_in_triangle)
+			{
+				++new_vertex_count;
+			}
+		}
+
+		if (current_meshlet.vertex_count + new_vertex_count > MESHLET_MAX_VERTICES || current_meshlet.triangle_count + 1 > MESHLET_MAX_TRIANGLES)
+		{
+			finish_meshlet();
+		}
+
+		uint32_t local_triangle[3];
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			uint32_t& local_vertex_index = local_vertex_indices[triangle[corner]];
+			if (local_vertex_index == NOT_IN_MESHLET)
+			{
+				local_vertex_index = current_meshlet.vertex_count++;
+				result.meshlet_vertices.push_back(triangle[corner]);
+			}
+			local_triangle[corner] = local_vertex_index;
+		}
+
+		result.meshlet_triangles.push_back(pack_meshlet_triangle(local_triangle[0], local_triangle[1], local_triangle[2]));
+		++current_meshlet.triangle_count;
+	}
+
+	finish_meshlet();
+	return result;
+}
+
+// Quadric error metric (Garland & Heckbert). Sum of weighted squared distances to a set of planes
+struct Quadric
+{
+	// Symmetric 3x3 A, b and c from p^T A p + 2 b.p + c
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+
+	// Total weight of all planes, so Evaluate can return an average rather than a sum
+	double weight = 0.0;
+
+	static Quadric FromPlane(const double in_nx, const double in_ny, const double in_nz, const double in_d, const double in_weight)
+	{
+		Quadric quadric;
+		quadric.a00 = in_weight * in_nx * in_nx;
+		quadric.a01 = in_weight * in_nx * in_ny;
+		quadric.a02 = in_weight * in_nx * in_nz;
+		quadric.a11 = in_weight * in_ny * in_ny;
+		quadric.a12 = in_weight * in_ny * in_nz;
+		quadric.a22 = in_weight * in_nz * in_nz;
+		quadric.b0 = in_weight * in_nx * in_d;
+		quadric.b1 = in_weight * in_ny * in_d;
+		quadric.b2 = in_weight * in_nz * in_d;
+		quadric.c = in_weight * in_d * in_d;
+		quadric.weight = in_weight;
+		return quadric;
+	}
+
+	Quadric& operator+=(const Quadric& in_other)
+	{
+		a00 += in_other.a00; a01 += in_other.a01; a02 += in_other.a02;
+		a11 += in_other.a11; a12 += in_other.a12; a22 += in_other.a22;
+		b0 += in_other.b0; b1 += in_other.b1; b2 += in_other.b2;
+		c += in_other.c;
+		weight += in_other.weight;
+		return *this;
+	}
+
+	// Weighted mean squared distance from in_position to this quadric's planes
+	double Evaluate(const float3& in_position) const
+	{
+		const double x = in_position.x, y = in_position.y, z = in_position.z;
+		const double error = a00 * x * x + a11 * y * y + a22 * z * z
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z)
+			+ c;
+		return weight > 0.0 ? (std::max)(error, 0.0) / weight : 0.0;
+	}
+};
+
+// How much attribute (normal + texcoord) differences count against a collapse, relative to squared geometric error in units of the mesh's size
+static constexpr float SIMPLIFY_ATTRIBUTE_WEIGHT = 0.01f;
+
+/*	Quadric error metric simplification using half-edge collapses: a vertex is only ever merged onto one of its neighbors,
+	so the result references a subset of in_vertices and can share the original vertex buffer.
+	Vertices on open borders, on non-manifold edges, or split along attribute seams (several vertices sharing a position) are never moved.
+	Stops at in_target_index_count or when no more collapses are possible. out_error receives the largest error introduced,
+	as a mesh space distance.
+*/
+inline vector<uint32_t> simplify_mesh(span<const uint32_t> in_indices, span<const Vertex> in_vertices, const size_t in_target_index_count, float& out_error)
+{
+	out_error = 0.0f;
+	const size_t vertex_count = in_vertices.size();
+	vector<uint32_t> indices(in_indices.begin(), in_indices.end());
+	if (indices.size() <= in_target_index_count || vertex_count == 0)
+	{
+		return indices;
+	}
+
+	// Weld vertices by position, so topology (borders, adjacency) ignores attribute seams
+	vector<uint32_t> position_root(vertex_count);
+	vector<bool> is_seam(vertex_count, false);
+	{
+		vector<uint32_t> sorted_vertices(vertex_count);
+		for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+		{
+			sorted_vertices[vertex_idx] = vertex_idx;
+		}
+
+		auto position_less = [&](const uint32_t a, const uint32_t b)
+		{
+			const float3& pa = in_vertices[a].position;
+			const float3& pb = in_vertices[b].position;
+			if (pa.x != pb.x) { return pa.x < pb.x; }
+			if (pa.y != pb.y) { return pa.y < pb.y; }
+			if (pa.z != pb.z) { return pa.z < pb.z; }
+			return a < b;
+		};
+		std::sort(sorted_vertices.begin(), sorted_vertices.end(), position_less);
+
+		for (size_t sorted_idx = 0; sorted_idx < vertex_count; )
+		{
+			const uint32_t root = sorted_vertices[sorted_idx];
+			const float3& root_position = in_vertices[root].position;
+
+			size_t group_end = sorted_idx;
+			while (group_end < vertex_count)
+			{
+				const float3& position = in_vertices[sorted_vertices[group_end]].position;
+				if (position.x != root_position.x || position.y != root_position.y || position.z != root_position.z)
+				{
+					break;
+				}
+				position_root[sorted_vertices[group_end]] = root;
+				++group_end;
+			}
+
+			if (group_end - sorted_idx > 1)
+			{
+				for (size_t group_idx = sorted_idx; group_idx < group_end; ++group_idx)
+				{
+					is_seam[sorted_vertices[group_idx]] = true;
+				}
+			}
+			sorted_idx = group_end;
+		}
+	}
+
+	// Lock vertices on edges that don't have exactly two triangles
+	vector<bool> is_locked = is_seam;
+	{
+		vector<uint64_t> edges;
+		edges.reserve(indices.size());
+		for (size_t index_idx = 0; index_idx + 2 < indices.size(); index_idx += 3)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint64_t a = position_root[indices[index_idx + corner]];
+				const uint64_t b = position_root[indices[index_idx + (corner + 1) % 3]];
+				edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (size_t edge_idx = 0; edge_idx < edges.size(); )
+		{
+			size_t edge_end = edge_idx;
+			while (edge_end < edges.size() && edges[edge_end] == edges[edge_idx])
+			{
+				++edge_end;
+			}
+			if (edge_end - edge_idx != 2)
+			{
+				is_locked[(uint32_t) (edges[edge_idx] >> 32)] = true;
+				is_locked[(uint32_t) (edges[edge_idx] & 0xFFFFFFFF)] = true;
+			}
+			edge_idx = edge_end;
+		}
+
+		// Locks are tracked on the position root, spread them to every vertex at that position
+		for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+		{
+			if (is_locked[position_root[vertex_idx]])
+			{
+				is_locked[vertex_idx] = true;
+			}
+		}
+	}
+
+	// Area weighted plane quadrics, accumulated on the position root
+	vector<Quadric> quadrics(vertex_count);
+	Vector3 bounds_min = in_vertices[0].position;
+	Vector3 bounds_max = in_vertices[0].position;
+	for (const Vertex& vertex : in_vertices)
+	{
+		bounds_min = Vector3::Min(bounds_min, vertex.position);
+		bounds_max = Vector3::Max(bounds_max, vertex.position);
+	}
+	const float mesh_scale = (std::max)(Vector3::Distance(bounds_min, bounds_max), 1e-6f);
+
+	for (size_t index_idx = 0; index_idx + 2 < indices.size(); index_idx += 3)
+	{
+		const Vector3& a = in_vertices[indices[index_idx + 0]].position;
+		const Vector3& b = in_vertices[indices[index_idx + 1]].position;
+		const Vector3& c = in_vertices[indices[index_idx + 2]].position;
+
+		Vector3 normal = (b - a).Cross(c - a);
+		const float double_area = normal.Length();
+		if (double_area <= 0.0f)
+		{
+			continue;
+		}
+		normal /= double_area;
+
+		const Quadric plane_quadric = Quadric::FromPlane(normal.x, normal.y, normal.z, -normal.Dot(a), 0.5 * double_area);
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			quadrics[position_root[indices[index_idx + corner]]] += plane_quadric;
+		}
+	}
+
+	auto get_attribute_error = [&](const uint32_t in_from, const uint32_t in_to)
+	{
+		const Vertex& from = in_vertices[in_from];
+		const Vertex& to = in_vertices[in_to];
+		const float normal_error = Vector3::DistanceSquared(from.normal, to.normal);
+		const float texcoord_error = Vector2::DistanceSquared(from.texcoord, to.texcoord);
+		return SIMPLIFY_ATTRIBUTE_WEIGHT * (normal_error + texcoord_error) * mesh_scale * mesh_scale;
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		// Geometric error plus attribute error, used to order collapses. Only the geometric part is reported through out_error
+		float cost;
+		float geometric_error;
+	};
+
+	vector<uint32_t> collapse_remap(vertex_count);
+	vector<bool> touched(vertex_count);
+	vector<uint32_t> adjacency_offsets(vertex_count + 1);
+	vector<uint32_t> adjacency;
+	float max_geometric_error = 0.0f;
+
+	// Each pass collapses a set of independent edges, cheapest first, then rebuilds the index buffer
+	while (indices.size() > in_target_index_count)
+	{
+		const size_t triangle_count = indices.size() / 3;
+
+		// Cheapest collapse for each vertex that's allowed to move
+		vector<Collapse> best_collapses(vertex_count, Collapse { .from = ~0u, .to = ~0u, .cost = FLT_MAX, .geometric_error = 0.0f });
+		for (size_t index_idx = 0; index_idx < indices.size(); index_idx += 3)
+		{
+			for (size_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t from = indices[index_idx + corner];
+				if (is_locked[from])
+				{
+					continue;
+				}
+
+				for (size_t other_corner = 1; other_corner < 3; ++other_corner)
+				{
+					const uint32_t to = indices[index_idx + (corner + other_corner) % 3];
+					Quadric merged_quadric = quadrics[position_root[from]];
+					merged_quadric += quadrics[position_root[to]];
+					const float geometric_error = (float) merged_quadric.Evaluate(in_vertices[to].position);
+					const float cost = geometric_error + get_attribute_error(from, to);
+
+					Collapse& best_collapse = best_collapses[from];
+					if (cost < best_collapse.cost || (cost == best_collapse.cost && to < best_collapse.to))
+					{
+						best_collapse = Collapse { .from = from, .to = to, .cost = cost, .geometric_error = geometric_error };
+					}
+				}
+			}
+		}
+
+		vector<Collapse> collapses;
+		for (const Collapse& collapse : best_collapses)
+		{
+			if (collapse.from != ~0u)
+			{
+				collapses.push_back(collapse);
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+		{
+			return a.cost != b.cost ? a.cost < b.cost : a.from < b.from;
+		});
+
+		// Vertex -> triangle adjacency for the flip test
+		std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+		for (const uint32_t index : indices)
+		{
+			++adjacency_offsets[index + 1];
+		}
+		for (size_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+		{
+			adjacency_offsets[vertex_idx + 1] += adjacency_offsets[vertex_idx];
+		}
+		adjacency.resize(indices.size());
+		{
+			vector<uint32_t> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+			for (size_t index_idx = 0; index_idx < indices.size(); ++index_idx)
+			{
+				adjacency[fill_offsets[indices[index_idx]]++] = (uint32_t) (index_idx / 3);
+			}
+		}
+
+		for (uint32_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+		{
+			collapse_remap[vertex_idx] = vertex_idx;
+		}
+		std::fill(touched.begin(), touched.end(), false);
+
+		const size_t target_triangle_count = in_target_index_count / 3;
+		size_t remaining_triangle_count = triangle_count;
+		size_t accepted_collapses = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (remaining_triangle_count <= target_triangle_count)
+			{
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			// Reject collapses that would flip (or fully degenerate) any triangle that survives them
+			bool flips = false;
+			size_t removed_triangle_count = 0;
+			for (uint32_t adjacency_idx = adjacency_offsets[collapse.from]; adjacency_idx < adjacency_offsets[collapse.from + 1]; ++adjacency_idx)
+			{
+				const uint32_t* triangle = &indices[adjacency[adjacency_idx] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					++removed_triangle_count;
+					continue;
+				}
+
+				const Vector3& a = in_vertices[triangle[0]].position;
+				const Vector3& b = in_vertices[triangle[1]].position;
+				const Vector3& c = in_vertices[triangle[2]].position;
+				const Vector3& new_a = in_vertices[triangle[0] == collapse.from ? collapse.to : triangle[0]].position;
+				const Vector3& new_b = in_vertices[triangle[1] == collapse.from ? collapse.to : triangle[1]].position;
+				const Vector3& new_c = in_vertices[triangle[2] == collapse.from ? collapse.to : triangle[2]].position;
+
+				const Vector3 normal = (b - a).Cross(c - a);
+				const Vector3 new_normal = (new_b - new_a).Cross(new_c - new_a);
+				if (normal.Dot(new_normal) <= 0.0f)
+				{
+					flips = true;
+					break;
+				}
+			}
+
+			if (flips)
+			{
+				continue;
+			}
+
+			collapse_remap[collapse.from] = collapse.to;
+			quadrics[position_root[collapse.to]] += quadrics[position_root[collapse.from]];
+			max_geometric_error = (std::max)(max_geometric_error, collapse.geometric_error);
+			remaining_triangle_count -= (std::min)(removed_triangle_count, remaining_triangle_count);
+			++accepted_collapses;
+
+			// Everything in from's one-ring now depends on this collapse, so keep it out of the rest of this pass
+			for (uint32_t adjacency_idx = adjacency_offsets[collapse.from]; adjacency_idx < adjacency_offsets[collapse.from + 1]; ++adjacency_idx)
+			{
+				const uint32_t* triangle = &indices[adjacency[adjacency_idx] * 3];
+				touched[triangle[0]] = true;
+				touched[triangle[1]] = true;
+				touched[triangle[2]] = true;
+			}
+		}
+
+		if (accepted_collapses == 0)
+		{
+			break;
+		}
+
+		// Apply collapses and drop the triangles they degenerated
+		size_t write_idx = 0;
+		for (size_t index_idx = 0; index_idx < indices.size(); index_idx += 3)
+		{
+			const uint32_t a = collapse_remap[indices[index_idx + 0]];
+			const uint32_t b = collapse_remap[indices[index_idx + 1]];
+			const uint32_t c = collapse_remap[indices[index_idx + 2]];
+			if (a != b && b != c && a != c)
+			{
+				indices[write_idx++] = a;
+				indices[write_idx++] = b;
+				indices[write_idx++] = c;
+			}
+		}
+		indices.resize(write_idx);
+	}
+
+	out_error = std::sqrt(max_geometric_error);
+	return indices;
+}
+
+// Each LOD after the first targets this fraction of the previous LOD's triangles
+static constexpr float LOD_TRIANGLE_RATIO = 0.5f;
+
+// The LOD chain ends early once simplification can't get a LOD below this fraction of the previous LOD's triangles
+static constexpr float LOD_MIN_TRIANGLE_REDUCTION = 0.85f;
+
+/*	Simplifies io_indices (which must hold only the full detail mesh on entry) into up to MESH_MAX_LODS - 1 further LODs,
+	vertex cache optimizes them and appends them to io_indices. Every LOD references the same vertices.
+	Returns the LOD table for the whole chain, starting with the full detail mesh
+*/
+inline vector<MeshLod> build_mesh_lods(vector<uint32_t>& io_indices, span<const Vertex> in_vertices)
+{
+	vector<MeshLod> lods;
+	lods.push_back(MeshLod {
+		.index_offset = 0,
+		.index_count = (uint32_t) io_indices.size(),
+		.error = 0.0f,
+		.padding = 0,
+	});
+
+	vector<uint32_t> previous_lod_indices = io_indices;
+	while (lods.size() < MESH_MAX_LODS)
+	{
+		const size_t previous_triangle_count = previous_lod_indices.size() / 3;
+		const size_t target_index_count = (size_t) (previous_triangle_count * LOD_TRIANGLE_RATIO) * 3;
+
+		float lod_error = 0.0f;
+		vector<uint32_t> lod_indices = simplify_mesh(previous_lod_indices, in_vertices, target_index_count, lod_error);
+		if (lod_indices.empty() || lod_indices.size() / 3 > previous_triangle_count * LOD_MIN_TRIANGLE_REDUCTION)
+		{
+			break;
+		}
+
+		optimize_vertex_cache(lod_indices, in_vertices.size());
+
+		lods.push_back(MeshLod {
+			.index_offset = (uint32_t) io_indices.size(),
+			.index_count = (uint32_t) lod_indices.size(),
+			// Each LOD is simplified from the previous one, so its error includes the previous LOD's
+			.error = lods.back().error + lod_error,
+			.padding = 0,
+		});
+
+		io_indices.insert(io_indices.end(), lod_indices.begin(), lod_indices.end());
+		previous_lod_indices = std::move(lod_indices);
+	}
+
+	return lods;
+}
@@ -0,0 +1,510 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+using std::span;
+
+/*	Decoders for the meshoptimizer bitstreams used by EXT_meshopt_compression buffer views. Nothing here knows about cgltf, see
+	decode_meshopt_buffer_views in GltfScene.h for that. Every decoder validates against the size of its input and returns false on
+	malformed data rather than reading out of bounds.
+
+	ATTRIBUTES (vertex codec v0):	Vertices are split into blocks. Each block stores every byte of the vertex as its own stream of zigzag
+									deltas from the previous vertex, packed 16 at a time into 0, 2, 4 or 8 bit groups. The stream ends with a
+									tail holding the first vertex, which is the baseline for the first block.
+	TRIANGLES (index codec v0/v1):	One code byte per triangle that references recently seen edges and vertices through small FIFOs, with
+									any vertex that can't be referenced stored as a varint delta. A 16 entry lookup table sits at the end.
+	INDICES (sequence codec):		Every index is a varint delta from one of two baselines.
+*/
+
+static constexpr uint8_t MESHOPT_VERTEX_HEADER = 0xA0;
+static constexpr uint8_t MESHOPT_INDEX_HEADER = 0xE0;
+static constexpr uint8_t MESHOPT_SEQUENCE_HEADER = 0xD0;
+
+static constexpr size_t MESHOPT_VERTEX_BLOCK_SIZE_BYTES = 8192;
+static constexpr size_t MESHOPT_VERTEX_BLOCK_MAX_SIZE = 256;
+static constexpr size_t MESHOPT_BYTE_GROUP_SIZE = 16;
+
+// Most bytes a single byte group can read (8 packed bytes of 4-bit values plus 16 escapes), which the vertex stream tail always covers
+static constexpr size_t MESHOPT_BYTE_GROUP_DECODE_LIMIT = 24;
+static constexpr size_t MESHOPT_VERTEX_TAIL_MIN_SIZE = 32;
+
+enum class MeshoptFilter : uint32_t
+{
+	None,
+	Octahedral,
+	Quaternion,
+	Exponential,
+};
+
+/* ---------------------------------------- Attributes ---------------------------------------- */
+
+inline size_t get_meshopt_vertex_block_size(const size_t in_vertex_size)
+{
+	// Blocks are a multiple of the byte group size, and never more than 8KiB of vertex data
+	const size_t block_size = (MESHOPT_VERTEX_BLOCK_SIZE_BYTES / in_vertex_size) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+	return block_size < MESHOPT_VERTEX_BLOCK_MAX_SIZE ? block_size : MESHOPT_VERTEX_BLOCK_MAX_SIZE;
+}
+
+// Unpacks 16 values stored with in_bits (2 or 4) bits each, most significant bits first. A value of all ones is an escape for a full byte
+template<uint32_t Bits>
+inline const uint8_t* decode_meshopt_packed_group(const uint8_t* in_data, uint8_t* out_values)
+{
+	constexpr uint32_t values_per_byte = 8 / Bits;
+	constexpr uint8_t escape = (1 << Bits) - 1;
+
+	const uint8_t* escaped_data = in_data + MESHOPT_BYTE_GROUP_SIZE / values_per_byte;
+	for (size_t byte_idx = 0; byte_idx < MESHOPT_BYTE_GROUP_SIZE / values_per_byte; ++byte_idx)
+	{
+		uint8_t packed = in_data[byte_idx];
+		for (uint32_t value_idx = 0; value_idx < values_per_byte; ++value_idx)
+		{
+			const uint8_t value = packed >> (8 - Bits);
+			packed <<= Bits;
+			*out_values++ = value == escape ? *escaped_data++ : value;
+		}
+	}
+	return escaped_data;
+}
+
+// Decodes in_value_count (a multiple of 16) delta bytes. Returns null if in_data runs out first
+inline const uint8_t* decode_meshopt_byte_stream(const uint8_t* in_data, const uint8_t* in_data_end, uint8_t* out_values, const size_t in_value_count)
+{
+	assert(in_value_count % MESHOPT_BYTE_GROUP_SIZE == 0);
+
+	// 2 bits of header per group, least significant bits first
+	const size_t group_count = in_value_count / MESHOPT_BYTE_GROUP_SIZE;
+	const size_t header_size = (group_count + 3) / 4;
+	if ((size_t) (in_data_end - in_data) < header_size)
+	{
+		return nullptr;
+	}
+
+	const uint8_t* header = in_data;
+	const uint8_t* data = in_data + header_size;
+	for (size_t group_idx = 0; group_idx < group_count; ++group_idx)
+	{
+		if ((size_t) (in_data_end - data) < MESHOPT_BYTE_GROUP_DECODE_LIMIT)
+		{
+			return nullptr;
+		}
+
+		uint8_t* group_values = out_values + group_idx * MESHOPT_BYTE_GROUP_SIZE;
+		switch ((header[group_idx / 4] >> ((group_idx % 4) * 2)) & 3)
+		{
+			case 0:
+				memset(group_values, 0, MESHOPT_BYTE_GROUP_SIZE);
+				break;
+			case 1:
+				data = decode_meshopt_packed_group<2>(data, group_values);
+				break;
+			case 2:
+				data = decode_meshopt_packed_group<4>(data, group_values);
+				break;
+			case 3:
+				memcpy(group_values, data, MESHOPT_BYTE_GROUP_SIZE);
+				data += MESHOPT_BYTE_GROUP_SIZE;
+				break;
+		}
+	}
+	return data;
+}
+
+// Decodes in_count vertices of in_vertex_size bytes (a multiple of 4, at most 256) into out_vertices
+inline bool decode_meshopt_vertex_buffer(void* out_vertices, const size_t in_count, const size_t in_vertex_size, span<const uint8_t> in_data)
+{
+	if (in_vertex_size == 0 || in_vertex_size > 256 || in_vertex_size % 4 != 0 || in_data.size() < 1 + in_vertex_size)
+	{
+		return false;
+	}
+
+	const uint8_t* data = in_data.data();
+	const uint8_t* data_end = in_data.data() + in_data.size();
+	if (*data++ != MESHOPT_VERTEX_HEADER)
+	{
+		return false;
+	}
+
+	// The tail holds the first vertex, which is what the first block's deltas are relative to
+	uint8_t last_vertex[256];
+	memcpy(last_vertex, data_end - in_vertex_size, in_vertex_size);
+
+	const size_t block_size = get_meshopt_vertex_block_size(in_vertex_size);
+	uint8_t deltas[MESHOPT_VERTEX_BLOCK_MAX_SIZE];
+	uint8_t* vertices = (uint8_t*) out_vertices;
+	for (size_t block_start = 0; block_start < in_count; block_start += block_size)
+	{
+		const size_t block_vertex_count = (std::min)(block_size, in_count - block_start);
+		const size_t aligned_vertex_count = (block_vertex_count + MESHOPT_BYTE_GROUP_SIZE - 1) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+		uint8_t* block_vertices = vertices + block_start * in_vertex_size;
+
+		for (size_t byte_idx = 0; byte_idx < in_vertex_size; ++byte_idx)
+		{
+			data = decode_meshopt_byte_stream(data, data_end, deltas, aligned_vertex_count);
+			if (!data)
+			{
+				return false;
+			}
+
+			uint8_t previous = last_vertex[byte_idx];
+			for (size_t vertex_idx = 0; vertex_idx < block_vertex_count; ++vertex_idx)
+			{
+				// Zigzag decode, then accumulate
+				const uint8_t delta = deltas[vertex_idx];
+				previous += (uint8_t) (-(delta & 1) ^ (delta >> 1));
+				block_vertices[vertex_idx * in_vertex_size + byte_idx] = previous;
+			}
+		}
+
+		memcpy(last_vertex, block_vertices + (block_vertex_count - 1) * in_vertex_size, in_vertex_size);
+	}
+
+	const size_t tail_size = (std::max)(in_vertex_size, MESHOPT_VERTEX_TAIL_MIN_SIZE);
+	return (size_t) (data_end - data) == tail_size;
+}
+
+/* ---------------------------------------- Indices ---------------------------------------- */
+
+// Little endian base 128. Callers make sure 5 bytes are readable
+inline uint32_t decode_meshopt_varint(const uint8_t*& io_data)
+{
+	const uint8_t lead = *io_data++;
+	if (lead < 128)
+	{
+		return lead;
+	}
+
+	uint32_t result = lead & 127;
+	uint32_t shift = 7;
+	for (uint32_t group_idx = 0; group_idx < 4; ++group_idx)
+	{
+		const uint8_t group = *io_data++;
+		result |= (uint32_t) (group & 127) << shift;
+		shift += 7;
+		if (group < 128)
+		{
+			break;
+		}
+	}
+	return result;
+}
+
+inline uint32_t decode_meshopt_index_delta(const uint8_t*& io_data, const uint32_t in_last)
+{
+	const uint32_t value = decode_meshopt_varint(io_data);
+	return in_last + ((value >> 1) ^ (0u - (value & 1)));
+}
+
+inline void write_meshopt_index(void* out_indices, const size_t in_index, const size_t in_index_size, const uint32_t in_value)
+{
+	if (in_index_size == 2)
+	{
+		((uint16_t*) out_indices)[in_index] = (uint16_t) in_value;
+	}
+	else
+	{
+		((uint32_t*) out_indices)[in_index] = in_value;
+	}
+}
+
+// Decodes in_count (a multiple of 3) triangle list indices of in_index_size (2 or 4) bytes into out_indices
+inline bool decode_meshopt_index_buffer(void* out_indices, const size_t in_count, const size_t in_index_size, span<const uint8_t> in_data)
+{
+	static constexpr size_t CODE_AUX_TABLE_SIZE = 16;
+
+	// The smallest valid encoding is the header, one code per triangle and the code aux table
+	if (in_count % 3 != 0 || (in_index_size != 2 && in_index_size != 4) || in_data.size() < 1 + in_count / 3 + CODE_AUX_TABLE_SIZE)
+	{
+		return false;
+	}
+
+	const uint8_t header = in_data[0];
+	const uint32_t version = header & 0x0F;
+	if ((header & 0xF0) != MESHOPT_INDEX_HEADER || version > 1)
+	{
+		return false;
+	}
+
+	// Version 1 spends codes 13 and 14 on "last index -1/+1" instead of vertex FIFO entries
+	const uint32_t fifo_code_max = version >= 1 ? 13 : 15;
+
+	uint32_t edge_fifo[16][2];
+	uint32_t vertex_fifo[16];
+	memset(edge_fifo, 0xFF, sizeof(edge_fifo));
+	memset(vertex_fifo, 0xFF, sizeof(vertex_fifo));
+	size_t edge_fifo_offset = 0;
+	size_t vertex_fifo_offset = 0;
+
+	auto push_edge = [&](const uint32_t in_a, const uint32_t in_b)
+	{
+		edge_fifo[edge_fifo_offset][0] = in_a;
+		edge_fifo[edge_fifo_offset][1] = in_b;
+		edge_fifo_offset = (edge_fifo_offset + 1) & 15;
+	};
+	auto push_vertex = [&](const uint32_t in_vertex, const bool in_push = true)
+	{
+		vertex_fifo[vertex_fifo_offset] = in_vertex;
+		vertex_fifo_offset = (vertex_fifo_offset + in_push) & 15;
+	};
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	const uint8_t* codes = in_data.data() + 1;
+	const uint8_t* data = codes + in_count / 3;
+	const uint8_t* data_safe_end = in_data.data() + in_data.size() - CODE_AUX_TABLE_SIZE;
+	const uint8_t* code_aux_table = data_safe_end;
+
+	for (size_t index_idx = 0; index_idx < in_count; index_idx += 3)
+	{
+		// A triangle reads at most 16 bytes of data (a code aux byte and three 5 byte varints), and the table is 16 bytes.
+		// So as long as we haven't started reading the table, this triangle can't read past the end
+		if (data > data_safe_end)
+		{
+			return false;
+		}
+
+		uint32_t a, b, c;
+		const uint8_t code = *codes++;
+		if (code < 0xF0)
+		{
+			// Reuses an edge from the edge FIFO, the third vertex is next, from the vertex FIFO, or encoded explicitly
+			const uint32_t edge_idx = code >> 4;
+			a = edge_fifo[(edge_fifo_offset - 1 - edge_idx) & 15][0];
+			b = edge_fifo[(edge_fifo_offset - 1 - edge_idx) & 15][1];
+
+			const uint32_t vertex_code = code & 15;
+			if (vertex_code < fifo_code_max)
+			{
+				const bool is_next = vertex_code == 0;
+				c = is_next ? next++ : vertex_fifo[(vertex_fifo_offset - 1 - vertex_code) & 15];
+				push_vertex(c, is_next);
+			}
+			else
+			{
+				// 13 and 14 decode to -1 and +1
+				last = c = vertex_code != 15 ? last + (vertex_code - (vertex_code ^ 3)) : decode_meshopt_index_delta(data, last);
+				push_vertex(c);
+			}
+
+			push_edge(c, b);
+			push_edge(a, c);
+		}
+		else
+		{
+			// A fresh triangle: a is either next or explicit, b and c are next, from the vertex FIFO, or explicit
+			uint32_t code_aux;
+			bool a_explicit = false;
+			if (code < 0xFE)
+			{
+				code_aux = code_aux_table[code & 15];
+			}
+			else
+			{
+				code_aux = *data++;
+				a_explicit = code == 0xFF;
+
+				// A zero code aux that didn't come from the table restarts next
+				if (code_aux == 0)
+				{
+					next = 0;
+				}
+			}
+
+			const uint32_t b_code = code_aux >> 4;
+			const uint32_t c_code = code_aux & 15;
+
+			// next is consumed in a, b, c order before any explicit indices are decoded, matching the encoder
+			a = a_explicit ? 0 : next++;
+			b = b_code == 0 ? next++ : vertex_fifo[(vertex_fifo_offset - b_code) & 15];
+			c = c_code == 0 ? next++ : vertex_fifo[(vertex_fifo_offset - c_code) & 15];
+			if (a_explicit)
+			{
+				last = a = decode_meshopt_index_delta(data, last);
+			}
+			if (b_code == 15)
+			{
+				last = b = decode_meshopt_index_delta(data, last);
+			}
+			if (c_code == 15)
+			{
+				last = c = decode_meshopt_index_delta(data, last);
+			}
+
+			push_vertex(a);
+			push_vertex(b, b_code == 0 || b_code == 15);
+			push_vertex(c, c_code == 0 || c_code == 15);
+			push_edge(b, a);
+			push_edge(c, b);
+			push_edge(a, c);
+		}
+
+		write_meshopt_index(out_indices, index_idx + 0, in_index_size, a);
+		write_meshopt_index(out_indices, index_idx + 1, in_index_size, b);
+		write_meshopt_index(out_indices, index_idx + 2, in_index_size, c);
+	}
+
+	// All the data should be consumed, right up to the table
+	return data == data_safe_end;
+}
+
+// Decodes in_count indices of in_index_size (2 or 4) bytes that don't form a triangle list (e.g. strips, lines, points) into out_indices
+inline bool decode_meshopt_index_sequence(void* out_indices, const size_t in_count, const size_t in_index_size, span<const uint8_t> in_data)
+{
+	static constexpr size_t TAIL_SIZE = 4;
+
+	// The smallest valid encoding is the header, one byte per index and the tail
+	if ((in_index_size != 2 && in_index_size != 4) || in_data.size() < 1 + in_count + TAIL_SIZE)
+	{
+		return false;
+	}
+
+	const uint8_t header = in_data[0];
+	if ((header & 0xF0) != MESHOPT_SEQUENCE_HEADER || (header & 0x0F) > 1)
+	{
+		return false;
+	}
+
+	const uint8_t* data = in_data.data() + 1;
+	const uint8_t* data_safe_end = in_data.data() + in_data.size() - TAIL_SIZE;
+	uint32_t last[2] = {};
+	for (size_t index_idx = 0; index_idx < in_count; ++index_idx)
+	{
+		// A varint reads at most 5 bytes, which the tail covers
+		if (data >= data_safe_end)
+		{
+			return false;
+		}
+
+		// The low bit picks the baseline, the rest is a zigzag delta from it
+		const uint32_t value = decode_meshopt_varint(data);
+		const uint32_t baseline = value & 1;
+		const uint32_t delta = value >> 1;
+		last[baseline] += (delta >> 1) ^ (0u - (delta & 1));
+		write_meshopt_index(out_indices, index_idx, in_index_size, last[baseline]);
+	}
+
+	return data == data_safe_end;
+}
+
+/* ---------------------------------------- Filters ---------------------------------------- */
+
+// Rounds to nearest, away from zero on ties
+inline int32_t round_meshopt_filter_value(const float in_value)
+{
+	return (int32_t) (in_value + (in_value >= 0.0f ? 0.5f : -0.5f));
+}
+
+// Octahedral encoded unit vectors (xy, plus z holding 1.0 at the same scale) back to normalized snorm xyz. w is left as is
+template<typename T>
+inline void decode_meshopt_octahedral_filter(T* io_data, const size_t in_count)
+{
+	const float max_value = (float) ((1 << (sizeof(T) * 8 - 1)) - 1);
+	for (size_t element_idx = 0; element_idx < in_count; ++element_idx)
+	{
+		T* element = io_data + element_idx * 4;
+		float x = (float) element[0];
+		float y = (float) element[1];
+		const float z = (float) element[2] - std::fabs(x) - std::fabs(y);
+
+		// Fold the lower hemisphere back out
+		const float t = z >= 0.0f ? 0.0f : z;
+		x += x >= 0.0f ? t : -t;
+		y += y >= 0.0f ? t : -t;
+
+		const float scale = max_value / std::sqrt(x * x + y * y + z * z);
+		element[0] = (T) round_meshopt_filter_value(x * scale);
+		element[1] = (T) round_meshopt_filter_value(y * scale);
+		element[2] = (T) round_meshopt_filter_value(z * scale);
+	}
+}
+
+// Quaternions stored as their three smallest components, with the largest component's index and the scale packed into the fourth
+inline void decode_meshopt_quaternion_filter(int16_t* io_data, const size_t in_count)
+{
+	const float scale = 1.0f / std::sqrt(2.0f);
+	for (size_t element_idx = 0; element_idx < in_count; ++element_idx)
+	{
+		int16_t* element = io_data + element_idx * 4;
+		const float component_scale = scale / (float) (element[3] | 3);
+		const float x = (float) element[0] * component_scale;
+		const float y = (float) element[1] * component_scale;
+		const float z = (float) element[2] * component_scale;
+
+		// Precision errors can push this slightly negative
+		const float w_squared = 1.0f - x * x - y * y - z * z;
+		const float w = std::sqrt(w_squared >= 0.0f ? w_squared : 0.0f);
+
+		const int32_t max_component = element[3] & 3;
+		const int16_t decoded[4] =
+		{
+			(int16_t) round_meshopt_filter_value(w * 32767.0f),
+			(int16_t) round_meshopt_filter_value(x * 32767.0f),
+			(int16_t) round_meshopt_filter_value(y * 32767.0f),
+			(int16_t) round_meshopt_filter_value(z * 32767.0f),
+		};
+		for (int32_t component_idx = 0; component_idx < 4; ++component_idx)
+		{
+			element[(max_component + component_idx) & 3] = decoded[component_idx];
+		}
+	}
+}
+
+// 24-bit signed mantissa with an 8-bit signed exponent, back to float
+inline void decode_meshopt_exponential_filter(uint32_t* io_data, const size_t in_count)
+{
+	for (size_t value_idx = 0; value_idx < in_count; ++value_idx)
+	{
+		const uint32_t value = io_data[value_idx];
+		const int32_t mantissa = (int32_t) (value << 8) >> 8;
+		const int32_t exponent = (int32_t) value >> 24;
+
+		// ldexp(mantissa, exponent), by way of a power of two float
+		const uint32_t power_bits = (uint32_t) (exponent + 127) << 23;
+		float power;
+		memcpy(&power, &power_bits, sizeof(float));
+		const float decoded = power * (float) mantissa;
+		memcpy(&io_data[value_idx], &decoded, sizeof(float));
+	}
+}
+
+// Applies in_filter in place to in_count elements of in_stride bytes. Returns false if the stride doesn't suit the filter
+inline bool apply_meshopt_filter(void* io_data, const size_t in_count, const size_t in_stride, const MeshoptFilter in_filter)
+{
+	switch (in_filter)
+	{
+		case MeshoptFilter::None:
+			return true;
+		case MeshoptFilter::Octahedral:
+			if (in_stride == 4)
+			{
+				decode_meshopt_octahedral_filter((int8_t*) io_data, in_count);
+				return true;
+			}
+			if (in_stride == 8)
+			{
+				decode_meshopt_octahedral_filter((int16_t*) io_data, in_count);
+				return true;
+			}
+			return false;
+		case MeshoptFilter::Quaternion:
+			if (in_stride != 8)
+			{
+				return false;
+			}
+			decode_meshopt_quaternion_filter((int16_t*) io_data, in_count);
+			return true;
+		case MeshoptFilter::Exponential:
+			if (in_stride % 4 != 0)
+			{
+				return false;
+			}
+			decode_meshopt_exponential_filter((uint32_t*) io_data, in_count * in_stride / 4);
+			return true;
+	}
+	return false;
+}
@@ -6,6 +6,18 @@ void RenderGraphNode::Execute(struct RenderGraph& render_graph, ComPtr<ID3D12Gra
 	multimap<string, RenderGraphEdge>& incoming_edges = render_graph.GetIncomingEdges();
 	const string& node_name = desc.name;
 
+	// Pooled outputs start out in whatever state the last graph to use them left them in
+	for (auto& [output_name, output] : outputs)
+	{
+		D3D12_RESOURCE_STATES& current_state = output.GetCurrentResourceState();
+		const D3D12_RESOURCE_STATES output_state = output.GetResourceState();
+		if (current_state != output_state)
+		{
+			CmdBarrier(in_command_list, output.GetD3D12Resource(), current_state, output_state);
+			current_state = output_state;
+		}
+	}
+
 	// Find Incoming Edges relevant to this node
 	auto equal_range = incoming_edges.equal_range(node_name);
 	for (auto& itr = equal_range.first; itr != equal_range.second; ++itr)
@@ -20,12 +32,13 @@ void RenderGraphNode::Execute(struct RenderGraph& render_graph, ComPtr<ID3D12Gra
 			RenderGraphOutput& other_node_output = other_node.outputs.at(*edge.incoming_resource);
 			input.incoming_resource = &other_node_output;
 
-			// if input and output resource states don't agree, we'll need a barrier
-			const D3D12_RESOURCE_STATES prev_state = other_node_output.GetResourceState();
+			// if the resource isn't already in the state our input wants, we'll need a barrier
+			D3D12_RESOURCE_STATES& current_state = other_node_output.GetCurrentResourceState();
 			const D3D12_RESOURCE_STATES new_state = input.GetResourceState();
-			if (prev_state != new_state)
+			if (current_state != new_state)
 			{
-				CmdBarrier(in_command_list, input.GetD3D12Resource(), prev_state, new_state);
+				CmdBarrier(in_command_list, input.GetD3D12Resource(), current_state, new_state);
+				current_state = new_state;
 			}
 		}
 	}
@@ -33,17 +46,6 @@ void RenderGraphNode::Execute(struct RenderGraph& render_graph, ComPtr<ID3D12Gra
 	desc.execute(*this, in_command_list);
 }
 
-void RenderGraph::Cleanup()
-{
-	for (auto& [node_name, node] : nodes)
-	{
-		for (auto& [output_name, output] : node.outputs)
-		{
-			output.UnregisterBindlessResource();
-		}
-	}
-}
-
 void RenderGraph::AddNode(const RenderGraphNodeDesc&& in_desc)
 {
 	assert(in_desc.setup && in_desc.execute);
@@ -52,7 +54,7 @@ void RenderGraph::AddNode(const RenderGraphNodeDesc&& in_desc)
 	RenderGraphNode new_node(in_desc);
 
 	////Immediately run setup
-	new_node.Setup(m_allocator.Get(), bindless_resource_manager, frame_index);
+	new_node.Setup(*transient_resource_pool, frame_index);
 
 	//Insert
 	nodes.insert({ in_desc.name, new_node });
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 
 #include <map>
 #include <vector>
@@ -28,6 +29,7 @@ using std::move;
 #include "GpuResources.h"
 #include "GpuCommands.h"
 #include "Common.h"
+#include "TransientResourceCache.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -38,34 +40,16 @@ struct RenderGraphBufferDesc
 	D3D12_RESOURCE_FLAGS resource_flags = D3D12_RESOURCE_FLAG_NONE;
 	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
 	bool bindless = false;
-};
 
-struct RenderGraphBuffer
-{
-	// Constructor sets up desc, but doesn't create resource yet
-	RenderGraphBuffer(const RenderGraphBufferDesc& in_desc)
-		: desc(in_desc)
-	{}
+	bool operator==(const RenderGraphBufferDesc& in_other) const = default;
 
-	void CreateResource(D3D12MA::Allocator* in_allocator, BindlessResourceManager* in_bindless_manager, UINT64 frame_index)
+	uint64_t Hash() const
 	{
-		buffer = GpuBuffer(GpuBufferDesc
-		{
-			.allocator = in_allocator,
-			.size = desc.size,
-			.heap_type = desc.heap_type,
-			.resource_flags = desc.resource_flags,
-			.resource_state = desc.resource_state,
-		});
-
-		if (desc.bindless)
-		{
-			in_bindless_manager->RegisterUAV(*buffer, frame_index);
-		}
+		uint64_t hash = hash_combine(size, heap_type);
+		hash = hash_combine(hash, resource_flags);
+		hash = hash_combine(hash, resource_state);
+		return hash_combine(hash, bindless);
 	}
-
-	RenderGraphBufferDesc desc;
-	optional<GpuBuffer> buffer;
 };
 
 struct RenderGraphTextureDesc
@@ -77,36 +61,245 @@ struct RenderGraphTextureDesc
 	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
 	optional<D3D12_CLEAR_VALUE> optimized_clear_value = std::nullopt;
 	bool bindless = false;
+
+	bool operator==(const RenderGraphTextureDesc& in_other) const
+	{
+		return width == in_other.width
+			&& height == in_other.height
+			&& format == in_other.format
+			&& resource_flags == in_other.resource_flags
+			&& resource_state == in_other.resource_state
+			&& bindless == in_other.bindless
+			&& optimized_clear_value.has_value() == in_other.optimized_clear_value.has_value()
+			&& (!optimized_clear_value || GetClearValueBits() == in_other.GetClearValueBits());
+	}
+
+	uint64_t Hash() const
+	{
+		uint64_t hash = hash_combine(((uint64_t) width << 32) | height, format);
+		hash = hash_combine(hash, resource_flags);
+		hash = hash_combine(hash, resource_state);
+		hash = hash_combine(hash, bindless);
+		if (optimized_clear_value)
+		{
+			const ClearValueBits clear_value_bits = GetClearValueBits();
+			hash = hash_combine(hash, ((uint64_t) clear_value_bits.format << 8) | clear_value_bits.stencil);
+			hash = hash_combine(hash, ankerl::unordered_dense::detail::wyhash::hash(clear_value_bits.values, sizeof(clear_value_bits.values)));
+		}
+		return hash;
+	}
+
+protected:
+	// The clear value's format plus whichever half of its union is in use, so the unused half doesn't take part in comparisons
+	struct ClearValueBits
+	{
+		DXGI_FORMAT format;
+		FLOAT values[4];
+		UINT8 stencil;
+
+		bool operator==(const ClearValueBits& in_other) const = default;
+	};
+
+	ClearValueBits GetClearValueBits() const
+	{
+		ClearValueBits clear_value_bits = {};
+		clear_value_bits.format = optimized_clear_value->Format;
+		if (resource_flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+		{
+			clear_value_bits.values[0] = optimized_clear_value->DepthStencil.Depth;
+			clear_value_bits.stencil = optimized_clear_value->DepthStencil.Stencil;
+		}
+		else
+		{
+			memcpy(clear_value_bits.values, optimized_clear_value->Color, sizeof(clear_value_bits.values));
+		}
+		return clear_value_bits;
+	}
 };
 
-struct RenderGraphTexture
+// A single CPU descriptor (RTV or DSV) in a heap of its own
+struct RenderGraphDescriptor
 {
-	// Constructor sets up desc, but doesn't create resource yet
-	RenderGraphTexture(const RenderGraphTextureDesc& desc)
-		: desc(desc)
+	ComPtr<ID3D12DescriptorHeap> descriptor_heap;
+	D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = {};
+};
+
+// Buffer behind a RenderGraphBuffer, owned by a TransientResourcePool
+struct TransientBuffer
+{
+	GpuBuffer buffer;
+
+	// State the last graph to use the buffer left it in
+	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
+};
+
+// Texture behind a RenderGraphTexture, owned by a TransientResourcePool
+struct TransientTexture
+{
+	GpuTexture texture;
+
+	// State the last graph to use the texture left it in
+	D3D12_RESOURCE_STATES resource_state = D3D12_RESOURCE_STATE_COMMON;
+
+	// Created the first time a graph asks for them, then kept for as long as the texture is
+	optional<RenderGraphDescriptor> rtv;
+	optional<RenderGraphDescriptor> dsv;
+};
+
+// Frames a pooled resource can go without being acquired before TransientResourcePool frees it
+static constexpr uint64_t TRANSIENT_RESOURCE_POOL_MAX_UNUSED_FRAMES = 8;
+
+/*	Keeps render graph outputs alive across frames, so graphs that are rebuilt every frame don't recreate their resources every frame.
+	Each output acquires a resource with an identical desc, which is only handed out again once the fence of the frame that last used it
+	has completed. Resources no graph has acquired for in_max_unused_frames frames (e.g. the old size after a resize) are freed by BeginFrame.
+	Pooled resources keep their bindless UAV, RTV and DSV for as long as they live, and track the state the last graph left them in.
+	Matching and eviction live in TransientResourceCache
+*/
+struct TransientResourcePool
+{
+	TransientResourcePool(
+		D3D12MA::Allocator* in_allocator,
+		BindlessResourceManager* in_bindless_resource_manager,
+		const uint64_t in_max_unused_frames = TRANSIENT_RESOURCE_POOL_MAX_UNUSED_FRAMES)
+		: m_allocator(in_allocator)
+		, m_bindless_resource_manager(in_bindless_resource_manager)
+		, m_buffers(in_max_unused_frames)
+		, m_textures(in_max_unused_frames)
 	{}
 
-	void CreateResource(D3D12MA::Allocator* in_allocator, BindlessResourceManager* in_bindless_manager, UINT64 frame_index)
+	DISALLOW_COPY(TransientResourcePool);
+
+	// Call once per frame before building its graphs. in_completed_frame_index is the frame fence's completed value
+	void BeginFrame(const uint64_t in_frame_index, const uint64_t in_completed_frame_index)
 	{
-		texture = GpuTexture(GpuTextureDesc
+		m_completed_frame_index = in_completed_frame_index;
+
+		m_buffers.Evict(in_frame_index, in_completed_frame_index, [](BufferCache::Entry& entry)
 		{
-			.allocator = in_allocator,
-			.width = desc.width,
-			.height = desc.height,
-			.format = desc.format,
-			.resource_flags = desc.resource_flags,
-			.resource_state = desc.resource_state,
-			.optimized_clear_value = desc.optimized_clear_value,
+			if (entry.key.bindless)
+			{
+				entry.resource.buffer.UnregisterBindlessResource();
+			}
 		});
 
-		if (desc.bindless)
+		m_textures.Evict(in_frame_index, in_completed_frame_index, [](TextureCache::Entry& entry)
 		{
-			in_bindless_manager->RegisterUAV(*texture, frame_index);
+			if (entry.key.bindless)
+			{
+				entry.resource.texture.UnregisterBindlessResource();
+			}
+		});
+	}
+
+	// Returns a buffer matching in_desc that's reserved for in_frame_index, creating one if no frame the GPU has finished left one behind
+	TransientBuffer& AcquireBuffer(const RenderGraphBufferDesc& in_desc, const uint64_t in_frame_index)
+	{
+		const uint64_t hash = in_desc.Hash();
+		if (BufferCache::Entry* entry = m_buffers.Acquire(hash, in_desc, in_frame_index, m_completed_frame_index))
+		{
+			return entry->resource;
+		}
+
+		TransientBuffer new_buffer =
+		{
+			.buffer = GpuBuffer(GpuBufferDesc
+			{
+				.allocator = m_allocator,
+				.size = in_desc.size,
+				.heap_type = in_desc.heap_type,
+				.resource_flags = in_desc.resource_flags,
+				.resource_state = in_desc.resource_state,
+			}),
+			.resource_state = in_desc.resource_state,
+		};
+
+		if (in_desc.bindless)
+		{
+			m_bindless_resource_manager->RegisterUAV(new_buffer.buffer);
 		}
+
+		const uint64_t size = new_buffer.buffer.GetSize();
+		return m_buffers.Add(hash, in_desc, move(new_buffer), size, in_frame_index)->resource;
+	}
+
+	// Returns a texture matching in_desc that's reserved for in_frame_index, creating one if no frame the GPU has finished left one behind
+	TransientTexture& AcquireTexture(const RenderGraphTextureDesc& in_desc, const uint64_t in_frame_index)
+	{
+		const uint64_t hash = in_desc.Hash();
+		if (TextureCache::Entry* entry = m_textures.Acquire(hash, in_desc, in_frame_index, m_completed_frame_index))
+		{
+			return entry->resource;
+		}
+
+		TransientTexture new_texture =
+		{
+			.texture = GpuTexture(GpuTextureDesc
+			{
+				.allocator = m_allocator,
+				.width = in_desc.width,
+				.height = in_desc.height,
+				.format = in_desc.format,
+				.resource_flags = in_desc.resource_flags,
+				.resource_state = in_desc.resource_state,
+				.optimized_clear_value = in_desc.optimized_clear_value,
+			}),
+			.resource_state = in_desc.resource_state,
+		};
+
+		if (in_desc.bindless)
+		{
+			m_bindless_resource_manager->RegisterUAV(new_texture.texture);
+		}
+
+		const uint64_t size = new_texture.texture.GetAllocationSize();
+		return m_textures.Add(hash, in_desc, move(new_texture), size, in_frame_index)->resource;
+	}
+
+	const TransientResourceStats& GetBufferStats() const { return m_buffers.GetStats(); }
+	const TransientResourceStats& GetTextureStats() const { return m_textures.GetStats(); }
+
+protected:
+	using BufferCache = TransientResourceCache<RenderGraphBufferDesc, TransientBuffer>;
+	using TextureCache = TransientResourceCache<RenderGraphTextureDesc, TransientTexture>;
+
+	D3D12MA::Allocator* m_allocator = nullptr;
+	BindlessResourceManager* m_bindless_resource_manager = nullptr;
+	uint64_t m_completed_frame_index = 0;
+
+	BufferCache m_buffers;
+	TextureCache m_textures;
+};
+
+struct RenderGraphBuffer
+{
+	// Constructor sets up desc, but doesn't acquire resource yet
+	RenderGraphBuffer(const RenderGraphBufferDesc& in_desc)
+		: desc(in_desc)
+	{}
+
+	void CreateResource(TransientResourcePool& in_transient_resource_pool, UINT64 frame_index)
+	{
+		transient = &in_transient_resource_pool.AcquireBuffer(desc, frame_index);
+	}
+
+	RenderGraphBufferDesc desc;
+	TransientBuffer* transient = nullptr;
+};
+
+struct RenderGraphTexture
+{
+	// Constructor sets up desc, but doesn't acquire resource yet
+	RenderGraphTexture(const RenderGraphTextureDesc& desc)
+		: desc(desc)
+	{}
+
+	void CreateResource(TransientResourcePool& in_transient_resource_pool, UINT64 frame_index)
+	{
+		transient = &in_transient_resource_pool.AcquireTexture(desc, frame_index);
 	};
 
 	RenderGraphTextureDesc desc;
-	optional<GpuTexture> texture;
+	TransientTexture* transient = nullptr;
 };
 
 struct RenderGraphOutput
@@ -119,15 +312,15 @@ struct RenderGraphOutput
 		: resource(RenderGraphTexture(texture_desc))
 	{}
 
-	void CreateResource(D3D12MA::Allocator* in_allocator, BindlessResourceManager* in_bindless_manager, UINT64 frame_index)
+	void CreateResource(TransientResourcePool& in_transient_resource_pool, UINT64 frame_index)
 	{
 		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
 		{
-			buffer->CreateResource(in_allocator, in_bindless_manager, frame_index);
+			buffer->CreateResource(in_transient_resource_pool, frame_index);
 		}
 		else if (RenderGraphTexture* texture = get_if<RenderGraphTexture>(&resource))
 		{
-			texture->CreateResource(in_allocator, in_bindless_manager, frame_index);
+			texture->CreateResource(in_transient_resource_pool, frame_index);
 		}
 	}
 
@@ -135,11 +328,11 @@ struct RenderGraphOutput
 	{
 		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
 		{
-			return buffer->buffer->GetResource();
+			return buffer->transient->buffer.GetResource();
 		}
 		else if (RenderGraphTexture* texture = get_if<RenderGraphTexture>(&resource))
 		{
-			return texture->texture->GetResource();
+			return texture->transient->texture.GetResource();
 		}
 		
 		assert(false);
@@ -152,36 +345,18 @@ struct RenderGraphOutput
 		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
 		{
 			assert(buffer->desc.bindless);
-			return buffer->buffer->GetBindlessResourceIndex();
+			return buffer->transient->buffer.GetBindlessResourceIndex();
 		}
 		else if (RenderGraphTexture* texture = get_if<RenderGraphTexture>(&resource))
 		{
 			assert(texture->desc.bindless);
-			return texture->texture->GetBindlessResourceIndex();
+			return texture->transient->texture.GetBindlessResourceIndex();
 		}
 		
 		assert(false);
 		return 0;
 	}
 
-	void UnregisterBindlessResource()
-	{
-		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
-		{
-			if (buffer->desc.bindless && buffer->buffer.has_value())
-			{
-				buffer->buffer->UnregisterBindlessResource();
-			}			
-		}
-		else if (RenderGraphTexture* texture = get_if<RenderGraphTexture>(&resource))
-		{
-			if (texture->desc.bindless && texture->texture.has_value())
-			{
-				texture->texture->UnregisterBindlessResource();
-			}
-		}
-	}
-
 	D3D12_RESOURCE_STATES GetResourceState()
 	{
 		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
@@ -197,11 +372,22 @@ struct RenderGraphOutput
 		return D3D12_RESOURCE_STATE_COMMON;
 	}
 
+	// State the pooled resource is actually in, as of the commands recorded so far. Whoever records a barrier on it updates this
+	D3D12_RESOURCE_STATES& GetCurrentResourceState()
+	{
+		if (RenderGraphBuffer* buffer = get_if<RenderGraphBuffer>(&resource))
+		{
+			return buffer->transient->resource_state;
+		}
+		return std::get<RenderGraphTexture>(resource).transient->resource_state;
+	}
+
 	D3D12_CPU_DESCRIPTOR_HANDLE& GetRtvHandle(ComPtr<ID3D12Device5> in_device)
 	{
+		optional<RenderGraphDescriptor>& rtv_data = std::get<RenderGraphTexture>(resource).transient->rtv;
 		if (!rtv_data)
 		{
-			rtv_data = DescriptorData();
+			rtv_data = RenderGraphDescriptor();
 
 			const UINT rtv_heap_offset = in_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
@@ -237,9 +423,10 @@ struct RenderGraphOutput
 
 	D3D12_CPU_DESCRIPTOR_HANDLE& GetDsvHandle(ComPtr<ID3D12Device5> in_device)
 	{
+		optional<RenderGraphDescriptor>& dsv_data = std::get<RenderGraphTexture>(resource).transient->dsv;
 		if (!dsv_data)
 		{
-			dsv_data = DescriptorData();
+			dsv_data = RenderGraphDescriptor();
 
 			const UINT rtv_heap_offset = in_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
@@ -285,15 +472,6 @@ struct RenderGraphOutput
 	}
 
 	variant<RenderGraphBuffer, RenderGraphTexture> resource;
-
-	struct DescriptorData
-	{
-		ComPtr<ID3D12DescriptorHeap> descriptor_heap;
-		D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = {};
-	};
-
-	optional<DescriptorData> rtv_data;
-	optional<DescriptorData> dsv_data;
 };
 
 struct RenderGraphInput
@@ -316,14 +494,6 @@ struct RenderGraphInput
 		return incoming_resource->GetBindlessResourceIndex();
 	}
 
-	void UnregisterBindlessResource()
-	{
-		if (incoming_resource)
-		{
-			incoming_resource->UnregisterBindlessResource();
-		}
-	}
-
 	D3D12_RESOURCE_STATES GetResourceState()
 	{
 		return	std::holds_alternative<RenderGraphBufferDesc>(desc)
@@ -382,14 +552,14 @@ private: //Called by friend struct RenderGraph
 		: desc(desc)
 	{}
 
-	void Setup(D3D12MA::Allocator* in_allocator, BindlessResourceManager* in_bindless_resource_manager, UINT64 frame_index)
+	void Setup(TransientResourcePool& in_transient_resource_pool, UINT64 frame_index)
 	{
 		desc.setup(*this);
 		
-		// Create output resources
+		// Acquire output resources
 		for (auto& output : outputs)
 		{
-			output.second.CreateResource(in_allocator, in_bindless_resource_manager, frame_index);
+			output.second.CreateResource(in_transient_resource_pool, frame_index);
 		}
 	}
 
@@ -414,9 +584,8 @@ struct RenderGraphEdge
 struct RenderGraphDesc
 {
 	ComPtr<ID3D12Device5> device;
-	ComPtr<D3D12MA::Allocator> allocator;
 	ComPtr<ID3D12GraphicsCommandList4> command_list;
-	BindlessResourceManager* bindless_resource_manager = nullptr;
+	TransientResourcePool* transient_resource_pool = nullptr;
 	UINT64 frame_index;
 };
 
@@ -424,13 +593,12 @@ struct RenderGraph
 {
 	RenderGraph(const RenderGraphDesc& create_info)
 		: m_device(create_info.device)
-		, m_allocator(create_info.allocator)
 		, m_command_list(create_info.command_list)
-		, bindless_resource_manager(create_info.bindless_resource_manager)
+		, transient_resource_pool(create_info.transient_resource_pool)
 		, frame_index(create_info.frame_index)
-	{}
-
-	void Cleanup();
+	{
+		assert(transient_resource_pool);
+	}
 
 	void AddNode(const RenderGraphNodeDesc&& in_desc);
 
@@ -458,8 +626,7 @@ private:
 private:
 	// D3D12 resources
 	ComPtr<ID3D12Device5> m_device;
-	ComPtr<D3D12MA::Allocator> m_allocator;
 	ComPtr<ID3D12GraphicsCommandList4> m_command_list;
-	BindlessResourceManager* bindless_resource_manager;
+	TransientResourcePool* transient_resource_pool;
 	UINT64 frame_index;
 };
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+using std::optional;
+using std::nullopt;
+
+struct RingAllocation
+{
+	uint64_t offset = 0;
+	uint64_t size = 0;
+};
+
+/*	Offset allocator for streaming transient data through a fixed size block (e.g. a persistently mapped upload buffer). Doesn't touch any memory itself.
+	Allocations are carved linearly off the head, wrapping back to offset 0 when one doesn't fit before the end (the skipped tail is used up with it).
+	Space comes back in the order it was allocated: Submit tags everything allocated since the previous Submit with a fence value, and Retire releases
+	every tagged region whose fence value has completed. Allocate and Retire are O(1).
+*/
+struct RingAllocator
+{
+	RingAllocator() = default;
+
+	explicit RingAllocator(const uint64_t in_capacity)
+		: m_capacity(in_capacity)
+	{
+	}
+
+	// in_alignment must be a power of two. Returns nullopt if there isn't room until more regions are retired (or ever, if in_size > capacity)
+	optional<RingAllocation> Allocate(const uint64_t in_size, const uint64_t in_alignment = 1)
+	{
+		assert(in_alignment > 0 && (in_alignment & (in_alignment - 1)) == 0);
+		if (in_size == 0 || in_size > m_capacity)
+		{
+			return nullopt;
+		}
+
+		// Nothing is in use, so start over at 0 rather than wrap (or pad) around an arbitrary head
+		if (m_used_size == 0)
+		{
+			m_head = 0;
+		}
+
+		uint64_t aligned_offset = (m_head + in_alignment - 1) & ~(in_alignment - 1);
+		if (aligned_offset + in_size > m_capacity)
+		{
+			aligned_offset = 0;
+		}
+
+		// Alignment padding, or the skipped tail when wrapping, is consumed along with the allocation
+		const uint64_t consumed_size = (aligned_offset >= m_head ? aligned_offset - m_head : m_capacity - m_head) + in_size;
+		if (m_used_size + consumed_size > m_capacity)
+		{
+			return nullopt;
+		}
+
+		m_head = aligned_offset + in_size;
+		m_used_size += consumed_size;
+		m_unsubmitted_size += consumed_size;
+		return RingAllocation {
+			.offset = aligned_offset,
+			.size = in_size,
+		};
+	}
+
+	// Everything allocated since the previous Submit stays in use until in_fence_value is retired. Fence values must increase
+	void Submit(const uint64_t in_fence_value)
+	{
+		assert(m_submitted_regions.empty() || m_submitted_regions.back().fence_value < in_fence_value);
+		if (m_unsubmitted_size > 0)
+		{
+			m_submitted_regions.push_back(SubmittedRegion {
+				.fence_value = in_fence_value,
+				.size = m_unsubmitted_size,
+			});
+			m_unsubmitted_size = 0;
+		}
+	}
+
+	// Releases every submitted region whose fence value is <= in_completed_fence_value
+	void Retire(const uint64_t in_completed_fence_value)
+	{
+		while (!m_submitted_regions.empty() && m_submitted_regions.front().fence_value <= in_completed_fence_value)
+		{
+			assert(m_used_size >= m_submitted_regions.front().size);
+			m_used_size -= m_submitted_regions.front().size;
+			m_submitted_regions.pop_front();
+		}
+	}
+
+	// Fence value that has to complete before any more space can be retired, or nullopt if nothing submitted is still in use
+	optional<uint64_t> GetOldestSubmittedFenceValue() const
+	{
+		return m_submitted_regions.empty() ? nullopt : optional<uint64_t>(m_submitted_regions.front().fence_value);
+	}
+
+	uint64_t GetCapacity() const { return m_capacity; }
+
+	// Includes alignment padding and skipped tails
+	uint64_t GetUsedSize() const { return m_used_size; }
+	uint64_t GetFreeSize() const { return m_capacity - m_used_size; }
+
+	// Allocated since the previous Submit. Space that can't be retired until it's submitted
+	uint64_t GetUnsubmittedSize() const { return m_unsubmitted_size; }
+
+protected:
+	struct SubmittedRegion
+	{
+		uint64_t fence_value = 0;
+		uint64_t size = 0;
+	};
+
+	uint64_t m_capacity = 0;
+	uint64_t m_head = 0;
+	uint64_t m_used_size = 0;
+	uint64_t m_unsubmitted_size = 0;
+
+	// Oldest first. Each region directly follows the one before it, so retiring from the front frees space in allocation order
+	std::deque<SubmittedRegion> m_submitted_regions;
+};
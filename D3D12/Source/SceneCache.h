@@ -0,0 +1,921 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::span;
+using std::string;
+using std::vector;
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Common.h"
+#include "MeshBounds.h"
+#include "ThreadPool.h"
+#include "../Shaders/HLSL_Types.h"
+
+// Only miniz's raw deflate (tdefl/tinfl) is used. Its implementation is compiled in by including miniz.c again without MINIZ_HEADER_FILE_ONLY
+#define MINIZ_NO_STDIO
+#define MINIZ_NO_TIME
+#define MINIZ_NO_ARCHIVE_APIS
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#define MINIZ_HEADER_FILE_ONLY
+#include "microprofile/demo/simple/miniz.c"
+#undef MINIZ_HEADER_FILE_ONLY
+
+/*	Cooked binary representation of a GltfScene. Written next to the source .gltf on first load
+	and memory-mapped on subsequent loads so we can skip parsing + vertex conversion entirely.
+
+	Layout:
+	SceneCacheHeader
+	Compressed caches only (see SceneCacheCompression) ...
+		Chunks (SceneCacheChunk * chunk_count)
+		Table of contents (SceneCacheTocEntry * mesh_count)
+		Compressed chunk data
+	Body (directly after the header when uncompressed, otherwise what the chunks decompress to) ...
+		Instances (GltfMeshInstance * instance_count, padded to 8 bytes)
+		For each unique mesh (8 byte aligned) ...
+			SceneCacheMeshHeader
+			Mesh Indices (index_stride * index_count, padded to 4 bytes). Every LOD's indices, back to back
+			Mesh Positions (position stride * vertex_count, see SceneCacheMeshHeader::vertex_format)
+			Mesh Attributes (attribute stride * vertex_count)
+			Meshlets (Meshlet * meshlet_count)
+			Meshlet Vertices (uint32_t * meshlet_vertex_count)
+			Meshlet Triangles (uint32_t * meshlet_triangle_count)
+			LODs (MeshLod * lod_count)
+
+	Uncompressed caches are memory-mapped and used in place. Compressed ones are smaller on disk, and each chunk is decompressed on its own,
+	so they decompress in parallel and any one mesh can be read without the rest of the body (see decompress_scene_cache_range)
+
+	Bump SCENE_CACHE_VERSION whenever this layout, any of the vertex stream formats or the cooking passes change.
+*/
+
+static constexpr uint32_t SCENE_CACHE_MAGIC = 0x43534346; // "FCSC"
+static constexpr uint32_t SCENE_CACHE_VERSION = 14;
+static constexpr const char* SCENE_CACHE_EXTENSION = ".cooked";
+
+// Uncompressed size of every chunk of a compressed body but the last
+static constexpr uint32_t SCENE_CACHE_CHUNK_SIZE = 256 * 1024;
+
+enum class SceneCacheCompression : uint32_t {
+	None,
+	Deflate,	// Body split into SCENE_CACHE_CHUNK_SIZE chunks, each raw deflated on its own
+};
+
+struct SceneCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int64_t source_file_age;
+	uint64_t mesh_count;
+	uint64_t instance_count;
+
+	// Size of largest vertex or index buffer in file, useful for preallocating staging buffers
+	uint64_t max_contiguous_size;
+
+	// See hash_file_contents. Lets a cache cooked on another machine (where file ages differ) be used. 0 if unknown
+	uint64_t source_content_hash;
+
+	SceneCacheCompression compression;
+	uint32_t chunk_size;
+
+	// Uncompressed size of the body. chunk_count is 0 if the cache isn't compressed
+	uint64_t body_size;
+	uint64_t chunk_count;
+};
+
+// chunk_size bytes of a compressed body (less for the last chunk). Stored as is when deflate can't make it smaller, in which case compressed_size == size
+struct SceneCacheChunk
+{
+	uint64_t file_offset;
+	uint32_t compressed_size;
+	uint32_t size;
+};
+
+// Where one mesh's SceneCacheMeshHeader and data live in the body
+struct SceneCacheTocEntry
+{
+	uint64_t body_offset;
+	uint64_t size;
+};
+
+enum class VertexFormat : uint32_t {
+	Full,		// float3 positions, VertexAttributes
+	Compact,	// CompactVertexPosition, CompactVertexAttributes
+};
+
+inline size_t get_position_stride(const VertexFormat in_format)
+{
+	return in_format == VertexFormat::Compact ? sizeof(CompactVertexPosition) : sizeof(float3);
+}
+
+inline size_t get_attribute_stride(const VertexFormat in_format)
+{
+	return in_format == VertexFormat::Compact ? sizeof(CompactVertexAttributes) : sizeof(VertexAttributes);
+}
+
+struct SceneCacheMeshHeader
+{
+	// Size of this header plus all mesh data that follows it (including padding)
+	uint64_t total_size;
+	uint64_t index_stride;
+	uint64_t index_count;
+	uint64_t vertex_count;
+	uint64_t source_hash;
+	VertexFormat vertex_format;
+	uint32_t material_index;
+
+	// Dequantization range for compact vertex positions
+	float3 position_min;
+	float3 position_extent;
+
+	Bounds bounds;
+	uint32_t padding = 0;
+
+	uint64_t meshlet_count;
+	uint64_t meshlet_vertex_count;
+	uint64_t meshlet_triangle_count;
+
+	uint64_t lod_count;
+};
+
+// A single node's reference to one of the scene's unique meshes (a gltf primitive)
+struct GltfMeshInstance
+{
+	Matrix transform;
+	uint32_t mesh_index;
+	uint32_t padding = 0;
+};
+
+// Non-owning view of a single mesh's converted data. Points either into converted gltf data or into a mapped cache file
+struct GltfMeshView
+{
+	// Either 2 or 4. index_data is padded to a multiple of 4 bytes so it can be bound as a raw buffer
+	uint32_t index_stride;
+	size_t index_count;
+	span<const uint8_t> index_data;
+
+	// Split vertex streams, both vertex_count long
+	VertexFormat vertex_format;
+	size_t vertex_count;
+	span<const uint8_t> position_data;
+	span<const uint8_t> attribute_data;
+
+	// AABB compact vertex positions are quantized against. Unused for VertexFormat::Full
+	float3 position_min;
+	float3 position_extent;
+
+	// Mesh space bounds of every vertex
+	Bounds bounds;
+
+	// See Meshlet. meshlet_vertices index into the vertex streams, meshlet_triangles are 3 packed 8-bit indices into meshlet_vertices
+	span<const Meshlet> meshlets;
+	span<const uint32_t> meshlet_vertices;
+	span<const uint32_t> meshlet_triangles;
+
+	// Ranges of index_data, see MeshLod. Meshlets are only built for LOD 0
+	span<const MeshLod> lods;
+
+	// Index of the gltf material the mesh is drawn with, or INVALID_MATERIAL_INDEX if it has none
+	uint32_t material_index = INVALID_MATERIAL_INDEX;
+
+	// Hash of the gltf data the mesh was converted from (see hash_primitive), so reloads can tell which meshes changed
+	uint64_t source_hash = 0;
+
+	template<typename T>
+	static span<const uint8_t> AsBytes(span<const T> in_span)
+	{
+		return span<const uint8_t>(reinterpret_cast<const uint8_t*>(in_span.data()), in_span.size_bytes());
+	}
+
+	// Mesh data in the order it's laid out in the cache. Every section is a multiple of 4 bytes
+	static constexpr size_t SECTION_COUNT = 7;
+	std::array<span<const uint8_t>, SECTION_COUNT> GetSections() const
+	{
+		return {
+			index_data,
+			position_data,
+			attribute_data,
+			AsBytes(meshlets),
+			AsBytes(meshlet_vertices),
+			AsBytes(meshlet_triangles),
+			AsBytes(lods),
+		};
+	}
+};
+
+inline uint64_t scene_cache_mesh_size(const GltfMeshView& in_mesh)
+{
+	size_t size = sizeof(SceneCacheMeshHeader);
+	for (const span<const uint8_t>& section : in_mesh.GetSections())
+	{
+		size += section.size_bytes();
+	}
+	return align_up(size, 8);
+}
+
+// Returns in_count elements starting at io_cursor and advances io_cursor past them
+template<typename T>
+span<const T> read_section(const uint8_t*& io_cursor, const uint64_t in_count)
+{
+	const T* section = reinterpret_cast<const T*>(io_cursor);
+	io_cursor += in_count * sizeof(T);
+	return span<const T>(section, in_count);
+}
+
+inline string get_scene_cache_path(const char* in_source_file)
+{
+	return string(in_source_file) + SCENE_CACHE_EXTENSION;
+}
+
+// Returns 0 if the file doesn't exist
+inline int64_t get_file_age(const char* in_file)
+{
+	std::error_code error;
+	const std::filesystem::file_time_type write_time = std::filesystem::last_write_time(in_file, error);
+	return error ? 0 : static_cast<int64_t>(write_time.time_since_epoch().count());
+}
+
+// Read-only memory mapping of an entire file
+struct MappedFile
+{
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	DISALLOW_COPY(MappedFile);
+
+	bool Open(const char* in_path)
+	{
+		Close();
+
+#ifdef _WIN32
+		m_file = CreateFileA(in_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mapping)
+		{
+			Close();
+			return false;
+		}
+
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+		m_file = open(in_path, O_RDONLY);
+		if (m_file < 0)
+		{
+			return false;
+		}
+
+		struct stat file_stat = {};
+		if (fstat(m_file, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+
+		void* mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+		m_data = mapped != MAP_FAILED ? static_cast<const uint8_t*>(mapped) : nullptr;
+		m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+		if (!m_data)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (m_data) { UnmapViewOfFile(m_data); }
+		if (m_mapping) { CloseHandle(m_mapping); }
+		if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_data) { munmap(const_cast<uint8_t*>(m_data), m_size); }
+		if (m_file >= 0) { close(m_file); }
+		m_file = -1;
+#endif
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	bool IsValid() const { return m_data != nullptr; }
+	const uint8_t* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+protected:
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+};
+
+// Hash of every one of in_files' contents, in order. Returns 0 if any of them can't be read
+inline uint64_t hash_file_contents(span<const string> in_files)
+{
+	uint64_t hash = in_files.size();
+	for (const string& file_path : in_files)
+	{
+		MappedFile file;
+		if (!file.Open(file_path.c_str()))
+		{
+			return 0;
+		}
+		hash = ankerl::unordered_dense::detail::wyhash::mix(hash ^ ankerl::unordered_dense::detail::wyhash::hash(file.GetData(), file.GetSize()), UINT64_C(0x9E3779B97F4A7C15));
+	}
+	return hash != 0 ? hash : 1;
+}
+
+// Size of the body (see the layout above) holding in_meshes and in_instances
+inline uint64_t scene_cache_body_size(const vector<GltfMeshView>& in_meshes, const vector<GltfMeshInstance>& in_instances)
+{
+	uint64_t size = align_up(in_instances.size() * sizeof(GltfMeshInstance), 8);
+	for (const GltfMeshView& mesh : in_meshes)
+	{
+		size += scene_cache_mesh_size(mesh);
+	}
+	return size;
+}
+
+// GPU memory of a set of meshes, by stream. Also what their indices would take if every mesh used 32-bit indices, see get_index_stride
+struct GltfMeshMemory
+{
+	uint64_t index_size = 0;
+	uint64_t wide_index_size = 0;
+	uint64_t vertex_size = 0;
+	uint64_t meshlet_size = 0;
+	size_t mesh_count = 0;
+	size_t narrow_index_mesh_count = 0;
+
+	uint64_t GetTotalSize() const { return index_size + vertex_size + meshlet_size; }
+
+	// Fraction of the 32-bit index memory that 16-bit indices saved
+	float GetIndexSavings() const { return wide_index_size > 0 ? 1.0f - (float) index_size / (float) wide_index_size : 0.0f; }
+};
+
+inline GltfMeshMemory get_mesh_memory(const vector<GltfMeshView>& in_meshes)
+{
+	GltfMeshMemory memory;
+	for (const GltfMeshView& mesh : in_meshes)
+	{
+		memory.index_size += mesh.index_data.size_bytes();
+		memory.wide_index_size += mesh.index_count * sizeof(uint32_t);
+		memory.vertex_size += mesh.position_data.size_bytes() + mesh.attribute_data.size_bytes();
+		memory.meshlet_size += mesh.meshlets.size_bytes() + mesh.meshlet_vertices.size_bytes() + mesh.meshlet_triangles.size_bytes() + mesh.lods.size_bytes();
+		memory.mesh_count += 1;
+		memory.narrow_index_mesh_count += mesh.index_stride == sizeof(uint16_t) ? 1 : 0;
+	}
+	return memory;
+}
+
+/*	Writes the body through in_write(const void* data, size_t size), which returns false if it fails. 
+	out_toc receives where each mesh ended up in the body
+*/
+template<typename WriteFunction>
+bool write_scene_cache_body(
+	const vector<GltfMeshView>& in_meshes, 
+	const vector<GltfMeshInstance>& in_instances, 
+	WriteFunction&& in_write, 
+	vector<SceneCacheTocEntry>& out_toc
+)
+{
+	static const uint8_t padding[8] = {};
+	uint64_t body_offset = 0;
+	auto write = [&](const void* in_data, const size_t in_size)
+	{
+		body_offset += in_size;
+		return in_size == 0 || in_write(in_data, in_size);
+	};
+
+	const size_t instances_size = in_instances.size() * sizeof(GltfMeshInstance);
+	const size_t instances_padding = align_up(instances_size, 8) - instances_size;
+	bool success = write(in_instances.data(), instances_size);
+	success &= write(padding, instances_padding);
+
+	out_toc.clear();
+	out_toc.reserve(in_meshes.size());
+	for (const GltfMeshView& mesh : in_meshes)
+	{
+		if (!success) { break; }
+
+		const SceneCacheMeshHeader mesh_header =
+		{
+			.total_size = scene_cache_mesh_size(mesh),
+			.index_stride = mesh.index_stride,
+			.index_count = mesh.index_count,
+			.vertex_count = mesh.vertex_count,
+			.source_hash = mesh.source_hash,
+			.vertex_format = mesh.vertex_format,
+			.material_index = mesh.material_index,
+			.position_min = mesh.position_min,
+			.position_extent = mesh.position_extent,
+			.bounds = mesh.bounds,
+			.meshlet_count = mesh.meshlets.size(),
+			.meshlet_vertex_count = mesh.meshlet_vertices.size(),
+			.meshlet_triangle_count = mesh.meshlet_triangles.size(),
+			.lod_count = mesh.lods.size(),
+		};
+		out_toc.push_back(SceneCacheTocEntry {
+			.body_offset = body_offset,
+			.size = mesh_header.total_size,
+		});
+
+		size_t written = sizeof(mesh_header);
+		success &= write(&mesh_header, sizeof(mesh_header));
+		for (const span<const uint8_t>& section : mesh.GetSections())
+		{
+			assert(section.size_bytes() % 4 == 0);
+			success &= write(section.data(), section.size_bytes());
+			written += section.size_bytes();
+		}
+
+		success &= write(padding, mesh_header.total_size - written);
+	}
+
+	return success;
+}
+
+/*	Writes out meshes and instances to in_cache_path. Writes to a temp file first so a partially written cache is never picked up.
+	Compressing builds the whole body in memory first, then deflates its chunks across in_thread_pool if set
+*/
+inline bool write_scene_cache(
+	const string& in_cache_path, 
+	const int64_t in_source_file_age, 
+	const vector<GltfMeshView>& in_meshes, 
+	const vector<GltfMeshInstance>& in_instances,
+	const uint64_t in_source_content_hash = 0,
+	const SceneCacheCompression in_compression = SceneCacheCompression::None,
+	ThreadPool* in_thread_pool = nullptr
+)
+{
+	SceneCacheHeader header =
+	{
+		.magic = SCENE_CACHE_MAGIC,
+		.version = SCENE_CACHE_VERSION,
+		.source_file_age = in_source_file_age,
+		.mesh_count = in_meshes.size(),
+		.instance_count = in_instances.size(),
+		.max_contiguous_size = 0,
+		.source_content_hash = in_source_content_hash,
+		.compression = in_compression,
+		.chunk_size = in_compression == SceneCacheCompression::None ? 0 : SCENE_CACHE_CHUNK_SIZE,
+		.body_size = scene_cache_body_size(in_meshes, in_instances),
+		.chunk_count = 0,
+	};
+
+	for (const GltfMeshView& mesh : in_meshes)
+	{
+		header.max_contiguous_size = std::max<uint64_t>(header.max_contiguous_size, mesh.index_data.size_bytes());
+		header.max_contiguous_size = std::max<uint64_t>(header.max_contiguous_size, mesh.position_data.size_bytes());
+		header.max_contiguous_size = std::max<uint64_t>(header.max_contiguous_size, mesh.attribute_data.size_bytes());
+	}
+
+	const string temp_path = in_cache_path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	auto write_to_file = [file](const void* in_data, const size_t in_size)
+	{
+		return in_size == 0 || fwrite(in_data, 1, in_size, file) == in_size;
+	};
+
+	bool success = true;
+	vector<SceneCacheTocEntry> toc;
+	if (in_compression == SceneCacheCompression::None)
+	{
+		success &= write_to_file(&header, sizeof(header));
+		success &= write_scene_cache_body(in_meshes, in_instances, write_to_file, toc);
+	}
+	else
+	{
+		vector<uint8_t> body;
+		body.reserve(header.body_size);
+		write_scene_cache_body(in_meshes, in_instances, [&](const void* in_data, const size_t in_size)
+		{
+			body.insert(body.end(), static_cast<const uint8_t*>(in_data), static_cast<const uint8_t*>(in_data) + in_size);
+			return true;
+		}, toc);
+		assert(body.size() == header.body_size);
+
+		header.chunk_count = (body.size() + header.chunk_size - 1) / header.chunk_size;
+		vector<vector<uint8_t>> compressed_chunks(header.chunk_count);
+		auto compress_job = [&](const size_t chunk_idx)
+		{
+			const size_t chunk_offset = chunk_idx * header.chunk_size;
+			const size_t chunk_size = (std::min)(body.size() - chunk_offset, (size_t) header.chunk_size);
+
+			// tdefl fails if the output doesn't fit, so anything that doesn't shrink is stored as is
+			vector<uint8_t>& compressed = compressed_chunks[chunk_idx];
+			compressed.resize(chunk_size);
+			size_t compressed_size = tdefl_compress_mem_to_mem(compressed.data(), compressed.size(), body.data() + chunk_offset, chunk_size, TDEFL_DEFAULT_MAX_PROBES);
+			if (compressed_size == 0 || compressed_size >= chunk_size)
+			{
+				memcpy(compressed.data(), body.data() + chunk_offset, chunk_size);
+				compressed_size = chunk_size;
+			}
+			compressed.resize(compressed_size);
+		};
+
+		if (in_thread_pool)
+		{
+			in_thread_pool->ParallelFor(compressed_chunks.size(), compress_job);
+		}
+		else
+		{
+			for (size_t chunk_idx = 0; chunk_idx < compressed_chunks.size(); ++chunk_idx)
+			{
+				compress_job(chunk_idx);
+			}
+		}
+
+		vector<SceneCacheChunk> chunks;
+		chunks.reserve(compressed_chunks.size());
+		uint64_t file_offset = sizeof(header) + compressed_chunks.size() * sizeof(SceneCacheChunk) + toc.size() * sizeof(SceneCacheTocEntry);
+		for (size_t chunk_idx = 0; chunk_idx < compressed_chunks.size(); ++chunk_idx)
+		{
+			chunks.push_back(SceneCacheChunk {
+				.file_offset = file_offset,
+				.compressed_size = static_cast<uint32_t>(compressed_chunks[chunk_idx].size()),
+				.size = static_cast<uint32_t>((std::min)(body.size() - chunk_idx * header.chunk_size, (size_t) header.chunk_size)),
+			});
+			file_offset += compressed_chunks[chunk_idx].size();
+		}
+
+		success &= write_to_file(&header, sizeof(header));
+		success &= write_to_file(chunks.data(), chunks.size() * sizeof(SceneCacheChunk));
+		success &= write_to_file(toc.data(), toc.size() * sizeof(SceneCacheTocEntry));
+		for (const vector<uint8_t>& compressed : compressed_chunks)
+		{
+			success &= write_to_file(compressed.data(), compressed.size());
+		}
+	}
+
+	success &= fclose(file) == 0;
+
+	std::error_code error;
+	if (success)
+	{
+		std::filesystem::rename(temp_path, in_cache_path, error);
+	}
+	if (!success || error)
+	{
+		std::filesystem::remove(temp_path, error);
+		return false;
+	}
+
+	return true;
+}
+
+/*	Decompresses out_data.size() bytes of a compressed cache's body, starting at in_body_offset. Only the chunks overlapping that range are
+	decompressed, spread across in_thread_pool if set. Chunks entirely inside the range decompress straight into out_data.
+	in_chunks must already be validated against in_file (see SceneCache::Open). Fails if the range runs past the end of the body
+*/
+inline bool decompress_scene_cache_range(
+	span<const uint8_t> in_file, 
+	const uint32_t in_chunk_size, 
+	span<const SceneCacheChunk> in_chunks, 
+	const uint64_t in_body_offset, 
+	span<uint8_t> out_data, 
+	ThreadPool* in_thread_pool
+)
+{
+	if (out_data.empty())
+	{
+		return true;
+	}
+
+	const uint64_t range_end = in_body_offset + out_data.size();
+	const size_t first_chunk = in_body_offset / in_chunk_size;
+	const size_t end_chunk = (range_end + in_chunk_size - 1) / in_chunk_size;
+	if (end_chunk > in_chunks.size() || range_end > (uint64_t) (in_chunks.size() - 1) * in_chunk_size + in_chunks.back().size)
+	{
+		return false;
+	}
+
+	std::atomic<bool> success = true;
+	auto decompress_job = [&](const size_t job_idx)
+	{
+		const size_t chunk_idx = first_chunk + job_idx;
+		const SceneCacheChunk& chunk = in_chunks[chunk_idx];
+		const uint64_t chunk_start = (uint64_t) chunk_idx * in_chunk_size;
+		const uint64_t copy_start = (std::max)(chunk_start, in_body_offset);
+		const uint64_t copy_end = (std::min)(chunk_start + chunk.size, range_end);
+		const bool whole_chunk = copy_start == chunk_start && copy_end == chunk_start + chunk.size;
+
+		// Partially covered chunks (at most the first and last) go through a temporary
+		vector<uint8_t> temp;
+		uint8_t* chunk_data = nullptr;
+		if (whole_chunk)
+		{
+			chunk_data = out_data.data() + (chunk_start - in_body_offset);
+		}
+		else
+		{
+			temp.resize(chunk.size);
+			chunk_data = temp.data();
+		}
+
+		const uint8_t* compressed = in_file.data() + chunk.file_offset;
+		if (chunk.compressed_size == chunk.size)
+		{
+			memcpy(chunk_data, compressed, chunk.size);
+		}
+		else if (tinfl_decompress_mem_to_mem(chunk_data, chunk.size, compressed, chunk.compressed_size, 0) != chunk.size)
+		{
+			success = false;
+			return;
+		}
+
+		if (!whole_chunk)
+		{
+			memcpy(out_data.data() + (copy_start - in_body_offset), chunk_data + (copy_start - chunk_start), copy_end - copy_start);
+		}
+	};
+
+	if (in_thread_pool)
+	{
+		in_thread_pool->ParallelFor(end_chunk - first_chunk, decompress_job);
+	}
+	else
+	{
+		for (size_t job_idx = 0; job_idx < end_chunk - first_chunk; ++job_idx)
+		{
+			decompress_job(job_idx);
+		}
+	}
+
+	return success;
+}
+
+// Memory-mapped scene cache. Views returned by GetMeshes and GetInstances are only valid while this is open
+struct SceneCache
+{
+	/*	Fails if the cache doesn't exist, is malformed, is out of date, or was written with a different version or vertex format.
+		The cache is up to date if its source had the same file age, or failing that the same content hash. in_get_source_content_hash
+		is only called in the second case, since hashing means reading every source file.
+		Compressed caches are decompressed up front, across in_thread_pool if set
+	*/
+	bool Open(
+		const string& in_cache_path, 
+		const int64_t in_source_file_age, 
+		const VertexFormat in_vertex_format, 
+		const std::function<uint64_t()>& in_get_source_content_hash = nullptr,
+		ThreadPool* in_thread_pool = nullptr
+	)
+	{
+		Close();
+
+		if (!m_file.Open(in_cache_path.c_str()))
+		{
+			return false;
+		}
+
+		if (m_file.GetSize() < sizeof(SceneCacheHeader))
+		{
+			return Fail();
+		}
+
+		memcpy(&m_header, m_file.GetData(), sizeof(SceneCacheHeader));
+		if (m_header.magic != SCENE_CACHE_MAGIC || m_header.version != SCENE_CACHE_VERSION)
+		{
+			return Fail();
+		}
+
+		if (m_header.source_file_age != in_source_file_age
+			&& (m_header.source_content_hash == 0 || !in_get_source_content_hash || in_get_source_content_hash() != m_header.source_content_hash))
+		{
+			return Fail();
+		}
+
+		// Everything below reads out of the body, which is used in place unless it has to be decompressed
+		const uint8_t* data = m_file.GetData() + sizeof(SceneCacheHeader);
+		size_t size = m_file.GetSize() - sizeof(SceneCacheHeader);
+		if (m_header.compression == SceneCacheCompression::Deflate)
+		{
+			if (!DecompressBody(in_thread_pool))
+			{
+				return Fail();
+			}
+			data = m_body.data();
+			size = m_body.size();
+		}
+		else if (m_header.compression != SceneCacheCompression::None)
+		{
+			return Fail();
+		}
+
+		size_t offset = 0;
+		const size_t instances_size = m_header.instance_count * sizeof(GltfMeshInstance);
+		if (offset + instances_size > size)
+		{
+			return Fail();
+		}
+		m_instances = span<const GltfMeshInstance>(reinterpret_cast<const GltfMeshInstance*>(data + offset), m_header.instance_count);
+		offset += align_up(instances_size, 8);
+
+		m_meshes.reserve(m_header.mesh_count);
+		for (uint64_t mesh_idx = 0; mesh_idx < m_header.mesh_count; ++mesh_idx)
+		{
+			if (offset + sizeof(SceneCacheMeshHeader) > size)
+			{
+				return Fail();
+			}
+
+			const SceneCacheMeshHeader* mesh_header = reinterpret_cast<const SceneCacheMeshHeader*>(data + offset);
+			if (offset + mesh_header->total_size > size)
+			{
+				return Fail();
+			}
+
+			if ((mesh_header->index_stride != 2 && mesh_header->index_stride != 4)
+				|| mesh_header->vertex_format != in_vertex_format
+				|| mesh_header->lod_count == 0
+				|| mesh_header->lod_count > MESH_MAX_LODS)
+			{
+				return Fail();
+			}
+
+			// Sections are only bounds checked (against total_size) after they've all been laid out below
+			const uint8_t* section_cursor = data + offset + sizeof(SceneCacheMeshHeader);
+
+			GltfMeshView mesh =
+			{
+				.index_stride = static_cast<uint32_t>(mesh_header->index_stride),
+				.index_count = mesh_header->index_count,
+				.index_data = read_section<uint8_t>(section_cursor, align_up(mesh_header->index_count * mesh_header->index_stride, 4)),
+				.vertex_format = mesh_header->vertex_format,
+				.vertex_count = mesh_header->vertex_count,
+				.position_data = read_section<uint8_t>(section_cursor, mesh_header->vertex_count * get_position_stride(mesh_header->vertex_format)),
+				.attribute_data = read_section<uint8_t>(section_cursor, mesh_header->vertex_count * get_attribute_stride(mesh_header->vertex_format)),
+				.position_min = mesh_header->position_min,
+				.position_extent = mesh_header->position_extent,
+				.bounds = mesh_header->bounds,
+				.meshlets = read_section<Meshlet>(section_cursor, mesh_header->meshlet_count),
+				.meshlet_vertices = read_section<uint32_t>(section_cursor, mesh_header->meshlet_vertex_count),
+				.meshlet_triangles = read_section<uint32_t>(section_cursor, mesh_header->meshlet_triangle_count),
+				.lods = read_section<MeshLod>(section_cursor, mesh_header->lod_count),
+				.material_index = mesh_header->material_index,
+				.source_hash = mesh_header->source_hash,
+			};
+
+			if (scene_cache_mesh_size(mesh) != mesh_header->total_size)
+			{
+				return Fail();
+			}
+
+			if (!m_toc.empty() && (m_toc[mesh_idx].body_offset != offset || m_toc[mesh_idx].size != mesh_header->total_size))
+			{
+				return Fail();
+			}
+
+			for (const MeshLod& lod : mesh.lods)
+			{
+				if ((uint64_t) lod.index_offset + lod.index_count > mesh.index_count)
+				{
+					return Fail();
+				}
+			}
+
+			m_meshes.push_back(mesh);
+			offset += mesh_header->total_size;
+		}
+
+		for (const GltfMeshInstance& instance : m_instances)
+		{
+			if (instance.mesh_index >= m_meshes.size())
+			{
+				return Fail();
+			}
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+		m_meshes.clear();
+		m_instances = {};
+		m_chunks = {};
+		m_toc = {};
+		m_body = {};
+		m_decompress_time = 0.0f;
+		m_file.Close();
+	}
+
+	const vector<GltfMeshView>& GetMeshes() const { return m_meshes; }
+	span<const GltfMeshInstance> GetInstances() const { return m_instances; }
+	uint64_t GetMaxContiguousSize() const { return m_header.max_contiguous_size; }
+
+	bool IsCompressed() const { return m_header.compression != SceneCacheCompression::None; }
+	size_t GetFileSize() const { return m_file.GetSize(); }
+	uint64_t GetBodySize() const { return m_header.body_size; }
+
+	// Wall time Open spent decompressing, in milliseconds
+	float GetDecompressTime() const { return m_decompress_time; }
+
+protected:
+	bool Fail()
+	{
+		Close();
+		return false;
+	}
+
+	// Validates the chunk table and table of contents, then decompresses every chunk into m_body
+	bool DecompressBody(ThreadPool* in_thread_pool)
+	{
+		const uint8_t* data = m_file.GetData();
+		const size_t size = m_file.GetSize();
+		const size_t tables_offset = sizeof(SceneCacheHeader);
+		if (m_header.chunk_size == 0
+			|| m_header.chunk_count != (m_header.body_size + m_header.chunk_size - 1) / m_header.chunk_size
+			|| m_header.chunk_count > size / sizeof(SceneCacheChunk)
+			|| m_header.mesh_count > size / sizeof(SceneCacheTocEntry))
+		{
+			return false;
+		}
+
+		const size_t chunks_size = m_header.chunk_count * sizeof(SceneCacheChunk);
+		const size_t toc_size = m_header.mesh_count * sizeof(SceneCacheTocEntry);
+		if (tables_offset + chunks_size + toc_size > size)
+		{
+			return false;
+		}
+		m_chunks = span<const SceneCacheChunk>(reinterpret_cast<const SceneCacheChunk*>(data + tables_offset), m_header.chunk_count);
+		m_toc = span<const SceneCacheTocEntry>(reinterpret_cast<const SceneCacheTocEntry*>(data + tables_offset + chunks_size), m_header.mesh_count);
+
+		for (size_t chunk_idx = 0; chunk_idx < m_chunks.size(); ++chunk_idx)
+		{
+			const SceneCacheChunk& chunk = m_chunks[chunk_idx];
+			const uint64_t expected_size = (std::min)(m_header.body_size - chunk_idx * m_header.chunk_size, (uint64_t) m_header.chunk_size);
+			if (chunk.size != expected_size
+				|| chunk.compressed_size > chunk.size
+				|| chunk.file_offset < tables_offset + chunks_size + toc_size
+				|| chunk.file_offset + chunk.compressed_size > size)
+			{
+				return false;
+			}
+		}
+
+		const auto decompress_start_time = std::chrono::high_resolution_clock::now();
+		m_body.resize(m_header.body_size);
+		if (!decompress_scene_cache_range(span<const uint8_t>(data, size), m_header.chunk_size, m_chunks, 0, m_body, in_thread_pool))
+		{
+			return false;
+		}
+
+		using milliseconds = std::chrono::duration<float, std::milli>;
+		m_decompress_time = std::chrono::duration_cast<milliseconds>(std::chrono::high_resolution_clock::now() - decompress_start_time).count();
+		return true;
+	}
+
+	MappedFile m_file;
+	SceneCacheHeader m_header = {};
+	vector<GltfMeshView> m_meshes;
+	span<const GltfMeshInstance> m_instances;
+
+	// Compressed caches only. Both point into m_file, m_body holds the decompressed body the views point into
+	span<const SceneCacheChunk> m_chunks;
+	span<const SceneCacheTocEntry> m_toc;
+	vector<uint8_t> m_body;
+	float m_decompress_time = 0.0f;
+};
@@ -16,7 +16,7 @@
 #error include d3d11.h or d3d12.h before including SimpleMath.h
 #endif
 
-#if !defined(_XBOX_ONE) || !defined(_TITLE)
+#if defined(_WIN32) && (!defined(_XBOX_ONE) || !defined(_TITLE))
 #include <dxgi1_6.h>
 #endif
 
@@ -933,8 +933,10 @@ namespace DirectX
             void Unproject(const Vector3& p, const Matrix& proj, const Matrix& view, const Matrix& world, Vector3& result) const noexcept;
 
             // Static methods
+#ifdef _WIN32
             static RECT __cdecl ComputeDisplayArea(DXGI_SCALING scaling, UINT backBufferWidth, UINT backBufferHeight, int outputWidth, int outputHeight) noexcept;
             static RECT __cdecl ComputeTitleSafeArea(UINT backBufferWidth, UINT backBufferHeight) noexcept;
+#endif
         };
 
         //FCS BEGIN Additions
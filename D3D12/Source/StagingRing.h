@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+#include "RingAllocator.h"
+
+using std::optional;
+using std::nullopt;
+
+enum class UploadRingFullBehavior
+{
+	Block,		// Wait for the GPU to retire earlier uploads
+	Overflow,	// Put the upload in a dedicated upload buffer, released once its fence completes
+};
+
+/*	The bookkeeping half of UploadRing, without the device: a RingAllocator over the ring buffer, plus the overflow buffers and what to do when
+	the ring is full (see UploadRingFullBehavior). OverflowBuffer is whatever the owner stores per overflow allocation (an upload buffer for UploadRing).
+	Waiting on fences and creating overflow buffers are left to callbacks, so this can be driven by a fake fence in tests.
+
+	Not thread-safe.
+*/
+template<typename OverflowBuffer>
+struct StagingRing
+{
+	// Either a range of the ring, or a dedicated overflow buffer
+	struct Allocation
+	{
+		RingAllocation ring_allocation;
+		OverflowBuffer* overflow_buffer = nullptr;
+	};
+
+	StagingRing(const uint64_t in_capacity, const UploadRingFullBehavior in_full_behavior)
+		: m_full_behavior(in_full_behavior)
+		, m_ring(in_capacity)
+	{
+	}
+
+	/*	in_alignment must be a power of two. in_completed_fence_value is the fence's current completed value.
+		When the ring is full, Block calls in_wait_for_fence(fence_value) on the oldest submitted fence values until enough space is retired, and
+		Overflow calls in_create_overflow_buffer(in_size) for an OverflowBuffer. Returns nullopt if neither helps
+	*/
+	template<typename WaitFunction, typename CreateOverflowFunction>
+	optional<Allocation> Allocate(
+		const uint64_t in_size,
+		const uint64_t in_alignment,
+		const uint64_t in_completed_fence_value,
+		WaitFunction&& in_wait_for_fence,
+		CreateOverflowFunction&& in_create_overflow_buffer
+	)
+	{
+		Retire(in_completed_fence_value);
+
+		optional<RingAllocation> allocation = m_ring.Allocate(in_size, in_alignment);
+		if (!allocation && m_full_behavior == UploadRingFullBehavior::Block && in_size <= m_ring.GetCapacity())
+		{
+			// Oldest uploads first, until enough has been retired
+			for (optional<uint64_t> fence_value = m_ring.GetOldestSubmittedFenceValue(); !allocation && fence_value; fence_value = m_ring.GetOldestSubmittedFenceValue())
+			{
+				in_wait_for_fence(*fence_value);
+				Retire(*fence_value);
+				allocation = m_ring.Allocate(in_size, in_alignment);
+			}
+		}
+
+		if (allocation)
+		{
+			return Allocation { .ring_allocation = *allocation };
+		}
+
+		if (m_full_behavior == UploadRingFullBehavior::Overflow && in_size > 0)
+		{
+			OverflowEntry& overflow = m_overflow_entries.emplace_back(OverflowEntry {
+				.buffer = in_create_overflow_buffer(in_size),
+				.size = in_size,
+			});
+			m_overflow_size += in_size;
+			return Allocation {
+				.ring_allocation = { .offset = 0, .size = in_size },
+				.overflow_buffer = &overflow.buffer,
+			};
+		}
+
+		return nullopt;
+	}
+
+	// Everything allocated since the previous Submit, ring or overflow, is retired once in_fence_value completes. Fence values must increase
+	void Submit(const uint64_t in_fence_value)
+	{
+		m_ring.Submit(in_fence_value);
+		for (auto overflow_it = m_overflow_entries.rbegin(); overflow_it != m_overflow_entries.rend() && overflow_it->fence_value == 0; ++overflow_it)
+		{
+			overflow_it->fence_value = in_fence_value;
+		}
+	}
+
+	// Releases every ring region and overflow buffer whose fence value is <= in_completed_fence_value
+	void Retire(const uint64_t in_completed_fence_value)
+	{
+		m_ring.Retire(in_completed_fence_value);
+		while (!m_overflow_entries.empty() && m_overflow_entries.front().fence_value != 0 && m_overflow_entries.front().fence_value <= in_completed_fence_value)
+		{
+			m_overflow_size -= m_overflow_entries.front().size;
+			m_overflow_entries.pop_front();
+		}
+	}
+
+	uint64_t GetCapacity() const { return m_ring.GetCapacity(); }
+	uint64_t GetUsedSize() const { return m_ring.GetUsedSize(); }
+
+	// Bytes currently held by overflow buffers
+	uint64_t GetOverflowSize() const { return m_overflow_size; }
+	size_t GetOverflowBufferCount() const { return m_overflow_entries.size(); }
+
+protected:
+	struct OverflowEntry
+	{
+		OverflowBuffer buffer;
+		uint64_t size = 0;
+
+		// 0 until the Submit following its allocation
+		uint64_t fence_value = 0;
+	};
+
+	UploadRingFullBehavior m_full_behavior = UploadRingFullBehavior::Block;
+	RingAllocator m_ring;
+
+	// Oldest first, like the ring's regions. A deque so allocations can point at their buffer
+	std::deque<OverflowEntry> m_overflow_entries;
+	uint64_t m_overflow_size = 0;
+};
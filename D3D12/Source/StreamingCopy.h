@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define STREAMING_COPY_SSE2 1
+#endif
+
+/*	memcpy for destinations the CPU only ever writes, like persistently mapped upload heaps (write-combined memory on most GPUs).
+	Non-temporal stores write whole cache lines straight to memory, neither reading the destination nor evicting anything useful from the cache.
+	Below STREAMING_COPY_MIN_SIZE, or without SSE2, this is a plain memcpy.
+*/
+
+static constexpr size_t STREAMING_COPY_MIN_SIZE = 256;
+
+inline void streaming_memcpy(void* out_dest, const void* in_source, size_t in_size)
+{
+	uint8_t* dest = static_cast<uint8_t*>(out_dest);
+	const uint8_t* source = static_cast<const uint8_t*>(in_source);
+
+#if STREAMING_COPY_SSE2
+	if (in_size >= STREAMING_COPY_MIN_SIZE)
+	{
+		// Non-temporal stores need 16 byte aligned destinations. Sources are loaded unaligned
+		const size_t head_size = (16 - (reinterpret_cast<uintptr_t>(dest) & 15)) & 15;
+		memcpy(dest, source, head_size);
+		dest += head_size;
+		source += head_size;
+		in_size -= head_size;
+
+		// A cache line per iteration, so write-combining buffers are flushed as full lines
+		for (; in_size >= 64; in_size -= 64, dest += 64, source += 64)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dest), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dest + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dest + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dest + 48), d);
+		}
+
+		for (; in_size >= 16; in_size -= 16, dest += 16, source += 16)
+		{
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dest), _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+		}
+
+		// Non-temporal stores are weakly ordered, make sure they land before anything that follows (e.g. submitting a copy that reads them)
+		_mm_sfence();
+	}
+#endif
+
+	memcpy(dest, source, in_size);
+}
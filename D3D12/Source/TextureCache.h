@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::span;
+using std::string;
+using std::vector;
+
+#include "SceneCache.h"
+#include "TextureCompression.h"
+
+/*	Cooked textures for a GltfScene: every texture its materials reference, already mipped and block compressed. Written next to the source .gltf
+	alongside the scene cache, and memory-mapped on subsequent loads so textures go straight from the file to the GPU.
+
+	Layout:
+	TextureCacheHeader
+	For each texture, in GltfMaterialSet::textures order (8 byte aligned) ...
+		TextureCacheEntryHeader
+		Mips (TextureMip * mip_count)
+		Texture Data (data_size bytes, padded to 8 bytes). A texture that failed to decode has no mips and no data
+
+	Bump TEXTURE_CACHE_VERSION whenever this layout, a block format's encoder or the mip generation changes.
+*/
+
+static constexpr uint32_t TEXTURE_CACHE_MAGIC = 0x43544346; // "FCTC"
+static constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+static constexpr const char* TEXTURE_CACHE_EXTENSION = ".textures.cooked";
+
+struct TextureCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int64_t source_file_age;
+	uint64_t texture_count;
+	TextureCompression compression;
+	uint32_t padding = 0;
+};
+
+struct TextureCacheEntryHeader
+{
+	// Size of this header plus the mips and data that follow it (including padding)
+	uint64_t total_size;
+
+	// Age of the image file this texture was cooked from, 0 if it was embedded in the gltf
+	int64_t source_file_age;
+	TextureUsage usage;
+	TextureFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t srgb;
+	uint32_t mip_count;
+	uint64_t data_size;
+};
+
+// What a cached texture was cooked from. A cached texture is stale if either of these no longer match
+struct TextureCacheSource
+{
+	int64_t source_file_age;
+	TextureUsage usage;
+};
+
+inline string get_texture_cache_path(const char* in_source_file)
+{
+	return string(in_source_file) + TEXTURE_CACHE_EXTENSION;
+}
+
+inline uint64_t texture_cache_entry_size(const TextureView& in_texture)
+{
+	return align_up(sizeof(TextureCacheEntryHeader) + in_texture.mips.size_bytes() + in_texture.data.size_bytes(), 8);
+}
+
+// Writes out in_textures (one per in_sources entry) to in_cache_path. Writes to a temp file first so a partially written cache is never picked up
+inline bool write_texture_cache(
+	const string& in_cache_path,
+	const int64_t in_source_file_age,
+	const TextureCompression in_compression,
+	span<const TextureCacheSource> in_sources,
+	span<const TextureView> in_textures
+)
+{
+	assert(in_sources.size() == in_textures.size());
+
+	const TextureCacheHeader header =
+	{
+		.magic = TEXTURE_CACHE_MAGIC,
+		.version = TEXTURE_CACHE_VERSION,
+		.source_file_age = in_source_file_age,
+		.texture_count = in_textures.size(),
+		.compression = in_compression,
+	};
+
+	const string temp_path = in_cache_path + ".tmp";
+	FILE* file = fopen(temp_path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	static const uint8_t padding[8] = {};
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (size_t texture_idx = 0; texture_idx < in_textures.size() && success; ++texture_idx)
+	{
+		const TextureView& texture = in_textures[texture_idx];
+		const TextureCacheEntryHeader entry_header =
+		{
+			.total_size = texture_cache_entry_size(texture),
+			.source_file_age = in_sources[texture_idx].source_file_age,
+			.usage = in_sources[texture_idx].usage,
+			.format = texture.format,
+			.width = texture.width,
+			.height = texture.height,
+			.srgb = texture.srgb,
+			.mip_count = (uint32_t) texture.mips.size(),
+			.data_size = texture.data.size(),
+		};
+
+		success &= fwrite(&entry_header, sizeof(entry_header), 1, file) == 1;
+		success &= fwrite(texture.mips.data(), 1, texture.mips.size_bytes(), file) == texture.mips.size_bytes();
+		success &= fwrite(texture.data.data(), 1, texture.data.size_bytes(), file) == texture.data.size_bytes();
+
+		const size_t end_padding = entry_header.total_size - sizeof(entry_header) - texture.mips.size_bytes() - texture.data.size_bytes();
+		success &= fwrite(padding, 1, end_padding, file) == end_padding;
+	}
+
+	success &= fclose(file) == 0;
+
+	std::error_code error;
+	if (success)
+	{
+		std::filesystem::rename(temp_path, in_cache_path, error);
+	}
+	if (!success || error)
+	{
+		std::filesystem::remove(temp_path, error);
+		return false;
+	}
+
+	return true;
+}
+
+// Memory-mapped texture cache. Views returned by GetTextures are only valid while this is open
+struct TextureCache
+{
+	// Fails if the cache doesn't exist, is malformed, was cooked with different settings, or any of its textures' sources have changed
+	bool Open(const string& in_cache_path, const int64_t in_source_file_age, const TextureCompression in_compression, span<const TextureCacheSource> in_sources)
+	{
+		Close();
+
+		if (!m_file.Open(in_cache_path.c_str()))
+		{
+			return false;
+		}
+
+		const uint8_t* data = m_file.GetData();
+		const size_t size = m_file.GetSize();
+		if (size < sizeof(TextureCacheHeader))
+		{
+			return Fail();
+		}
+
+		TextureCacheHeader header;
+		memcpy(&header, data, sizeof(TextureCacheHeader));
+		if (header.magic != TEXTURE_CACHE_MAGIC
+			|| header.version != TEXTURE_CACHE_VERSION
+			|| header.source_file_age != in_source_file_age
+			|| header.compression != in_compression
+			|| header.texture_count != in_sources.size())
+		{
+			return Fail();
+		}
+
+		size_t offset = sizeof(TextureCacheHeader);
+		m_textures.reserve(header.texture_count);
+		for (uint64_t texture_idx = 0; texture_idx < header.texture_count; ++texture_idx)
+		{
+			if (offset + sizeof(TextureCacheEntryHeader) > size)
+			{
+				return Fail();
+			}
+
+			const TextureCacheEntryHeader* entry_header = reinterpret_cast<const TextureCacheEntryHeader*>(data + offset);
+			if (offset + entry_header->total_size > size
+				|| entry_header->source_file_age != in_sources[texture_idx].source_file_age
+				|| entry_header->usage != in_sources[texture_idx].usage
+				|| entry_header->format > TextureFormat::BC7)
+			{
+				return Fail();
+			}
+
+			const uint8_t* section_cursor = data + offset + sizeof(TextureCacheEntryHeader);
+			const TextureView texture =
+			{
+				.width = entry_header->width,
+				.height = entry_header->height,
+				.format = entry_header->format,
+				.srgb = entry_header->srgb != 0,
+				.mips = read_section<TextureMip>(section_cursor, entry_header->mip_count),
+				.data = read_section<uint8_t>(section_cursor, entry_header->data_size),
+			};
+
+			if (texture_cache_entry_size(texture) != entry_header->total_size)
+			{
+				return Fail();
+			}
+
+			for (const TextureMip& mip : texture.mips)
+			{
+				if (mip.offset + mip.GetSize() > texture.data.size())
+				{
+					return Fail();
+				}
+			}
+
+			m_textures.push_back(texture);
+			offset += entry_header->total_size;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+		m_textures.clear();
+		m_file.Close();
+	}
+
+	// Indexed the same as the in_sources the cache was opened with. Textures that failed to decode when cooking have no mips
+	const vector<TextureView>& GetTextures() const { return m_textures; }
+
+protected:
+	bool Fail()
+	{
+		Close();
+		return false;
+	}
+
+	MappedFile m_file;
+	vector<TextureView> m_textures;
+};
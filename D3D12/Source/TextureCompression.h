@@ -0,0 +1,702 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+using std::span;
+using std::vector;
+
+#include "microprofile/stb/stb_dxt.h"
+#include "TextureProcessing.h"
+#include "ThreadPool.h"
+
+/*	Block compression (BCn) of decoded textures, plus decoders for everything we encode so compression quality can be checked headless.
+	BC1, BC3 and BC5 blocks are encoded with stb_dxt. BC7 blocks are encoded here, using only mode 6 (one subset, RGBA endpoints, 4-bit indices),
+	which covers color and alpha in a single pass and is within a few dB of a full mode search on typical material textures.
+*/
+
+// What a texture is sampled as, which decides what it can be compressed to
+enum class TextureUsage : uint32_t
+{
+	Color,		// sRGB color, possibly with alpha (base color, emissive)
+	Data,		// Linear data in RGB (metallic-roughness, occlusion)
+	NormalMap,	// Tangent space normals. Only XY survive compression, so Z has to be reconstructed when sampling
+};
+
+enum class TextureCompression : uint32_t
+{
+	None,			// Everything stays RGBA8
+	Fast,			// BC1 (BC3 for color with alpha), BC5 for normal maps
+	HighQuality,	// BC7, BC5 for normal maps
+};
+
+// True if any of in_texture's base level texels aren't fully opaque
+inline bool has_transparent_texels(const TextureData& in_texture)
+{
+	const span<const uint8_t> texels = in_texture.GetMipData(0);
+	for (size_t texel_idx = 0; texel_idx < texels.size(); texel_idx += TEXTURE_BYTES_PER_TEXEL)
+	{
+		if (texels[texel_idx + 3] != 255)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// D3D12 requires the base level of a block compressed texture to be a whole number of blocks, anything else stays RGBA8
+inline TextureFormat choose_texture_format(const TextureData& in_texture, const TextureUsage in_usage, const TextureCompression in_compression)
+{
+	if (in_compression == TextureCompression::None || in_texture.width % TEXTURE_BLOCK_DIM != 0 || in_texture.height % TEXTURE_BLOCK_DIM != 0)
+	{
+		return TextureFormat::RGBA8;
+	}
+
+	if (in_usage == TextureUsage::NormalMap)
+	{
+		return TextureFormat::BC5;
+	}
+
+	if (in_compression == TextureCompression::HighQuality)
+	{
+		return TextureFormat::BC7;
+	}
+
+	return in_usage == TextureUsage::Color && has_transparent_texels(in_texture) ? TextureFormat::BC3 : TextureFormat::BC1;
+}
+
+// Copies the 4x4 block at (in_block_x, in_block_y) of an RGBA8 mip into out_block. Texels past the mip's edges (mips smaller than a block) repeat the edge
+inline void load_texel_block(const TextureMip& in_mip, const uint8_t* in_texels, const uint32_t in_block_x, const uint32_t in_block_y, uint8_t* out_block)
+{
+	for (uint32_t y = 0; y < TEXTURE_BLOCK_DIM; ++y)
+	{
+		const uint32_t texel_y = (std::min)(in_block_y * TEXTURE_BLOCK_DIM + y, in_mip.height - 1);
+		for (uint32_t x = 0; x < TEXTURE_BLOCK_DIM; ++x)
+		{
+			const uint32_t texel_x = (std::min)(in_block_x * TEXTURE_BLOCK_DIM + x, in_mip.width - 1);
+			memcpy(
+				out_block + (y * TEXTURE_BLOCK_DIM + x) * TEXTURE_BYTES_PER_TEXEL,
+				in_texels + ((size_t) texel_y * in_mip.width + texel_x) * TEXTURE_BYTES_PER_TEXEL,
+				TEXTURE_BYTES_PER_TEXEL
+			);
+		}
+	}
+}
+
+// Reads and writes fields of a 128-bit block, least significant bit first
+struct BlockBits
+{
+	uint64_t bits[2] = {};
+	uint32_t position = 0;
+
+	void Write(const uint32_t in_value, const uint32_t in_bit_count)
+	{
+		for (uint32_t bit_idx = 0; bit_idx < in_bit_count; ++bit_idx, ++position)
+		{
+			bits[position >> 6] |= (uint64_t) ((in_value >> bit_idx) & 1) << (position & 63);
+		}
+	}
+
+	uint32_t Read(const uint32_t in_bit_count)
+	{
+		uint32_t value = 0;
+		for (uint32_t bit_idx = 0; bit_idx < in_bit_count; ++bit_idx, ++position)
+		{
+			value |= (uint32_t) ((bits[position >> 6] >> (position & 63)) & 1) << bit_idx;
+		}
+		return value;
+	}
+};
+
+static constexpr uint32_t BC7_MODE_6_INDEX_COUNT = 16;
+static constexpr uint32_t BC7_MODE_6_REFINE_ITERATIONS = 2;
+static constexpr uint8_t BC7_WEIGHTS_4[BC7_MODE_6_INDEX_COUNT] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+inline uint32_t bc7_interpolate(const uint32_t in_endpoint_0, const uint32_t in_endpoint_1, const uint32_t in_weight)
+{
+	return ((64 - in_weight) * in_endpoint_0 + in_weight * in_endpoint_1 + 32) >> 6;
+}
+
+// Mode 6 endpoints, as the 8-bit values they expand to: 7 bits per channel, plus a p-bit shared by all of an endpoint's channels
+struct Bc7Mode6Endpoints
+{
+	uint8_t endpoints[2][4];
+};
+
+/*	Picks the closest palette entry for each of in_texels, returning the block's total squared error. The palette is evaluated four
+	entries at a time (as separate R, G, B and A lanes), keeping a running per-lane minimum, so the inner loop is branch-free.
+*/
+inline float bc7_mode_6_select_indices(const float (&in_texels)[16][4], const Bc7Mode6Endpoints& in_endpoints, uint8_t (&out_indices)[16])
+{
+	alignas(16) float palette[4][BC7_MODE_6_INDEX_COUNT];
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		for (uint32_t index = 0; index < BC7_MODE_6_INDEX_COUNT; ++index)
+		{
+			palette[channel][index] = (float) bc7_interpolate(in_endpoints.endpoints[0][channel], in_endpoints.endpoints[1][channel], BC7_WEIGHTS_4[index]);
+		}
+	}
+
+	float total_error = 0.0f;
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		const float* texel = in_texels[texel_idx];
+		float best_error = FLT_MAX;
+		uint32_t best_index = 0;
+#if TEXTURE_PROCESSING_SSE2
+		__m128 best_errors = _mm_set1_ps(FLT_MAX);
+		__m128i best_indices = _mm_setzero_si128();
+		for (uint32_t index = 0; index < BC7_MODE_6_INDEX_COUNT; index += 4)
+		{
+			__m128 error = _mm_setzero_ps();
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const __m128 delta = _mm_sub_ps(_mm_load_ps(&palette[channel][index]), _mm_set1_ps(texel[channel]));
+				error = _mm_add_ps(error, _mm_mul_ps(delta, delta));
+			}
+
+			const __m128i is_better = _mm_castps_si128(_mm_cmplt_ps(error, best_errors));
+			const __m128i indices = _mm_setr_epi32(index, index + 1, index + 2, index + 3);
+			best_indices = _mm_or_si128(_mm_and_si128(is_better, indices), _mm_andnot_si128(is_better, best_indices));
+			best_errors = _mm_min_ps(error, best_errors);
+		}
+
+		alignas(16) float lane_errors[4];
+		alignas(16) int32_t lane_indices[4];
+		_mm_store_ps(lane_errors, best_errors);
+		_mm_store_si128((__m128i*) lane_indices, best_indices);
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			if (lane_errors[lane] < best_error)
+			{
+				best_error = lane_errors[lane];
+				best_index = (uint32_t) lane_indices[lane];
+			}
+		}
+#else
+		for (uint32_t index = 0; index < BC7_MODE_6_INDEX_COUNT; ++index)
+		{
+			float error = 0.0f;
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const float delta = palette[channel][index] - texel[channel];
+				error += delta * delta;
+			}
+			if (error < best_error)
+			{
+				best_error = error;
+				best_index = index;
+			}
+		}
+#endif
+		out_indices[texel_idx] = (uint8_t) best_index;
+		total_error += best_error;
+	}
+	return total_error;
+}
+
+/*	Quantizes a pair of float endpoints to mode 6's 7 bits + p-bit, trying all four p-bit combinations and keeping whichever gives the lowest error.
+	Returns that error, with the chosen endpoints and indices in io_best_endpoints / io_best_indices if it beats in_best_error
+*/
+inline float bc7_mode_6_quantize_endpoints(
+	const float (&in_texels)[16][4], const float (&in_endpoints)[2][4], float in_best_error,
+	Bc7Mode6Endpoints& io_best_endpoints, uint8_t (&io_best_indices)[16])
+{
+	for (uint32_t p_bits = 0; p_bits < 4; ++p_bits)
+	{
+		Bc7Mode6Endpoints endpoints;
+		for (uint32_t endpoint_idx = 0; endpoint_idx < 2; ++endpoint_idx)
+		{
+			const uint32_t p_bit = (p_bits >> endpoint_idx) & 1;
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const float value = std::clamp(in_endpoints[endpoint_idx][channel], 0.0f, 255.0f);
+				const int32_t quantized = std::clamp((int32_t) std::lround((value - p_bit) * 0.5f), 0, 127);
+				endpoints.endpoints[endpoint_idx][channel] = (uint8_t) ((quantized << 1) | p_bit);
+			}
+		}
+
+		uint8_t indices[16];
+		const float error = bc7_mode_6_select_indices(in_texels, endpoints, indices);
+		if (error < in_best_error)
+		{
+			in_best_error = error;
+			io_best_endpoints = endpoints;
+			memcpy(io_best_indices, indices, sizeof(indices));
+		}
+	}
+	return in_best_error;
+}
+
+/*	Encodes a 4x4 RGBA8 block as BC7 mode 6. Endpoints start at the extremes of the block's principal axis, then are refined by a least squares fit
+	to the indices they selected.
+*/
+inline void encode_bc7_block(const uint8_t* in_block, uint8_t* out_block)
+{
+	float texels[16][4];
+	float mean[4] = {};
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			texels[texel_idx][channel] = in_block[texel_idx * 4 + channel];
+			mean[channel] += texels[texel_idx][channel] / 16.0f;
+		}
+	}
+
+	float covariance[4][4] = {};
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				covariance[row][column] += (texels[texel_idx][row] - mean[row]) * (texels[texel_idx][column] - mean[column]);
+			}
+		}
+	}
+
+	// Power iteration for the principal axis, starting from the diagonal of the covariance so a single dominant channel converges immediately
+	float axis[4] = { covariance[0][0], covariance[1][1], covariance[2][2], covariance[3][3] };
+	for (uint32_t iteration = 0; iteration < 8; ++iteration)
+	{
+		float next_axis[4] = {};
+		float max_component = 0.0f;
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column)
+			{
+				next_axis[row] += covariance[row][column] * axis[column];
+			}
+			max_component = (std::max)(max_component, std::fabs(next_axis[row]));
+		}
+		if (max_component <= 0.0f)
+		{
+			break;
+		}
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			axis[channel] = next_axis[channel] / max_component;
+		}
+	}
+
+	float axis_length_squared = 0.0f;
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		axis_length_squared += axis[channel] * axis[channel];
+	}
+
+	float min_t = 0.0f;
+	float max_t = 0.0f;
+	if (axis_length_squared > 0.0f)
+	{
+		min_t = FLT_MAX;
+		max_t = -FLT_MAX;
+		for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+		{
+			float t = 0.0f;
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				t += (texels[texel_idx][channel] - mean[channel]) * axis[channel];
+			}
+			t /= axis_length_squared;
+			min_t = (std::min)(min_t, t);
+			max_t = (std::max)(max_t, t);
+		}
+	}
+
+	float endpoints[2][4];
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		endpoints[0][channel] = mean[channel] + axis[channel] * min_t;
+		endpoints[1][channel] = mean[channel] + axis[channel] * max_t;
+	}
+
+	Bc7Mode6Endpoints best_endpoints = {};
+	uint8_t best_indices[16] = {};
+	float best_error = bc7_mode_6_quantize_endpoints(texels, endpoints, FLT_MAX, best_endpoints, best_indices);
+
+	for (uint32_t iteration = 0; iteration < BC7_MODE_6_REFINE_ITERATIONS && best_error > 0.0f; ++iteration)
+	{
+		// Minimize sum(((1 - w) * e0 + w * e1 - x)^2) over both endpoints, per channel. The 2x2 system is the same for every channel
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		float d0[4] = {};
+		float d1[4] = {};
+		for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+		{
+			const float weight = BC7_WEIGHTS_4[best_indices[texel_idx]] / 64.0f;
+			a += (1.0f - weight) * (1.0f - weight);
+			b += (1.0f - weight) * weight;
+			c += weight * weight;
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				d0[channel] += (1.0f - weight) * texels[texel_idx][channel];
+				d1[channel] += weight * texels[texel_idx][channel];
+			}
+		}
+
+		const float determinant = a * c - b * b;
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			break;
+		}
+
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = (c * d0[channel] - b * d1[channel]) / determinant;
+			endpoints[1][channel] = (a * d1[channel] - b * d0[channel]) / determinant;
+		}
+
+		const float refined_error = bc7_mode_6_quantize_endpoints(texels, endpoints, best_error, best_endpoints, best_indices);
+		if (refined_error >= best_error)
+		{
+			break;
+		}
+		best_error = refined_error;
+	}
+
+	// The first index's top bit is implicitly 0, so flip the block around if it's set
+	if (best_indices[0] & 0x8)
+	{
+		std::swap(best_endpoints.endpoints[0], best_endpoints.endpoints[1]);
+		for (uint8_t& index : best_indices)
+		{
+			index = (uint8_t) (BC7_MODE_6_INDEX_COUNT - 1 - index);
+		}
+	}
+
+	BlockBits block;
+	block.Write(1 << 6, 7);
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		block.Write(best_endpoints.endpoints[0][channel] >> 1, 7);
+		block.Write(best_endpoints.endpoints[1][channel] >> 1, 7);
+	}
+	block.Write(best_endpoints.endpoints[0][0] & 1, 1);
+	block.Write(best_endpoints.endpoints[1][0] & 1, 1);
+	block.Write(best_indices[0], 3);
+	for (uint32_t texel_idx = 1; texel_idx < 16; ++texel_idx)
+	{
+		block.Write(best_indices[texel_idx], 4);
+	}
+	assert(block.position == 128);
+	memcpy(out_block, block.bits, 16);
+}
+
+// Encodes one 4x4 RGBA8 block (see load_texel_block) as in_format
+inline void compress_block(const TextureFormat in_format, const uint8_t* in_block, uint8_t* out_block)
+{
+	switch (in_format)
+	{
+		case TextureFormat::BC1:
+			stb_compress_dxt_block(out_block, in_block, 0, STB_DXT_HIGHQUAL);
+			break;
+		case TextureFormat::BC3:
+			stb_compress_dxt_block(out_block, in_block, 1, STB_DXT_HIGHQUAL);
+			break;
+		case TextureFormat::BC5:
+		{
+			uint8_t red_green[16 * 2];
+			for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+			{
+				red_green[texel_idx * 2 + 0] = in_block[texel_idx * 4 + 0];
+				red_green[texel_idx * 2 + 1] = in_block[texel_idx * 4 + 1];
+			}
+			stb_compress_bc5_block(out_block, red_green);
+			break;
+		}
+		case TextureFormat::BC7:
+			encode_bc7_block(in_block, out_block);
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
+
+/*	Compresses every mip of an RGBA8 texture to in_format. Each row of blocks is an independent job, so with a thread pool even a single
+	large texture is spread across every thread. Safe to call from within a pool task.
+*/
+inline TextureData compress_texture(const TextureData& in_texture, const TextureFormat in_format, ThreadPool* in_thread_pool = nullptr)
+{
+	assert(in_texture.format == TextureFormat::RGBA8);
+	if (in_format == TextureFormat::RGBA8)
+	{
+		return in_texture;
+	}
+
+	TextureData compressed_texture;
+	compressed_texture.width = in_texture.width;
+	compressed_texture.height = in_texture.height;
+	compressed_texture.format = in_format;
+	compressed_texture.srgb = in_texture.srgb;
+	allocate_texture_mips(compressed_texture, (uint32_t) in_texture.mips.size());
+
+	struct BlockRow
+	{
+		uint32_t mip;
+		uint32_t row;
+	};
+	vector<BlockRow> block_rows;
+	for (uint32_t mip_idx = 0; mip_idx < compressed_texture.mips.size(); ++mip_idx)
+	{
+		for (uint32_t row_idx = 0; row_idx < compressed_texture.mips[mip_idx].row_count; ++row_idx)
+		{
+			block_rows.push_back(BlockRow { .mip = mip_idx, .row = row_idx });
+		}
+	}
+
+	const uint32_t block_size = get_texture_block_size(in_format);
+	auto compress_block_row = [&](const size_t in_block_row_idx)
+	{
+		const BlockRow& block_row = block_rows[in_block_row_idx];
+		const TextureMip& source_mip = in_texture.mips[block_row.mip];
+		const TextureMip& mip = compressed_texture.mips[block_row.mip];
+		const uint8_t* source_texels = in_texture.GetMipData(block_row.mip).data();
+		uint8_t* blocks = compressed_texture.GetMipData(block_row.mip).data() + block_row.row * mip.row_size;
+
+		const uint32_t block_count = (uint32_t) (mip.row_size / block_size);
+		for (uint32_t block_x = 0; block_x < block_count; ++block_x)
+		{
+			uint8_t block[16 * TEXTURE_BYTES_PER_TEXEL];
+			load_texel_block(source_mip, source_texels, block_x, block_row.row, block);
+			compress_block(in_format, block, blocks + block_x * block_size);
+		}
+	};
+
+	if (in_thread_pool)
+	{
+		in_thread_pool->ParallelFor(block_rows.size(), compress_block_row);
+	}
+	else
+	{
+		for (size_t block_row_idx = 0; block_row_idx < block_rows.size(); ++block_row_idx)
+		{
+			compress_block_row(block_row_idx);
+		}
+	}
+
+	return compressed_texture;
+}
+
+inline void expand_565(const uint16_t in_color, uint8_t* out_rgb)
+{
+	const uint32_t red = (in_color >> 11) & 0x1F;
+	const uint32_t green = (in_color >> 5) & 0x3F;
+	const uint32_t blue = in_color & 0x1F;
+	out_rgb[0] = (uint8_t) ((red << 3) | (red >> 2));
+	out_rgb[1] = (uint8_t) ((green << 2) | (green >> 4));
+	out_rgb[2] = (uint8_t) ((blue << 3) | (blue >> 2));
+}
+
+// Decodes a BC1 color block into the RGB(A) of out_block. BC2/3 color blocks are always in 4 color mode
+inline void decode_bc1_block(const uint8_t* in_block, uint8_t* out_block, const bool in_allow_punchthrough)
+{
+	const uint16_t color_0 = (uint16_t) (in_block[0] | (in_block[1] << 8));
+	const uint16_t color_1 = (uint16_t) (in_block[2] | (in_block[3] << 8));
+	const uint32_t indices = in_block[4] | (in_block[5] << 8) | (in_block[6] << 16) | ((uint32_t) in_block[7] << 24);
+
+	uint8_t palette[4][4];
+	expand_565(color_0, palette[0]);
+	expand_565(color_1, palette[1]);
+	palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+	const bool four_colors = color_0 > color_1 || !in_allow_punchthrough;
+	for (uint32_t channel = 0; channel < 3; ++channel)
+	{
+		if (four_colors)
+		{
+			palette[2][channel] = (uint8_t) ((2 * palette[0][channel] + palette[1][channel] + 1) / 3);
+			palette[3][channel] = (uint8_t) ((palette[0][channel] + 2 * palette[1][channel] + 1) / 3);
+		}
+		else
+		{
+			palette[2][channel] = (uint8_t) ((palette[0][channel] + palette[1][channel] + 1) / 2);
+			palette[3][channel] = 0;
+		}
+	}
+	if (!four_colors)
+	{
+		palette[3][3] = 0;
+	}
+
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		memcpy(out_block + texel_idx * 4, palette[(indices >> (texel_idx * 2)) & 0x3], 4);
+	}
+}
+
+// Decodes a BC4 block (also BC3's alpha and each of BC5's channels) into every in_stride'th byte of out_values
+inline void decode_bc4_block(const uint8_t* in_block, uint8_t* out_values, const uint32_t in_stride)
+{
+	const uint32_t value_0 = in_block[0];
+	const uint32_t value_1 = in_block[1];
+	uint8_t palette[8] = { (uint8_t) value_0, (uint8_t) value_1 };
+	if (value_0 > value_1)
+	{
+		for (uint32_t index = 2; index < 8; ++index)
+		{
+			palette[index] = (uint8_t) (((8 - index) * value_0 + (index - 1) * value_1 + 3) / 7);
+		}
+	}
+	else
+	{
+		for (uint32_t index = 2; index < 6; ++index)
+		{
+			palette[index] = (uint8_t) (((6 - index) * value_0 + (index - 1) * value_1 + 2) / 5);
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (uint32_t byte_idx = 0; byte_idx < 6; ++byte_idx)
+	{
+		indices |= (uint64_t) in_block[2 + byte_idx] << (byte_idx * 8);
+	}
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		out_values[texel_idx * in_stride] = palette[(indices >> (texel_idx * 3)) & 0x7];
+	}
+}
+
+// Only decodes mode 6, the one mode encode_bc7_block writes. Blocks in any other mode decode to transparent black
+inline void decode_bc7_block(const uint8_t* in_block, uint8_t* out_block)
+{
+	BlockBits block;
+	memcpy(block.bits, in_block, 16);
+	if (block.Read(7) != (1 << 6))
+	{
+		memset(out_block, 0, 16 * 4);
+		return;
+	}
+
+	uint32_t endpoints[2][4];
+	for (uint32_t channel = 0; channel < 4; ++channel)
+	{
+		endpoints[0][channel] = block.Read(7) << 1;
+		endpoints[1][channel] = block.Read(7) << 1;
+	}
+	for (uint32_t endpoint_idx = 0; endpoint_idx < 2; ++endpoint_idx)
+	{
+		const uint32_t p_bit = block.Read(1);
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoints[endpoint_idx][channel] |= p_bit;
+		}
+	}
+
+	for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+	{
+		const uint32_t index = block.Read(texel_idx == 0 ? 3 : 4);
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			out_block[texel_idx * 4 + channel] = (uint8_t) bc7_interpolate(endpoints[0][channel], endpoints[1][channel], BC7_WEIGHTS_4[index]);
+		}
+	}
+}
+
+// Decodes one block of in_format into 4x4 RGBA8 texels. BC5 decodes to (R, G, 0, 255)
+inline void decompress_block(const TextureFormat in_format, const uint8_t* in_block, uint8_t* out_block)
+{
+	switch (in_format)
+	{
+		case TextureFormat::BC1:
+			decode_bc1_block(in_block, out_block, true);
+			break;
+		case TextureFormat::BC3:
+			decode_bc1_block(in_block + 8, out_block, false);
+			decode_bc4_block(in_block, out_block + 3, 4);
+			break;
+		case TextureFormat::BC5:
+			for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+			{
+				out_block[texel_idx * 4 + 2] = 0;
+				out_block[texel_idx * 4 + 3] = 255;
+			}
+			decode_bc4_block(in_block, out_block + 0, 4);
+			decode_bc4_block(in_block + 8, out_block + 1, 4);
+			break;
+		case TextureFormat::BC7:
+			decode_bc7_block(in_block, out_block);
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
+
+// Decodes every mip of a block compressed texture back to RGBA8
+inline TextureData decompress_texture(const TextureView& in_texture)
+{
+	assert(is_block_compressed(in_texture.format));
+
+	TextureData texture;
+	texture.width = in_texture.width;
+	texture.height = in_texture.height;
+	texture.srgb = in_texture.srgb;
+	allocate_texture_mips(texture, (uint32_t) in_texture.mips.size());
+
+	const uint32_t block_size = get_texture_block_size(in_texture.format);
+	for (uint32_t mip_idx = 0; mip_idx < texture.mips.size(); ++mip_idx)
+	{
+		const TextureMip& block_mip = in_texture.mips[mip_idx];
+		const TextureMip& mip = texture.mips[mip_idx];
+		const uint8_t* blocks = in_texture.GetMipData(mip_idx).data();
+		uint8_t* texels = texture.GetMipData(mip_idx).data();
+
+		for (uint32_t block_y = 0; block_y < block_mip.row_count; ++block_y)
+		{
+			for (uint32_t block_x = 0; block_x < block_mip.row_size / block_size; ++block_x)
+			{
+				uint8_t block[16 * TEXTURE_BYTES_PER_TEXEL];
+				decompress_block(in_texture.format, blocks + block_y * block_mip.row_size + block_x * block_size, block);
+
+				// Mips smaller than a block only keep the texels that are actually inside them
+				const uint32_t block_width = (std::min)(TEXTURE_BLOCK_DIM, mip.width - block_x * TEXTURE_BLOCK_DIM);
+				const uint32_t block_height = (std::min)(TEXTURE_BLOCK_DIM, mip.height - block_y * TEXTURE_BLOCK_DIM);
+				for (uint32_t y = 0; y < block_height; ++y)
+				{
+					memcpy(
+						texels + (((size_t) block_y * TEXTURE_BLOCK_DIM + y) * mip.width + block_x * TEXTURE_BLOCK_DIM) * TEXTURE_BYTES_PER_TEXEL,
+						block + y * TEXTURE_BLOCK_DIM * TEXTURE_BYTES_PER_TEXEL,
+						block_width * TEXTURE_BYTES_PER_TEXEL
+					);
+				}
+			}
+		}
+	}
+
+	return texture;
+}
+
+// Peak signal-to-noise ratio (dB) between two RGBA8 images of the same size, over the channels set in in_channel_mask (bit 0 = R ... bit 3 = A).
+// Infinite if they're identical
+inline float calculate_psnr(span<const uint8_t> in_reference, span<const uint8_t> in_texels, const uint32_t in_channel_mask = 0xF)
+{
+	assert(in_reference.size() == in_texels.size());
+
+	double squared_error = 0.0;
+	size_t sample_count = 0;
+	for (size_t byte_idx = 0; byte_idx < in_reference.size(); ++byte_idx)
+	{
+		if (in_channel_mask & (1 << (byte_idx % TEXTURE_BYTES_PER_TEXEL)))
+		{
+			const double delta = (double) in_reference[byte_idx] - (double) in_texels[byte_idx];
+			squared_error += delta * delta;
+			++sample_count;
+		}
+	}
+
+	if (squared_error == 0.0 || sample_count == 0)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+	return (float) (10.0 * std::log10(255.0 * 255.0 / (squared_error / sample_count)));
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+using std::optional;
+using std::nullopt;
+using std::span;
+using std::vector;
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_PROCESSING_SSE2 1
+#endif
+
+#include "microprofile/stb/stb_image.h"
+
+/*	CPU texture processing (decoding, mip generation) run while loading a scene. Like MeshProcessing.h, every pass only touches the texture
+	it's given, so they're safe to run on many textures in parallel. Nothing here depends on D3D12, so it can run headless.
+*/
+
+// Decoded textures are always expanded to RGBA8
+static constexpr uint32_t TEXTURE_BYTES_PER_TEXEL = 4;
+
+// Block compressed formats store 4x4 texel blocks
+static constexpr uint32_t TEXTURE_BLOCK_DIM = 4;
+
+enum class TextureFormat : uint32_t
+{
+	RGBA8,
+	BC1,	// RGB + 1-bit alpha, 8 bytes per block
+	BC3,	// RGBA, 16 bytes per block
+	BC5,	// Two channels (RG), 16 bytes per block. Used for normal maps
+	BC7,	// RGBA, 16 bytes per block. Highest quality
+};
+
+inline bool is_block_compressed(const TextureFormat in_format)
+{
+	return in_format != TextureFormat::RGBA8;
+}
+
+// Width and height of the texel blocks a row of texture data holds
+inline uint32_t get_texture_block_dim(const TextureFormat in_format)
+{
+	return is_block_compressed(in_format) ? TEXTURE_BLOCK_DIM : 1;
+}
+
+// Bytes per texel block (per texel for RGBA8)
+inline uint32_t get_texture_block_size(const TextureFormat in_format)
+{
+	switch (in_format)
+	{
+		case TextureFormat::RGBA8:	return TEXTURE_BYTES_PER_TEXEL;
+		case TextureFormat::BC1:	return 8;
+		case TextureFormat::BC3:	return 16;
+		case TextureFormat::BC5:	return 16;
+		case TextureFormat::BC7:	return 16;
+	}
+	assert(false);
+	return 0;
+}
+
+// Size of the linear -> sRGB encode table. Fine enough that the encoded value is off by at most one step of rounding, even near black
+static constexpr uint32_t SRGB_ENCODE_TABLE_SIZE = 1 << 16;
+
+// A single mip level's location in TextureData::data. Rows are tightly packed, and are a row of blocks for block compressed formats
+struct TextureMip
+{
+	uint32_t width;
+	uint32_t height;
+	size_t offset;
+	size_t row_size;
+	uint32_t row_count;
+
+	size_t GetSize() const { return row_size * row_count; }
+};
+
+// Non-owning view of a texture and its mips. Points either into a TextureData or into a mapped texture cache file
+struct TextureView
+{
+	uint32_t width;
+	uint32_t height;
+	TextureFormat format;
+	bool srgb;
+
+	span<const TextureMip> mips;
+	span<const uint8_t> data;
+
+	span<const uint8_t> GetMipData(const size_t in_mip) const
+	{
+		return data.subspan(mips[in_mip].offset, mips[in_mip].GetSize());
+	}
+};
+
+// CPU copy of a texture and all of its mips, back to back in data
+struct TextureData
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	TextureFormat format = TextureFormat::RGBA8;
+
+	// Color textures (base color, emissive) are stored sRGB encoded, everything else (normals, roughness...) is linear data
+	bool srgb = false;
+
+	vector<TextureMip> mips;
+	vector<uint8_t> data;
+
+	TextureView GetView() const
+	{
+		return TextureView {
+			.width = width,
+			.height = height,
+			.format = format,
+			.srgb = srgb,
+			.mips = mips,
+			.data = data,
+		};
+	}
+
+	span<const uint8_t> GetMipData(const size_t in_mip) const
+	{
+		return span<const uint8_t>(data.data() + mips[in_mip].offset, mips[in_mip].GetSize());
+	}
+
+	span<uint8_t> GetMipData(const size_t in_mip)
+	{
+		return span<uint8_t>(data.data() + mips[in_mip].offset, mips[in_mip].GetSize());
+	}
+};
+
+// Number of levels in a full mip chain, down to 1x1
+inline uint32_t calculate_mip_count(const uint32_t in_width, const uint32_t in_height)
+{
+	uint32_t mip_count = 1;
+	for (uint32_t size = (std::max)(in_width, in_height); size > 1; size >>= 1)
+	{
+		++mip_count;
+	}
+	return mip_count;
+}
+
+inline float srgb_to_linear(const float in_value)
+{
+	return in_value <= 0.04045f ? in_value / 12.92f : std::pow((in_value + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float linear_to_srgb(const float in_value)
+{
+	return in_value <= 0.0031308f ? in_value * 12.92f : 1.055f * std::pow(in_value, 1.0f / 2.4f) - 0.055f;
+}
+
+// 8-bit sRGB -> linear float
+inline const std::array<float, 256>& get_srgb_decode_table()
+{
+	static const std::array<float, 256> decode_table = []
+	{
+		std::array<float, 256> table;
+		for (uint32_t value = 0; value < table.size(); ++value)
+		{
+			table[value] = srgb_to_linear(value / 255.0f);
+		}
+		return table;
+	}();
+	return decode_table;
+}
+
+// Linear float (quantized to SRGB_ENCODE_TABLE_SIZE steps) -> 8-bit sRGB
+inline const vector<uint8_t>& get_srgb_encode_table()
+{
+	static const vector<uint8_t> encode_table = []
+	{
+		vector<uint8_t> table(SRGB_ENCODE_TABLE_SIZE);
+		for (uint32_t value = 0; value < SRGB_ENCODE_TABLE_SIZE; ++value)
+		{
+			table[value] = (uint8_t) std::lround(linear_to_srgb(value / (float) (SRGB_ENCODE_TABLE_SIZE - 1)) * 255.0f);
+		}
+		return table;
+	}();
+	return encode_table;
+}
+
+// Sets up in_texture's mip table for in_mip_count levels of its format and sizes its data to match. Level 0's data is left as is
+inline void allocate_texture_mips(TextureData& io_texture, const uint32_t in_mip_count)
+{
+	const uint32_t block_dim = get_texture_block_dim(io_texture.format);
+	const uint32_t block_size = get_texture_block_size(io_texture.format);
+
+	io_texture.mips.clear();
+	size_t offset = 0;
+	for (uint32_t mip_idx = 0; mip_idx < in_mip_count; ++mip_idx)
+	{
+		const uint32_t mip_width = (std::max)(io_texture.width >> mip_idx, 1u);
+		const uint32_t mip_height = (std::max)(io_texture.height >> mip_idx, 1u);
+		io_texture.mips.push_back(TextureMip {
+			.width = mip_width,
+			.height = mip_height,
+			.offset = offset,
+			.row_size = (size_t) (mip_width + block_dim - 1) / block_dim * block_size,
+			.row_count = (mip_height + block_dim - 1) / block_dim,
+		});
+		offset += io_texture.mips.back().GetSize();
+	}
+	io_texture.data.resize(offset);
+}
+
+// Decodes a PNG/JPG/TGA/BMP... image held in memory into a single RGBA8 mip. Returns nullopt if stb_image can't decode it
+inline optional<TextureData> decode_image(span<const uint8_t> in_encoded_data, const bool in_srgb)
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(in_encoded_data.data(), (int) in_encoded_data.size(), &width, &height, &channels, TEXTURE_BYTES_PER_TEXEL);
+	if (!pixels)
+	{
+		return nullopt;
+	}
+
+	TextureData texture;
+	texture.width = (uint32_t) width;
+	texture.height = (uint32_t) height;
+	texture.srgb = in_srgb;
+	allocate_texture_mips(texture, 1);
+	memcpy(texture.data.data(), pixels, texture.data.size());
+	stbi_image_free(pixels);
+	return texture;
+}
+
+inline optional<TextureData> decode_image_file(const char* in_path, const bool in_srgb)
+{
+	FILE* file = fopen(in_path, "rb");
+	if (!file)
+	{
+		return nullopt;
+	}
+
+	vector<uint8_t> encoded_data;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		const long file_size = ftell(file);
+		if (file_size > 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			encoded_data.resize((size_t) file_size);
+			encoded_data.resize(fread(encoded_data.data(), 1, encoded_data.size(), file));
+		}
+	}
+	fclose(file);
+
+	return decode_image(encoded_data, in_srgb);
+}
+
+/*	2x2 box filter reduction of a level held as linear float RGBA, into out_texels (which must hold (in_width / 2) * (in_height / 2) texels, rounded
+	down but at least 1). in_load_texel(x, y, out_rgba) fetches a source texel. Like the mip sizes themselves, odd sizes round down: the last row or
+	column of an odd level isn't sampled. A side that's down to 1 texel clamps, so the other side keeps being averaged
+*/
+template<typename LoadTexel>
+inline void downsample_texels(const uint32_t in_width, const uint32_t in_height, LoadTexel&& in_load_texel, float* out_texels)
+{
+	const uint32_t out_width = (std::max)(in_width >> 1, 1u);
+	const uint32_t out_height = (std::max)(in_height >> 1, 1u);
+	for (uint32_t y = 0; y < out_height; ++y)
+	{
+		const uint32_t y0 = (std::min)(y * 2, in_height - 1);
+		const uint32_t y1 = (std::min)(y * 2 + 1, in_height - 1);
+		for (uint32_t x = 0; x < out_width; ++x)
+		{
+			const uint32_t x0 = (std::min)(x * 2, in_width - 1);
+			const uint32_t x1 = (std::min)(x * 2 + 1, in_width - 1);
+
+			alignas(16) float texels[4][4];
+			in_load_texel(x0, y0, texels[0]);
+			in_load_texel(x1, y0, texels[1]);
+			in_load_texel(x0, y1, texels[2]);
+			in_load_texel(x1, y1, texels[3]);
+
+			float* out_texel = out_texels + ((size_t) y * out_width + x) * 4;
+#if TEXTURE_PROCESSING_SSE2
+			const __m128 sum = _mm_add_ps(
+				_mm_add_ps(_mm_load_ps(texels[0]), _mm_load_ps(texels[1])),
+				_mm_add_ps(_mm_load_ps(texels[2]), _mm_load_ps(texels[3]))
+			);
+			_mm_storeu_ps(out_texel, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				out_texel[channel] = (texels[0][channel] + texels[1][channel] + texels[2][channel] + texels[3][channel]) * 0.25f;
+			}
+#endif
+		}
+	}
+}
+
+// Quantizes a level of linear float RGBA texels to RGBA8, sRGB encoding color channels if in_srgb is set. Alpha is always linear
+inline void encode_texels(span<const float> in_texels, const bool in_srgb, uint8_t* out_texels)
+{
+	const uint8_t* encode_table = get_srgb_encode_table().data();
+	const size_t texel_count = in_texels.size() / 4;
+	for (size_t texel_idx = 0; texel_idx < texel_count; ++texel_idx)
+	{
+		const float* texel = in_texels.data() + texel_idx * 4;
+		uint8_t* out_texel = out_texels + texel_idx * 4;
+#if TEXTURE_PROCESSING_SSE2
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texel), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		alignas(16) int32_t quantized[4];
+		if (in_srgb)
+		{
+			// Color channels index the encode table, alpha is rounded to 8 bits directly
+			const float table_scale = (float) (SRGB_ENCODE_TABLE_SIZE - 1);
+			const __m128 scale = _mm_setr_ps(table_scale, table_scale, table_scale, 255.0f);
+			_mm_store_si128((__m128i*) quantized, _mm_cvtps_epi32(_mm_mul_ps(clamped, scale)));
+			out_texel[0] = encode_table[quantized[0]];
+			out_texel[1] = encode_table[quantized[1]];
+			out_texel[2] = encode_table[quantized[2]];
+			out_texel[3] = (uint8_t) quantized[3];
+		}
+		else
+		{
+			const __m128i quantized_texel = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+			const __m128i packed_texel = _mm_packus_epi16(_mm_packs_epi32(quantized_texel, quantized_texel), _mm_setzero_si128());
+			const int32_t rgba = _mm_cvtsi128_si32(packed_texel);
+			memcpy(out_texel, &rgba, 4);
+		}
+#else
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			const float value = std::clamp(texel[channel], 0.0f, 1.0f);
+			out_texel[channel] = in_srgb && channel < 3
+				? encode_table[std::lround(value * (SRGB_ENCODE_TABLE_SIZE - 1))]
+				: (uint8_t) std::lround(value * 255.0f);
+		}
+#endif
+	}
+}
+
+/*	Fills out the full mip chain below io_texture's level 0 (which must be its only level). Filtering happens in linear space, so sRGB textures
+	are decoded before averaging and re-encoded after, which keeps mips from darkening. Each level is reduced from the previous level's unquantized
+	float texels rather than its RGBA8 result, so rounding error doesn't build up down the chain.
+*/
+inline void generate_mips(TextureData& io_texture)
+{
+	assert(io_texture.mips.size() == 1 && io_texture.format == TextureFormat::RGBA8);
+	const uint32_t mip_count = calculate_mip_count(io_texture.width, io_texture.height);
+	if (mip_count == 1)
+	{
+		return;
+	}
+
+	allocate_texture_mips(io_texture, mip_count);
+
+	const std::array<float, 256>& decode_table = get_srgb_decode_table();
+	const bool srgb = io_texture.srgb;
+
+	// Level 1 is reduced straight from level 0's RGBA8 texels, which saves holding a float copy of the largest level
+	vector<float> source_texels((size_t) io_texture.mips[1].width * io_texture.mips[1].height * 4);
+	vector<float> destination_texels;
+	{
+		const TextureMip& base_mip = io_texture.mips[0];
+		const uint8_t* base_texels = io_texture.data.data();
+		downsample_texels(base_mip.width, base_mip.height, [&](const uint32_t x, const uint32_t y, float* out_rgba)
+		{
+			const uint8_t* texel = base_texels + ((size_t) y * base_mip.width + x) * 4;
+			for (uint32_t channel = 0; channel < 3; ++channel)
+			{
+				out_rgba[channel] = srgb ? decode_table[texel[channel]] : texel[channel] / 255.0f;
+			}
+			out_rgba[3] = texel[3] / 255.0f;
+		}, source_texels.data());
+		encode_texels(source_texels, srgb, io_texture.GetMipData(1).data());
+	}
+
+	for (uint32_t mip_idx = 2; mip_idx < mip_count; ++mip_idx)
+	{
+		const TextureMip& source_mip = io_texture.mips[mip_idx - 1];
+		const TextureMip& mip = io_texture.mips[mip_idx];
+		destination_texels.resize((size_t) mip.width * mip.height * 4);
+
+		const float* source = source_texels.data();
+		downsample_texels(source_mip.width, source_mip.height, [&](const uint32_t x, const uint32_t y, float* out_rgba)
+		{
+			memcpy(out_rgba, source + ((size_t) y * source_mip.width + x) * 4, 4 * sizeof(float));
+		}, destination_texels.data());
+		encode_texels(destination_texels, srgb, io_texture.GetMipData(mip_idx).data());
+
+		std::swap(source_texels, destination_texels);
+	}
+}
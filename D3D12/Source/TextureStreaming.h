@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using std::span;
+using std::vector;
+
+/*	Decides which mips of which textures should be resident. Pure bookkeeping with no GPU dependency: feed it requested mips every frame
+	(from GPU feedback, or a CPU estimate like estimate_requested_mip), call Update, and carry out the changes it returns.
+
+	Every texture has a tail of small mips that is always resident and doesn't count against the budget. Finer mips are streamed in one level at a
+	time, most starved textures first (the ones furthest from the mip they requested). When a load doesn't fit in the budget, mips finer than a
+	texture currently requests are evicted, least recently used texture first. Mips that are being sampled at their requested level are only evicted
+	when the budget shrinks below what's already requested, largest mip first.
+
+	A texture only has one change in flight at a time. The budget counts a change's target mips as soon as it's issued, so while a texture is being
+	swapped to its new mips both copies are briefly allocated.
+*/
+
+struct TextureStreamingDesc
+{
+	// Bytes of streamed (non-tail) mips allowed to be resident
+	uint64_t budget = 256ull * 1024 * 1024;
+
+	// Caps how many loads a single Update issues, which bounds upload bandwidth per frame
+	uint32_t max_loads_per_update = 4;
+};
+
+// Rebuild a texture so its most detailed resident mip is first_mip
+struct TextureStreamingChange
+{
+	uint32_t texture;
+	uint32_t first_mip;
+};
+
+struct TextureStreamingUpdate
+{
+	vector<TextureStreamingChange> loads;
+	vector<TextureStreamingChange> evictions;
+};
+
+struct TextureStreamingPolicy
+{
+	explicit TextureStreamingPolicy(const TextureStreamingDesc& in_desc = {})
+		: m_desc(in_desc)
+	{
+	}
+
+	// in_mip_sizes holds the size of every mip, most detailed first. Mips from in_tail_mip on are always resident. Returns the texture's id
+	uint32_t AddTexture(span<const uint64_t> in_mip_sizes, const uint32_t in_tail_mip)
+	{
+		assert(in_tail_mip < in_mip_sizes.size());
+
+		StreamedTexture texture;
+		texture.mip_sizes.assign(in_mip_sizes.begin(), in_mip_sizes.end());
+		texture.tail_mip = in_tail_mip;
+		texture.resident_mip = in_tail_mip;
+		texture.target_mip = in_tail_mip;
+		texture.requested_mip = in_tail_mip;
+		for (uint32_t mip_idx = in_tail_mip; mip_idx < in_mip_sizes.size(); ++mip_idx)
+		{
+			m_tail_size += in_mip_sizes[mip_idx];
+		}
+
+		m_textures.push_back(std::move(texture));
+		return (uint32_t) m_textures.size() - 1;
+	}
+
+	// Feedback for the current frame. Multiple requests for the same texture keep the most detailed one
+	void RequestMip(const uint32_t in_texture, const uint32_t in_mip)
+	{
+		StreamedTexture& texture = m_textures[in_texture];
+		texture.requested_mip = (std::min)(texture.requested_mip, in_mip);
+	}
+
+	// Issues this frame's loads and evictions, then clears the frame's requests. in_frame only needs to increase between calls
+	TextureStreamingUpdate Update(const uint64_t in_frame)
+	{
+		TextureStreamingUpdate update;
+
+		for (StreamedTexture& texture : m_textures)
+		{
+			if (texture.requested_mip < texture.tail_mip)
+			{
+				texture.last_used_frame = in_frame;
+			}
+		}
+
+		// The budget may have shrunk since the last update. If dropping unused mips isn't enough, even requested mips have to go
+		while (m_used_size > m_desc.budget && (EvictLeastRecentlyUsed(UINT32_MAX, update) || EvictMostDetailed(update))) {}
+
+		// Most starved first, breaking ties in favor of the cheapest load
+		vector<uint32_t> candidates;
+		for (uint32_t texture_idx = 0; texture_idx < m_textures.size(); ++texture_idx)
+		{
+			const StreamedTexture& texture = m_textures[texture_idx];
+			if (!texture.IsInFlight() && texture.requested_mip < texture.resident_mip)
+			{
+				candidates.push_back(texture_idx);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [&](const uint32_t in_lhs, const uint32_t in_rhs)
+		{
+			const StreamedTexture& lhs = m_textures[in_lhs];
+			const StreamedTexture& rhs = m_textures[in_rhs];
+			const uint32_t lhs_deficit = lhs.resident_mip - lhs.requested_mip;
+			const uint32_t rhs_deficit = rhs.resident_mip - rhs.requested_mip;
+			if (lhs_deficit != rhs_deficit)
+			{
+				return lhs_deficit > rhs_deficit;
+			}
+			return lhs.mip_sizes[lhs.resident_mip - 1] < rhs.mip_sizes[rhs.resident_mip - 1];
+		});
+
+		for (const uint32_t texture_idx : candidates)
+		{
+			if (update.loads.size() >= m_desc.max_loads_per_update)
+			{
+				break;
+			}
+
+			StreamedTexture& texture = m_textures[texture_idx];
+			if (texture.IsInFlight())
+			{
+				// Already picked as an eviction victim earlier in this update
+				continue;
+			}
+
+			const uint32_t load_mip = texture.resident_mip - 1;
+			const uint64_t load_size = texture.mip_sizes[load_mip];
+			while (m_used_size + load_size > m_desc.budget && EvictLeastRecentlyUsed(texture_idx, update)) {}
+			if (m_used_size + load_size > m_desc.budget)
+			{
+				// Nothing left to evict for this one, but a smaller load further down may still fit
+				continue;
+			}
+
+			texture.target_mip = load_mip;
+			m_used_size += load_size;
+			update.loads.push_back(TextureStreamingChange { .texture = texture_idx, .first_mip = load_mip });
+		}
+
+		for (StreamedTexture& texture : m_textures)
+		{
+			texture.requested_mip = texture.tail_mip;
+		}
+
+		return update;
+	}
+
+	// A change returned by Update has been carried out, and the texture is now sampled with its new mips
+	void OnChangeComplete(const uint32_t in_texture)
+	{
+		StreamedTexture& texture = m_textures[in_texture];
+		assert(texture.IsInFlight());
+		texture.resident_mip = texture.target_mip;
+	}
+
+	void SetBudget(const uint64_t in_budget) { m_desc.budget = in_budget; }
+	uint64_t GetBudget() const { return m_desc.budget; }
+
+	// Bytes of streamed mips that are resident or on their way. <= GetBudget() after Update, unless changes still in flight hold more
+	uint64_t GetUsedSize() const { return m_used_size; }
+
+	// Bytes of always resident tail mips
+	uint64_t GetTailSize() const { return m_tail_size; }
+
+	size_t GetTextureCount() const { return m_textures.size(); }
+	uint32_t GetResidentMip(const uint32_t in_texture) const { return m_textures[in_texture].resident_mip; }
+	uint32_t GetTargetMip(const uint32_t in_texture) const { return m_textures[in_texture].target_mip; }
+	uint32_t GetTailMip(const uint32_t in_texture) const { return m_textures[in_texture].tail_mip; }
+	bool IsInFlight(const uint32_t in_texture) const { return m_textures[in_texture].IsInFlight(); }
+
+protected:
+	struct StreamedTexture
+	{
+		vector<uint64_t> mip_sizes;
+		uint32_t tail_mip = 0;
+
+		// Most detailed mip currently sampled, and the one it's being changed to (equal unless a change is in flight)
+		uint32_t resident_mip = 0;
+		uint32_t target_mip = 0;
+
+		// Most detailed mip requested this frame
+		uint32_t requested_mip = 0;
+		uint64_t last_used_frame = 0;
+
+		bool IsInFlight() const { return resident_mip != target_mip; }
+	};
+
+	/*	Evicts every mip finer than requested from the least recently used texture that has any, skipping in_protected_texture.
+		Returns false if there's nothing left to evict
+	*/
+	bool EvictLeastRecentlyUsed(const uint32_t in_protected_texture, TextureStreamingUpdate& io_update)
+	{
+		uint32_t victim_idx = UINT32_MAX;
+		for (uint32_t texture_idx = 0; texture_idx < m_textures.size(); ++texture_idx)
+		{
+			const StreamedTexture& texture = m_textures[texture_idx];
+			if (texture_idx == in_protected_texture || texture.IsInFlight() || texture.resident_mip >= texture.requested_mip)
+			{
+				continue;
+			}
+
+			if (victim_idx == UINT32_MAX || texture.last_used_frame < m_textures[victim_idx].last_used_frame)
+			{
+				victim_idx = texture_idx;
+			}
+		}
+
+		if (victim_idx == UINT32_MAX)
+		{
+			return false;
+		}
+
+		StreamedTexture& victim = m_textures[victim_idx];
+		for (uint32_t mip_idx = victim.resident_mip; mip_idx < victim.requested_mip; ++mip_idx)
+		{
+			m_used_size -= victim.mip_sizes[mip_idx];
+		}
+		victim.target_mip = victim.requested_mip;
+		io_update.evictions.push_back(TextureStreamingChange { .texture = victim_idx, .first_mip = victim.target_mip });
+		return true;
+	}
+
+	// Drops the single largest resident streamed mip, requested or not. Returns false if there's nothing left to evict
+	bool EvictMostDetailed(TextureStreamingUpdate& io_update)
+	{
+		uint32_t victim_idx = UINT32_MAX;
+		for (uint32_t texture_idx = 0; texture_idx < m_textures.size(); ++texture_idx)
+		{
+			const StreamedTexture& texture = m_textures[texture_idx];
+			if (texture.IsInFlight() || texture.resident_mip >= texture.tail_mip)
+			{
+				continue;
+			}
+
+			if (victim_idx == UINT32_MAX || texture.mip_sizes[texture.resident_mip] > m_textures[victim_idx].mip_sizes[m_textures[victim_idx].resident_mip])
+			{
+				victim_idx = texture_idx;
+			}
+		}
+
+		if (victim_idx == UINT32_MAX)
+		{
+			return false;
+		}
+
+		StreamedTexture& victim = m_textures[victim_idx];
+		m_used_size -= victim.mip_sizes[victim.resident_mip];
+		victim.target_mip = victim.resident_mip + 1;
+		io_update.evictions.push_back(TextureStreamingChange { .texture = victim_idx, .first_mip = victim.target_mip });
+		return true;
+	}
+
+	TextureStreamingDesc m_desc;
+	vector<StreamedTexture> m_textures;
+	uint64_t m_used_size = 0;
+	uint64_t m_tail_size = 0;
+};
+
+/*	CPU feedback: the mip a texture of in_texture_size texels needs when it's stretched over in_screen_size pixels, assuming its UVs span the
+	surface once. Negative in_mip_bias asks for sharper mips, which makes up for textures that repeat across a surface
+*/
+inline uint32_t estimate_requested_mip(const uint32_t in_texture_size, const float in_screen_size, const float in_mip_bias, const uint32_t in_mip_count)
+{
+	if (in_screen_size <= 0.0f)
+	{
+		return in_mip_count - 1;
+	}
+
+	const float mip = std::log2((float) in_texture_size / in_screen_size) + in_mip_bias;
+	return (uint32_t) std::clamp(std::floor(mip), 0.0f, (float) (in_mip_count - 1));
+}
@@ -22,8 +22,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -142,6 +145,66 @@ public:
 		return result;
     }
 
+	// Calls fn(index) for every index in [0, count) and blocks until all calls have returned.
+	// The calling thread also processes indices, so this is safe to call from within a pool task.
+	template<typename F>
+	void ParallelFor(size_t count, F&& fn)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		struct ParallelForState
+		{
+			std::function<void(size_t)> fn;
+			size_t count = 0;
+			std::atomic<size_t> next_index = 0;
+			std::atomic<size_t> completed = 0;
+			std::mutex mutex;
+			std::condition_variable done;
+		};
+
+		// Helper tasks may start after we've returned (and find nothing left to do), so they share ownership of the state
+		auto state = std::make_shared<ParallelForState>();
+		state->fn = std::forward<F>(fn);
+		state->count = count;
+
+		auto run = [](ParallelForState& state)
+		{
+			size_t num_completed = 0;
+			for (size_t index = state.next_index++; index < state.count; index = state.next_index++)
+			{
+				state.fn(index);
+				++num_completed;
+			}
+
+			if (num_completed > 0 && state.completed.fetch_add(num_completed) + num_completed == state.count)
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.done.notify_all();
+			}
+		};
+
+		const size_t num_helpers = (std::min)(threads_.size(), count - 1);
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex_);
+			assert(running_);
+			for (size_t helper_idx = 0; helper_idx < num_helpers; ++helper_idx)
+			{
+				task_queue_.emplace_back([state, run] { run(*state); }, TaskShutdownBehavior::SkipOnShutdown);
+			}
+		}
+		not_empty_.notify_all();
+
+		run(*state);
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state] { return state->completed == state->count; });
+	}
+
+	size_t GetThreadCount() const { return threads_.size(); }
+
 private:
     void RunInThread()
 	{
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+
+using std::unique_ptr;
+using std::vector;
+
+struct TransientResourceStats
+{
+	// Acquires served from the pool (hits) and acquires that had to create a resource (allocations)
+	uint64_t acquire_count = 0;
+	uint64_t hit_count = 0;
+	uint64_t allocation_count = 0;
+	uint64_t eviction_count = 0;
+
+	// Resources the pool currently holds, whether a frame is using them or not
+	size_t pooled_count = 0;
+
+	// Bytes handed out by hits, each of which would have been a new allocation without the pool, and bytes allocated on misses
+	uint64_t hit_bytes = 0;
+	uint64_t allocated_bytes = 0;
+
+	// Bytes the pool currently holds, and the most it has held at once
+	uint64_t pooled_bytes = 0;
+	uint64_t peak_pooled_bytes = 0;
+
+	uint64_t GetMissCount() const { return acquire_count - hit_count; }
+	float GetHitRate() const { return acquire_count > 0 ? (float) hit_count / (float) acquire_count : 0.0f; }
+
+	// Bytes every acquire would have allocated without the pool
+	uint64_t GetAcquiredBytes() const { return hit_bytes + allocated_bytes; }
+};
+
+// One line report of in_stats, e.g. when the app shuts down
+inline void print_transient_resource_stats(const char* in_name, const TransientResourceStats& in_stats)
+{
+	constexpr double megabyte = 1024.0 * 1024.0;
+	printf(
+		"%s: %llu acquires, %llu hits, %llu misses (%.1f%% hit rate), %llu evictions. Allocated %.2f MB of the %.2f MB acquired (%.2f MB saved), pooled %.2f MB (peak %.2f MB)\n",
+		in_name,
+		(unsigned long long) in_stats.acquire_count,
+		(unsigned long long) in_stats.hit_count,
+		(unsigned long long) in_stats.GetMissCount(),
+		in_stats.GetHitRate() * 100.0f,
+		(unsigned long long) in_stats.eviction_count,
+		in_stats.allocated_bytes / megabyte,
+		in_stats.GetAcquiredBytes() / megabyte,
+		in_stats.hit_bytes / megabyte,
+		in_stats.pooled_bytes / megabyte,
+		in_stats.peak_pooled_bytes / megabyte
+	);
+}
+
+/*	Matching and eviction for TransientResourcePool, kept free of D3D12 so it can be tested headlessly.
+	Resources are keyed by a description (Key, compared with ==) and a hash of it. A resource acquired for frame F stays in use until
+	F's fence has completed, after which Acquire can hand it to a later frame asking for an equal key. Frame indices are fence values,
+	and must only ever increase.
+	Evict drops resources no frame has acquired for more than in_max_unused_frames frames.
+	Entries are heap allocated, so a pointer to one stays valid until it's evicted. Not thread-safe.
+*/
+template<typename Key, typename Resource>
+struct TransientResourceCache
+{
+	struct Entry
+	{
+		Key key;
+		Resource resource;
+
+		// Memory the resource takes up, as given to Add
+		uint64_t size = 0;
+
+		// Last frame to acquire this entry, which uses it until that frame's fence completes
+		uint64_t last_used_frame_index = 0;
+	};
+
+	explicit TransientResourceCache(const uint64_t in_max_unused_frames)
+		: m_max_unused_frames(in_max_unused_frames)
+	{}
+
+	DISALLOW_COPY(TransientResourceCache);
+	DEFAULT_MOVE(TransientResourceCache);
+
+	// Claims an entry matching in_key for in_frame_index, out of those no frame after in_completed_frame_index is using.
+	// Entries in_frame_index has already acquired are in use however far the fence has got (e.g. both at frame 0, before anything is signalled).
+	// Returns nullptr on a miss, in which case the caller creates the resource and hands it to Add
+	Entry* Acquire(const uint64_t in_hash, const Key& in_key, const uint64_t in_frame_index, const uint64_t in_completed_frame_index)
+	{
+		++m_stats.acquire_count;
+
+		auto found_bucket = m_buckets.find(in_hash);
+		if (found_bucket == m_buckets.end())
+		{
+			return nullptr;
+		}
+
+		for (unique_ptr<Entry>& entry : found_bucket->second)
+		{
+			const bool is_in_flight = entry->last_used_frame_index >= in_frame_index || entry->last_used_frame_index > in_completed_frame_index;
+			if (!is_in_flight && entry->key == in_key)
+			{
+				entry->last_used_frame_index = in_frame_index;
+				++m_stats.hit_count;
+				m_stats.hit_bytes += entry->size;
+				return entry.get();
+			}
+		}
+		return nullptr;
+	}
+
+	// Adds a resource of in_size bytes created after Acquire missed, claimed for in_frame_index
+	Entry* Add(const uint64_t in_hash, const Key& in_key, Resource&& in_resource, const uint64_t in_size, const uint64_t in_frame_index)
+	{
+		++m_stats.allocation_count;
+		++m_stats.pooled_count;
+		m_stats.allocated_bytes += in_size;
+		m_stats.pooled_bytes += in_size;
+		m_stats.peak_pooled_bytes = (std::max)(m_stats.peak_pooled_bytes, m_stats.pooled_bytes);
+
+		vector<unique_ptr<Entry>>& bucket = m_buckets[in_hash];
+		bucket.push_back(std::make_unique<Entry>(Entry {
+			.key = in_key,
+			.resource = std::move(in_resource),
+			.size = in_size,
+			.last_used_frame_index = in_frame_index,
+		}));
+		return bucket.back().get();
+	}
+
+	// Calls in_on_evict on each entry last acquired before in_frame_index - max unused frames (and whose frame has completed), then destroys it.
+	// Returns how many were evicted
+	template<typename OnEvict>
+	size_t Evict(const uint64_t in_frame_index, const uint64_t in_completed_frame_index, OnEvict&& in_on_evict)
+	{
+		size_t evicted_count = 0;
+		vector<uint64_t> empty_buckets;
+		for (auto& [hash, bucket] : m_buckets)
+		{
+			for (size_t entry_idx = 0; entry_idx < bucket.size();)
+			{
+				Entry& entry = *bucket[entry_idx];
+				const bool is_complete = entry.last_used_frame_index <= in_completed_frame_index;
+				const bool is_unused = entry.last_used_frame_index + m_max_unused_frames < in_frame_index;
+				if (is_complete && is_unused)
+				{
+					in_on_evict(entry);
+					m_stats.pooled_bytes -= entry.size;
+					bucket[entry_idx] = std::move(bucket.back());
+					bucket.pop_back();
+					++evicted_count;
+				}
+				else
+				{
+					++entry_idx;
+				}
+			}
+
+			if (bucket.empty())
+			{
+				empty_buckets.push_back(hash);
+			}
+		}
+
+		for (const uint64_t hash : empty_buckets)
+		{
+			m_buckets.erase(hash);
+		}
+
+		m_stats.eviction_count += evicted_count;
+		m_stats.pooled_count -= evicted_count;
+		return evicted_count;
+	}
+
+	size_t Evict(const uint64_t in_frame_index, const uint64_t in_completed_frame_index)
+	{
+		return Evict(in_frame_index, in_completed_frame_index, [](Entry&) {});
+	}
+
+	const TransientResourceStats& GetStats() const { return m_stats; }
+	uint64_t GetMaxUnusedFrames() const { return m_max_unused_frames; }
+
+protected:
+	uint64_t m_max_unused_frames = 0;
+
+	// Entries keyed by the hash of their key. Entries with colliding hashes but different keys share a bucket
+	HashMap<uint64_t, vector<unique_ptr<Entry>>> m_buckets;
+
+	TransientResourceStats m_stats;
+};
@@ -3,15 +3,18 @@
 #include <vector>
 
 #include "GpuResources.h"
+#include "UploadManager.h"
 #include "SimpleMath/SimpleMath.h"
 using namespace DirectX::SimpleMath;
 #include "../Shaders/HLSL_Types.h"
+#include "VertexStreams.h"
 
 struct UVSphereDesc
 {
-	ComPtr<ID3D12Device5> device;
-	D3D12MA::Allocator* allocator;
-	ComPtr<ID3D12CommandQueue> command_queue;
+	GeometryPool* geometry_pool;
+
+	// Uploads the geometry. Nothing waits for it on the CPU, see UVSphere::upload_ticket
+	UploadManager* upload_manager;
 
 	float radius;
 	int latitudes;
@@ -20,24 +23,20 @@ struct UVSphereDesc
 
 struct UVSphere
 {
-	GpuBuffer vertex_buffer;
+	// Split vertex streams (see VertexAttributes) followed by 32-bit indices, all in one geometry pool allocation
+	GeometryAllocation geometry;
+	uint32_t geometry_buffer_index;
+	uint32_t position_offset;
+	uint32_t attribute_offset;
 	uint32_t vertices_count;
-	GpuBuffer index_buffer;
+	uint32_t index_offset;
 	uint32_t indices_count;
 
+	// Geometry is resident once this completes. Wait on it (UploadManager::WaitOnQueue) before drawing the sphere
+	UploadTicket upload_ticket;
+
 	UVSphere(const UVSphereDesc& desc)
 	{
-		// Set up command allocator/list for staging buffer copies
-		ComPtr<ID3D12CommandAllocator> command_allocator;
-		HR_CHECK(desc.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&command_allocator)));
-
-		ComPtr<ID3D12GraphicsCommandList> command_list;
-		HR_CHECK(desc.device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, command_allocator.Get(), nullptr, IID_PPV_ARGS(&command_list)));
-		HR_CHECK(command_list->Close());
-		HR_CHECK(command_list->Reset(command_allocator.Get(), nullptr));
-
-		vector<BufferUploadResult> pending_uploads;
-
 		vector<Vertex> vertices;
 		vector<uint32_t> indices;
 
@@ -114,74 +113,30 @@ struct UVSphere
 			}
 		}
 
-		{
-			size_t vertex_buffer_size = vertices.size() * sizeof(Vertex);
-			const BufferUploadData vertex_upload_data =
-			{
-				.buffer_desc =
-				{
-					.allocator = desc.allocator,
-					.size = vertex_buffer_size,
-					.heap_type = D3D12_HEAP_TYPE_DEFAULT,
-					.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-					.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
-				},
-				.buffer_data = vertices.data(),
-				.buffer_data_size = vertex_buffer_size,
-			};
-
-			const BufferUploadDesc vertex_buffer_upload_desc =
-			{
-				.device = desc.device,
-				.allocator = desc.allocator,
-				.command_list = command_list,
-				.upload_data = vertex_upload_data,
-			};
-
-			BufferUploadResult vertex_upload_result = staging_upload_helper(vertex_buffer_upload_desc);
-			vertex_buffer = vertex_upload_result.result_buffer;
-			vertices_count = (uint32_t) vertices.size();
-
-			pending_uploads.push_back(vertex_upload_result);
-		}
-
-		{
-			size_t index_buffer_size = indices.size() * sizeof(uint32_t);
-			const BufferUploadData index_upload_data =
-			{
-				.buffer_desc =
-				{
-					.allocator = desc.allocator,
-					.size = index_buffer_size,
-					.heap_type = D3D12_HEAP_TYPE_DEFAULT,
-					.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-					.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
-				},
-				.buffer_data = indices.data(),
-				.buffer_data_size = index_buffer_size,
-			};
-
-			const BufferUploadDesc index_buffer_upload_desc =
-			{
-				.device = desc.device,
-				.allocator = desc.allocator,
-				.command_list = command_list,
-				.upload_data = index_upload_data,
-			};
-
-			BufferUploadResult index_upload_result = staging_upload_helper(index_buffer_upload_desc);
-			index_buffer = index_upload_result.result_buffer;
-			indices_count = (uint32_t) indices.size();
-
-			pending_uploads.push_back(index_upload_result);
-		}
-
-		HR_CHECK(command_list->Close());
-		ID3D12CommandList* ppCommandLists[] = { command_list.Get() };
-		desc.command_queue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-		wait_gpu_idle(desc.device, desc.command_queue);
-		pending_uploads.clear();
+		const VertexStreams streams = split_vertex_streams(vertices);
+		const size_t positions_size = streams.positions.size() * sizeof(float3);
+		const size_t attributes_size = streams.attributes.size() * sizeof(VertexAttributes);
+		const size_t indices_size = indices.size() * sizeof(uint32_t);
+
+		// Packed the same way as our geometry pool allocation, so it goes up in a single copy
+		const size_t attributes_start = align_up(positions_size, GEOMETRY_POOL_ALIGNMENT);
+		const size_t indices_start = align_up(attributes_start + attributes_size, GEOMETRY_POOL_ALIGNMENT);
+		const size_t geometry_size = indices_start + indices_size;
+
+		vector<uint8_t> geometry_data(geometry_size, 0);
+		memcpy(geometry_data.data(), streams.positions.data(), positions_size);
+		memcpy(geometry_data.data() + attributes_start, streams.attributes.data(), attributes_size);
+		memcpy(geometry_data.data() + indices_start, indices.data(), indices_size);
+
+		geometry = desc.geometry_pool->Allocate(geometry_size);
+		upload_ticket = desc.upload_manager->Upload(desc.geometry_pool->GetPageBuffer(geometry.page_index), geometry.offset, geometry_data.data(), geometry_size);
+
+		geometry_buffer_index = desc.geometry_pool->GetPageBindlessIndex(geometry.page_index);
+		position_offset = (uint32_t) geometry.offset;
+		attribute_offset = (uint32_t) (geometry.offset + attributes_start);
+		vertices_count = (uint32_t) vertices.size();
+		index_offset = (uint32_t) (geometry.offset + indices_start);
+		indices_count = (uint32_t) indices.size();
 	}
 	
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+// Names a set of uploads by the copy queue fence value that signals once they've all landed. Invalid tickets have nothing to wait for
+struct UploadTicket
+{
+	uint64_t fence_value = 0;
+
+	bool IsValid() const { return fence_value != 0; }
+};
+
+/*	Batching policy and fence bookkeeping for UploadManager, kept free of D3D12 so it can be driven by a mock queue.
+	Copies are recorded into one batch at a time (the open batch), out of in_batch_count that are reused round robin. A batch is submitted
+	once it holds in_batch_size bytes of copies (or when flushed), signalling the next fence value, and the following batch opens.
+	A batch can only be reopened once the fence of its previous submission has completed, since its command list may still be executing.
+	Not thread-safe.
+*/
+struct UploadBatcher
+{
+	struct Submission
+	{
+		size_t batch_index = 0;
+		uint64_t fence_value = 0;
+	};
+
+	UploadBatcher(const size_t in_batch_count, const size_t in_batch_size)
+		: m_batch_size(in_batch_size)
+		, m_batch_fence_values(in_batch_count, 0)
+	{
+		assert(in_batch_count > 0 && in_batch_size > 0);
+	}
+
+	// Records in_size bytes of copies into the open batch, which must have room for them. Returns the ticket they complete with
+	UploadTicket Record(const size_t in_size)
+	{
+		assert(in_size <= GetOpenBatchSpace());
+		m_open_batch_size += in_size;
+		return UploadTicket { .fence_value = m_last_submitted_fence_value + 1 };
+	}
+
+	// Closes the open batch and opens the next one. The caller executes the returned batch and signals its fence value.
+	// The next batch must not be recorded into until GetOpenBatchReuseFenceValue has completed
+	Submission Submit()
+	{
+		const Submission submission = {
+			.batch_index = m_open_batch_index,
+			.fence_value = ++m_last_submitted_fence_value,
+		};
+		m_batch_fence_values[m_open_batch_index] = submission.fence_value;
+
+		m_open_batch_index = (m_open_batch_index + 1) % m_batch_fence_values.size();
+		m_open_batch_size = 0;
+		return submission;
+	}
+
+	size_t GetOpenBatchIndex() const { return m_open_batch_index; }
+	size_t GetOpenBatchSize() const { return m_open_batch_size; }
+	size_t GetOpenBatchSpace() const { return m_batch_size - m_open_batch_size; }
+	bool IsOpenBatchEmpty() const { return m_open_batch_size == 0; }
+	bool IsOpenBatchFull() const { return m_open_batch_size == m_batch_size; }
+
+	// Fence value of the open batch's previous submission (0 if it hasn't had one), which has to complete before it can be recorded into
+	uint64_t GetOpenBatchReuseFenceValue() const { return m_batch_fence_values[m_open_batch_index]; }
+
+	// Completes once everything recorded so far has landed, including the open batch once it's submitted
+	UploadTicket GetPendingTicket() const
+	{
+		return UploadTicket { .fence_value = IsOpenBatchEmpty() ? m_last_submitted_fence_value : m_last_submitted_fence_value + 1 };
+	}
+
+	// True once in_ticket's batch has been submitted, i.e. a queue can wait on it without waiting on a fence value nobody has signalled yet
+	bool IsSubmitted(const UploadTicket in_ticket) const { return in_ticket.fence_value <= m_last_submitted_fence_value; }
+
+	uint64_t GetLastSubmittedFenceValue() const { return m_last_submitted_fence_value; }
+	size_t GetBatchSize() const { return m_batch_size; }
+	size_t GetBatchCount() const { return m_batch_fence_values.size(); }
+
+protected:
+	size_t m_batch_size = 0;
+	size_t m_open_batch_index = 0;
+	size_t m_open_batch_size = 0;
+	uint64_t m_last_submitted_fence_value = 0;
+
+	// Fence value of each batch's last submission
+	vector<uint64_t> m_batch_fence_values;
+};
+
+/*	Allocates staging memory for a copy into the open batch. in_allocate(in_size, in_alignment) returns an optional allocation. If it fails, the
+	staging ring is full of copies that haven't been submitted yet, so in_submit_batch() submits the open batch and the allocation is retried once.
+	With everything submitted, a blocking ring can always wait its way to room for anything up to its capacity
+*/
+template<typename AllocateFunction, typename SubmitFunction>
+auto allocate_or_submit(const size_t in_size, const size_t in_alignment, AllocateFunction&& in_allocate, SubmitFunction&& in_submit_batch)
+{
+	auto allocation = in_allocate(in_size, in_alignment);
+	if (!allocation)
+	{
+		in_submit_batch();
+		allocation = in_allocate(in_size, in_alignment);
+	}
+	assert(allocation);
+	return *allocation;
+}
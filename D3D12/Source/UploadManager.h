@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "Common.h"
+#include "GpuResources.h"
+#include "StreamingCopy.h"
+#include "UploadBatcher.h"
+#include "UploadRing.h"
+
+using std::vector;
+
+// Number of copy batches the staging budget is split into. One batch records while the others are in flight on the copy queue
+static constexpr size_t UPLOAD_MANAGER_BATCH_COUNT = 4;
+
+// Smallest batch we'll split a staging budget into, regardless of how small the budget is
+static constexpr size_t UPLOAD_MANAGER_MIN_BATCH_SIZE = 64 * 1024;
+
+/*	Uploads buffers and textures on a copy queue, shared by everything that streams data to the GPU.
+	Staging memory comes from an UploadRing the size of the staging budget, so peak staging memory is capped by the budget rather than by
+	the total upload size. Copies are recorded into batches of their own copy command list (see UploadBatcher), each submitted as soon as
+	it has recorded a batch's worth of staging memory (or on Flush), signalling the ring's fence. Uploads larger than a batch are split across batches.
+
+	Every upload returns an UploadTicket. Poll it with IsComplete, or have another queue wait for it on the GPU with WaitOnQueue, which is how
+	the direct queue should wait for data it's about to read. WaitForTicket blocks the CPU, and is only meant for shutdown and loading threads.
+
+	Thread-safe. Uploads from different threads are serialized, including their copies into staging memory.
+	An upload blocks while the ring is full of batches the copy queue hasn't finished
+*/
+struct UploadManager
+{
+	UploadManager(ComPtr<ID3D12Device5> in_device, D3D12MA::Allocator* in_allocator, ComPtr<ID3D12CommandQueue> in_command_queue, const size_t in_staging_budget)
+		: m_command_queue(in_command_queue)
+		, m_batcher(UPLOAD_MANAGER_BATCH_COUNT, (std::max)(in_staging_budget / UPLOAD_MANAGER_BATCH_COUNT, UPLOAD_MANAGER_MIN_BATCH_SIZE))
+		, m_ring(in_device, in_allocator, m_batcher.GetBatchSize() * UPLOAD_MANAGER_BATCH_COUNT, UploadRingFullBehavior::Block)
+	{
+		m_batches.resize(UPLOAD_MANAGER_BATCH_COUNT);
+		for (CopyBatch& batch : m_batches)
+		{
+			HR_CHECK(in_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&batch.command_allocator)));
+			HR_CHECK(in_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, batch.command_allocator.Get(), nullptr, IID_PPV_ARGS(&batch.command_list)));
+			HR_CHECK(batch.command_list->Close());
+		}
+
+		BeginBatch();
+	}
+
+	~UploadManager()
+	{
+		// Command lists must outlive any copies still reading them. The ring waits on its own staging memory
+		WaitForTicket(Flush());
+	}
+
+	DISALLOW_COPY(UploadManager);
+
+	// Queues a copy of in_data_size bytes from in_data to in_dest_offset in in_dest.
+	// in_data only needs to stay valid for the duration of this call
+	UploadTicket Upload(GpuBuffer& in_dest, const size_t in_dest_offset, const void* in_data, const size_t in_data_size)
+	{
+		std::lock_guard scope_lock(m_mutex);
+
+		const uint8_t* data = static_cast<const uint8_t*>(in_data);
+		UploadTicket ticket = m_batcher.GetPendingTicket();
+		size_t uploaded_size = 0;
+		while (uploaded_size < in_data_size)
+		{
+			if (m_batcher.IsOpenBatchFull())
+			{
+				SubmitBatch();
+			}
+
+			const size_t copy_size = (std::min)(in_data_size - uploaded_size, m_batcher.GetOpenBatchSpace());
+			const UploadAllocation staging = AllocateStaging(copy_size, 1);
+			streaming_memcpy(staging.data, data + uploaded_size, copy_size);
+			GetOpenCommandList()->CopyBufferRegion(
+				in_dest.GetResource(), in_dest_offset + uploaded_size,
+				staging.resource, staging.offset,
+				copy_size
+			);
+
+			ticket = m_batcher.Record(copy_size);
+			uploaded_size += copy_size;
+		}
+		return ticket;
+	}
+
+	/*	Queues a copy into one subresource of in_dest. in_data holds in_row_count tightly packed rows of in_row_size bytes, where a row is one texel high,
+		or in_block_dim texels high for block compressed formats. Rows are re-pitched to D3D12's alignment rules as they're copied into staging memory,
+		and subresources too big for a single batch are split into bands of rows. in_data only needs to stay valid for the duration of this call
+	*/
+	UploadTicket UploadTexture(
+		GpuTexture& in_dest, const uint32_t in_subresource, const uint32_t in_width,
+		const void* in_data, const size_t in_row_size, const uint32_t in_row_count, const uint32_t in_block_dim = 1)
+	{
+		std::lock_guard scope_lock(m_mutex);
+
+		const uint8_t* data = static_cast<const uint8_t*>(in_data);
+		const size_t row_pitch = align_up(in_row_size, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+		assert(row_pitch <= m_batcher.GetBatchSize());
+
+		UploadTicket ticket = m_batcher.GetPendingTicket();
+		uint32_t uploaded_rows = 0;
+		while (uploaded_rows < in_row_count)
+		{
+			if (m_batcher.GetOpenBatchSpace() < row_pitch)
+			{
+				SubmitBatch();
+			}
+
+			const uint32_t band_rows = (uint32_t) (std::min)((size_t) (in_row_count - uploaded_rows), m_batcher.GetOpenBatchSpace() / row_pitch);
+			const UploadAllocation staging = AllocateStaging(band_rows * row_pitch, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+			for (uint32_t row_idx = 0; row_idx < band_rows; ++row_idx)
+			{
+				streaming_memcpy(
+					staging.data + row_idx * row_pitch,
+					data + (size_t) (uploaded_rows + row_idx) * in_row_size,
+					in_row_size
+				);
+			}
+
+			D3D12_TEXTURE_COPY_LOCATION source_location = {};
+			source_location.pResource = staging.resource;
+			source_location.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			source_location.PlacedFootprint.Offset = staging.offset;
+			source_location.PlacedFootprint.Footprint = {
+				.Format = in_dest.GetFormat(),
+				.Width = (UINT) align_up(in_width, in_block_dim),
+				.Height = band_rows * in_block_dim,
+				.Depth = 1,
+				.RowPitch = (UINT) row_pitch,
+			};
+
+			D3D12_TEXTURE_COPY_LOCATION dest_location = {};
+			dest_location.pResource = in_dest.GetResource();
+			dest_location.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			dest_location.SubresourceIndex = in_subresource;
+
+			GetOpenCommandList()->CopyTextureRegion(&dest_location, 0, uploaded_rows * in_block_dim, 0, &source_location, nullptr);
+
+			ticket = m_batcher.Record(band_rows * row_pitch);
+			uploaded_rows += band_rows;
+		}
+		return ticket;
+	}
+
+	// Submits the open batch if it holds any copies. Returns a ticket for everything queued so far, by any thread
+	UploadTicket Flush()
+	{
+		std::lock_guard scope_lock(m_mutex);
+		if (!m_batcher.IsOpenBatchEmpty())
+		{
+			SubmitBatch();
+		}
+		return m_batcher.GetPendingTicket();
+	}
+
+	// Completes once everything queued so far (by any thread) has landed. The open batch still needs a Flush (or to fill up) to get there
+	UploadTicket GetPendingTicket() const
+	{
+		std::lock_guard scope_lock(m_mutex);
+		return m_batcher.GetPendingTicket();
+	}
+
+	bool IsComplete(const UploadTicket in_ticket) const { return m_ring.IsComplete(in_ticket.fence_value); }
+
+	// True if the copy queue has finished everything submitted, i.e. it's sitting idle waiting on us
+	bool IsIdle() const
+	{
+		std::lock_guard scope_lock(m_mutex);
+		return m_ring.IsComplete(m_batcher.GetLastSubmittedFenceValue());
+	}
+
+	// GPU-side wait: work submitted to in_command_queue after this call doesn't start until in_ticket's uploads have landed.
+	// Submits in_ticket's batch first if it's still open
+	void WaitOnQueue(ID3D12CommandQueue* in_command_queue, const UploadTicket in_ticket)
+	{
+		if (!in_ticket.IsValid())
+		{
+			return;
+		}
+
+		std::lock_guard scope_lock(m_mutex);
+		if (!m_batcher.IsSubmitted(in_ticket))
+		{
+			SubmitBatch();
+		}
+		m_ring.QueueWait(in_command_queue, in_ticket.fence_value);
+	}
+
+	// Blocks the calling thread until in_ticket's uploads have landed, submitting its batch first if it's still open
+	void WaitForTicket(const UploadTicket in_ticket)
+	{
+		{
+			std::lock_guard scope_lock(m_mutex);
+			if (!m_batcher.IsSubmitted(in_ticket))
+			{
+				SubmitBatch();
+			}
+		}
+		m_ring.WaitForFence(in_ticket.fence_value);
+	}
+
+	size_t GetStagingBudget() const { return m_ring.GetCapacity(); }
+
+protected:
+	struct CopyBatch
+	{
+		ComPtr<ID3D12CommandAllocator> command_allocator;
+		ComPtr<ID3D12GraphicsCommandList> command_list;
+	};
+
+	ID3D12GraphicsCommandList* GetOpenCommandList() { return m_batches[m_batcher.GetOpenBatchIndex()].command_list.Get(); }
+
+	// Batches never record more than a batch's worth of bytes and the ring holds UPLOAD_MANAGER_BATCH_COUNT of them,
+	// so once the open batch is submitted the ring can always block its way to room
+	UploadAllocation AllocateStaging(const size_t in_size, const size_t in_alignment)
+	{
+		return allocate_or_submit(in_size, in_alignment,
+			[this](const size_t in_allocation_size, const size_t in_allocation_alignment) { return m_ring.Allocate(in_allocation_size, in_allocation_alignment); },
+			[this]() { SubmitBatch(); }
+		);
+	}
+
+	// Waits for the open batch's previous submission before resetting its command list
+	void BeginBatch()
+	{
+		CopyBatch& batch = m_batches[m_batcher.GetOpenBatchIndex()];
+		m_ring.WaitForFence(m_batcher.GetOpenBatchReuseFenceValue());
+		HR_CHECK(batch.command_allocator->Reset());
+		HR_CHECK(batch.command_list->Reset(batch.command_allocator.Get(), nullptr));
+	}
+
+	void SubmitBatch()
+	{
+		const UploadBatcher::Submission submission = m_batcher.Submit();
+		CopyBatch& batch = m_batches[submission.batch_index];
+		HR_CHECK(batch.command_list->Close());
+		ID3D12CommandList* command_lists[] = { batch.command_list.Get() };
+		m_command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+
+		// The ring's fence is the only thing signalled on it, so its values line up with the batcher's
+		[[maybe_unused]] const uint64_t fence_value = m_ring.Signal(m_command_queue.Get());
+		assert(fence_value == submission.fence_value);
+
+		BeginBatch();
+	}
+
+	ComPtr<ID3D12CommandQueue> m_command_queue;
+	UploadBatcher m_batcher;
+	UploadRing m_ring;
+	vector<CopyBatch> m_batches;
+	mutable std::mutex m_mutex;
+};
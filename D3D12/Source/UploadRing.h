@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+#include "Common.h"
+#include "GpuResources.h"
+#include "StagingRing.h"
+
+using std::optional;
+using std::nullopt;
+
+// Staging memory for one upload. data is write-only CPU memory, the GPU copies out of resource at offset
+struct UploadAllocation
+{
+	ID3D12Resource* resource = nullptr;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	uint8_t* data = nullptr;
+};
+
+/*	Staging memory for uploads, sub-allocated out of one persistently mapped upload heap buffer by a StagingRing.
+	Once the copies reading from allocations have been submitted, Signal tags those allocations with a fence value on in_command_queue.
+	Their space is reused as soon as that fence completes.
+
+	When the ring is full, Allocate either blocks until the GPU retires earlier uploads or overflows into a dedicated buffer (see UploadRingFullBehavior).
+	Neither helps when the ring is full of allocations that haven't been signalled yet. Block returns nullopt then, so the caller can submit and retry.
+
+	Not thread-safe, other than IsComplete and WaitForFence.
+*/
+struct UploadRing
+{
+	UploadRing(ComPtr<ID3D12Device5> in_device, D3D12MA::Allocator* in_allocator, const size_t in_capacity, const UploadRingFullBehavior in_full_behavior = UploadRingFullBehavior::Block)
+		: m_allocator(in_allocator)
+		, m_staging(in_capacity, in_full_behavior)
+	{
+		HR_CHECK(in_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+
+		m_buffer = GpuBuffer(GpuBufferDesc{
+			.allocator = in_allocator,
+			.size = in_capacity,
+			.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+			.resource_flags = D3D12_RESOURCE_FLAG_NONE,
+			.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
+		});
+		m_buffer.Map(reinterpret_cast<void**>(&m_mapped_data));
+	}
+
+	~UploadRing()
+	{
+		// Copies still in flight may be reading the ring or any overflow buffers
+		WaitForFence(m_last_signalled_fence_value);
+	}
+
+	DISALLOW_COPY(UploadRing);
+
+	// in_alignment must be a power of two
+	optional<UploadAllocation> Allocate(const uint64_t in_size, const uint64_t in_alignment = 1)
+	{
+		optional<StagingRing<OverflowBuffer>::Allocation> allocation = m_staging.Allocate(
+			in_size, in_alignment, m_fence->GetCompletedValue(),
+			[this](const uint64_t in_fence_value) { WaitForFence(in_fence_value); },
+			[this](const uint64_t in_overflow_size)
+			{
+				OverflowBuffer overflow;
+				overflow.buffer = GpuBuffer(GpuBufferDesc{
+					.allocator = m_allocator,
+					.size = in_overflow_size,
+					.heap_type = D3D12_HEAP_TYPE_UPLOAD,
+					.resource_flags = D3D12_RESOURCE_FLAG_NONE,
+					.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ,
+				});
+				overflow.buffer.Map(reinterpret_cast<void**>(&overflow.data));
+				return overflow;
+			}
+		);
+
+		if (!allocation)
+		{
+			return nullopt;
+		}
+
+		if (OverflowBuffer* overflow = allocation->overflow_buffer)
+		{
+			return UploadAllocation {
+				.resource = overflow->buffer.GetResource(),
+				.offset = 0,
+				.size = in_size,
+				.data = overflow->data,
+			};
+		}
+
+		return UploadAllocation {
+			.resource = m_buffer.GetResource(),
+			.offset = allocation->ring_allocation.offset,
+			.size = allocation->ring_allocation.size,
+			.data = m_mapped_data + allocation->ring_allocation.offset,
+		};
+	}
+
+	// Signals a new fence value on in_command_queue, after any copies already submitted to it. Everything allocated since the last Signal is
+	// retired once that fence value completes
+	uint64_t Signal(ID3D12CommandQueue* in_command_queue)
+	{
+		const uint64_t fence_value = ++m_last_signalled_fence_value;
+		HR_CHECK(in_command_queue->Signal(m_fence.Get(), fence_value));
+
+		m_staging.Submit(fence_value);
+		return fence_value;
+	}
+
+	bool IsComplete(const uint64_t in_fence_value) const
+	{
+		return m_fence->GetCompletedValue() >= in_fence_value;
+	}
+
+	/*	Blocks until in_fence_value completes. UploadManager calls this from several threads at once, outside its lock. With a null event
+		SetEventOnCompletion blocks by itself, so there's no shared auto-reset event for one waiter to consume another's signal from
+	*/
+	void WaitForFence(const uint64_t in_fence_value)
+	{
+		while (!IsComplete(in_fence_value))
+		{
+			HR_CHECK(m_fence->SetEventOnCompletion(in_fence_value, nullptr));
+		}
+	}
+
+	// Makes in_command_queue wait (on the GPU) until in_fence_value has been signalled, without blocking the CPU
+	void QueueWait(ID3D12CommandQueue* in_command_queue, const uint64_t in_fence_value)
+	{
+		HR_CHECK(in_command_queue->Wait(m_fence.Get(), in_fence_value));
+	}
+
+	uint64_t GetLastSignalledFenceValue() const { return m_last_signalled_fence_value; }
+	uint64_t GetCapacity() const { return m_staging.GetCapacity(); }
+	uint64_t GetUsedSize() const { return m_staging.GetUsedSize(); }
+
+	// Bytes currently held by overflow buffers
+	uint64_t GetOverflowSize() const { return m_staging.GetOverflowSize(); }
+
+protected:
+	struct OverflowBuffer
+	{
+		GpuBuffer buffer;
+		uint8_t* data = nullptr;
+	};
+
+	D3D12MA::Allocator* m_allocator = nullptr;
+
+	GpuBuffer m_buffer;
+	uint8_t* m_mapped_data = nullptr;
+	StagingRing<OverflowBuffer> m_staging;
+
+	ComPtr<ID3D12Fence> m_fence;
+	uint64_t m_last_signalled_fence_value = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+using std::span;
+using std::vector;
+
+#include "../Shaders/HLSL_Types.h"
+
+// Vertices split into a tightly packed position stream and a separate attribute stream, see VertexAttributes
+struct VertexStreams
+{
+	vector<float3> positions;
+	vector<VertexAttributes> attributes;
+
+	size_t size() const { return positions.size(); }
+};
+
+inline VertexStreams split_vertex_streams(span<const Vertex> in_vertices)
+{
+	VertexStreams streams;
+	streams.positions.reserve(in_vertices.size());
+	streams.attributes.reserve(in_vertices.size());
+
+	for (const Vertex& vertex : in_vertices)
+	{
+		streams.positions.push_back(vertex.position);
+		streams.attributes.push_back(VertexAttributes {
+			.normal = vertex.normal,
+			.color = vertex.color,
+			.texcoord = vertex.texcoord,
+		});
+	}
+
+	return streams;
+}
+
+inline Vertex assemble_vertex(const float3& in_position, const VertexAttributes& in_attributes)
+{
+	Vertex vertex(in_position, in_attributes.normal, in_attributes.color);
+	vertex.texcoord = in_attributes.texcoord;
+	return vertex;
+}
+
+// Inverse of split_vertex_streams
+inline vector<Vertex> assemble_vertex_streams(const VertexStreams& in_streams)
+{
+	vector<Vertex> vertices;
+	vertices.reserve(in_streams.size());
+	for (size_t vertex_idx = 0; vertex_idx < in_streams.size(); ++vertex_idx)
+	{
+		vertices.push_back(assemble_vertex(in_streams.positions[vertex_idx], in_streams.attributes[vertex_idx]));
+	}
+	return vertices;
+}
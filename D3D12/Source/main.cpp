@@ -20,6 +20,7 @@
 #include "SimpleMath/SimpleMath.h"
 using namespace DirectX::SimpleMath;
 
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -30,12 +31,24 @@ using namespace DirectX::SimpleMath;
 #include "GpuPipelines.h"
 #include "../Shaders/HLSL_Types.h"
 
+#include "FileWatcher.h"
+#include "FrameIndices.h"
 #include "GltfScene.h"
 #include "ThreadPool.h"
+#include "UploadManager.h"
 
 #define CGLTF_IMPLEMENTATION
 #include "cgltf/cgltf.h"
 
+#define STB_IMAGE_IMPLEMENTATION
+#include "microprofile/stb/stb_image.h"
+
+#define STB_DXT_IMPLEMENTATION
+#include "microprofile/stb/stb_dxt.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
 using std::vector;
 using std::wstring;
 using std::move;
@@ -171,15 +184,15 @@ struct FrameData
 	ComPtr<ID3D12CommandAllocator> command_allocators[frame_count];
 
 	// Synchronization
-	UINT current_backbuffer_index = 0;
 	HANDLE fence_event;
 	ComPtr<ID3D12Fence> fence;
 
-	UINT64 fence_values[frame_count];
+	// The current backbuffer, and the frame (and fence value) last rendered to each one
+	FrameIndices<frame_count> frame_indices;
 
 	BindlessResourceManager bindless_resource_manager;
 
-	// Need to keep render graphs around until their frame is done presenting
+	// Keep render graphs around until their frame is done presenting. Their resources belong to the TransientResourcePool, which won't hand them out again until then
 	HashMap<UINT64, vector<RenderGraph>> pending_render_graphs;
 
 	FrameData(const FrameDataDesc& create_info)
@@ -193,7 +206,7 @@ struct FrameData
 			HR_CHECK(create_info.device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocators[i])));
 		}
 
-		HR_CHECK(create_info.device->CreateFence(fence_values[0], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+		HR_CHECK(create_info.device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
 
 		// Create an event handle to use for frame synchronization.
 		fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
@@ -205,6 +218,19 @@ struct FrameData
 
 	void resize(const FrameDataDesc& create_info)
 	{
+		// The current frame keeps its index. Everything before it has to be done with the old backbuffers before they go away
+		if (fence)
+		{
+			wait_for_frame(frame_indices.GetLastSubmittedFrame());
+			for (UINT i = 0; i < frame_count; ++i)
+			{
+				if (i != frame_indices.GetBackbufferIndex())
+				{
+					retire_frame(frame_indices.GetFrame(i));
+				}
+			}
+		}
+
 		swapchain.Reset();
 		for (UINT i = 0; i < frame_count; ++i)
 		{
@@ -232,7 +258,9 @@ struct FrameData
 
 		HR_CHECK(create_info.factory->MakeWindowAssociation(create_info.window, 0));
 		HR_CHECK(swapchain_1.As(&swapchain));
-		current_backbuffer_index = swapchain->GetCurrentBackBufferIndex();
+
+		// The other backbuffers' previous frames are complete (and retired above)
+		frame_indices.OnResize(swapchain->GetCurrentBackBufferIndex());
 
 		ComPtr<ID3D12DescriptorHeap> rtv_descriptor_heap;
 		const UINT rtv_heap_offset = create_info.device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
@@ -248,7 +276,7 @@ struct FrameData
 			{
 				D3D12_CPU_DESCRIPTOR_HANDLE rtv_descriptor_handle(rtv_descriptor_heap->GetCPUDescriptorHandleForHeapStart());
 
-				// Create a render target view for each frame. Reset all fence_values to zero
+				// Create a render target view for each frame
 				for (UINT i = 0; i < frame_count; i++)
 				{
 					HR_CHECK(swapchain->GetBuffer(i, IID_PPV_ARGS(&render_targets[i])));
@@ -259,8 +287,6 @@ struct FrameData
 
 					create_info.device->CreateRenderTargetView(render_targets[i].Get(), &render_target_view_desc, rtv_descriptor_handle);
 					rtv_descriptor_handle.ptr += rtv_heap_offset;
-
-					fence_values[i] = 0;
 				}
 			}
 		}
@@ -279,12 +305,12 @@ struct FrameData
 
 	ID3D12CommandAllocator* get_command_allocator() const
 	{
-		return command_allocators[current_backbuffer_index].Get();
+		return command_allocators[get_backbuffer_index()].Get();
 	}
 
 	ID3D12Resource* get_render_target() const
 	{
-		return render_targets[current_backbuffer_index].Get();
+		return render_targets[get_backbuffer_index()].Get();
 	}
 
 	void present()
@@ -292,14 +318,14 @@ struct FrameData
 		HR_CHECK(swapchain->Present(1, 0));
 	}
 
-	UINT64 get_current_frame_idx() const
+	UINT get_backbuffer_index() const
 	{
-		return fence_values[current_backbuffer_index];
+		return frame_indices.GetBackbufferIndex();
 	}
 
-	void set_current_frame_idx(UINT64 in_new_frame_index)
+	UINT64 get_current_frame_idx() const
 	{
-		fence_values[current_backbuffer_index] = in_new_frame_index;
+		return frame_indices.GetCurrentFrame();
 	}
 
 	void begin_frame()
@@ -313,41 +339,34 @@ struct FrameData
 		pending_render_graphs[get_current_frame_idx()].push_back(move(in_render_graph));
 	}
 
-	void wait_for_previous_frame(ComPtr<ID3D12CommandQueue> command_queue)
+	void wait_for_frame(const UINT64 in_frame_index)
 	{
-		// Signal The current fence value
-		const UINT64 old_frame_index = get_current_frame_idx();
-		HR_CHECK(command_queue->Signal(fence.Get(), old_frame_index));
-
-		// Update Current Backbuffer Index
-		current_backbuffer_index = swapchain->GetCurrentBackBufferIndex();
-
-		// Current Frame Index is the fence value at our new current_backbuffer_index
-		UINT64 current_frame_index = get_current_frame_idx();
-		
-		// Check the fence's current completed value. If it is less than the value at our new current_back_buffer_index, we need to wait
-		if (fence->GetCompletedValue() < current_frame_index)
+		if (fence->GetCompletedValue() < in_frame_index)
 		{
-			HR_CHECK(fence->SetEventOnCompletion(current_frame_index, fence_event));
+			HR_CHECK(fence->SetEventOnCompletion(in_frame_index, fence_event));
 			WaitForSingleObjectEx(fence_event, INFINITE, FALSE);
 		}
+	}
 
-		// Cleanup any resources on the render graph
-		auto found_render_graph = pending_render_graphs.find(current_frame_index);
-		if (found_render_graph != pending_render_graphs.end())
-		{
-			for (RenderGraph& render_graph : found_render_graph->second)
-			{
-				render_graph.Cleanup();
-				pending_render_graphs.erase(current_frame_index);
-			}
-		}
+	// Releases what a completed frame was holding on to
+	void retire_frame(const UINT64 in_frame_index)
+	{
+		// That frame's render graphs are done with
+		pending_render_graphs.erase(in_frame_index);
 
 		// Clean up any bindless resources for that frame
-		bindless_resource_manager.CleanupFrame(current_frame_index);
+		bindless_resource_manager.CleanupFrame(in_frame_index);
+	}
 
-		// Update our current frame index
-		set_current_frame_idx(old_frame_index + 1);
+	void wait_for_previous_frame(ComPtr<ID3D12CommandQueue> command_queue)
+	{
+		// Signal The current fence value
+		HR_CHECK(command_queue->Signal(fence.Get(), get_current_frame_idx()));
+
+		// Move on to the next frame at the new backbuffer index. If the fence hasn't reached the frame last rendered to that backbuffer, we need to wait
+		const UINT64 previous_frame_index = frame_indices.BeginNextFrame(swapchain->GetCurrentBackBufferIndex());
+		wait_for_frame(previous_frame_index);
+		retire_frame(previous_frame_index);
 	}
 };
 
@@ -495,6 +514,9 @@ int main()
 	FrameData frame_data(frame_data_create_info);
 	BindlessResourceManager& bindless_resource_manager = frame_data.bindless_resource_manager;
 
+	// Render graph outputs, reused across frames
+	TransientResourcePool transient_resource_pool(gpu_memory_allocator, &bindless_resource_manager);
+
 	// 12. Create Command list using command allocator and pipeline state, and close it (we'll record it later)
 	ComPtr<ID3D12GraphicsCommandList4> command_list;
 	HR_CHECK(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frame_data.get_command_allocator(), nullptr, IID_PPV_ARGS(&command_list)));
@@ -502,7 +524,7 @@ int main()
 
 	//FCS TODO: BEGIN TESTING SGs
 
-	//FCS TODO: Calculate center/bounds of scene and use that to inform extents and center
+	// Placeholder volume until the scene's bounds are known, see fit_octree_to_scene
 	static bool enable_octree_debug_view = false;
 	constexpr float3 octree_center(0, 1000, 0);
 	constexpr size_t octree_depth = 6;
@@ -519,20 +541,34 @@ int main()
 		octree_depth
 	);
 
-	UVSphere uv_sphere(UVSphereDesc{
-		.device = device,
+	// Shared by all scene geometry, so meshes are offsets into a few large buffers rather than buffers of their own
+	GeometryPool geometry_pool(GeometryPoolDesc{
 		.allocator = gpu_memory_allocator,
-		.command_queue = copy_queue,
+		.bindless_resource_manager = &bindless_resource_manager,
+	});
+
+	// Every asset upload goes through the copy queue here. The direct queue waits for uploads on the GPU (WaitOnQueue), never the CPU
+	UploadManager upload_manager(device, gpu_memory_allocator, copy_queue, 64 * 1024 * 1024);
+
+	UVSphere uv_sphere(UVSphereDesc{
+		.geometry_pool = &geometry_pool,
+		.upload_manager = &upload_manager,
 		.radius = 20.0f,
 		.latitudes = 12,
 		.longitudes = 12,
 	});
+	upload_manager.WaitOnQueue(command_queue.Get(), uv_sphere.upload_ticket);
 
 	GpuInstanceData uv_sphere_instance_data =
 	{
 		.transform = Matrix::Identity(),
-		.vertex_buffer_index = bindless_resource_manager.RegisterSRV(uv_sphere.vertex_buffer, uv_sphere.vertices_count, sizeof(Vertex)),
-		.index_buffer_index = bindless_resource_manager.RegisterSRV(uv_sphere.index_buffer, uv_sphere.indices_count, sizeof(uint32_t)),
+		.geometry_buffer_index = uv_sphere.geometry_buffer_index,
+		.flags = 0,
+		.position_offset = uv_sphere.position_offset,
+		.attribute_offset = uv_sphere.attribute_offset,
+		.index_offset = uv_sphere.index_offset,
+		.material_buffer_index = INVALID_BINDLESS_INDEX,
+		.material_index = INVALID_MATERIAL_INDEX,
 	};
 
 	GpuBuffer uv_sphere_instance_buffer(GpuBufferDesc{
@@ -545,33 +581,32 @@ int main()
 	uv_sphere_instance_buffer.Write(&uv_sphere_instance_data, sizeof(uv_sphere_instance_data));
 	bindless_resource_manager.RegisterSRV(uv_sphere_instance_buffer, 1, sizeof(GpuInstanceData));
 
+	// Octree buffers are rarely written but read by every octree debug view pixel, so they live in default heaps. See FlushDirtyRanges in the frame loop
 	const size_t octree_buffer_size = octree_nodes.size() * sizeof(OctreeNode);
-	GpuBuffer octree_buffer(GpuBufferDesc{
+	GpuMirroredBuffer octree_buffer(GpuBufferDesc{
 		.allocator = gpu_memory_allocator,
 		.size = octree_buffer_size,
-		.heap_type = D3D12_HEAP_TYPE_UPLOAD,
 		.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-		.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ
+		.resource_state = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
 	});
-	octree_buffer.Write(octree_nodes.data(), octree_buffer_size);
+	octree_buffer.WriteElements<OctreeNode>(0, octree_nodes);
 	const uint32_t octree_bindless_id = bindless_resource_manager.RegisterSRV(
-		octree_buffer, 
+		octree_buffer.GetBuffer(), 
 		(uint32_t) octree_nodes.size(), 
 		sizeof(OctreeNode)
 	);
 
 	// For fast access when doing octree leaf debug view
 	const size_t octree_leaf_indices_buffer_size = octree_leaf_nodes.size() * sizeof(uint32_t);
-	GpuBuffer octree_leaf_indices_buffer(GpuBufferDesc{	
+	GpuMirroredBuffer octree_leaf_indices_buffer(GpuBufferDesc{	
 		.allocator = gpu_memory_allocator,
 		.size = octree_leaf_indices_buffer_size,
-		.heap_type = D3D12_HEAP_TYPE_UPLOAD,
 		.resource_flags = D3D12_RESOURCE_FLAG_NONE,
-		.resource_state = D3D12_RESOURCE_STATE_GENERIC_READ
+		.resource_state = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
 	});
-	octree_leaf_indices_buffer.Write(octree_leaf_nodes.data(), octree_leaf_indices_buffer_size);
+	octree_leaf_indices_buffer.WriteElements<uint32_t>(0, octree_leaf_nodes);
 	const uint32_t octree_leaf_indices_bindless_id = bindless_resource_manager.RegisterSRV(
-		octree_leaf_indices_buffer, 
+		octree_leaf_indices_buffer.GetBuffer(), 
 		(uint32_t) octree_leaf_nodes.size(), 
 		sizeof(uint32_t)
 	);
@@ -593,7 +628,7 @@ int main()
 	const size_t global_constant_buffer_size = ROUND_UP(sizeof(GlobalConstantBuffer), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
 
 	GpuBuffer global_constant_buffers[frame_count];
-	for (int32_t current_backbuffer_index = 0; current_backbuffer_index < frame_count; ++current_backbuffer_index)
+	for (UINT current_backbuffer_index = 0; current_backbuffer_index < frame_count; ++current_backbuffer_index)
 	{
 		GpuBuffer global_constant_buffer(GpuBufferDesc{
 			.allocator = gpu_memory_allocator,
@@ -701,8 +736,9 @@ int main()
 
 	global_constant_buffer_data.frames_rendered = 0;
 
-	// Load GLTF Scene
-	TaskResult<GltfScene> gltf_task_result = thread_pool.PostTask([&]() {
+	// Load GLTF Scene. Draws are published as meshes finish uploading, so we can start rendering it immediately
+	GltfScene gltf_scene;
+	TaskResult<bool> gltf_task_result = thread_pool.PostTask([&]() {
 		const char* gltf_files[3] = {
 			"Assets/FlyingWorld/scene.gltf",
 			"Assets/Sponza/Sponza.gltf",
@@ -720,20 +756,77 @@ int main()
 		GltfInitData gltf_init_data = {
 			.file = gltf_files[gltf_scene_index],
 			.transform = transforms[gltf_scene_index],
-			.device = device,
 			.allocator = gpu_memory_allocator,
-			.command_queue = copy_queue,
 			.bindless_resource_manager = &bindless_resource_manager,
+			.upload_manager = &upload_manager,
+			.geometry_pool = &geometry_pool,
+			.thread_pool = &thread_pool,
 		};
-		return GltfScene(gltf_init_data);
+		gltf_scene.Load(gltf_init_data);
+		return true;
 	});
 
+	// Watches the scene's files once it's loaded, reloading whatever changed
+	optional<FileWatcher> gltf_file_watcher;
+
+	// Rebuilds the octree around the scene's bounds. Node count and order only depend on octree_depth, so octree_leaf_indices_buffer stays valid
+	bool octree_fit_to_scene = false;
+	auto fit_octree_to_scene = [&]()
+	{
+		const Bounds& scene_bounds = gltf_scene.GetSceneBounds();
+		const float3 scene_size = scene_bounds.aabb_max - scene_bounds.aabb_min;
+
+		// Octree nodes are cubes. Padded slightly so geometry on the scene's boundary still lands inside a leaf
+		const float scene_octree_extents = (std::max)((std::max)((std::max)(scene_size.x, scene_size.y), scene_size.z) * 1.01f, 1.0f);
+
+		octree_nodes.clear();
+		octree_leaf_nodes.clear();
+		octree_node_init(
+			octree_nodes, 
+			octree_leaf_nodes,
+			scene_bounds.GetCenter(), 
+			scene_octree_extents, 
+			octree_depth
+		);
+
+		// Frames in flight keep the old nodes, octree_buffer writes around the flush that may still be copying them
+		octree_buffer.WriteElements<OctreeNode>(0, octree_nodes);
+		octree_fit_to_scene = true;
+	};
+
 	std::chrono::high_resolution_clock timer;
 	auto previous_time = timer.now();
 	while (!should_close)
 	{
 		frame_data.begin_frame();
 
+		// Instance bounds are all known before the first draw is published
+		if (!octree_fit_to_scene && gltf_scene.GetInstanceCount() > 0)
+		{
+			fit_octree_to_scene();
+		}
+
+		if (!gltf_file_watcher && gltf_task_result.get())
+		{
+			gltf_file_watcher.emplace();
+			for (const string& source_file : gltf_scene.GetSourceFiles())
+			{
+				gltf_file_watcher->AddFile(source_file);
+			}
+		}
+		else if (gltf_file_watcher && !gltf_file_watcher->PollChanges().empty())
+		{
+			// Frames in flight keep drawing the old scene, Reload retires what it replaces against this frame
+			if (gltf_scene.Reload(frame_data.get_current_frame_idx()))
+			{
+				upload_manager.WaitOnQueue(command_queue.Get(), upload_manager.GetPendingTicket());
+				if (gltf_scene.GetInstanceCount() > 0)
+				{
+					fit_octree_to_scene();
+				}
+			}
+		}
+
 		auto current_time = timer.now();
 		using seconds = std::chrono::duration<float, std::ratio<1, 1>>;
 		float delta_time = std::chrono::duration_cast<seconds>(current_time - previous_time).count();
@@ -833,6 +926,12 @@ int main()
 			const Matrix proj = Matrix::CreatePerspectiveFieldOfView(fieldOfView, aspectRatio, 1.f, 50000.0f);
 			global_constant_buffer_data.projection = proj;
 			global_constant_buffer_data.projection_inverse = proj.Invert();
+
+			// Before recording this frame, so it samples whichever texture mips have just become resident
+			gltf_scene.UpdateTextureStreaming(cam_pos, fieldOfView, (float) render_height, frame_data.get_current_frame_idx(), frame_data.fence->GetCompletedValue());
+			gltf_scene.ReleaseRetiredBuffers(frame_data.fence->GetCompletedValue());
+			octree_buffer.ReleaseRetiredBuffers(frame_data.fence->GetCompletedValue());
+			octree_leaf_indices_buffer.ReleaseRetiredBuffers(frame_data.fence->GetCompletedValue());
 		}
 
 		// Enable/Disable Octree Debug View
@@ -842,7 +941,7 @@ int main()
 		}
 
 		//Update current frame's constant buffer
-		global_constant_buffers[frame_data.current_backbuffer_index].Write(&global_constant_buffer_data, sizeof(global_constant_buffer_data));
+		global_constant_buffers[frame_data.get_backbuffer_index()].Write(&global_constant_buffer_data, sizeof(global_constant_buffer_data));
 
 		// Process any messages in the queue.
 		MSG msg = {};
@@ -859,14 +958,20 @@ int main()
 			HR_CHECK(frame_data.get_command_allocator()->Reset());
 			HR_CHECK(command_list->Reset(frame_data.get_command_allocator(), nullptr));
 
+			// Copies any octree writes into the default heap buffers before anything this frame reads them
+			octree_buffer.FlushDirtyRanges(command_list.Get(), frame_data.get_current_frame_idx());
+			octree_leaf_indices_buffer.FlushDirtyRanges(command_list.Get(), frame_data.get_current_frame_idx());
+
+			// Frees render graph resources that have gone unused, e.g. the old size's after a resize
+			transient_resource_pool.BeginFrame(frame_data.get_current_frame_idx(), frame_data.fence->GetCompletedValue());
+
 			// Construct render graph for this frame
 			RenderGraph render_graph(RenderGraphDesc
 			{
 				.device = device,
-				.allocator = gpu_memory_allocator,
 				.command_list = command_list,
-				.bindless_resource_manager = &bindless_resource_manager,
-				.frame_index = frame_data.fence_values[frame_data.current_backbuffer_index],
+				.transient_resource_pool = &transient_resource_pool,
+				.frame_index = frame_data.get_current_frame_idx(),
 			});
 
 			const DXGI_FORMAT swap_chain_format = frame_data.swap_chain_format;
@@ -958,7 +1063,7 @@ int main()
 				{
 					command_list->SetDescriptorHeaps(1, bindless_resource_manager.GetDescriptorHeap().GetAddressOf());
 					command_list->SetGraphicsRootSignature(global_root_signature.Get());
-					command_list->SetGraphicsRootConstantBufferView(0, global_constant_buffers[frame_data.current_backbuffer_index].GetGPUVirtualAddress());
+					command_list->SetGraphicsRootConstantBufferView(0, global_constant_buffers[frame_data.get_backbuffer_index()].GetGPUVirtualAddress());
 
 					RenderGraphOutput& color_output = self.GetOutput("color");
 					D3D12_CPU_DESCRIPTOR_HANDLE& rtv_handle = color_output.GetRtvHandle(device);
@@ -990,14 +1095,13 @@ int main()
 					};
 					command_list->RSSetScissorRects(1, &scissor);
 
-					if (optional<GltfScene> gltf_scene = gltf_task_result.get())
+					if (const UINT draw_count = gltf_scene.GetPublishedDrawCount())
 					{
 						command_list->SetPipelineState(visibility_pso.Get());
-						UINT instance_count = (UINT) gltf_scene->instances_array.size();
 						command_list->ExecuteIndirect(
 							indirect_command_signature.Get(), 
-							instance_count, 
-							gltf_scene->indirect_draw_gpu_buffer.GetResource(), 
+							draw_count, 
+							gltf_scene.indirect_draw_gpu_buffer.GetResource(), 
 							0, 
 							nullptr, 
 							0
@@ -1050,15 +1154,11 @@ int main()
 					RenderGraphInput& input = self.GetInput("input");
 					RenderGraphOutput& output = self.GetOutput("output");
 
-					UINT32 num_instances = 0;
-					if (optional<GltfScene> gltf_scene = gltf_task_result.get())
-					{
-						num_instances = static_cast<UINT32>(gltf_scene->instances_array.size());
-					}
+					const UINT32 num_instances = gltf_scene.GetInstanceCount();
 
 					command_list->SetComputeRootSignature(global_root_signature.Get());
 					command_list->SetDescriptorHeaps(1, bindless_resource_manager.GetDescriptorHeap().GetAddressOf());
-					command_list->SetComputeRootConstantBufferView(0, global_constant_buffers[frame_data.current_backbuffer_index].GetGPUVirtualAddress());
+					command_list->SetComputeRootConstantBufferView(0, global_constant_buffers[frame_data.get_backbuffer_index()].GetGPUVirtualAddress());
 					uint32_t constants[3] =
 					{
 						input.GetBindlessResourceIndex(),
@@ -1138,6 +1238,15 @@ int main()
 
 			// Execute the render graph and prevent it from being cleaned up until the frame is done presenting
 			frame_data.register_graph(move(render_graph));
+
+			const TransientResourceStats& transient_texture_stats = transient_resource_pool.GetTextureStats();
+			MICROPROFILE_COUNTER_SET("render_graph/textures/allocations", transient_texture_stats.allocation_count);
+			MICROPROFILE_COUNTER_SET("render_graph/textures/evictions", transient_texture_stats.eviction_count);
+			MICROPROFILE_COUNTER_SET("render_graph/textures/pooled", transient_texture_stats.pooled_count);
+			MICROPROFILE_COUNTER_SET("render_graph/textures/hit_rate_percent", (int64_t) (transient_texture_stats.GetHitRate() * 100.0f));
+			MICROPROFILE_COUNTER_SET("render_graph/textures/pooled_bytes", transient_texture_stats.pooled_bytes);
+			MICROPROFILE_COUNTER_SET("render_graph/textures/saved_bytes", transient_texture_stats.hit_bytes);
+
 			// Potentially wait for a frame to free up
 			frame_data.wait_for_previous_frame(command_queue);
 		}
@@ -1150,8 +1259,21 @@ int main()
 		MicroProfileFlip(nullptr);
 	}
 
+	// gltf_scene is destroyed before thread_pool, so make sure its load task has finished
+	gltf_scene.CancelLoad();
+	while (!gltf_task_result.get())
+	{
+		std::this_thread::yield();
+	}
+
 	wait_gpu_idle(device, command_queue);
 
+	print_transient_resource_stats("TransientResourcePool textures", transient_resource_pool.GetTextureStats());
+	print_transient_resource_stats("TransientResourcePool buffers", transient_resource_pool.GetBufferStats());
+
+	// Streamed texture copies may still be in flight, and upload_manager outlives the resources they write to
+	upload_manager.WaitForTicket(upload_manager.Flush());
+
 	frame_data.reset();
 	return 0;
 }
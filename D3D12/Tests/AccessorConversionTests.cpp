@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "AccessorConversion.h"
+#include "Test.h"
+
+using std::vector;
+
+static constexpr AccessorComponentType ALL_COMPONENT_TYPES[] = {
+	AccessorComponentType::Float,
+	AccessorComponentType::Half,
+	AccessorComponentType::Int8,
+	AccessorComponentType::UInt8,
+	AccessorComponentType::Int16,
+	AccessorComponentType::UInt16,
+	AccessorComponentType::UInt32,
+};
+
+// Converts a single element with in_components' raw bytes to floats
+template<typename ComponentType>
+vector<float> ConvertElement(const vector<ComponentType>& in_components, const AccessorComponentType in_type, const bool in_normalized)
+{
+	const AccessorDesc accessor = {
+		.data = (const uint8_t*) in_components.data(),
+		.count = 1,
+		.stride = in_components.size() * sizeof(ComponentType),
+		.component_type = in_type,
+		.component_count = (uint32_t) in_components.size(),
+		.normalized = in_normalized,
+	};
+	vector<float> result(in_components.size());
+	convert_accessor_to_float(accessor, result.data(), result.size() * sizeof(float), (uint32_t) result.size());
+	return result;
+}
+
+// Normalized integers map their full range onto [0,1] or [-1,1], with the extra negative value of signed types clamping to -1
+void TestNormalization()
+{
+	// The ends of the range are exact
+	TEST_CHECK((ConvertElement<uint8_t>({ 0, 255 }, AccessorComponentType::UInt8, true) == vector<float> { 0.0f, 1.0f }));
+	TEST_CHECK((ConvertElement<int8_t>({ 0, 127, -127, -128 }, AccessorComponentType::Int8, true) == vector<float> { 0.0f, 1.0f, -1.0f, -1.0f }));
+	TEST_CHECK((ConvertElement<uint16_t>({ 0, 65535 }, AccessorComponentType::UInt16, true) == vector<float> { 0.0f, 1.0f }));
+	TEST_CHECK((ConvertElement<int16_t>({ 0, 32767, -32767, -32768 }, AccessorComponentType::Int16, true) == vector<float> { 0.0f, 1.0f, -1.0f, -1.0f }));
+
+	// Every normalized value lands in range and within rounding of the exact quotient
+	for (int value = -128; value <= 127; ++value)
+	{
+		const float converted = ConvertElement<int8_t>({ (int8_t) value }, AccessorComponentType::Int8, true)[0];
+		TEST_CHECK(converted >= -1.0f && converted <= 1.0f);
+		TEST_CHECK_NEAR(converted, (std::max)(value / 127.0, -1.0), 1e-6);
+	}
+	for (int value = 0; value <= 255; ++value)
+	{
+		const float converted = ConvertElement<uint8_t>({ (uint8_t) value }, AccessorComponentType::UInt8, true)[0];
+		TEST_CHECK_NEAR(converted, value / 255.0, 1e-7);
+	}
+	for (int value = -32768; value <= 32767; ++value)
+	{
+		const float converted = ConvertElement<int16_t>({ (int16_t) value }, AccessorComponentType::Int16, true)[0];
+		TEST_CHECK(converted >= -1.0f && converted <= 1.0f);
+		TEST_CHECK_NEAR(converted, (std::max)(value / 32767.0, -1.0), 1e-7);
+	}
+	for (int value = 0; value <= 65535; ++value)
+	{
+		const float converted = ConvertElement<uint16_t>({ (uint16_t) value }, AccessorComponentType::UInt16, true)[0];
+		TEST_CHECK_NEAR(converted, value / 65535.0, 1e-7);
+	}
+}
+
+// Without normalization, integers convert to their value
+void TestUnnormalized()
+{
+	TEST_CHECK((ConvertElement<uint8_t>({ 0, 255, 7 }, AccessorComponentType::UInt8, false) == vector<float> { 0.0f, 255.0f, 7.0f }));
+	TEST_CHECK((ConvertElement<int8_t>({ -128, 127 }, AccessorComponentType::Int8, false) == vector<float> { -128.0f, 127.0f }));
+	TEST_CHECK((ConvertElement<int16_t>({ -32768, 1000 }, AccessorComponentType::Int16, false) == vector<float> { -32768.0f, 1000.0f }));
+	TEST_CHECK((ConvertElement<uint32_t>({ 0, 16777216 }, AccessorComponentType::UInt32, false) == vector<float> { 0.0f, 16777216.0f }));
+}
+
+// Every half, against a straightforward decode
+void TestHalfConversion()
+{
+	for (uint32_t half = 0; half <= 0xFFFF; ++half)
+	{
+		const uint32_t exponent = (half >> 10) & 0x1F;
+		const uint32_t mantissa = half & 0x3FF;
+		const float sign = (half & 0x8000) ? -1.0f : 1.0f;
+
+		const float converted = convert_half_to_float((uint16_t) half);
+		if (exponent == 0x1F)
+		{
+			TEST_CHECK(mantissa == 0 ? converted == sign * INFINITY : std::isnan(converted));
+		}
+		else
+		{
+			const float expected = exponent == 0
+				? sign * std::ldexp((float) mantissa, -24)
+				: sign * std::ldexp((float) (mantissa | 0x400), (int) exponent - 25);
+			TEST_CHECK(converted == expected);
+			TEST_CHECK(std::signbit(converted) == std::signbit(sign));
+		}
+	}
+}
+
+// Missing components come from the fill value, extra ones are dropped
+void TestComponentCountMismatch()
+{
+	const vector<float> positions = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+	const AccessorDesc accessor = {
+		.data = (const uint8_t*) positions.data(),
+		.count = 2,
+		.stride = 3 * sizeof(float),
+		.component_type = AccessorComponentType::Float,
+		.component_count = 3,
+	};
+
+	const float fill[4] = { 9.0f, 9.0f, 9.0f, 1.0f };
+	float widened[8];
+	convert_accessor_to_float(accessor, widened, 4 * sizeof(float), 4, fill);
+	TEST_CHECK((vector<float>(widened, widened + 8) == vector<float> { 1.0f, 2.0f, 3.0f, 1.0f, 4.0f, 5.0f, 6.0f, 1.0f }));
+
+	float narrowed[4];
+	convert_accessor_to_float(accessor, narrowed, 2 * sizeof(float), 2);
+	TEST_CHECK((vector<float>(narrowed, narrowed + 4) == vector<float> { 1.0f, 2.0f, 4.0f, 5.0f }));
+}
+
+/*	The dispatching (SSE2 where available) conversion must match the scalar reference bit for bit, for every component type,
+	component count and interleaving. Source buffers end exactly at the accessor's last element, so any over-read shows up under ASan
+*/
+void TestMatchesScalarReference()
+{
+	std::mt19937 rng(8642);
+	for (const AccessorComponentType component_type : ALL_COMPONENT_TYPES)
+	{
+		for (const bool normalized : { false, true })
+		{
+			for (uint32_t component_count = 1; component_count <= 4; ++component_count)
+			{
+				for (const size_t stride_padding : { (size_t) 0, (size_t) 4, (size_t) 12 })
+				{
+					AccessorDesc accessor = {
+						.count = 37,
+						.component_type = component_type,
+						.component_count = component_count,
+						.normalized = normalized,
+					};
+					accessor.stride = accessor.GetElementSize() + stride_padding;
+
+					vector<uint8_t> source(accessor.GetSize());
+					for (uint8_t& byte : source)
+					{
+						byte = (uint8_t) rng();
+					}
+
+					// Random floats can be NaNs with arbitrary payloads, keep to ordinary values for those
+					if (component_type == AccessorComponentType::Float)
+					{
+						std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+						for (size_t element_idx = 0; element_idx < accessor.count; ++element_idx)
+						{
+							for (uint32_t component_idx = 0; component_idx < component_count; ++component_idx)
+							{
+								const float value = distribution(rng);
+								memcpy(source.data() + element_idx * accessor.stride + component_idx * sizeof(float), &value, sizeof(float));
+							}
+						}
+					}
+					accessor.data = source.data();
+
+					for (uint32_t out_component_count = 1; out_component_count <= 4; ++out_component_count)
+					{
+						const float fill[4] = { 0.5f, 0.25f, 0.125f, 1.0f };
+						vector<float> converted(accessor.count * out_component_count);
+						vector<float> reference(accessor.count * out_component_count);
+						convert_accessor_to_float(accessor, converted.data(), out_component_count * sizeof(float), out_component_count, fill);
+						convert_accessor_to_float_scalar(accessor, 0, accessor.count, reference.data(), out_component_count * sizeof(float), out_component_count, fill);
+						TEST_CHECK(memcmp(converted.data(), reference.data(), converted.size() * sizeof(float)) == 0);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Index widening for each index size, across the vectorized widths and with interleaved indices
+void TestIndexConversion()
+{
+	std::mt19937 rng(7531);
+	for (const AccessorComponentType component_type : { AccessorComponentType::UInt8, AccessorComponentType::UInt16, AccessorComponentType::UInt32 })
+	{
+		const uint32_t index_size = get_accessor_component_size(component_type);
+		for (const size_t stride : { (size_t) index_size, (size_t) 8 })
+		{
+			for (const size_t count : { (size_t) 0, (size_t) 1, (size_t) 15, (size_t) 16, (size_t) 37 })
+			{
+				AccessorDesc accessor = {
+					.count = count,
+					.stride = stride,
+					.component_type = component_type,
+					.component_count = 1,
+				};
+
+				vector<uint8_t> source(accessor.GetSize());
+				vector<uint32_t> expected(count);
+				for (size_t index_idx = 0; index_idx < count; ++index_idx)
+				{
+					const uint32_t index = (uint32_t) (rng() >> (32 - index_size * 8));
+					memcpy(source.data() + index_idx * stride, &index, index_size);
+					expected[index_idx] = index;
+				}
+				accessor.data = source.data();
+
+				vector<uint32_t> indices(count);
+				convert_accessor_to_indices(accessor, indices.data());
+				TEST_CHECK(indices == expected);
+			}
+		}
+	}
+}
+
+// Indices narrowed to the stride get_index_stride picks widen back to the same indices, on both sides of the 16-bit limit
+void TestIndexNarrowing()
+{
+	TEST_CHECK(get_index_stride(0) == sizeof(uint16_t));
+	TEST_CHECK(get_index_stride(MAX_VERTICES_FOR_16BIT_INDICES) == sizeof(uint16_t));
+	TEST_CHECK(get_index_stride(MAX_VERTICES_FOR_16BIT_INDICES + 1) == sizeof(uint32_t));
+
+	std::mt19937 rng(9753);
+	for (const size_t vertex_count : { (size_t) 1, (size_t) 300, MAX_VERTICES_FOR_16BIT_INDICES, MAX_VERTICES_FOR_16BIT_INDICES + 1, (size_t) 1 << 20 })
+	{
+		for (const size_t count : { (size_t) 0, (size_t) 3, (size_t) 37, (size_t) 3000 })
+		{
+			// Random triangles, plus the first and last vertex so both ends of the range are covered
+			vector<uint32_t> indices(count);
+			std::uniform_int_distribution<uint32_t> index_distribution(0, (uint32_t) vertex_count - 1);
+			for (uint32_t& index : indices)
+			{
+				index = index_distribution(rng);
+			}
+			if (count >= 2)
+			{
+				indices[0] = 0;
+				indices[count - 1] = (uint32_t) vertex_count - 1;
+			}
+
+			const uint32_t index_stride = get_index_stride(vertex_count);
+			vector<uint8_t> narrowed(count * index_stride);
+			narrow_indices(indices.data(), count, index_stride, narrowed.data());
+
+			const AccessorDesc accessor = {
+				.data = narrowed.data(),
+				.count = count,
+				.stride = index_stride,
+				.component_type = index_stride == sizeof(uint16_t) ? AccessorComponentType::UInt16 : AccessorComponentType::UInt32,
+				.component_count = 1,
+			};
+
+			vector<uint32_t> widened(count);
+			convert_accessor_to_indices(accessor, widened.data());
+			TEST_CHECK(widened == indices);
+		}
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestNormalization);
+	TEST_RUN(TestUnnormalized);
+	TEST_RUN(TestHalfConversion);
+	TEST_RUN(TestComponentCountMismatch);
+	TEST_RUN(TestMatchesScalarReference);
+	TEST_RUN(TestIndexConversion);
+	TEST_RUN(TestIndexNarrowing);
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <random>
+
+#include "Common.h"
+#include "Test.h"
+
+// Already big enough, the capacity is returned as is, whatever min_capacity says
+void TestGrowCapacityKeepsFittingCapacity()
+{
+	TEST_CHECK(grow_capacity(0, 0) == 0);
+	TEST_CHECK(grow_capacity(16, 0) == 16);
+	TEST_CHECK(grow_capacity(16, 16) == 16);
+	TEST_CHECK(grow_capacity(16, 9, 64) == 16);
+	TEST_CHECK(grow_capacity(100, 100, 1024) == 100);
+}
+
+// Empty containers start from min_capacity (1 if that's 0), then double
+void TestGrowCapacityStartsFromMinCapacity()
+{
+	TEST_CHECK(grow_capacity(0, 1) == 1);
+	TEST_CHECK(grow_capacity(0, 5) == 8);
+	TEST_CHECK(grow_capacity(0, 5, 0) == 8);
+	TEST_CHECK(grow_capacity(0, 5, 64) == 64);
+	TEST_CHECK(grow_capacity(0, 65, 64) == 128);
+	TEST_CHECK(grow_capacity(0, 100, 3) == 192);
+}
+
+/*	Random capacities and sizes: the result always fits, never shrinks, and is the capacity doubled the fewest times that fits,
+	so it's never twice the size it has to be
+*/
+void TestGrowCapacityIsGeometric()
+{
+	std::mt19937 rng(13579);
+	std::uniform_int_distribution<size_t> capacity_distribution(0, 1 << 20);
+	std::uniform_int_distribution<size_t> size_distribution(0, 1 << 26);
+	for (int case_idx = 0; case_idx < 100000; ++case_idx)
+	{
+		const size_t capacity = capacity_distribution(rng);
+		const size_t required_size = size_distribution(rng);
+		const size_t new_capacity = grow_capacity(capacity, required_size);
+		TEST_CHECK(new_capacity >= capacity && new_capacity >= required_size);
+		if (required_size <= capacity)
+		{
+			TEST_CHECK(new_capacity == capacity);
+			continue;
+		}
+
+		const size_t start_capacity = capacity > 0 ? capacity : 1;
+		TEST_CHECK(new_capacity % start_capacity == 0);
+		const size_t growth = new_capacity / start_capacity;
+		TEST_CHECK((growth & (growth - 1)) == 0);
+		TEST_CHECK(new_capacity / 2 < required_size);
+	}
+
+	// Growing a little at a time, like appending, only reallocates on powers of two
+	size_t capacity = 0;
+	size_t growth_count = 0;
+	for (size_t size = 1; size <= 1 << 20; ++size)
+	{
+		const size_t new_capacity = grow_capacity(capacity, size);
+		growth_count += new_capacity != capacity;
+		capacity = new_capacity;
+	}
+	TEST_CHECK(capacity == 1 << 20 && growth_count == 21);
+}
+
+// Doubling past SIZE_MAX would wrap around to a capacity smaller than required, that gives exactly the required size instead
+void TestGrowCapacityDoesntOverflow()
+{
+	const size_t half_max = SIZE_MAX / 2 + 1;
+	TEST_CHECK(grow_capacity(half_max, half_max + 1) == half_max + 1);
+	TEST_CHECK(grow_capacity(half_max, SIZE_MAX) == SIZE_MAX);
+	TEST_CHECK(grow_capacity(3, SIZE_MAX - 1) == SIZE_MAX - 1);
+	TEST_CHECK(grow_capacity(0, SIZE_MAX) == SIZE_MAX);
+	TEST_CHECK(grow_capacity(0, half_max) == half_max);
+	TEST_CHECK(grow_capacity(half_max / 2, half_max) == half_max);
+}
+
+int main()
+{
+	TEST_RUN(TestGrowCapacityKeepsFittingCapacity);
+	TEST_RUN(TestGrowCapacityStartsFromMinCapacity);
+	TEST_RUN(TestGrowCapacityIsGeometric);
+	TEST_RUN(TestGrowCapacityDoesntOverflow);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*	Runs the Cooker over a small synthetic gltf and checks that the scene cache it writes loads, through SceneCache the way the app loads it,
+	into exactly the geometry converting the gltf in-process gives. Needs the built Cooker, so ../Cooker/CMakeLists.txt registers it, not ours.
+
+	Usage: CookerTests <path to Cooker>
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "GltfConversion.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include "TestGltf.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string;
+
+static string g_cooker_path;
+
+// Runs the Cooker with in_arguments, returning whether it succeeded
+bool RunCooker(const string& in_arguments)
+{
+	const string command = "\"" + g_cooker_path + "\" " + in_arguments;
+	fflush(stdout);
+	return std::system(command.c_str()) == 0;
+}
+
+// Cooks with each of the Cooker's vertex formats and compressions, then loads the cache and compares it to an uncached conversion
+void TestCookedCacheMatchesConversion()
+{
+	const std::filesystem::path directory = GetTestDirectory("CookerTests_round_trip");
+	const string path = (directory / "scene.gltf").string();
+
+	TestGltfBuilder builder;
+	const uint32_t ground = builder.AddMesh({ builder.AddGridPrimitive(16, 0.0f) });
+	const uint32_t props = builder.AddMesh({ builder.AddGridPrimitive(4, 1.0f), builder.AddGridPrimitive(6, 2.0f) });
+	builder.AddNode(ground);
+	builder.AddNode(props, 5.0f, 0.0f, 0.0f);
+	builder.AddNode(props, -5.0f, 0.0f, 0.0f);
+	TEST_CHECK(builder.Write(path));
+
+	struct CookCase
+	{
+		const char* arguments;
+		VertexFormat vertex_format;
+		bool compressed;
+	};
+	const CookCase cook_cases[] =
+	{
+		{ "", VertexFormat::Compact, true },
+		{ "--uncompressed", VertexFormat::Compact, false },
+		{ "--full", VertexFormat::Full, true },
+	};
+	for (const CookCase& cook_case : cook_cases)
+	{
+		TEST_CHECK(RunCooker(string("--force --threads 2 ") + cook_case.arguments + " \"" + path + "\""));
+		TEST_CHECK(std::filesystem::exists(get_scene_cache_path(path.c_str())));
+
+		GltfGeometry cooked;
+		TEST_CHECK(load_gltf_geometry(GltfGeometryDesc { .file = path.c_str(), .vertex_format = cook_case.vertex_format }, cooked));
+		TEST_CHECK(cooked.loaded_from_cache && !cooked.buffers_loaded);
+		TEST_CHECK(cooked.scene_cache.IsCompressed() == cook_case.compressed);
+
+		GltfGeometry converted;
+		const GltfGeometryDesc uncached_desc = { .file = path.c_str(), .use_scene_cache = false, .vertex_format = cook_case.vertex_format };
+		TEST_CHECK(load_gltf_geometry(uncached_desc, converted));
+		TEST_CHECK(!converted.loaded_from_cache);
+		TEST_CHECK(converted.meshes.size() == 3 && converted.instances.size() == 5);
+		TEST_CHECK(GeometryEqual(cooked, converted));
+	}
+
+	// Up to date now, so cooking again leaves the cache alone
+	const std::filesystem::file_time_type cooked_time = std::filesystem::last_write_time(get_scene_cache_path(path.c_str()));
+	TEST_CHECK(RunCooker("--full \"" + path + "\""));
+	TEST_CHECK(std::filesystem::last_write_time(get_scene_cache_path(path.c_str())) == cooked_time);
+
+	std::filesystem::remove_all(directory);
+}
+
+// A file that can't be cooked fails the run, without writing a cache
+void TestMissingFileFails()
+{
+	const std::filesystem::path directory = GetTestDirectory("CookerTests_missing");
+	const string path = (directory / "missing.gltf").string();
+	TEST_CHECK(!RunCooker("\"" + path + "\""));
+	TEST_CHECK(!std::filesystem::exists(get_scene_cache_path(path.c_str())));
+
+	std::filesystem::remove_all(directory);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		printf("Usage: CookerTests <path to Cooker>\n");
+		return 1;
+	}
+	g_cooker_path = argv[1];
+
+	TEST_RUN(TestCookedCacheMatchesConversion);
+	TEST_RUN(TestMissingFileFails);
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "DirtyRanges.h"
+#include "Test.h"
+
+using std::vector;
+
+bool RangesEqual(const DirtyRanges& in_ranges, const vector<DirtyRange>& in_expected)
+{
+	const span<const DirtyRange> ranges = in_ranges.Get();
+	if (ranges.size() != in_expected.size())
+	{
+		return false;
+	}
+	for (size_t range_idx = 0; range_idx < ranges.size(); ++range_idx)
+	{
+		if (ranges[range_idx].offset != in_expected[range_idx].offset || ranges[range_idx].size != in_expected[range_idx].size)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Disjoint ranges stay separate and come back sorted, whatever order they were added in
+void TestDisjoint()
+{
+	DirtyRanges ranges;
+	TEST_CHECK(ranges.IsEmpty());
+
+	ranges.Add(100, 10);
+	ranges.Add(0, 10);
+	ranges.Add(50, 10);
+	ranges.Add(200, 0);
+	TEST_CHECK(RangesEqual(ranges, { { 0, 10 }, { 50, 10 }, { 100, 10 } }));
+	TEST_CHECK(ranges.GetTotalSize() == 30);
+
+	ranges.Clear();
+	TEST_CHECK(ranges.IsEmpty());
+	TEST_CHECK(ranges.GetTotalSize() == 0);
+}
+
+// Ranges that touch or overlap merge, on either side and across any number of existing ranges
+void TestMerging()
+{
+	DirtyRanges ranges;
+	ranges.Add(10, 10);
+
+	// Touching the end, then the start
+	ranges.Add(20, 5);
+	ranges.Add(5, 5);
+	TEST_CHECK(RangesEqual(ranges, { { 5, 20 } }));
+
+	// Contained in an existing range
+	ranges.Add(12, 3);
+	TEST_CHECK(RangesEqual(ranges, { { 5, 20 } }));
+
+	// Spanning the gaps between several
+	ranges.Add(40, 5);
+	ranges.Add(60, 5);
+	ranges.Add(80, 5);
+	TEST_CHECK(RangesEqual(ranges, { { 5, 20 }, { 40, 5 }, { 60, 5 }, { 80, 5 } }));
+	ranges.Add(42, 40);
+	TEST_CHECK(RangesEqual(ranges, { { 5, 20 }, { 40, 45 } }));
+
+	// Bridging the last gap exactly
+	ranges.Add(25, 15);
+	TEST_CHECK(RangesEqual(ranges, { { 5, 80 } }));
+
+	// Covering everything
+	ranges.Add(0, 1000);
+	TEST_CHECK(RangesEqual(ranges, { { 0, 1000 } }));
+}
+
+// Random adds against a byte-per-byte reference: the ranges cover exactly the dirty bytes, sorted, with a gap between each
+void TestRandomized()
+{
+	const uint64_t buffer_size = 4096;
+	std::mt19937 rng(24680);
+	for (int round = 0; round < 50; ++round)
+	{
+		DirtyRanges ranges;
+		vector<bool> dirty(buffer_size, false);
+		for (int step = 0; step < 100; ++step)
+		{
+			const uint64_t offset = rng() % buffer_size;
+			const uint64_t size = (std::min)((uint64_t) (rng() % 64), buffer_size - offset);
+			ranges.Add(offset, size);
+			std::fill(dirty.begin() + offset, dirty.begin() + offset + size, true);
+
+			vector<bool> covered(buffer_size, false);
+			uint64_t previous_end = 0;
+			for (const DirtyRange& range : ranges.Get())
+			{
+				TEST_CHECK(range.size > 0);
+				TEST_CHECK(previous_end == 0 || range.offset > previous_end);
+				std::fill(covered.begin() + range.offset, covered.begin() + range.offset + range.size, true);
+				previous_end = range.offset + range.size;
+			}
+			TEST_CHECK(covered == dirty);
+		}
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestDisjoint);
+	TEST_RUN(TestMerging);
+	TEST_RUN(TestRandomized);
+	return 0;
+}
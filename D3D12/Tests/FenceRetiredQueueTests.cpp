@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FenceRetiredQueue.h"
+#include "Test.h"
+
+using std::vector;
+
+// Set from argv[0], so a test can run this executable again to watch it fail
+static std::string g_test_path;
+
+// Nothing retires before its fence value is reached, and once it is everything up to it retires, oldest first
+void TestRetireWaitsForFence()
+{
+	FenceRetiredQueue<uint32_t> queue;
+	TEST_CHECK(queue.IsEmpty() && queue.Retire(100) == 0);
+
+	const uint64_t fence_values[] = { 2, 2, 3, 5, 5, 5, 9 };
+	for (uint32_t object_idx = 0; object_idx < std::size(fence_values); ++object_idx)
+	{
+		queue.Push(uint32_t(object_idx), fence_values[object_idx]);
+	}
+	TEST_CHECK(queue.GetCount() == 7);
+
+	vector<uint32_t> retired;
+	auto on_retire = [&](const uint32_t& in_object)
+	{
+		retired.push_back(in_object);
+	};
+	TEST_CHECK(queue.Retire(0, on_retire) == 0);
+	TEST_CHECK(queue.Retire(1, on_retire) == 0);
+	TEST_CHECK(queue.Retire(2, on_retire) == 2);
+	TEST_CHECK(queue.Retire(2, on_retire) == 0);
+	TEST_CHECK(queue.Retire(4, on_retire) == 1);
+	TEST_CHECK(queue.GetCount() == 4);
+
+	// A completed fence value can skip past several pushes at once
+	TEST_CHECK(queue.Retire(8, on_retire) == 3);
+	TEST_CHECK(retired == vector<uint32_t>({ 0, 1, 2, 3, 4, 5 }));
+	TEST_CHECK(queue.GetCount() == 1);
+
+	TEST_CHECK(queue.Retire(UINT64_MAX, on_retire) == 1);
+	TEST_CHECK(queue.IsEmpty() && retired.back() == 6);
+}
+
+// Retired objects are destroyed right after in_on_retire sees them, while the ones still in flight stay alive
+void TestRetireDestroysObjects()
+{
+	std::shared_ptr<int> resource = std::make_shared<int>(7);
+	FenceRetiredQueue<std::shared_ptr<int>> queue;
+	queue.Push(std::shared_ptr<int>(resource), 1);
+	queue.Push(std::shared_ptr<int>(resource), 2);
+	TEST_CHECK(resource.use_count() == 3);
+
+	bool seen_alive = false;
+	TEST_CHECK(queue.Retire(1, [&](std::shared_ptr<int>& in_object)
+	{
+		seen_alive = in_object && *in_object == 7;
+	}) == 1);
+	TEST_CHECK(seen_alive && resource.use_count() == 2);
+
+	TEST_CHECK(queue.Retire(2) == 1);
+	TEST_CHECK(resource.use_count() == 1);
+}
+
+// Pushes interleaved with retires, like frames pushing what they replaced while the GPU catches up a few frames behind
+void TestInterleavedPushAndRetire()
+{
+	FenceRetiredQueue<uint64_t> queue;
+	uint64_t next_retired = 0;
+	uint64_t pushed_count = 0;
+	for (uint64_t frame = 1; frame <= 100; ++frame)
+	{
+		for (uint64_t push_idx = 0; push_idx < frame % 4; ++push_idx)
+		{
+			queue.Push(uint64_t(pushed_count++), frame);
+		}
+
+		const uint64_t completed_frame = frame > 2 ? frame - 2 : 0;
+		queue.Retire(completed_frame, [&](const uint64_t& in_object)
+		{
+			TEST_CHECK(in_object == next_retired);
+			++next_retired;
+		});
+	}
+	TEST_CHECK(next_retired + queue.GetCount() == pushed_count);
+
+	queue.Retire(100);
+	TEST_CHECK(queue.IsEmpty());
+}
+
+// Pushed with a fence value lower than the last one, Push asserts. Checked in a child process, since the assert aborts it
+void TestOutOfOrderPushAsserts()
+{
+#ifdef NDEBUG
+	printf("  asserts are compiled out, skipping\n");
+#else
+	const std::string command = "\"" + g_test_path + "\" --push-out-of-order";
+	fflush(stdout);
+	TEST_CHECK(std::system(command.c_str()) != 0);
+#endif
+}
+
+// What TestOutOfOrderPushAsserts runs in the child process. Returns 0, which would fail the test, if the assert doesn't fire
+int PushOutOfOrder()
+{
+	FenceRetiredQueue<uint32_t> queue;
+	queue.Push(0, 5);
+	queue.Push(1, 4);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 2 && strcmp(argv[1], "--push-out-of-order") == 0)
+	{
+		return PushOutOfOrder();
+	}
+	g_test_path = argv[0];
+
+	TEST_RUN(TestRetireWaitsForFence);
+	TEST_RUN(TestRetireDestroysObjects);
+	TEST_RUN(TestInterleavedPushAndRetire);
+	TEST_RUN(TestOutOfOrderPushAsserts);
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "FenceRetiredQueue.h"
+#include "FrameIndices.h"
+#include "Test.h"
+
+static constexpr uint32_t TEST_FRAME_COUNT = 3;
+
+/*	Stands in for FrameData: a fence the GPU advances when it finishes a frame, and a queue of objects retired against it,
+	pushed with the current frame's index the way texture streaming retires replaced textures
+*/
+struct FrameSimulation
+{
+	FrameIndices<TEST_FRAME_COUNT> frame_indices;
+	uint64_t completed_frame = 0;
+	uint64_t last_pushed_frame = 0;
+	FenceRetiredQueue<uint64_t> retired_objects;
+
+	// Waiting on a frame lets the GPU catch up to it. Every retired object must have been pushed on a completed frame
+	void WaitForFrame(const uint64_t in_frame)
+	{
+		TEST_CHECK(in_frame < frame_indices.GetCurrentFrame());
+		completed_frame = (std::max)(completed_frame, in_frame);
+		retired_objects.Retire(completed_frame, [&](const uint64_t& in_pushed_frame)
+		{
+			TEST_CHECK(in_pushed_frame <= completed_frame);
+		});
+	}
+
+	// A frame may render more than once, as a resize keeps the current frame going
+	void RenderFrame()
+	{
+		TEST_CHECK(frame_indices.GetCurrentFrame() >= last_pushed_frame);
+		last_pushed_frame = frame_indices.GetCurrentFrame();
+		retired_objects.Push(uint64_t(last_pushed_frame), last_pushed_frame);
+	}
+
+	void PresentFrame(const uint32_t in_next_backbuffer_index)
+	{
+		const uint64_t submitted_frame = frame_indices.GetCurrentFrame();
+		WaitForFrame(frame_indices.BeginNextFrame(in_next_backbuffer_index));
+		TEST_CHECK(frame_indices.GetCurrentFrame() == submitted_frame + 1);
+	}
+
+	void Resize(const uint32_t in_new_backbuffer_index)
+	{
+		const uint64_t current_frame = frame_indices.GetCurrentFrame();
+		WaitForFrame(frame_indices.GetLastSubmittedFrame());
+		for (uint32_t backbuffer_index = 0; backbuffer_index < TEST_FRAME_COUNT; ++backbuffer_index)
+		{
+			if (backbuffer_index != frame_indices.GetBackbufferIndex())
+			{
+				TEST_CHECK(frame_indices.GetFrame(backbuffer_index) <= completed_frame);
+			}
+		}
+
+		frame_indices.OnResize(in_new_backbuffer_index);
+		TEST_CHECK(frame_indices.GetCurrentFrame() == current_frame);
+		TEST_CHECK(frame_indices.GetBackbufferIndex() == in_new_backbuffer_index);
+	}
+};
+
+// Frames start at 1, since a fence starts out having completed 0, and each backbuffer waits on the frame that last used it
+void TestFrameSequence()
+{
+	FrameSimulation simulation;
+	TEST_CHECK(simulation.frame_indices.GetCurrentFrame() == 1);
+	TEST_CHECK(simulation.frame_indices.GetBackbufferIndex() == 0);
+
+	const uint64_t expected_waits[] = { 0, 0, 1, 2, 3, 4 };
+	for (const uint64_t expected_wait : expected_waits)
+	{
+		simulation.RenderFrame();
+		const uint32_t next_backbuffer_index = (simulation.frame_indices.GetBackbufferIndex() + 1) % TEST_FRAME_COUNT;
+		const uint64_t submitted_frame = simulation.frame_indices.GetCurrentFrame();
+		TEST_CHECK(simulation.frame_indices.BeginNextFrame(next_backbuffer_index) == expected_wait);
+		TEST_CHECK(simulation.frame_indices.GetCurrentFrame() == submitted_frame + 1);
+	}
+	TEST_CHECK(simulation.frame_indices.GetCurrentFrame() == 7);
+}
+
+/*	Regression: resizing used to reset every backbuffer's frame index to 0, so frame indices went backwards and a FenceRetiredQueue pushed
+	with them either asserted or released objects still in use. Resizes at any point, onto any backbuffer, back to back, keep them increasing
+*/
+void TestFrameIndicesIncreaseAcrossResize()
+{
+	FrameSimulation simulation;
+
+	// Resizing before the first frame, like FrameData's constructor does
+	simulation.Resize(0);
+	TEST_CHECK(simulation.frame_indices.GetCurrentFrame() == 1);
+
+	uint32_t swapchain_backbuffer_index = 0;
+	for (uint32_t frame_idx = 0; frame_idx < 200; ++frame_idx)
+	{
+		simulation.RenderFrame();
+		if (frame_idx % 7 == 3)
+		{
+			// Recreated swapchains don't necessarily start at the same backbuffer
+			swapchain_backbuffer_index = (swapchain_backbuffer_index + frame_idx) % TEST_FRAME_COUNT;
+			simulation.Resize(swapchain_backbuffer_index);
+			if (frame_idx % 3 == 0)
+			{
+				simulation.Resize((swapchain_backbuffer_index + 1) % TEST_FRAME_COUNT);
+			}
+			simulation.RenderFrame();
+		}
+
+		swapchain_backbuffer_index = (simulation.frame_indices.GetBackbufferIndex() + 1) % TEST_FRAME_COUNT;
+		simulation.PresentFrame(swapchain_backbuffer_index);
+	}
+
+	// Once the GPU is idle everything pushed has been retired
+	simulation.WaitForFrame(simulation.frame_indices.GetLastSubmittedFrame());
+	TEST_CHECK(simulation.retired_objects.IsEmpty());
+}
+
+int main()
+{
+	TEST_RUN(TestFrameSequence);
+	TEST_RUN(TestFrameIndicesIncreaseAcrossResize);
+	return 0;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "FreeListAllocator.h"
+#include "Test.h"
+
+using std::vector;
+
+bool Overlaps(const FreeListAllocation& in_a, const FreeListAllocation& in_b)
+{
+	return in_a.offset < in_b.offset + in_b.size && in_b.offset < in_a.offset + in_a.size;
+}
+
+void TestAllocateAndFreeAll()
+{
+	FreeListAllocator allocator(1024);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1024);
+
+	const optional<FreeListAllocation> a = allocator.Allocate(100);
+	const optional<FreeListAllocation> b = allocator.Allocate(200);
+	TEST_CHECK(a && b);
+	TEST_CHECK(!Overlaps(*a, *b));
+	TEST_CHECK(allocator.GetUsedSize() == 300);
+	TEST_CHECK(allocator.GetAllocationCount() == 2);
+
+	allocator.Free(*a);
+	allocator.Free(*b);
+	TEST_CHECK(allocator.GetUsedSize() == 0);
+	TEST_CHECK(allocator.GetAllocationCount() == 0);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1024);
+}
+
+void TestAllocateFailures()
+{
+	FreeListAllocator allocator(256);
+	TEST_CHECK(!allocator.Allocate(0));
+	TEST_CHECK(!allocator.Allocate(257));
+
+	const optional<FreeListAllocation> whole = allocator.Allocate(256);
+	TEST_CHECK(whole && whole->offset == 0);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 0);
+	TEST_CHECK(!allocator.Allocate(1));
+
+	TEST_CHECK(!FreeListAllocator().Allocate(1));
+}
+
+// A freed block merges with free neighbors on both sides, in whatever order they're freed
+void TestCoalescing()
+{
+	FreeListAllocator allocator(400);
+	const FreeListAllocation a = *allocator.Allocate(100);
+	const FreeListAllocation b = *allocator.Allocate(100);
+	const FreeListAllocation c = *allocator.Allocate(100);
+	const FreeListAllocation d = *allocator.Allocate(100);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 0);
+
+	// Non-adjacent frees stay separate blocks
+	allocator.Free(a);
+	allocator.Free(c);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 2);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 100);
+
+	// Freeing b merges with both a (before) and c (after)
+	allocator.Free(b);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 300);
+
+	// And the merged block can be handed out whole
+	const optional<FreeListAllocation> merged = allocator.Allocate(300);
+	TEST_CHECK(merged && merged->offset == 0);
+
+	allocator.Free(*merged);
+	allocator.Free(d);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 400);
+}
+
+// Each allocation takes the smallest free block it fits in
+void TestBestFit()
+{
+	FreeListAllocator allocator(1000);
+	const FreeListAllocation a = *allocator.Allocate(300);
+	const FreeListAllocation separator_0 = *allocator.Allocate(10);
+	const FreeListAllocation b = *allocator.Allocate(100);
+	const FreeListAllocation separator_1 = *allocator.Allocate(10);
+	(void) separator_0;
+	(void) separator_1;
+
+	// Free blocks: 300 at a, 100 at b and the 580 byte tail
+	allocator.Free(a);
+	allocator.Free(b);
+
+	const optional<FreeListAllocation> small = allocator.Allocate(80);
+	TEST_CHECK(small && small->offset == b.offset);
+
+	const optional<FreeListAllocation> medium = allocator.Allocate(250);
+	TEST_CHECK(medium && medium->offset == a.offset);
+}
+
+void TestFragmentation()
+{
+	FreeListAllocator allocator(1000);
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+
+	vector<FreeListAllocation> allocations;
+	for (int i = 0; i < 10; ++i)
+	{
+		allocations.push_back(*allocator.Allocate(100));
+	}
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+
+	// Every other block free: 500 bytes free, but no more than 100 contiguous
+	for (size_t allocation_idx = 0; allocation_idx < allocations.size(); allocation_idx += 2)
+	{
+		allocator.Free(allocations[allocation_idx]);
+	}
+	TEST_CHECK(allocator.GetFreeSize() == 500);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 100);
+	TEST_CHECK_NEAR(allocator.GetFragmentation(), 0.8f, 1e-6f);
+	TEST_CHECK(!allocator.Allocate(101));
+
+	// Freeing the rest brings it back to a single block
+	for (size_t allocation_idx = 1; allocation_idx < allocations.size(); allocation_idx += 2)
+	{
+		allocator.Free(allocations[allocation_idx]);
+	}
+	TEST_CHECK(allocator.GetFragmentation() == 0.0f);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == 1000);
+}
+
+// Aligned allocations start aligned, and the padding in front of them goes back to the free list rather than being lost
+void TestAlignment()
+{
+	FreeListAllocator allocator(1024);
+	const FreeListAllocation unaligned = *allocator.Allocate(3);
+	TEST_CHECK(unaligned.offset == 0);
+
+	const optional<FreeListAllocation> aligned = allocator.Allocate(64, 256);
+	TEST_CHECK(aligned && aligned->offset == 256);
+	TEST_CHECK(allocator.GetUsedSize() == 67);
+
+	// The padding between the two is free for small allocations to use
+	const optional<FreeListAllocation> in_padding = allocator.Allocate(200, 4);
+	TEST_CHECK(in_padding && in_padding->offset == 4);
+
+	// A block that's big enough but can't fit the alignment is skipped: 52 bytes free at 204, but the next 64 aligned offset is 256
+	TEST_CHECK(allocator.GetLargestFreeBlock() >= 52);
+	const optional<FreeListAllocation> skipped = allocator.Allocate(48, 64);
+	TEST_CHECK(skipped && skipped->offset % 64 == 0 && skipped->offset >= 320);
+
+	allocator.Free(*skipped);
+	allocator.Free(*in_padding);
+	allocator.Free(*aligned);
+	allocator.Free(unaligned);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetUsedSize() == 0);
+}
+
+// Random allocations and frees never overlap or leak, and everything coalesces back into one block at the end
+void TestRandomized()
+{
+	const uint64_t capacity = 1 << 20;
+	FreeListAllocator allocator(capacity);
+
+	std::mt19937 rng(424242);
+	std::uniform_int_distribution<uint64_t> size_distribution(1, 4096);
+	std::uniform_int_distribution<uint32_t> alignment_shift_distribution(0, 8);
+
+	vector<FreeListAllocation> allocations;
+	uint64_t expected_used_size = 0;
+	for (int step = 0; step < 20000; ++step)
+	{
+		if (allocations.empty() || rng() % 3 != 0)
+		{
+			const uint64_t alignment = 1ull << alignment_shift_distribution(rng);
+			const optional<FreeListAllocation> allocation = allocator.Allocate(size_distribution(rng), alignment);
+			if (allocation)
+			{
+				TEST_CHECK(allocation->offset % alignment == 0);
+				TEST_CHECK(allocation->offset + allocation->size <= capacity);
+				allocations.push_back(*allocation);
+				expected_used_size += allocation->size;
+			}
+		}
+		else
+		{
+			const size_t allocation_idx = rng() % allocations.size();
+			allocator.Free(allocations[allocation_idx]);
+			expected_used_size -= allocations[allocation_idx].size;
+			allocations[allocation_idx] = allocations.back();
+			allocations.pop_back();
+		}
+		TEST_CHECK(allocator.GetUsedSize() == expected_used_size);
+	}
+
+	std::sort(allocations.begin(), allocations.end(), [](const FreeListAllocation& a, const FreeListAllocation& b) { return a.offset < b.offset; });
+	for (size_t allocation_idx = 1; allocation_idx < allocations.size(); ++allocation_idx)
+	{
+		TEST_CHECK(!Overlaps(allocations[allocation_idx - 1], allocations[allocation_idx]));
+	}
+
+	for (const FreeListAllocation& allocation : allocations)
+	{
+		allocator.Free(allocation);
+	}
+	TEST_CHECK(allocator.GetUsedSize() == 0);
+	TEST_CHECK(allocator.GetFreeBlockCount() == 1);
+	TEST_CHECK(allocator.GetLargestFreeBlock() == capacity);
+}
+
+int main()
+{
+	TEST_RUN(TestAllocateAndFreeAll);
+	TEST_RUN(TestAllocateFailures);
+	TEST_RUN(TestCoalescing);
+	TEST_RUN(TestBestFit);
+	TEST_RUN(TestFragmentation);
+	TEST_RUN(TestAlignment);
+	TEST_RUN(TestRandomized);
+	return 0;
+}
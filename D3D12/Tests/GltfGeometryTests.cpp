@@ -0,0 +1,243 @@
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GltfConversion.h"
+#include "Test.h"
+#include "TestGeometry.h"
+#include "TestGltf.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string;
+using std::vector;
+
+// Two meshes, one of them drawn twice
+TestGltfBuilder MakeTestScene()
+{
+	TestGltfBuilder builder;
+	const uint32_t ground = builder.AddMesh({ builder.AddGridPrimitive(16, 0.0f) });
+	const uint32_t props = builder.AddMesh({ builder.AddGridPrimitive(4, 1.0f), builder.AddGridPrimitive(6, 2.0f) });
+	builder.AddNode(ground);
+	builder.AddNode(props, 5.0f, 0.0f, 0.0f);
+	builder.AddNode(props, -5.0f, 0.0f, 0.0f);
+	return builder;
+}
+
+// Files that aren't gltfs, or don't exist, fail without leaving anything behind or writing a cache
+void TestMalformedFile()
+{
+	const std::filesystem::path directory = GetTestDirectory("GltfGeometryTests_malformed");
+
+	const std::filesystem::path garbage_path = directory / "garbage.gltf";
+	const char garbage[] = "{ \"asset\": { \"version\": \"2.0\" }, \"meshes\": [ { \"primitives\": [ { \"attrib";
+	FILE* file = fopen(garbage_path.string().c_str(), "wb");
+	TEST_CHECK(file && fwrite(garbage, 1, sizeof(garbage) - 1, file) == sizeof(garbage) - 1);
+	fclose(file);
+
+	const std::filesystem::path missing_path = directory / "missing.gltf";
+	for (const std::filesystem::path& path : { garbage_path, missing_path })
+	{
+		const string path_string = path.string();
+		GltfGeometry geometry;
+		TEST_CHECK(!load_gltf_geometry(GltfGeometryDesc { .file = path_string.c_str() }, geometry));
+		TEST_CHECK(!geometry.data);
+		TEST_CHECK(geometry.meshes.empty() && geometry.instances.empty());
+		TEST_CHECK(!std::filesystem::exists(get_scene_cache_path(path_string.c_str())));
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+// A valid gltf whose buffer is missing fails the same way, rather than converting garbage
+void TestMissingBuffer()
+{
+	const std::filesystem::path directory = GetTestDirectory("GltfGeometryTests_missing_buffer");
+	const string path = (directory / "scene.gltf").string();
+	TEST_CHECK(MakeTestScene().Write(path));
+	std::filesystem::remove(directory / "scene.bin");
+
+	GltfGeometry geometry;
+	TEST_CHECK(!load_gltf_geometry(GltfGeometryDesc { .file = path.c_str() }, geometry));
+	TEST_CHECK(!geometry.data && !geometry.buffers_loaded);
+	TEST_CHECK(geometry.source_files.empty());
+	TEST_CHECK(geometry.meshes.empty());
+	TEST_CHECK(!std::filesystem::exists(get_scene_cache_path(path.c_str())));
+
+	std::filesystem::remove_all(directory);
+}
+
+// The first load converts and writes a cache, the second loads the exact same geometry out of it without touching the buffers
+void TestSceneCacheRoundTrip()
+{
+	const std::filesystem::path directory = GetTestDirectory("GltfGeometryTests_round_trip");
+	const string path = (directory / "scene.gltf").string();
+	TEST_CHECK(MakeTestScene().Write(path));
+
+	for (const SceneCacheCompression compression : { SceneCacheCompression::None, SceneCacheCompression::Deflate })
+	{
+		ThreadPool thread_pool(3);
+		const GltfGeometryDesc desc =
+		{
+			.file = path.c_str(),
+			.scene_cache_compression = compression,
+			.thread_pool = &thread_pool,
+		};
+
+		std::filesystem::remove(get_scene_cache_path(path.c_str()));
+		GltfGeometry converted;
+		TEST_CHECK(load_gltf_geometry(desc, converted));
+		TEST_CHECK(!converted.loaded_from_cache && converted.buffers_loaded);
+		TEST_CHECK(converted.meshes.size() == 3 && converted.instances.size() == 5);
+		TEST_CHECK(converted.source_files.size() == 2);
+		TEST_CHECK(std::filesystem::exists(get_scene_cache_path(path.c_str())));
+
+		GltfGeometry cached;
+		TEST_CHECK(load_gltf_geometry(desc, cached));
+		TEST_CHECK(cached.loaded_from_cache && !cached.buffers_loaded);
+		TEST_CHECK(cached.data);
+		TEST_CHECK(cached.scene_cache.IsCompressed() == (compression != SceneCacheCompression::None));
+		TEST_CHECK(GeometryEqual(converted, cached));
+
+		// Without the cache, the geometry is converted again, identically
+		GltfGeometry reconverted;
+		GltfGeometryDesc uncached_desc = desc;
+		uncached_desc.use_scene_cache = false;
+		TEST_CHECK(load_gltf_geometry(uncached_desc, reconverted));
+		TEST_CHECK(!reconverted.loaded_from_cache);
+		TEST_CHECK(GeometryEqual(converted, reconverted));
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+// Nodes sharing a mesh, and a primitive repeating another's data under a different mesh, all draw one converted mesh
+void TestMeshDeduplication()
+{
+	const std::filesystem::path directory = GetTestDirectory("GltfGeometryTests_dedup");
+	const string path = (directory / "scene.gltf").string();
+
+	TestGltfBuilder builder;
+	const uint32_t shared_primitive = builder.AddGridPrimitive(8, 0.0f);
+	const uint32_t shared_mesh = builder.AddMesh({ shared_primitive });
+	const uint32_t duplicate_mesh = builder.AddMesh({ builder.AddDuplicatePrimitive(shared_primitive) });
+	const uint32_t other_mesh = builder.AddMesh({ builder.AddGridPrimitive(8, 1.0f) });
+	builder.AddNode(shared_mesh);
+	builder.AddNode(shared_mesh, 5.0f, 0.0f, 0.0f);
+	builder.AddNode(duplicate_mesh, -5.0f, 0.0f, 0.0f);
+	builder.AddNode(other_mesh, 0.0f, 0.0f, 5.0f);
+	TEST_CHECK(builder.Write(path));
+
+	GltfGeometry converted;
+	TEST_CHECK(load_gltf_geometry(GltfGeometryDesc { .file = path.c_str() }, converted));
+	TEST_CHECK(converted.converted_meshes.size() == 2);
+	TEST_CHECK(converted.meshes.size() == 2 && converted.instances.size() == 4);
+
+	const uint32_t shared_mesh_index = converted.instances[0].mesh_index;
+	TEST_CHECK(converted.instances[1].mesh_index == shared_mesh_index);
+	TEST_CHECK(converted.instances[2].mesh_index == shared_mesh_index);
+	TEST_CHECK(converted.instances[3].mesh_index != shared_mesh_index);
+	TEST_CHECK(converted.meshes[0].source_hash != converted.meshes[1].source_hash);
+
+	// The cache holds the deduplicated meshes
+	GltfGeometry cached;
+	TEST_CHECK(load_gltf_geometry(GltfGeometryDesc { .file = path.c_str() }, cached));
+	TEST_CHECK(cached.loaded_from_cache);
+	TEST_CHECK(GeometryEqual(converted, cached));
+
+	std::filesystem::remove_all(directory);
+}
+
+// Parses in_path and loads its buffers, the way GltfScene::Reload does. Returns null on failure
+cgltf_data* ParseScene(const string& in_path)
+{
+	cgltf_options options = {};
+	cgltf_data* data = nullptr;
+	if (cgltf_parse_file(&options, in_path.c_str(), &data) != cgltf_result_success)
+	{
+		return nullptr;
+	}
+	if (cgltf_load_buffers(&options, data, in_path.c_str()) != cgltf_result_success)
+	{
+		cgltf_free(data);
+		return nullptr;
+	}
+	return data;
+}
+
+// Reloading after editing one primitive converts just that one. The rest, the other primitive of the same gltf mesh included, reuse what was loaded
+void TestReloadReconvertsChangedPrimitive()
+{
+	const std::filesystem::path directory = GetTestDirectory("GltfGeometryTests_reload");
+	const string path = (directory / "scene.gltf").string();
+	TestGltfBuilder builder = MakeTestScene();
+	TEST_CHECK(builder.Write(path));
+
+	cgltf_data* loaded_data = ParseScene(path);
+	TEST_CHECK(loaded_data);
+	GltfSceneLayout loaded_layout = extract_scene_layout(*loaded_data);
+	dedupe_scene_layout(*loaded_data, loaded_layout, nullptr);
+	TEST_CHECK(loaded_layout.meshes.size() == 3);
+	const GltfConvertedMeshes loaded_meshes = convert_primitives(loaded_layout.meshes, *loaded_data, VertexFormat::Full, nullptr);
+
+	// Nothing to reuse on the first load, everything to reuse when nothing changed
+	const GltfReloadPlan initial_plan = plan_scene_reload(loaded_layout, {});
+	TEST_CHECK(initial_plan.changed_meshes.size() == 3 && initial_plan.kept_meshes.empty());
+	const GltfReloadPlan unchanged_plan = plan_scene_reload(loaded_layout, loaded_layout.mesh_hashes);
+	TEST_CHECK(unchanged_plan.changed_meshes.empty());
+	for (uint32_t mesh_idx = 0; mesh_idx < 3; ++mesh_idx)
+	{
+		TEST_CHECK(unchanged_plan.reused_meshes[mesh_idx] == mesh_idx && unchanged_plan.kept_meshes[mesh_idx]);
+	}
+
+	// The first primitive of the props mesh (see MakeTestScene)
+	builder.ChangePrimitive(1);
+	TEST_CHECK(builder.Write(path));
+
+	cgltf_data* reloaded_data = ParseScene(path);
+	TEST_CHECK(reloaded_data);
+	GltfSceneLayout reloaded_layout = extract_scene_layout(*reloaded_data);
+	dedupe_scene_layout(*reloaded_data, reloaded_layout, nullptr);
+	TEST_CHECK(reloaded_layout.meshes.size() == 3);
+	const uint32_t changed_mesh = reloaded_layout.mesh_lookup.at(&reloaded_data->meshes[1].primitives[0]);
+
+	const GltfReloadPlan plan = plan_scene_reload(reloaded_layout, loaded_layout.mesh_hashes);
+	TEST_CHECK(plan.changed_meshes.size() == 1 && plan.changed_meshes[0] == changed_mesh);
+	TEST_CHECK(plan.reused_meshes[changed_mesh] == UINT32_MAX && !plan.kept_meshes[changed_mesh]);
+
+	// What's reused is what converting the reloaded file from scratch gives, and so is the one mesh that's converted again
+	const GltfConvertedMeshes all_meshes = convert_primitives(reloaded_layout.meshes, *reloaded_data, VertexFormat::Full, nullptr);
+	for (uint32_t mesh_idx = 0; mesh_idx < 3; ++mesh_idx)
+	{
+		if (mesh_idx != changed_mesh)
+		{
+			TEST_CHECK(plan.reused_meshes[mesh_idx] == mesh_idx && plan.kept_meshes[mesh_idx]);
+			TEST_CHECK(MeshEqual(loaded_meshes.meshes[mesh_idx].GetView(), all_meshes.meshes[mesh_idx].GetView()));
+		}
+	}
+
+	const vector<cgltf_primitive*> changed_primitives = { reloaded_layout.meshes[changed_mesh] };
+	const GltfConvertedMeshes changed_meshes = convert_primitives(changed_primitives, *reloaded_data, VertexFormat::Full, nullptr);
+	TEST_CHECK(changed_meshes.meshes.size() == 1);
+	TEST_CHECK(MeshEqual(changed_meshes.meshes[0].GetView(), all_meshes.meshes[changed_mesh].GetView()));
+	TEST_CHECK(!MeshEqual(changed_meshes.meshes[0].GetView(), loaded_meshes.meshes[changed_mesh].GetView()));
+
+	cgltf_free(loaded_data);
+	cgltf_free(reloaded_data);
+	std::filesystem::remove_all(directory);
+}
+
+int main()
+{
+	TEST_RUN(TestMalformedFile);
+	TEST_RUN(TestMissingBuffer);
+	TEST_RUN(TestSceneCacheRoundTrip);
+	TEST_RUN(TestMeshDeduplication);
+	TEST_RUN(TestReloadReconvertsChangedPrimitive);
+	return 0;
+}
@@ -0,0 +1,180 @@
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "GltfConversion.h"
+#include "Test.h"
+
+#define CGLTF_IMPLEMENTATION
+#include "cgltf/cgltf.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::string_view;
+using std::vector;
+
+/*	Two quads sharing texcoords and indices. Primitive 2 is a copy of primitive 0, primitive 1 has its own positions and a material with a
+	texture transform. The buffer ends in 4 bytes that no accessor reads
+*/
+static constexpr string_view TEST_GLTF = R"({
+	"asset": { "version": "2.0" },
+	"buffers": [ { "byteLength": 144 } ],
+	"bufferViews": [
+		{ "buffer": 0, "byteOffset": 0, "byteLength": 96, "byteStride": 12 },
+		{ "buffer": 0, "byteOffset": 96, "byteLength": 32 },
+		{ "buffer": 0, "byteOffset": 128, "byteLength": 12 }
+	],
+	"accessors": [
+		{ "bufferView": 0, "byteOffset": 0, "count": 4, "componentType": 5126, "type": "VEC3" },
+		{ "bufferView": 0, "byteOffset": 48, "count": 4, "componentType": 5126, "type": "VEC3" },
+		{ "bufferView": 1, "count": 4, "componentType": 5126, "type": "VEC2" },
+		{ "bufferView": 2, "count": 6, "componentType": 5123, "type": "SCALAR" }
+	],
+	"textures": [ {} ],
+	"materials": [
+		{},
+		{ "pbrMetallicRoughness": { "baseColorTexture": { "index": 0, "extensions": { "KHR_texture_transform": { "offset": [ 0.5, 0.0 ], "scale": [ 2.0, 2.0 ] } } } } }
+	],
+	"meshes": [ { "primitives": [
+		{ "attributes": { "POSITION": 0, "TEXCOORD_0": 2 }, "indices": 3, "material": 0 },
+		{ "attributes": { "POSITION": 1, "TEXCOORD_0": 2 }, "indices": 3, "material": 1 },
+		{ "attributes": { "POSITION": 0, "TEXCOORD_0": 2 }, "indices": 3, "material": 0 }
+	] } ]
+})";
+
+static constexpr size_t POSITIONS_A_OFFSET = 0;
+static constexpr size_t POSITIONS_B_OFFSET = 48;
+static constexpr size_t TEXCOORDS_OFFSET = 96;
+static constexpr size_t INDICES_OFFSET = 128;
+static constexpr size_t UNUSED_OFFSET = 140;
+
+// TEST_GLTF parsed, with its buffer filled in from memory rather than loaded
+struct TestGltf
+{
+	TestGltf()
+	{
+		const cgltf_options options = {};
+		TEST_CHECK(cgltf_parse(&options, TEST_GLTF.data(), TEST_GLTF.size(), &data) == cgltf_result_success);
+
+		const float positions[] = {
+			0.0f, 0.0f, 0.0f,	1.0f, 0.0f, 0.0f,	1.0f, 1.0f, 0.0f,	0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 1.0f,	2.0f, 0.0f, 1.0f,	2.0f, 2.0f, 1.0f,	0.0f, 2.0f, 1.0f,
+		};
+		const float texcoords[] = { 0.0f, 0.0f,		1.0f, 0.0f,		1.0f, 1.0f,		0.0f, 1.0f };
+		const uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+		buffer.resize(data->buffers[0].size);
+		memcpy(buffer.data() + POSITIONS_A_OFFSET, positions, sizeof(positions));
+		memcpy(buffer.data() + TEXCOORDS_OFFSET, texcoords, sizeof(texcoords));
+		memcpy(buffer.data() + INDICES_OFFSET, indices, sizeof(indices));
+
+		// cgltf leaves buffers it didn't load alone when freeing
+		data->buffers[0].data = buffer.data();
+	}
+
+	~TestGltf()
+	{
+		cgltf_free(data);
+	}
+
+	TestGltf(const TestGltf&) = delete;
+	TestGltf& operator=(const TestGltf&) = delete;
+
+	// Hashes every primitive the way GltfScene does
+	vector<uint64_t> HashPrimitives()
+	{
+		cgltf_mesh& mesh = data->meshes[0];
+		vector<uint64_t> hashes;
+		for (size_t primitive_idx = 0; primitive_idx < mesh.primitives_count; ++primitive_idx)
+		{
+			cgltf_primitive& primitive = mesh.primitives[primitive_idx];
+			const uint32_t material_index = primitive.material ? (uint32_t) (primitive.material - data->materials) : INVALID_MATERIAL_INDEX;
+			hashes.push_back(hash_primitive(primitive, material_index));
+		}
+		return hashes;
+	}
+
+	cgltf_data* data = nullptr;
+	vector<uint8_t> buffer;
+};
+
+/*	Hashes are stored in the scene cache and compared against freshly computed ones on reload, so they must not change between runs or builds.
+	If these values change on purpose, bump SCENE_CACHE_VERSION
+*/
+void TestHashCombine()
+{
+	TEST_CHECK(hash_combine(0, 1) == UINT64_C(0x9E3779B97F4A7C15));
+	TEST_CHECK(hash_combine(hash_combine(0, 1), 2) == UINT64_C(0x7A7BA6D34C68D209));
+
+	// Order matters, so swapped attributes or indices don't collide
+	TEST_CHECK(hash_combine(hash_combine(0, 1), 2) != hash_combine(hash_combine(0, 2), 1));
+	TEST_CHECK(hash_combine(hash_combine(0, 1), 2) != hash_combine(hash_combine(0, 1), 3));
+}
+
+// The same gltf hashes the same across separate parses, and identical primitives collapse to the same hash
+void TestHashDeterministic()
+{
+	TestGltf gltf_a;
+	TestGltf gltf_b;
+	const vector<uint64_t> hashes_a = gltf_a.HashPrimitives();
+	TEST_CHECK(hashes_a == gltf_b.HashPrimitives());
+	TEST_CHECK(hashes_a == gltf_a.HashPrimitives());
+
+	TEST_CHECK(hashes_a[0] == hashes_a[2]);
+	TEST_CHECK(hashes_a[0] != hashes_a[1]);
+	TEST_CHECK(hashes_a[0] == UINT64_C(0x6A7E9B7B355958F5));
+
+	TEST_CHECK(hash_accessor(nullptr) == 0);
+}
+
+// Returns which primitives' hashes differ from in_baseline after in_change
+template<typename ChangeFunction>
+vector<bool> GetChangedPrimitives(const vector<uint64_t>& in_baseline, ChangeFunction&& in_change)
+{
+	TestGltf gltf;
+	in_change(gltf);
+	const vector<uint64_t> hashes = gltf.HashPrimitives();
+
+	vector<bool> changed;
+	for (size_t primitive_idx = 0; primitive_idx < hashes.size(); ++primitive_idx)
+	{
+		changed.push_back(hashes[primitive_idx] != in_baseline[primitive_idx]);
+	}
+	return changed;
+}
+
+// Each change to something a primitive is converted from changes that primitive's hash, and only the hashes of primitives that use it
+void TestHashSensitivity()
+{
+	const vector<uint64_t> baseline = TestGltf().HashPrimitives();
+
+	// Vertex data
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.buffer[POSITIONS_A_OFFSET + 4] ^= 1; }) == vector<bool> { true, false, true }));
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.buffer[POSITIONS_B_OFFSET + 47] ^= 1; }) == vector<bool> { false, true, false }));
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.buffer[TEXCOORDS_OFFSET] ^= 1; }) == vector<bool> { true, true, true }));
+
+	// Bytes no accessor reads
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.buffer[UNUSED_OFFSET] ^= 1; }) == vector<bool> { false, false, false }));
+
+	// Accessor layout and format
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->accessors[0].stride = 24; }) == vector<bool> { true, false, true }));
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->accessors[1].count = 3; }) == vector<bool> { false, true, false }));
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->accessors[3].component_type = cgltf_component_type_r_8u; }) == vector<bool> { true, true, true }));
+
+	// Which accessor an attribute reads from
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->meshes[0].primitives[2].attributes[0].data = &gltf.data->accessors[1]; }) == vector<bool> { false, false, true }));
+
+	// Materials, and the texture transform that gets baked into the texcoords
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->meshes[0].primitives[0].material = &gltf.data->materials[1]; }) == vector<bool> { true, false, false }));
+	TEST_CHECK((GetChangedPrimitives(baseline, [](TestGltf& gltf) { gltf.data->materials[1].pbr_metallic_roughness.base_color_texture.transform.offset[0] = 0.25f; }) == vector<bool> { false, true, false }));
+}
+
+int main()
+{
+	TEST_RUN(TestHashCombine);
+	TEST_RUN(TestHashDeterministic);
+	TEST_RUN(TestHashSensitivity);
+	return 0;
+}
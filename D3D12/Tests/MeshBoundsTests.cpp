@@ -0,0 +1,132 @@
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "MeshBounds.h"
+#include "Test.h"
+
+using std::vector;
+
+// compute_bounds against the scalar reference. Float compares, so a zero's sign may differ where lanes were reduced in another order
+bool BoundsMatchScalar(const vector<float3>& in_positions)
+{
+	const Bounds bounds = compute_bounds(in_positions);
+	const Bounds scalar_bounds = compute_bounds_scalar(in_positions);
+	return bounds.aabb_min.x == scalar_bounds.aabb_min.x && bounds.aabb_min.y == scalar_bounds.aabb_min.y && bounds.aabb_min.z == scalar_bounds.aabb_min.z
+		&& bounds.aabb_max.x == scalar_bounds.aabb_max.x && bounds.aabb_max.y == scalar_bounds.aabb_max.y && bounds.aabb_max.z == scalar_bounds.aabb_max.z
+		&& bounds.radius == scalar_bounds.radius;
+}
+
+// Every count from 0 to past a few SIMD iterations, so the remainder loop runs with 0 to 3 positions, and a few larger meshes
+vector<size_t> GetPositionCounts()
+{
+	vector<size_t> counts;
+	for (size_t count = 0; count <= 33; ++count)
+	{
+		counts.push_back(count);
+	}
+	for (const size_t count : { 255, 256, 257, 1000, 1003, 65537 })
+	{
+		counts.push_back(count);
+	}
+	return counts;
+}
+
+// Random meshes, both around the origin and far from it, where the center has rounding error the radius depends on
+void TestRandomPositions()
+{
+	std::mt19937 rng(24680);
+	const std::pair<float, float> ranges[] = { { -1.0f, 1.0f }, { -1000.0f, 1000.0f }, { 10000.0f, 10001.0f }, { -1.0e30f, 1.0e30f } };
+	for (const auto& [range_min, range_max] : ranges)
+	{
+		std::uniform_real_distribution<float> distribution(range_min, range_max);
+		for (const size_t count : GetPositionCounts())
+		{
+			vector<float3> positions(count);
+			for (float3& position : positions)
+			{
+				position = float3(distribution(rng), distribution(rng), distribution(rng));
+			}
+			TEST_CHECK(BoundsMatchScalar(positions));
+		}
+	}
+}
+
+// The extremes of each axis at every index, so each SIMD lane and each remainder position has to win the reduction at some point
+void TestExtremePositions()
+{
+	for (const size_t count : { 1, 2, 3, 4, 5, 7, 8, 9, 13 })
+	{
+		for (size_t extreme_idx = 0; extreme_idx < count; ++extreme_idx)
+		{
+			vector<float3> positions(count, float3(1.0f, 2.0f, 3.0f));
+			positions[extreme_idx] = float3(-5.0f, 7.0f, -9.0f);
+			positions[count - 1 - extreme_idx] = float3(6.0f, -8.0f, 10.0f);
+			TEST_CHECK(BoundsMatchScalar(positions));
+		}
+	}
+}
+
+// A single vertex, points all in one place or on a line or plane, denormals, and float range extremes whose center or radius overflow to infinity
+void TestDegeneratePositions()
+{
+	for (const size_t count : { 1, 3, 4, 5, 8, 11 })
+	{
+		const float3 single_values[] =
+		{
+			float3(0.0f, 0.0f, 0.0f),
+			float3(-0.0f, 0.0f, -0.0f),
+			float3(1.0f, -2.0f, 3.0f),
+			float3(FLT_MIN * 0.5f, -FLT_MIN * 0.25f, FLT_MIN),
+			float3(FLT_MAX, -FLT_MAX, FLT_MAX),
+		};
+		for (const float3& value : single_values)
+		{
+			const vector<float3> positions(count, value);
+			TEST_CHECK(BoundsMatchScalar(positions));
+		}
+
+		vector<float3> line(count);
+		vector<float3> plane(count);
+		vector<float3> signed_zeros(count);
+		vector<float3> float_range(count);
+		for (size_t position_idx = 0; position_idx < count; ++position_idx)
+		{
+			const float t = (float) position_idx;
+			line[position_idx] = float3(t, 0.0f, 0.0f);
+			plane[position_idx] = float3(t, 4.0f, -t * t);
+			signed_zeros[position_idx] = position_idx % 2 == 0 ? float3(0.0f, -0.0f, 0.0f) : float3(-0.0f, 0.0f, -0.0f);
+			float_range[position_idx] = position_idx % 2 == 0 ? float3(FLT_MAX, FLT_MAX, -FLT_MAX) : float3(-FLT_MAX, FLT_MAX, -FLT_MAX);
+		}
+		TEST_CHECK(BoundsMatchScalar(line));
+		TEST_CHECK(BoundsMatchScalar(plane));
+		TEST_CHECK(BoundsMatchScalar(signed_zeros));
+		TEST_CHECK(BoundsMatchScalar(float_range));
+	}
+
+	// The scalar reference itself, on the simplest cases
+	const Bounds empty_bounds = compute_bounds(vector<float3>());
+	TEST_CHECK(empty_bounds.radius == 0.0f && empty_bounds.aabb_min.x == 0.0f && empty_bounds.aabb_max.x == 0.0f);
+
+	const Bounds single_bounds = compute_bounds(vector<float3>(1, float3(1.0f, -2.0f, 3.0f)));
+	TEST_CHECK(single_bounds.radius == 0.0f);
+	TEST_CHECK(single_bounds.aabb_min.x == 1.0f && single_bounds.aabb_min.y == -2.0f && single_bounds.aabb_min.z == 3.0f);
+	TEST_CHECK(single_bounds.aabb_max.x == 1.0f && single_bounds.aabb_max.y == -2.0f && single_bounds.aabb_max.z == 3.0f);
+
+	const Bounds overflowing_bounds = compute_bounds(vector<float3>(5, float3(FLT_MAX, 0.0f, 0.0f)));
+	TEST_CHECK(std::isinf(overflowing_bounds.GetCenter().x) && std::isinf(overflowing_bounds.radius));
+}
+
+int main()
+{
+#if !MESH_BOUNDS_SSE2
+	printf("SSE2 isn't available, compute_bounds is the scalar path\n");
+#endif
+	TEST_RUN(TestRandomPositions);
+	TEST_RUN(TestExtremePositions);
+	TEST_RUN(TestDegeneratePositions);
+	return 0;
+}
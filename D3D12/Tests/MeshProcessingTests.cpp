@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "MeshProcessing.h"
+#include "Test.h"
+
+using std::array;
+using std::vector;
+
+struct TestMesh
+{
+	vector<Vertex> vertices;
+	vector<uint32_t> indices;
+};
+
+// A flat in_size x in_size grid of quads in the xy plane, facing +z, with its triangles in a shuffled order
+TestMesh MakeShuffledGrid(const uint32_t in_size)
+{
+	TestMesh mesh;
+	for (uint32_t y = 0; y <= in_size; ++y)
+	{
+		for (uint32_t x = 0; x <= in_size; ++x)
+		{
+			Vertex vertex(float3((float) x, (float) y, 0.0f), float3(0.0f, 0.0f, 1.0f), float3(1.0f, 1.0f, 1.0f));
+			vertex.texcoord = float2((float) x / in_size, (float) y / in_size);
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	vector<array<uint32_t, 3>> triangles;
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			const uint32_t corner = y * (in_size + 1) + x;
+			triangles.push_back({ corner, corner + 1, corner + in_size + 2 });
+			triangles.push_back({ corner, corner + in_size + 2, corner + in_size + 1 });
+		}
+	}
+
+	std::mt19937 rng(13579);
+	std::shuffle(triangles.begin(), triangles.end(), rng);
+	for (const array<uint32_t, 3>& triangle : triangles)
+	{
+		mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+	}
+	return mesh;
+}
+
+// Triangles as (winding preserving) tuples of positions, sorted, so meshes can be compared regardless of triangle and vertex order
+vector<array<float, 9>> GetSortedTriangles(const vector<uint32_t>& in_indices, const vector<Vertex>& in_vertices)
+{
+	vector<array<float, 9>> triangles;
+	for (size_t index_idx = 0; index_idx < in_indices.size(); index_idx += 3)
+	{
+		array<float, 9> triangle;
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			const float3& position = in_vertices[in_indices[index_idx + corner]].position;
+			triangle[corner * 3 + 0] = position.x;
+			triangle[corner * 3 + 1] = position.y;
+			triangle[corner * 3 + 2] = position.z;
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+// Only the triangle order changes, and a shuffled grid ends up far more cache friendly than it started
+void TestOptimizeVertexCache()
+{
+	TestMesh mesh = MakeShuffledGrid(64);
+	const vector<uint32_t> original_indices = mesh.indices;
+	const VertexCacheStats original_stats = analyze_vertex_cache(mesh.indices, mesh.vertices.size());
+
+	optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+	TEST_CHECK(mesh.indices.size() == original_indices.size());
+	TEST_CHECK(GetSortedTriangles(mesh.indices, mesh.vertices) == GetSortedTriangles(original_indices, mesh.vertices));
+
+	const VertexCacheStats optimized_stats = analyze_vertex_cache(mesh.indices, mesh.vertices.size());
+	TEST_CHECK(optimized_stats.triangle_count == original_stats.triangle_count);
+
+	// A regular grid can't go below 0.5 misses per triangle, while a random order is close to 3
+	TEST_CHECK(original_stats.GetACMR() > 2.0f);
+	TEST_CHECK(optimized_stats.GetACMR() >= 0.5f);
+	TEST_CHECK(optimized_stats.GetACMR() < 0.9f);
+
+	// Deterministic, so cooked scenes are reproducible
+	vector<uint32_t> indices_again = original_indices;
+	optimize_vertex_cache(indices_again, mesh.vertices.size());
+	TEST_CHECK(indices_again == mesh.indices);
+}
+
+void TestAnalyzeVertexCache()
+{
+	// Each triangle misses on all three vertices the first time, and reusing a triangle's vertices right away hits
+	const vector<uint32_t> indices = { 0, 1, 2, 2, 1, 0, 3, 4, 5 };
+	const VertexCacheStats stats = analyze_vertex_cache(indices, 6);
+	TEST_CHECK(stats.triangle_count == 3);
+	TEST_CHECK(stats.cache_misses == 6);
+	TEST_CHECK(stats.GetATVR() == 1.0f);
+
+	// With a one entry cache only immediate repeats hit
+	const VertexCacheStats tiny_cache_stats = analyze_vertex_cache(indices, 6, 1);
+	TEST_CHECK(tiny_cache_stats.cache_misses == 8);
+}
+
+// Vertices end up in first reference order, unreferenced ones are dropped, and the triangles still describe the same mesh
+void TestOptimizeVertexFetch()
+{
+	TestMesh mesh = MakeShuffledGrid(16);
+
+	// An extra vertex no triangle references
+	mesh.vertices.push_back(Vertex(float3(-1.0f, -1.0f, -1.0f), float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, 0.0f)));
+	const vector<Vertex> original_vertices = mesh.vertices;
+	const vector<uint32_t> original_indices = mesh.indices;
+
+	optimize_vertex_fetch(span<uint32_t>(mesh.indices), mesh.vertices);
+	TEST_CHECK(mesh.vertices.size() == original_vertices.size() - 1);
+	TEST_CHECK(GetSortedTriangles(mesh.indices, mesh.vertices) == GetSortedTriangles(original_indices, original_vertices));
+
+	uint32_t next_new_vertex = 0;
+	for (const uint32_t index : mesh.indices)
+	{
+		TEST_CHECK(index <= next_new_vertex);
+		if (index == next_new_vertex)
+		{
+			++next_new_vertex;
+		}
+	}
+	TEST_CHECK(next_new_vertex == mesh.vertices.size());
+}
+
+// Every triangle lands in exactly one meshlet, within the meshlet size limits
+void TestBuildMeshletsCoverage()
+{
+	TestMesh mesh = MakeShuffledGrid(32);
+	optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+	const MeshletData meshlet_data = build_meshlets(mesh.indices, mesh.vertices);
+
+	vector<uint32_t> meshlet_indices;
+	uint32_t expected_vertex_offset = 0;
+	uint32_t expected_triangle_offset = 0;
+	for (const Meshlet& meshlet : meshlet_data.meshlets)
+	{
+		TEST_CHECK(meshlet.vertex_count > 0 && meshlet.vertex_count <= MESHLET_MAX_VERTICES);
+		TEST_CHECK(meshlet.triangle_count > 0 && meshlet.triangle_count <= MESHLET_MAX_TRIANGLES);
+		TEST_CHECK(meshlet.vertex_offset == expected_vertex_offset);
+		TEST_CHECK(meshlet.triangle_offset == expected_triangle_offset);
+		expected_vertex_offset += meshlet.vertex_count;
+		expected_triangle_offset += meshlet.triangle_count;
+
+		for (uint32_t triangle_idx = 0; triangle_idx < meshlet.triangle_count; ++triangle_idx)
+		{
+			const uint32_t packed_triangle = meshlet_data.meshlet_triangles[meshlet.triangle_offset + triangle_idx];
+			TEST_CHECK((packed_triangle >> 24) == 0);
+			for (const uint32_t local_index : { packed_triangle & 0xFF, (packed_triangle >> 8) & 0xFF, (packed_triangle >> 16) & 0xFF })
+			{
+				TEST_CHECK(local_index < meshlet.vertex_count);
+				meshlet_indices.push_back(meshlet_data.meshlet_vertices[meshlet.vertex_offset + local_index]);
+			}
+		}
+	}
+	TEST_CHECK(expected_vertex_offset == meshlet_data.meshlet_vertices.size());
+	TEST_CHECK(expected_triangle_offset == meshlet_data.meshlet_triangles.size());
+
+	// Triangles are consumed in index order, so the meshlets reproduce the index buffer exactly
+	TEST_CHECK(meshlet_indices == mesh.indices);
+}
+
+// Bounding spheres hold every vertex of their meshlet, and a flat grid's normal cones point straight along its normal
+void TestMeshletBounds()
+{
+	TestMesh mesh = MakeShuffledGrid(32);
+	optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+	const MeshletData meshlet_data = build_meshlets(mesh.indices, mesh.vertices);
+	TEST_CHECK(meshlet_data.meshlets.size() > 1);
+
+	for (const Meshlet& meshlet : meshlet_data.meshlets)
+	{
+		for (uint32_t local_idx = 0; local_idx < meshlet.vertex_count; ++local_idx)
+		{
+			const float3& position = mesh.vertices[meshlet_data.meshlet_vertices[meshlet.vertex_offset + local_idx]].position;
+			TEST_CHECK(float3::Distance(meshlet.center, position) <= meshlet.radius * 1.0001f);
+		}
+
+		TEST_CHECK_NEAR(meshlet.cone_axis.z, 1.0f, 1e-5f);
+		TEST_CHECK_NEAR(meshlet.cone_cutoff, 0.0f, 1e-3f);
+	}
+}
+
+// A closed mesh's meshlet has normals in every direction, so it must opt out of cone culling rather than get culled wrongly
+void TestMeshletBoundsUncullable()
+{
+	// Octahedron, all 8 faces wound outwards
+	vector<Vertex> vertices;
+	for (const float3& position : {
+		float3(1.0f, 0.0f, 0.0f), float3(-1.0f, 0.0f, 0.0f),
+		float3(0.0f, 1.0f, 0.0f), float3(0.0f, -1.0f, 0.0f),
+		float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, -1.0f),
+	})
+	{
+		vertices.push_back(Vertex(position, position, float3(1.0f, 1.0f, 1.0f)));
+	}
+	const vector<uint32_t> indices = {
+		0, 2, 4,  2, 1, 4,  1, 3, 4,  3, 0, 4,
+		2, 0, 5,  1, 2, 5,  3, 1, 5,  0, 3, 5,
+	};
+
+	const MeshletData meshlet_data = build_meshlets(indices, vertices);
+	TEST_CHECK(meshlet_data.meshlets.size() == 1);
+
+	const Meshlet& meshlet = meshlet_data.meshlets[0];
+	TEST_CHECK(meshlet.cone_axis == float3(0.0f, 0.0f, 0.0f));
+	TEST_CHECK(meshlet.cone_cutoff == 1.0f);
+	TEST_CHECK_NEAR(meshlet.radius, 1.0f, 1e-6f);
+}
+
+// The cone test from Meshlet's comment must only ever cull meshlets whose triangles all face away from the camera
+void TestMeshletConeCullingIsConservative()
+{
+	// A bumpy grid, so cones have some width to them
+	TestMesh mesh = MakeShuffledGrid(32);
+	std::mt19937 rng(97531);
+	std::uniform_real_distribution<float> height_distribution(0.0f, 0.3f);
+	for (Vertex& vertex : mesh.vertices)
+	{
+		vertex.position.z = height_distribution(rng);
+	}
+	optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+	const MeshletData meshlet_data = build_meshlets(mesh.indices, mesh.vertices);
+
+	std::uniform_real_distribution<float> camera_distribution(-50.0f, 50.0f);
+	size_t culled_count = 0;
+	for (int camera_idx = 0; camera_idx < 200; ++camera_idx)
+	{
+		const float3 camera_position(camera_distribution(rng), camera_distribution(rng), camera_distribution(rng));
+		for (const Meshlet& meshlet : meshlet_data.meshlets)
+		{
+			const float3 to_center = meshlet.center - camera_position;
+			const bool is_culled = to_center.Dot(meshlet.cone_axis) >= meshlet.cone_cutoff * to_center.Length() + meshlet.radius * (1.0f + meshlet.cone_cutoff);
+			if (!is_culled)
+			{
+				continue;
+			}
+
+			++culled_count;
+			for (uint32_t triangle_idx = 0; triangle_idx < meshlet.triangle_count; ++triangle_idx)
+			{
+				const uint32_t packed_triangle = meshlet_data.meshlet_triangles[meshlet.triangle_offset + triangle_idx];
+				const float3& a = mesh.vertices[meshlet_data.meshlet_vertices[meshlet.vertex_offset + (packed_triangle & 0xFF)]].position;
+				const float3& b = mesh.vertices[meshlet_data.meshlet_vertices[meshlet.vertex_offset + ((packed_triangle >> 8) & 0xFF)]].position;
+				const float3& c = mesh.vertices[meshlet_data.meshlet_vertices[meshlet.vertex_offset + ((packed_triangle >> 16) & 0xFF)]].position;
+				const float3 face_normal = (b - a).Cross(c - a);
+				TEST_CHECK(face_normal.Dot(a - camera_position) >= 0.0f);
+			}
+		}
+	}
+
+	// Cameras below the grid should see some meshlets culled, or this tests nothing
+	TEST_CHECK(culled_count > 0);
+}
+
+// Signed area of in_indices' triangles projected onto the xy plane. Positive for triangles facing +z
+float GetProjectedArea(const vector<uint32_t>& in_indices, const vector<Vertex>& in_vertices)
+{
+	float area = 0.0f;
+	for (size_t index_idx = 0; index_idx < in_indices.size(); index_idx += 3)
+	{
+		const float3& a = in_vertices[in_indices[index_idx + 0]].position;
+		const float3& b = in_vertices[in_indices[index_idx + 1]].position;
+		const float3& c = in_vertices[in_indices[index_idx + 2]].position;
+		area += (b - a).Cross(c - a).z * 0.5f;
+	}
+	return area;
+}
+
+// A flat grid can lose all its interior vertices for free: the border stays put, nothing flips and the reported error stays zero
+void TestSimplifyFlatGrid()
+{
+	const uint32_t grid_size = 16;
+	const TestMesh mesh = MakeShuffledGrid(grid_size);
+	const size_t target_index_count = mesh.indices.size() / 4;
+
+	float error = -1.0f;
+	const vector<uint32_t> simplified_indices = simplify_mesh(mesh.indices, mesh.vertices, target_index_count, error);
+	TEST_CHECK(simplified_indices.size() % 3 == 0);
+	TEST_CHECK(simplified_indices.size() <= target_index_count);
+	TEST_CHECK(!simplified_indices.empty());
+	TEST_CHECK_NEAR(error, 0.0f, 1e-4f);
+
+	// Still covers exactly the original square, with every triangle facing +z
+	TEST_CHECK_NEAR(GetProjectedArea(simplified_indices, mesh.vertices), (float) (grid_size * grid_size), 1e-3f);
+	for (size_t index_idx = 0; index_idx < simplified_indices.size(); index_idx += 3)
+	{
+		TEST_CHECK(GetProjectedArea({ simplified_indices.begin() + index_idx, simplified_indices.begin() + index_idx + 3 }, mesh.vertices) > 0.0f);
+	}
+
+	// Border vertices are never collapsed, so every one of them is still referenced
+	vector<bool> is_referenced(mesh.vertices.size(), false);
+	for (const uint32_t index : simplified_indices)
+	{
+		TEST_CHECK(index < mesh.vertices.size());
+		is_referenced[index] = true;
+	}
+	for (uint32_t vertex_idx = 0; vertex_idx < mesh.vertices.size(); ++vertex_idx)
+	{
+		const float3& position = mesh.vertices[vertex_idx].position;
+		if (position.x == 0.0f || position.y == 0.0f || position.x == (float) grid_size || position.y == (float) grid_size)
+		{
+			TEST_CHECK(is_referenced[vertex_idx]);
+		}
+	}
+}
+
+void TestSimplifyTargetAlreadyMet()
+{
+	const TestMesh mesh = MakeShuffledGrid(4);
+	float error = -1.0f;
+	TEST_CHECK(simplify_mesh(mesh.indices, mesh.vertices, mesh.indices.size(), error) == mesh.indices);
+	TEST_CHECK(error == 0.0f);
+}
+
+// A curved surface can't be simplified for free. The reported error must be non-zero yet smaller than the surface's height
+void TestSimplifyCurvedGrid()
+{
+	const uint32_t grid_size = 24;
+	const float amplitude = 2.0f;
+	TestMesh mesh = MakeShuffledGrid(grid_size);
+	for (Vertex& vertex : mesh.vertices)
+	{
+		vertex.position.z = amplitude * std::sin(vertex.position.x * 0.25f) * std::sin(vertex.position.y * 0.25f);
+	}
+
+	float error = 0.0f;
+	const vector<uint32_t> simplified_indices = simplify_mesh(mesh.indices, mesh.vertices, mesh.indices.size() / 4, error);
+	TEST_CHECK(simplified_indices.size() < mesh.indices.size());
+	TEST_CHECK(error > 0.0f);
+	TEST_CHECK(error < amplitude);
+
+	// The simplified mesh is still a height field over the same square
+	TEST_CHECK_NEAR(GetProjectedArea(simplified_indices, mesh.vertices), (float) (grid_size * grid_size), 1e-2f);
+}
+
+// LODs are appended after LOD 0 with shrinking triangle counts and non-decreasing errors
+void TestBuildMeshLods()
+{
+	TestMesh mesh = MakeShuffledGrid(32);
+	for (Vertex& vertex : mesh.vertices)
+	{
+		vertex.position.z = std::sin(vertex.position.x * 0.2f) * std::cos(vertex.position.y * 0.3f);
+	}
+	const vector<uint32_t> original_indices = mesh.indices;
+
+	vector<uint32_t> indices = mesh.indices;
+	const vector<MeshLod> lods = build_mesh_lods(indices, mesh.vertices);
+	TEST_CHECK(lods.size() > 1 && lods.size() <= MESH_MAX_LODS);
+
+	// LOD 0 is untouched
+	TEST_CHECK(lods[0].index_offset == 0);
+	TEST_CHECK(lods[0].index_count == original_indices.size());
+	TEST_CHECK(lods[0].error == 0.0f);
+	TEST_CHECK(std::equal(original_indices.begin(), original_indices.end(), indices.begin()));
+
+	for (size_t lod_idx = 1; lod_idx < lods.size(); ++lod_idx)
+	{
+		const MeshLod& lod = lods[lod_idx];
+		const MeshLod& previous_lod = lods[lod_idx - 1];
+		TEST_CHECK(lod.index_offset == previous_lod.index_offset + previous_lod.index_count);
+		TEST_CHECK(lod.index_count % 3 == 0 && lod.index_count > 0);
+		TEST_CHECK(lod.index_count <= previous_lod.index_count * LOD_MIN_TRIANGLE_REDUCTION);
+		TEST_CHECK(lod.error >= previous_lod.error);
+	}
+
+	const MeshLod& last_lod = lods.back();
+	TEST_CHECK(indices.size() == last_lod.index_offset + last_lod.index_count);
+	for (const uint32_t index : indices)
+	{
+		TEST_CHECK(index < mesh.vertices.size());
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestOptimizeVertexCache);
+	TEST_RUN(TestAnalyzeVertexCache);
+	TEST_RUN(TestOptimizeVertexFetch);
+	TEST_RUN(TestBuildMeshletsCoverage);
+	TEST_RUN(TestMeshletBounds);
+	TEST_RUN(TestMeshletBoundsUncullable);
+	TEST_RUN(TestMeshletConeCullingIsConservative);
+	TEST_RUN(TestSimplifyFlatGrid);
+	TEST_RUN(TestSimplifyTargetAlreadyMet);
+	TEST_RUN(TestSimplifyCurvedGrid);
+	TEST_RUN(TestBuildMeshLods);
+	return 0;
+}
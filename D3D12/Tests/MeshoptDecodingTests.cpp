@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "MeshoptDecoding.h"
+#include "MeshoptEncoding.h"
+#include "Test.h"
+
+using std::array;
+using std::vector;
+
+// Triangles rotated so their smallest index comes first, which keeps winding but ignores the rotation the encoder picked
+vector<array<uint32_t, 3>> GetCanonicalTriangles(const vector<uint32_t>& in_indices)
+{
+	vector<array<uint32_t, 3>> triangles;
+	for (size_t index_idx = 0; index_idx < in_indices.size(); index_idx += 3)
+	{
+		array<uint32_t, 3> triangle = { in_indices[index_idx], in_indices[index_idx + 1], in_indices[index_idx + 2] };
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		triangles.push_back(triangle);
+	}
+	return triangles;
+}
+
+/* ---------------------------------------- Tests ---------------------------------------- */
+
+// Smooth, noisy and constant vertex bytes, across several blocks and a partial last block
+void TestVertexBufferRoundTrip()
+{
+	std::mt19937 rng(1357);
+	for (const size_t vertex_size : { (size_t) 4, (size_t) 12, (size_t) 16, (size_t) 32, (size_t) 256 })
+	{
+		for (const size_t vertex_count : { (size_t) 1, (size_t) 15, (size_t) 17, (size_t) 1000 })
+		{
+			vector<uint8_t> vertices(vertex_count * vertex_size);
+			for (size_t vertex_idx = 0; vertex_idx < vertex_count; ++vertex_idx)
+			{
+				for (size_t byte_idx = 0; byte_idx < vertex_size; ++byte_idx)
+				{
+					uint8_t value = 0;
+					switch (byte_idx % 4)
+					{
+						case 0: value = (uint8_t) vertex_idx; break;
+						case 1: value = (uint8_t) (vertex_idx / 7 + rng() % 3); break;
+						case 2: value = (uint8_t) rng(); break;
+						case 3: value = 42; break;
+					}
+					vertices[vertex_idx * vertex_size + byte_idx] = value;
+				}
+			}
+
+			const vector<uint8_t> encoded = EncodeVertexBuffer(vertices, vertex_size);
+			vector<uint8_t> decoded(vertices.size());
+			TEST_CHECK(decode_meshopt_vertex_buffer(decoded.data(), vertex_count, vertex_size, encoded));
+			TEST_CHECK(decoded == vertices);
+		}
+	}
+}
+
+void TestVertexBufferRejectsMalformed()
+{
+	vector<uint8_t> vertices(64 * 16);
+	for (size_t byte_idx = 0; byte_idx < vertices.size(); ++byte_idx)
+	{
+		vertices[byte_idx] = (uint8_t) (byte_idx * 31);
+	}
+	const vector<uint8_t> encoded = EncodeVertexBuffer(vertices, 16);
+	vector<uint8_t> decoded(vertices.size());
+
+	// Wrong header, unsupported vertex sizes, and truncated or overlong data
+	vector<uint8_t> bad_header = encoded;
+	bad_header[0] = 0xA1;
+	TEST_CHECK(!decode_meshopt_vertex_buffer(decoded.data(), 64, 16, bad_header));
+	TEST_CHECK(!decode_meshopt_vertex_buffer(decoded.data(), 64, 18, encoded));
+	TEST_CHECK(!decode_meshopt_vertex_buffer(decoded.data(), 64, 0, encoded));
+	for (const size_t truncated_size : { (size_t) 1, encoded.size() / 2, encoded.size() - 1 })
+	{
+		TEST_CHECK(!decode_meshopt_vertex_buffer(decoded.data(), 64, 16, span(encoded).first(truncated_size)));
+	}
+	vector<uint8_t> overlong = encoded;
+	overlong.push_back(0);
+	TEST_CHECK(!decode_meshopt_vertex_buffer(decoded.data(), 64, 16, overlong));
+}
+
+void TestIndexBufferRoundTrip()
+{
+	// A grid (mostly edge FIFO hits), a shuffled grid (mostly fresh triangles) and scattered indices (explicit deltas)
+	vector<uint32_t> grid_indices = MakeGridIndices(20);
+
+	vector<uint32_t> shuffled_indices = grid_indices;
+	{
+		vector<array<uint32_t, 3>> triangles;
+		for (size_t index_idx = 0; index_idx < shuffled_indices.size(); index_idx += 3)
+		{
+			triangles.push_back({ shuffled_indices[index_idx], shuffled_indices[index_idx + 1], shuffled_indices[index_idx + 2] });
+		}
+		std::mt19937 rng(2468);
+		std::shuffle(triangles.begin(), triangles.end(), rng);
+		shuffled_indices.clear();
+		for (const array<uint32_t, 3>& triangle : triangles)
+		{
+			shuffled_indices.insert(shuffled_indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	vector<uint32_t> scattered_indices;
+	{
+		std::mt19937 rng(97531);
+		for (int triangle_idx = 0; triangle_idx < 100; ++triangle_idx)
+		{
+			const uint32_t base = (uint32_t) (rng() % 60000);
+			const uint32_t b = base + 1 + (uint32_t) (rng() % 5000);
+			const uint32_t c = base + 5001 + (uint32_t) (rng() % 500);
+			scattered_indices.insert(scattered_indices.end(), { base, b, c });
+		}
+	}
+
+	// Fresh triangles that pick up older vertices (code 0xFE), then a closed fan whose last triangle finds its third vertex in the vertex FIFO
+	vector<uint32_t> fifo_indices = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 4 };
+	for (uint32_t ring_idx = 0; ring_idx < 8; ++ring_idx)
+	{
+		fifo_indices.insert(fifo_indices.end(), { 10, 11 + ring_idx, 11 + (ring_idx + 1) % 8 });
+	}
+
+	for (const vector<uint32_t>* indices : { &grid_indices, &shuffled_indices, &scattered_indices, &fifo_indices })
+	{
+		const vector<uint8_t> encoded = IndexEncoder().Encode(*indices);
+
+		vector<uint32_t> decoded(indices->size());
+		TEST_CHECK(decode_meshopt_index_buffer(decoded.data(), decoded.size(), sizeof(uint32_t), encoded));
+		TEST_CHECK(GetCanonicalTriangles(decoded) == GetCanonicalTriangles(*indices));
+
+		vector<uint16_t> decoded_16(indices->size());
+		TEST_CHECK(decode_meshopt_index_buffer(decoded_16.data(), decoded_16.size(), sizeof(uint16_t), encoded));
+		TEST_CHECK(std::equal(decoded_16.begin(), decoded_16.end(), decoded.begin()));
+	}
+
+	// The grid should mostly have been encoded through the edge FIFO, or this isn't testing it
+	const vector<uint8_t> grid_encoded = IndexEncoder().Encode(grid_indices);
+	const size_t edge_code_count = std::count_if(grid_encoded.begin() + 1, grid_encoded.begin() + 1 + grid_indices.size() / 3, [](uint8_t code) { return code < 0xF0; });
+	TEST_CHECK(edge_code_count > grid_indices.size() / 3 / 2);
+}
+
+void TestIndexBufferRejectsMalformed()
+{
+	const vector<uint32_t> indices = MakeGridIndices(4);
+	const vector<uint8_t> encoded = IndexEncoder().Encode(indices);
+	vector<uint32_t> decoded(indices.size());
+
+	vector<uint8_t> bad_version = encoded;
+	bad_version[0] = MESHOPT_INDEX_HEADER | 2;
+	TEST_CHECK(!decode_meshopt_index_buffer(decoded.data(), decoded.size(), sizeof(uint32_t), bad_version));
+	TEST_CHECK(!decode_meshopt_index_buffer(decoded.data(), decoded.size() - 1, sizeof(uint32_t), encoded));
+	TEST_CHECK(!decode_meshopt_index_buffer(decoded.data(), decoded.size(), 1, encoded));
+	TEST_CHECK(!decode_meshopt_index_buffer(decoded.data(), decoded.size(), sizeof(uint32_t), span(encoded).first(encoded.size() - 1)));
+}
+
+void TestIndexSequenceRoundTrip()
+{
+	// Two interleaved runs (as in a line list walking two rows), plus a few far jumps
+	vector<uint32_t> indices;
+	for (uint32_t index = 0; index < 500; ++index)
+	{
+		indices.push_back(index);
+		indices.push_back(100000 + index * 2);
+	}
+	indices.insert(indices.end(), { 0, 4000000000u, 7, 7, 7 });
+
+	const vector<uint8_t> encoded = EncodeIndexSequence(indices);
+	vector<uint32_t> decoded(indices.size());
+	TEST_CHECK(decode_meshopt_index_sequence(decoded.data(), decoded.size(), sizeof(uint32_t), encoded));
+	TEST_CHECK(decoded == indices);
+
+	TEST_CHECK(!decode_meshopt_index_sequence(decoded.data(), decoded.size() + 1, sizeof(uint32_t), encoded));
+	TEST_CHECK(!decode_meshopt_index_sequence(decoded.data(), decoded.size(), sizeof(uint32_t), span(encoded).first(encoded.size() - 1)));
+}
+
+// Octahedral snorm16 normals (as meshoptimizer's encoder writes them) decode to within a few units of the original snorm normal
+void TestOctahedralFilter()
+{
+	std::mt19937 rng(3141);
+	std::normal_distribution<float> distribution;
+	for (int normal_idx = 0; normal_idx < 10000; ++normal_idx)
+	{
+		float normal[3] = { distribution(rng), distribution(rng), distribution(rng) };
+		const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length < 1e-3f)
+		{
+			continue;
+		}
+		for (float& component : normal)
+		{
+			component /= length;
+		}
+
+		const float l1_length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+		const float x = normal[0] / l1_length;
+		const float y = normal[1] / l1_length;
+		const float u = normal[2] >= 0.0f ? x : (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		const float v = normal[2] >= 0.0f ? y : (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+		int16_t element[4] = {
+			(int16_t) round_meshopt_filter_value(u * 32767.0f),
+			(int16_t) round_meshopt_filter_value(v * 32767.0f),
+			32767,
+			1234,
+		};
+		TEST_CHECK(apply_meshopt_filter(element, 1, sizeof(element), MeshoptFilter::Octahedral));
+		for (int component_idx = 0; component_idx < 3; ++component_idx)
+		{
+			TEST_CHECK_NEAR(element[component_idx], normal[component_idx] * 32767.0f, 8.0f);
+		}
+		TEST_CHECK(element[3] == 1234);
+	}
+}
+
+void TestQuaternionFilter()
+{
+	std::mt19937 rng(2718);
+	std::normal_distribution<float> distribution;
+	for (int quaternion_idx = 0; quaternion_idx < 10000; ++quaternion_idx)
+	{
+		float quaternion[4] = { distribution(rng), distribution(rng), distribution(rng), distribution(rng) };
+		const float length = std::sqrt(quaternion[0] * quaternion[0] + quaternion[1] * quaternion[1] + quaternion[2] * quaternion[2] + quaternion[3] * quaternion[3]);
+		for (float& component : quaternion)
+		{
+			component /= length;
+		}
+
+		// The largest component is dropped, and reconstructed as positive
+		int32_t max_component = 0;
+		for (int32_t component_idx = 1; component_idx < 4; ++component_idx)
+		{
+			if (std::fabs(quaternion[component_idx]) > std::fabs(quaternion[max_component]))
+			{
+				max_component = component_idx;
+			}
+		}
+		if (quaternion[max_component] < 0.0f)
+		{
+			for (float& component : quaternion)
+			{
+				component = -component;
+			}
+		}
+
+		int16_t element[4];
+		for (int32_t component_idx = 0; component_idx < 3; ++component_idx)
+		{
+			element[component_idx] = (int16_t) round_meshopt_filter_value(quaternion[(max_component + 1 + component_idx) & 3] * std::sqrt(2.0f) * 32767.0f);
+		}
+		element[3] = (int16_t) (32764 | max_component);
+
+		TEST_CHECK(apply_meshopt_filter(element, 1, sizeof(element), MeshoptFilter::Quaternion));
+		for (int32_t component_idx = 0; component_idx < 4; ++component_idx)
+		{
+			TEST_CHECK_NEAR(element[component_idx], quaternion[component_idx] * 32767.0f, 4.0f);
+		}
+	}
+}
+
+void TestExponentialFilter()
+{
+	auto encode = [](const int32_t in_mantissa, const int32_t in_exponent)
+	{
+		return ((uint32_t) in_exponent << 24) | ((uint32_t) in_mantissa & 0xFFFFFF);
+	};
+
+	uint32_t values[6] = { encode(3, -1), encode(-3, -1), encode(0, 0), encode(8388607, -23), encode(-8388608, 0), encode(1, 10) };
+	TEST_CHECK(apply_meshopt_filter(values, 2, 12, MeshoptFilter::Exponential));
+
+	float decoded[6];
+	memcpy(decoded, values, sizeof(values));
+	TEST_CHECK(decoded[0] == 1.5f);
+	TEST_CHECK(decoded[1] == -1.5f);
+	TEST_CHECK(decoded[2] == 0.0f);
+	TEST_CHECK(decoded[3] == 8388607.0f / 8388608.0f);
+	TEST_CHECK(decoded[4] == -8388608.0f);
+	TEST_CHECK(decoded[5] == 1024.0f);
+
+	// Strides the filters can't handle are rejected rather than misread
+	TEST_CHECK(!apply_meshopt_filter(values, 1, 6, MeshoptFilter::Exponential));
+	TEST_CHECK(!apply_meshopt_filter(values, 1, 12, MeshoptFilter::Octahedral));
+	TEST_CHECK(!apply_meshopt_filter(values, 1, 4, MeshoptFilter::Quaternion));
+}
+
+int main()
+{
+	TEST_RUN(TestVertexBufferRoundTrip);
+	TEST_RUN(TestVertexBufferRejectsMalformed);
+	TEST_RUN(TestIndexBufferRoundTrip);
+	TEST_RUN(TestIndexBufferRejectsMalformed);
+	TEST_RUN(TestIndexSequenceRoundTrip);
+	TEST_RUN(TestOctahedralFilter);
+	TEST_RUN(TestQuaternionFilter);
+	TEST_RUN(TestExponentialFilter);
+	return 0;
+}
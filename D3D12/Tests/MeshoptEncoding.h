@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "MeshoptDecoding.h"
+
+using std::vector;
+
+/*	Reference encoders for the bitstreams MeshoptDecoding.h reads, written from the format description rather than from meshoptimizer.
+	They don't try to compress well, only to reach every decoder path: all byte group modes, edge and vertex FIFO hits, "next" vertices,
+	the code aux table and explicit deltas, so a decoder change that drifts from the format shows up as a failed round trip.
+	Used by MeshoptDecodingTests, and by MeshoptDecodingBenchmark for its input
+*/
+
+/* ---------------------------------------- Attributes ---------------------------------------- */
+
+inline void EncodeVarint(vector<uint8_t>& out_data, uint32_t in_value)
+{
+	do
+	{
+		out_data.push_back((uint8_t) ((in_value & 127) | (in_value > 127 ? 128 : 0)));
+		in_value >>= 7;
+	} while (in_value > 0);
+}
+
+inline uint32_t ZigzagEncode(const uint32_t in_delta)
+{
+	return (in_delta << 1) ^ (uint32_t) ((int32_t) in_delta >> 31);
+}
+
+// Packs 16 values with Bits bits each, escaping values that don't fit
+template<uint32_t Bits>
+inline void EncodePackedGroup(vector<uint8_t>& out_data, const uint8_t* in_values)
+{
+	constexpr uint32_t values_per_byte = 8 / Bits;
+	constexpr uint8_t escape = (1 << Bits) - 1;
+
+	vector<uint8_t> escaped;
+	for (size_t byte_idx = 0; byte_idx < MESHOPT_BYTE_GROUP_SIZE / values_per_byte; ++byte_idx)
+	{
+		uint8_t packed = 0;
+		for (uint32_t value_idx = 0; value_idx < values_per_byte; ++value_idx)
+		{
+			const uint8_t value = in_values[byte_idx * values_per_byte + value_idx];
+			packed = (uint8_t) (packed << Bits) | (value >= escape ? escape : value);
+			if (value >= escape)
+			{
+				escaped.push_back(value);
+			}
+		}
+		out_data.push_back(packed);
+	}
+	out_data.insert(out_data.end(), escaped.begin(), escaped.end());
+}
+
+inline void EncodeByteStream(vector<uint8_t>& out_data, const vector<uint8_t>& in_values)
+{
+	const size_t group_count = in_values.size() / MESHOPT_BYTE_GROUP_SIZE;
+	const size_t header_offset = out_data.size();
+	out_data.resize(out_data.size() + (group_count + 3) / 4, 0);
+
+	for (size_t group_idx = 0; group_idx < group_count; ++group_idx)
+	{
+		const uint8_t* group_values = in_values.data() + group_idx * MESHOPT_BYTE_GROUP_SIZE;
+		const uint8_t max_value = *std::max_element(group_values, group_values + MESHOPT_BYTE_GROUP_SIZE);
+
+		// Smallest mode that holds the whole group, with the occasional escape
+		uint32_t mode = 3;
+		if (max_value == 0)
+		{
+			mode = 0;
+		}
+		else if (std::count_if(group_values, group_values + MESHOPT_BYTE_GROUP_SIZE, [](uint8_t value) { return value >= 3; }) <= 2)
+		{
+			mode = 1;
+		}
+		else if (std::count_if(group_values, group_values + MESHOPT_BYTE_GROUP_SIZE, [](uint8_t value) { return value >= 15; }) <= 6)
+		{
+			mode = 2;
+		}
+
+		out_data[header_offset + group_idx / 4] |= (uint8_t) (mode << ((group_idx % 4) * 2));
+		switch (mode)
+		{
+			case 1: EncodePackedGroup<2>(out_data, group_values); break;
+			case 2: EncodePackedGroup<4>(out_data, group_values); break;
+			case 3: out_data.insert(out_data.end(), group_values, group_values + MESHOPT_BYTE_GROUP_SIZE); break;
+		}
+	}
+}
+
+inline vector<uint8_t> EncodeVertexBuffer(const vector<uint8_t>& in_vertices, const size_t in_vertex_size)
+{
+	const size_t vertex_count = in_vertices.size() / in_vertex_size;
+	vector<uint8_t> data = { MESHOPT_VERTEX_HEADER };
+
+	const size_t block_size = get_meshopt_vertex_block_size(in_vertex_size);
+	vector<uint8_t> last_vertex(in_vertices.begin(), in_vertices.begin() + in_vertex_size);
+	for (size_t block_start = 0; block_start < vertex_count; block_start += block_size)
+	{
+		const size_t block_vertex_count = (std::min)(block_size, vertex_count - block_start);
+		const size_t aligned_vertex_count = (block_vertex_count + MESHOPT_BYTE_GROUP_SIZE - 1) & ~(MESHOPT_BYTE_GROUP_SIZE - 1);
+		for (size_t byte_idx = 0; byte_idx < in_vertex_size; ++byte_idx)
+		{
+			vector<uint8_t> deltas(aligned_vertex_count, 0);
+			uint8_t previous = last_vertex[byte_idx];
+			for (size_t vertex_idx = 0; vertex_idx < block_vertex_count; ++vertex_idx)
+			{
+				const uint8_t value = in_vertices[(block_start + vertex_idx) * in_vertex_size + byte_idx];
+				const uint8_t delta = value - previous;
+				deltas[vertex_idx] = (uint8_t) ((delta << 1) ^ (uint8_t) ((int8_t) delta >> 7));
+				previous = value;
+			}
+			EncodeByteStream(data, deltas);
+		}
+		memcpy(last_vertex.data(), &in_vertices[(block_start + block_vertex_count - 1) * in_vertex_size], in_vertex_size);
+	}
+
+	// Tail: padding, then the first vertex
+	const size_t tail_size = (std::max)(in_vertex_size, MESHOPT_VERTEX_TAIL_MIN_SIZE);
+	data.resize(data.size() + tail_size - in_vertex_size, 0);
+	data.insert(data.end(), in_vertices.begin(), in_vertices.begin() + in_vertex_size);
+	return data;
+}
+
+/* ---------------------------------------- Indices ---------------------------------------- */
+
+// Mirrors decode_meshopt_index_buffer's state, so each triangle can be encoded with whatever that state allows
+struct IndexEncoder
+{
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint32_t FIFO_CODE_MAX = 13;
+
+	// Code aux bytes available through codes 0xF0-0xFD. Entry 0 is "b and c are next", which can't be sent explicitly without restarting next
+	static constexpr uint8_t CODE_AUX_TABLE[16] = { 0x00, 0x01, 0x10, 0x11, 0x02, 0x20, 0x12, 0x21, 0x22, 0x0F, 0xF0, 0xFF, 0x13, 0x31, 0x00, 0x00 };
+
+	uint32_t edge_fifo[16][2];
+	uint32_t vertex_fifo[16];
+	size_t edge_fifo_offset = 0;
+	size_t vertex_fifo_offset = 0;
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	vector<uint8_t> codes;
+	vector<uint8_t> data;
+
+	IndexEncoder()
+	{
+		memset(edge_fifo, 0xFF, sizeof(edge_fifo));
+		memset(vertex_fifo, 0xFF, sizeof(vertex_fifo));
+	}
+
+	void PushEdge(const uint32_t in_a, const uint32_t in_b)
+	{
+		edge_fifo[edge_fifo_offset][0] = in_a;
+		edge_fifo[edge_fifo_offset][1] = in_b;
+		edge_fifo_offset = (edge_fifo_offset + 1) & 15;
+	}
+
+	void PushVertex(const uint32_t in_vertex, const bool in_push = true)
+	{
+		vertex_fifo[vertex_fifo_offset] = in_vertex;
+		vertex_fifo_offset = (vertex_fifo_offset + in_push) & 15;
+	}
+
+	void EncodeDelta(const uint32_t in_value)
+	{
+		EncodeVarint(data, ZigzagEncode(in_value - last));
+		last = in_value;
+	}
+
+	// Tries the edge FIFO for each rotation of the triangle. Returns false if none of its edges are in there
+	bool EncodeEdgeTriangle(const uint32_t in_triangle[3])
+	{
+		for (uint32_t edge_idx = 0; edge_idx < 15; ++edge_idx)
+		{
+			const uint32_t* edge = edge_fifo[(edge_fifo_offset - 1 - edge_idx) & 15];
+			for (uint32_t rotation = 0; rotation < 3; ++rotation)
+			{
+				const uint32_t a = in_triangle[rotation];
+				const uint32_t b = in_triangle[(rotation + 1) % 3];
+				const uint32_t c = in_triangle[(rotation + 2) % 3];
+				if (edge[0] != a || edge[1] != b)
+				{
+					continue;
+				}
+
+				uint32_t vertex_code = 15;
+				if (c == next)
+				{
+					vertex_code = 0;
+				}
+				else
+				{
+					for (uint32_t fifo_idx = 1; fifo_idx < FIFO_CODE_MAX; ++fifo_idx)
+					{
+						if (vertex_fifo[(vertex_fifo_offset - 1 - fifo_idx) & 15] == c)
+						{
+							vertex_code = fifo_idx;
+							break;
+						}
+					}
+					if (vertex_code == 15 && (c == last - 1 || c == last + 1))
+					{
+						vertex_code = c == last - 1 ? 13 : 14;
+					}
+				}
+
+				codes.push_back((uint8_t) ((edge_idx << 4) | vertex_code));
+				if (vertex_code == 0)
+				{
+					++next;
+					PushVertex(c, true);
+				}
+				else if (vertex_code < FIFO_CODE_MAX)
+				{
+					PushVertex(c, false);
+				}
+				else
+				{
+					if (vertex_code == 15)
+					{
+						EncodeDelta(c);
+					}
+					last = c;
+					PushVertex(c);
+				}
+				PushEdge(c, b);
+				PushEdge(a, c);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void EncodeFreshTriangle(const uint32_t in_triangle[3])
+	{
+		const uint32_t a = in_triangle[0];
+		const uint32_t b = in_triangle[1];
+		const uint32_t c = in_triangle[2];
+
+		uint32_t expected_next = next;
+		const bool a_is_next = a == expected_next;
+		expected_next += a_is_next;
+
+		auto get_vertex_code = [&](const uint32_t in_vertex)
+		{
+			if (in_vertex == expected_next)
+			{
+				++expected_next;
+				return 0u;
+			}
+			for (uint32_t fifo_idx = 1; fifo_idx < 15; ++fifo_idx)
+			{
+				if (vertex_fifo[(vertex_fifo_offset - fifo_idx) & 15] == in_vertex)
+				{
+					return fifo_idx;
+				}
+			}
+			return 15u;
+		};
+		const uint32_t b_code = get_vertex_code(b);
+		uint32_t c_code = get_vertex_code(c);
+
+		// An explicit zero code aux would restart next
+		if (!a_is_next && b_code == 0 && c_code == 0)
+		{
+			--expected_next;
+			c_code = 15;
+		}
+		const uint8_t code_aux = (uint8_t) ((b_code << 4) | c_code);
+
+		const uint8_t* table_entry = std::find(CODE_AUX_TABLE, CODE_AUX_TABLE + 14, code_aux);
+		if (a_is_next && table_entry != CODE_AUX_TABLE + 14)
+		{
+			codes.push_back((uint8_t) (0xF0 | (table_entry - CODE_AUX_TABLE)));
+		}
+		else
+		{
+			codes.push_back(a_is_next ? 0xFE : 0xFF);
+			data.push_back(code_aux);
+		}
+
+		next = expected_next;
+		if (!a_is_next)
+		{
+			EncodeDelta(a);
+		}
+		if (b_code == 15)
+		{
+			EncodeDelta(b);
+		}
+		if (c_code == 15)
+		{
+			EncodeDelta(c);
+		}
+
+		PushVertex(a);
+		PushVertex(b, b_code == 0 || b_code == 15);
+		PushVertex(c, c_code == 0 || c_code == 15);
+		PushEdge(b, a);
+		PushEdge(c, b);
+		PushEdge(a, c);
+	}
+
+	vector<uint8_t> Encode(const vector<uint32_t>& in_indices)
+	{
+		for (size_t index_idx = 0; index_idx < in_indices.size(); index_idx += 3)
+		{
+			if (!EncodeEdgeTriangle(&in_indices[index_idx]))
+			{
+				EncodeFreshTriangle(&in_indices[index_idx]);
+			}
+		}
+
+		// Header byte, codes, data, then the 16 byte aux table
+		vector<uint8_t> result;
+		result.resize(1 + codes.size() + data.size() + sizeof(CODE_AUX_TABLE));
+		result[0] = (uint8_t) (MESHOPT_INDEX_HEADER | VERSION);
+		uint8_t* write = result.data() + 1;
+		memcpy(write, codes.data(), codes.size());
+		write += codes.size();
+		memcpy(write, data.data(), data.size());
+		write += data.size();
+		memcpy(write, CODE_AUX_TABLE, sizeof(CODE_AUX_TABLE));
+		return result;
+	}
+};
+
+inline vector<uint8_t> EncodeIndexSequence(const vector<uint32_t>& in_indices)
+{
+	vector<uint8_t> data = { MESHOPT_SEQUENCE_HEADER | 1 };
+	uint32_t last[2] = {};
+	for (const uint32_t index : in_indices)
+	{
+		// Whichever baseline is closer
+		const uint32_t baseline = (uint32_t) std::abs((int64_t) index - last[1]) < (uint32_t) std::abs((int64_t) index - last[0]) ? 1 : 0;
+		EncodeVarint(data, (ZigzagEncode(index - last[baseline]) << 1) | baseline);
+		last[baseline] = index;
+	}
+	data.insert(data.end(), 4, 0);
+	return data;
+}
+
+// A grid in strip order, the kind of connectivity the index codec is built around
+inline vector<uint32_t> MakeGridIndices(const uint32_t in_size)
+{
+	vector<uint32_t> indices;
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			const uint32_t corner = y * (in_size + 1) + x;
+			indices.insert(indices.end(), { corner, corner + in_size + 1, corner + 1 });
+			indices.insert(indices.end(), { corner + 1, corner + in_size + 1, corner + in_size + 2 });
+		}
+	}
+	return indices;
+}
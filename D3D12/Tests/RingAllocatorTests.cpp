@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "RingAllocator.h"
+#include "Test.h"
+
+using std::vector;
+
+void TestAllocateFailures()
+{
+	RingAllocator ring(256);
+	TEST_CHECK(!ring.Allocate(0));
+	TEST_CHECK(!ring.Allocate(257));
+
+	const optional<RingAllocation> whole = ring.Allocate(256);
+	TEST_CHECK(whole && whole->offset == 0 && whole->size == 256);
+	TEST_CHECK(ring.GetFreeSize() == 0);
+	TEST_CHECK(!ring.Allocate(1));
+
+	TEST_CHECK(!RingAllocator().Allocate(1));
+}
+
+// Allocations are carved off the head in order, aligned, with the padding counted as used
+void TestLinearAllocation()
+{
+	RingAllocator ring(1024);
+	const optional<RingAllocation> a = ring.Allocate(10);
+	const optional<RingAllocation> b = ring.Allocate(16, 16);
+	const optional<RingAllocation> c = ring.Allocate(1);
+	TEST_CHECK(a && a->offset == 0);
+	TEST_CHECK(b && b->offset == 16);
+	TEST_CHECK(c && c->offset == 32);
+	TEST_CHECK(ring.GetUsedSize() == 33);
+	TEST_CHECK(ring.GetUnsubmittedSize() == 33);
+}
+
+// An allocation that doesn't fit before the end wraps to 0, using up the skipped tail along with it
+void TestWrapAround()
+{
+	RingAllocator ring(100);
+	TEST_CHECK(ring.Allocate(40)->offset == 0);
+	ring.Submit(1);
+	TEST_CHECK(ring.Allocate(40)->offset == 40);
+	ring.Submit(2);
+
+	// The first region is still in use, so there's no room at the front
+	TEST_CHECK(!ring.Allocate(30));
+
+	ring.Retire(1);
+	TEST_CHECK(ring.GetUsedSize() == 40);
+
+	// 20 byte tail plus 30 bytes at the front
+	const optional<RingAllocation> wrapped = ring.Allocate(30);
+	TEST_CHECK(wrapped && wrapped->offset == 0);
+	TEST_CHECK(ring.GetUsedSize() == 90);
+
+	// Up to, but not into, the second region
+	TEST_CHECK(!ring.Allocate(11));
+	const optional<RingAllocation> last = ring.Allocate(10);
+	TEST_CHECK(last && last->offset == 30);
+	TEST_CHECK(ring.GetFreeSize() == 0);
+	ring.Submit(3);
+
+	ring.Retire(2);
+	TEST_CHECK(ring.GetUsedSize() == 60);
+	ring.Retire(3);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+
+	// With nothing in use, allocation starts over at 0 rather than after the old head
+	TEST_CHECK(ring.Allocate(80)->offset == 0);
+}
+
+// Space only comes back once it's been submitted and that fence value retired, oldest region first
+void TestSubmitRetireOrdering()
+{
+	RingAllocator ring(1000);
+	TEST_CHECK(!ring.GetOldestSubmittedFenceValue());
+
+	// Submitting with nothing allocated doesn't make a region
+	ring.Submit(1);
+	TEST_CHECK(!ring.GetOldestSubmittedFenceValue());
+
+	ring.Allocate(100);
+	ring.Allocate(100);
+	ring.Submit(5);
+	ring.Allocate(300);
+	ring.Submit(7);
+	ring.Allocate(50);
+	TEST_CHECK(ring.GetOldestSubmittedFenceValue() == 5);
+	TEST_CHECK(ring.GetUnsubmittedSize() == 50);
+
+	ring.Retire(4);
+	TEST_CHECK(ring.GetUsedSize() == 550);
+
+	ring.Retire(6);
+	TEST_CHECK(ring.GetUsedSize() == 350);
+	TEST_CHECK(ring.GetOldestSubmittedFenceValue() == 7);
+
+	// Unsubmitted allocations stay in use however far retirement gets
+	ring.Retire(100);
+	TEST_CHECK(ring.GetUsedSize() == 50);
+	TEST_CHECK(!ring.GetOldestSubmittedFenceValue());
+
+	ring.Submit(101);
+	ring.Retire(101);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+	TEST_CHECK(ring.GetUnsubmittedSize() == 0);
+}
+
+// Random allocations, submits and retirements never hand out space that's still in use
+void TestRandomized()
+{
+	struct LiveAllocation
+	{
+		RingAllocation allocation;
+		uint64_t fence_value = 0;	// 0 until submitted
+	};
+
+	const uint64_t capacity = 64 * 1024;
+	RingAllocator ring(capacity);
+	vector<LiveAllocation> live_allocations;
+	uint64_t next_fence_value = 1;
+	uint64_t completed_fence_value = 0;
+
+	std::mt19937 rng(13579);
+	std::uniform_int_distribution<uint64_t> size_distribution(1, 4096);
+	std::uniform_int_distribution<uint32_t> alignment_shift_distribution(0, 8);
+	for (int step = 0; step < 20000; ++step)
+	{
+		const uint32_t action = rng() % 8;
+		if (action < 5)
+		{
+			const uint64_t alignment = 1ull << alignment_shift_distribution(rng);
+			if (const optional<RingAllocation> allocation = ring.Allocate(size_distribution(rng), alignment))
+			{
+				TEST_CHECK(allocation->offset % alignment == 0);
+				TEST_CHECK(allocation->offset + allocation->size <= capacity);
+				for (const LiveAllocation& live : live_allocations)
+				{
+					TEST_CHECK(allocation->offset + allocation->size <= live.allocation.offset || live.allocation.offset + live.allocation.size <= allocation->offset);
+				}
+				live_allocations.push_back(LiveAllocation { .allocation = *allocation });
+			}
+		}
+		else if (action < 7)
+		{
+			const uint64_t fence_value = next_fence_value++;
+			ring.Submit(fence_value);
+			for (LiveAllocation& live : live_allocations)
+			{
+				live.fence_value = live.fence_value == 0 ? fence_value : live.fence_value;
+			}
+		}
+		else
+		{
+			completed_fence_value = (std::min)(completed_fence_value + 1 + rng() % 3, next_fence_value - 1);
+			ring.Retire(completed_fence_value);
+			std::erase_if(live_allocations, [&](const LiveAllocation& live) { return live.fence_value != 0 && live.fence_value <= completed_fence_value; });
+		}
+
+		uint64_t live_size = 0;
+		for (const LiveAllocation& live : live_allocations)
+		{
+			live_size += live.allocation.size;
+		}
+		TEST_CHECK(ring.GetUsedSize() >= live_size);
+	}
+
+	ring.Submit(next_fence_value);
+	ring.Retire(next_fence_value);
+	TEST_CHECK(ring.GetUsedSize() == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestAllocateFailures);
+	TEST_RUN(TestLinearAllocation);
+	TEST_RUN(TestWrapAround);
+	TEST_RUN(TestSubmitRetireOrdering);
+	TEST_RUN(TestRandomized);
+	return 0;
+}
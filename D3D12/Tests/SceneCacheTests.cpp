@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SceneCache.h"
+#include "Test.h"
+
+// SceneCache.h included miniz's header (with its configuration), this pulls in the implementation
+#include "microprofile/demo/simple/miniz.c"
+
+using std::span;
+using std::string;
+using std::vector;
+
+static constexpr int64_t TEST_SOURCE_FILE_AGE = 1234;
+static constexpr uint64_t TEST_SOURCE_CONTENT_HASH = 0xC0FFEE;
+
+// Owns the data a GltfMeshView points at. The cache doesn't look inside the sections, so their contents are just patterns
+struct TestMesh
+{
+	TestMesh(const uint32_t in_index_stride, const size_t in_index_count, const size_t in_vertex_count, std::mt19937& io_rng)
+		: index_stride(in_index_stride)
+		, index_count(in_index_count)
+		, vertex_count(in_vertex_count)
+	{
+		// Index data is padded to 4 bytes, like cook_mesh does
+		index_data.resize(align_up(in_index_count * in_index_stride, 4));
+		for (size_t index_idx = 0; index_idx < in_index_count; ++index_idx)
+		{
+			const uint32_t index = (uint32_t) (index_idx % in_vertex_count);
+			memcpy(index_data.data() + index_idx * in_index_stride, &index, in_index_stride);
+		}
+
+		// Random bits don't deflate, smooth attributes do, so a large enough mesh exercises both stored and deflated chunks
+		positions.resize(in_vertex_count);
+		attributes.resize(in_vertex_count);
+		for (size_t vertex_idx = 0; vertex_idx < in_vertex_count; ++vertex_idx)
+		{
+			const uint32_t position_bits[3] = { (uint32_t) io_rng(), (uint32_t) io_rng(), (uint32_t) io_rng() };
+			memcpy(&positions[vertex_idx], position_bits, sizeof(float3));
+			attributes[vertex_idx] = VertexAttributes {
+				.normal = float3(0.0f, 1.0f, 0.0f),
+				.color = float3(1.0f, 1.0f, 1.0f),
+				.texcoord = float2((float) (vertex_idx % 64), (float) (vertex_idx / 64)),
+			};
+		}
+
+		meshlets.resize(3);
+		for (uint32_t meshlet_idx = 0; meshlet_idx < meshlets.size(); ++meshlet_idx)
+		{
+			meshlets[meshlet_idx].vertex_offset = meshlet_idx * 4;
+			meshlets[meshlet_idx].vertex_count = 4;
+			meshlets[meshlet_idx].triangle_offset = meshlet_idx * 2;
+			meshlets[meshlet_idx].triangle_count = 2;
+		}
+		meshlet_vertices = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+		meshlet_triangles = { 0x020100, 0x030200, 0x020100, 0x030200, 0x020100, 0x030200 };
+
+		lods = {
+			MeshLod { .index_offset = 0, .index_count = (uint32_t) in_index_count, .error = 0.0f },
+			MeshLod { .index_offset = 0, .index_count = (uint32_t) (in_index_count / 3 / 2 * 3), .error = 0.5f },
+		};
+	}
+
+	GltfMeshView GetView(const uint32_t in_material_index, const uint64_t in_source_hash) const
+	{
+		return GltfMeshView {
+			.index_stride = index_stride,
+			.index_count = index_count,
+			.index_data = index_data,
+			.vertex_format = VertexFormat::Full,
+			.vertex_count = vertex_count,
+			.position_data = GltfMeshView::AsBytes(span<const float3>(positions)),
+			.attribute_data = GltfMeshView::AsBytes(span<const VertexAttributes>(attributes)),
+			.position_min = float3(-100.0f, -100.0f, -100.0f),
+			.position_extent = float3(200.0f, 200.0f, 200.0f),
+			.bounds = Bounds {
+				.aabb_min = float3(-100.0f, -100.0f, -100.0f),
+				.aabb_max = float3(100.0f, 100.0f, 100.0f),
+				.radius = 173.3f,
+			},
+			.meshlets = meshlets,
+			.meshlet_vertices = meshlet_vertices,
+			.meshlet_triangles = meshlet_triangles,
+			.lods = lods,
+			.material_index = in_material_index,
+			.source_hash = in_source_hash,
+		};
+	}
+
+	uint32_t index_stride;
+	size_t index_count;
+	size_t vertex_count;
+	vector<uint8_t> index_data;
+	vector<float3> positions;
+	vector<VertexAttributes> attributes;
+	vector<Meshlet> meshlets;
+	vector<uint32_t> meshlet_vertices;
+	vector<uint32_t> meshlet_triangles;
+	vector<MeshLod> lods;
+};
+
+// A large mesh spanning several chunks with 32-bit indices, and a small one with an odd number of 16-bit indices (so padded index data)
+struct TestScene
+{
+	TestScene()
+		: rng(97531)
+		, large_mesh(4, 90000, 60000, rng)
+		, small_mesh(2, 3, 3, rng)
+	{
+		meshes = { large_mesh.GetView(0, 0x1111), small_mesh.GetView(INVALID_MATERIAL_INDEX, 0x2222) };
+		for (uint32_t instance_idx = 0; instance_idx < 5; ++instance_idx)
+		{
+			GltfMeshInstance instance = { .mesh_index = instance_idx % 2 };
+			instance.transform._41 = (float) instance_idx;
+			instances.push_back(instance);
+		}
+	}
+
+	std::mt19937 rng;
+	TestMesh large_mesh;
+	TestMesh small_mesh;
+	vector<GltfMeshView> meshes;
+	vector<GltfMeshInstance> instances;
+};
+
+bool BytesEqual(span<const uint8_t> in_a, span<const uint8_t> in_b)
+{
+	return std::equal(in_a.begin(), in_a.end(), in_b.begin(), in_b.end());
+}
+
+// Everything the cache stores for a mesh comes back unchanged
+void CheckMeshesEqual(const GltfMeshView& in_read, const GltfMeshView& in_written)
+{
+	TEST_CHECK(in_read.index_stride == in_written.index_stride);
+	TEST_CHECK(in_read.index_count == in_written.index_count);
+	TEST_CHECK(in_read.vertex_format == in_written.vertex_format);
+	TEST_CHECK(in_read.vertex_count == in_written.vertex_count);
+	TEST_CHECK(in_read.material_index == in_written.material_index);
+	TEST_CHECK(in_read.source_hash == in_written.source_hash);
+	TEST_CHECK(memcmp(&in_read.position_min, &in_written.position_min, sizeof(float3)) == 0);
+	TEST_CHECK(memcmp(&in_read.position_extent, &in_written.position_extent, sizeof(float3)) == 0);
+	TEST_CHECK(memcmp(&in_read.bounds, &in_written.bounds, sizeof(Bounds)) == 0);
+
+	const auto read_sections = in_read.GetSections();
+	const auto written_sections = in_written.GetSections();
+	for (size_t section_idx = 0; section_idx < GltfMeshView::SECTION_COUNT; ++section_idx)
+	{
+		TEST_CHECK(BytesEqual(read_sections[section_idx], written_sections[section_idx]));
+	}
+}
+
+void CheckSceneEqual(const SceneCache& in_cache, const TestScene& in_scene)
+{
+	TEST_CHECK(in_cache.GetMeshes().size() == in_scene.meshes.size());
+	for (size_t mesh_idx = 0; mesh_idx < in_scene.meshes.size(); ++mesh_idx)
+	{
+		CheckMeshesEqual(in_cache.GetMeshes()[mesh_idx], in_scene.meshes[mesh_idx]);
+	}
+
+	TEST_CHECK(in_cache.GetInstances().size() == in_scene.instances.size());
+	TEST_CHECK(memcmp(in_cache.GetInstances().data(), in_scene.instances.data(), in_scene.instances.size() * sizeof(GltfMeshInstance)) == 0);
+	TEST_CHECK(in_cache.GetMaxContiguousSize() == in_scene.meshes[0].attribute_data.size_bytes());
+}
+
+vector<uint8_t> ReadTestFile(const string& in_path)
+{
+	vector<uint8_t> contents(std::filesystem::file_size(in_path));
+	FILE* file = fopen(in_path.c_str(), "rb");
+	TEST_CHECK(file && fread(contents.data(), 1, contents.size(), file) == contents.size());
+	fclose(file);
+	return contents;
+}
+
+void WriteTestFile(const string& in_path, span<const uint8_t> in_contents)
+{
+	FILE* file = fopen(in_path.c_str(), "wb");
+	TEST_CHECK(file && fwrite(in_contents.data(), 1, in_contents.size(), file) == in_contents.size());
+	fclose(file);
+}
+
+string GetTestCachePath(const char* in_name)
+{
+	return (std::filesystem::temp_directory_path() / in_name).string();
+}
+
+// Uncompressed caches read back in place, exactly as written
+void TestUncompressedRoundTrip()
+{
+	const TestScene scene;
+	const string path = GetTestCachePath("SceneCacheTests_uncompressed.cooked");
+	TEST_CHECK(write_scene_cache(path, TEST_SOURCE_FILE_AGE, scene.meshes, scene.instances, TEST_SOURCE_CONTENT_HASH));
+	TEST_CHECK(!std::filesystem::exists(path + ".tmp"));
+
+	SceneCache cache;
+	TEST_CHECK(cache.Open(path, TEST_SOURCE_FILE_AGE, VertexFormat::Full));
+	TEST_CHECK(!cache.IsCompressed());
+	TEST_CHECK(cache.GetFileSize() == sizeof(SceneCacheHeader) + scene_cache_body_size(scene.meshes, scene.instances));
+	CheckSceneEqual(cache, scene);
+
+	cache.Close();
+	std::filesystem::remove(path);
+}
+
+// Deflated caches decompress to the same body, with or without a thread pool, and the chunks that don't shrink are stored as is
+void TestDeflateRoundTrip()
+{
+	const TestScene scene;
+	const string path = GetTestCachePath("SceneCacheTests_deflate.cooked");
+	ThreadPool thread_pool(4);
+	for (ThreadPool* thread_pool_ptr : { (ThreadPool*) nullptr, &thread_pool })
+	{
+		TEST_CHECK(write_scene_cache(path, TEST_SOURCE_FILE_AGE, scene.meshes, scene.instances, TEST_SOURCE_CONTENT_HASH, SceneCacheCompression::Deflate, thread_pool_ptr));
+
+		SceneCache cache;
+		TEST_CHECK(cache.Open(path, TEST_SOURCE_FILE_AGE, VertexFormat::Full, nullptr, thread_pool_ptr));
+		TEST_CHECK(cache.IsCompressed());
+		TEST_CHECK(cache.GetBodySize() == scene_cache_body_size(scene.meshes, scene.instances));
+		TEST_CHECK(cache.GetFileSize() < sizeof(SceneCacheHeader) + cache.GetBodySize());
+		CheckSceneEqual(cache, scene);
+	}
+
+	const vector<uint8_t> file = ReadTestFile(path);
+	SceneCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	TEST_CHECK(header.chunk_size == SCENE_CACHE_CHUNK_SIZE);
+	TEST_CHECK(header.chunk_count > 2);
+
+	const span<const SceneCacheChunk> chunks(reinterpret_cast<const SceneCacheChunk*>(file.data() + sizeof(header)), header.chunk_count);
+	const bool has_stored_chunk = std::any_of(chunks.begin(), chunks.end(), [](const SceneCacheChunk& chunk) { return chunk.compressed_size == chunk.size; });
+	const bool has_deflated_chunk = std::any_of(chunks.begin(), chunks.end(), [](const SceneCacheChunk& chunk) { return chunk.compressed_size < chunk.size; });
+	TEST_CHECK(has_stored_chunk && has_deflated_chunk);
+
+	// Ranges that start and end partway through chunks decompress to the same bytes as the whole body does
+	vector<uint8_t> body(header.body_size);
+	TEST_CHECK(decompress_scene_cache_range(file, header.chunk_size, chunks, 0, body, nullptr));
+
+	const uint64_t range_offsets[][2] = {
+		{ 0, 1 },
+		{ 100, SCENE_CACHE_CHUNK_SIZE - 100 },
+		{ SCENE_CACHE_CHUNK_SIZE - 8, SCENE_CACHE_CHUNK_SIZE + 8 },
+		{ 1000, header.body_size },
+		{ SCENE_CACHE_CHUNK_SIZE, 2 * SCENE_CACHE_CHUNK_SIZE },
+	};
+	for (const auto& [range_start, range_end] : range_offsets)
+	{
+		vector<uint8_t> range(range_end - range_start);
+		TEST_CHECK(decompress_scene_cache_range(file, header.chunk_size, chunks, range_start, range, &thread_pool));
+		TEST_CHECK(std::equal(range.begin(), range.end(), body.begin() + range_start));
+	}
+
+	// Past the end of the body
+	vector<uint8_t> past_end(16);
+	TEST_CHECK(!decompress_scene_cache_range(file, header.chunk_size, chunks, header.body_size, past_end, nullptr));
+
+	std::filesystem::remove(path);
+}
+
+// The header identifies the cache and its source. Caches from another version, source, or vertex format are rejected
+void TestHeaderValidation()
+{
+	const TestScene scene;
+	const string path = GetTestCachePath("SceneCacheTests_header.cooked");
+	TEST_CHECK(write_scene_cache(path, TEST_SOURCE_FILE_AGE, scene.meshes, scene.instances, TEST_SOURCE_CONTENT_HASH, SceneCacheCompression::Deflate));
+
+	const vector<uint8_t> file = ReadTestFile(path);
+	SceneCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	TEST_CHECK(header.magic == SCENE_CACHE_MAGIC);
+	TEST_CHECK(header.version == SCENE_CACHE_VERSION);
+	TEST_CHECK(header.source_file_age == TEST_SOURCE_FILE_AGE);
+	TEST_CHECK(header.source_content_hash == TEST_SOURCE_CONTENT_HASH);
+	TEST_CHECK(header.mesh_count == scene.meshes.size());
+	TEST_CHECK(header.instance_count == scene.instances.size());
+	TEST_CHECK(header.compression == SceneCacheCompression::Deflate);
+
+	SceneCache cache;
+	TEST_CHECK(!cache.Open(path, TEST_SOURCE_FILE_AGE, VertexFormat::Compact));
+
+	// A different file age is fine as long as the source's contents hash the same, which is only checked when the ages differ
+	TEST_CHECK(!cache.Open(path, TEST_SOURCE_FILE_AGE + 1, VertexFormat::Full));
+	TEST_CHECK(!cache.Open(path, TEST_SOURCE_FILE_AGE + 1, VertexFormat::Full, [] { return TEST_SOURCE_CONTENT_HASH + 1; }));
+	TEST_CHECK(cache.Open(path, TEST_SOURCE_FILE_AGE + 1, VertexFormat::Full, [] { return TEST_SOURCE_CONTENT_HASH; }));
+	TEST_CHECK(cache.Open(path, TEST_SOURCE_FILE_AGE, VertexFormat::Full, [] { TEST_CHECK(false); return (uint64_t) 0; }));
+	cache.Close();
+
+	// Copies of the file with a single field of the header changed
+	auto open_modified = [&](auto&& in_modify)
+	{
+		cache.Close();
+		vector<uint8_t> modified = file;
+		in_modify(modified);
+		WriteTestFile(path, modified);
+		return cache.Open(path, TEST_SOURCE_FILE_AGE, VertexFormat::Full);
+	};
+	TEST_CHECK(open_modified([](vector<uint8_t>&) {}));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { reinterpret_cast<SceneCacheHeader*>(io_file.data())->magic ^= 1; }));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { reinterpret_cast<SceneCacheHeader*>(io_file.data())->version = SCENE_CACHE_VERSION - 1; }));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { reinterpret_cast<SceneCacheHeader*>(io_file.data())->compression = (SceneCacheCompression) 7; }));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { reinterpret_cast<SceneCacheHeader*>(io_file.data())->chunk_count -= 1; }));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { reinterpret_cast<SceneCacheHeader*>(io_file.data())->mesh_count += 1; }));
+
+	// Truncated files, whether mid-header or mid-chunk
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { io_file.resize(sizeof(SceneCacheHeader) - 1); }));
+	TEST_CHECK(!open_modified([](vector<uint8_t>& io_file) { io_file.pop_back(); }));
+
+	cache.Close();
+	std::filesystem::remove(path);
+}
+
+int main()
+{
+	TEST_RUN(TestUncompressedRoundTrip);
+	TEST_RUN(TestDeflateRoundTrip);
+	TEST_RUN(TestHeaderValidation);
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "StagingRing.h"
+#include "Test.h"
+
+using std::vector;
+
+// Stands in for an upload buffer, remembering which overflow allocation it was made for
+struct TestOverflowBuffer
+{
+	uint64_t size = 0;
+	uint32_t id = 0;
+};
+
+/*	Drives a StagingRing with a fake fence: waiting on a fence value completes it immediately, and records that it was waited on.
+	Overflow buffers are numbered in creation order
+*/
+struct TestStaging
+{
+	TestStaging(const uint64_t in_capacity, const UploadRingFullBehavior in_full_behavior)
+		: ring(in_capacity, in_full_behavior)
+	{
+	}
+
+	optional<StagingRing<TestOverflowBuffer>::Allocation> Allocate(const uint64_t in_size, const uint64_t in_alignment = 1)
+	{
+		return ring.Allocate(
+			in_size, in_alignment, completed_fence_value,
+			[this](const uint64_t in_fence_value)
+			{
+				TEST_CHECK(in_fence_value > completed_fence_value);
+				waited_fence_values.push_back(in_fence_value);
+				completed_fence_value = in_fence_value;
+			},
+			[this](const uint64_t in_size)
+			{
+				return TestOverflowBuffer { .size = in_size, .id = overflow_buffer_count++ };
+			}
+		);
+	}
+
+	StagingRing<TestOverflowBuffer> ring;
+	uint64_t completed_fence_value = 0;
+	vector<uint64_t> waited_fence_values;
+	uint32_t overflow_buffer_count = 0;
+};
+
+// Block waits on the oldest submitted fence values, only as many as it takes to make room
+void TestBlockWaitsOldestFirst()
+{
+	TestStaging staging(100, UploadRingFullBehavior::Block);
+	for (uint64_t fence_value = 1; fence_value <= 3; ++fence_value)
+	{
+		TEST_CHECK(staging.Allocate(30));
+		staging.ring.Submit(fence_value);
+	}
+	TEST_CHECK(staging.waited_fence_values.empty());
+
+	// Wrapping uses up the 10 byte tail too, so this needs the first two regions back
+	const optional<StagingRing<TestOverflowBuffer>::Allocation> allocation = staging.Allocate(50);
+	TEST_CHECK(allocation && allocation->ring_allocation.offset == 0 && !allocation->overflow_buffer);
+	TEST_CHECK((staging.waited_fence_values == vector<uint64_t> { 1, 2 }));
+	TEST_CHECK(staging.overflow_buffer_count == 0);
+}
+
+// Block can't help when the ring is full of allocations that haven't been submitted, or with an allocation that could never fit
+void TestBlockFailures()
+{
+	TestStaging staging(100, UploadRingFullBehavior::Block);
+	TEST_CHECK(!staging.Allocate(101));
+
+	TEST_CHECK(staging.Allocate(60));
+	TEST_CHECK(!staging.Allocate(60));
+	TEST_CHECK(staging.waited_fence_values.empty());
+
+	// Once submitted, it can wait for them
+	staging.ring.Submit(1);
+	TEST_CHECK(staging.Allocate(60));
+	TEST_CHECK((staging.waited_fence_values == vector<uint64_t> { 1 }));
+	TEST_CHECK(staging.overflow_buffer_count == 0);
+}
+
+// Fence values that have already completed are retired before allocating, without waiting
+void TestRetiresCompletedWithoutWaiting()
+{
+	TestStaging staging(100, UploadRingFullBehavior::Block);
+	TEST_CHECK(staging.Allocate(80));
+	staging.ring.Submit(1);
+	staging.completed_fence_value = 1;
+
+	TEST_CHECK(staging.Allocate(80));
+	TEST_CHECK(staging.waited_fence_values.empty());
+	TEST_CHECK(staging.ring.GetUsedSize() == 80);
+}
+
+// Overflow never waits. A full ring puts the allocation in a buffer of its own, held until the fence it's submitted with completes
+void TestOverflow()
+{
+	TestStaging staging(100, UploadRingFullBehavior::Overflow);
+	TEST_CHECK(staging.Allocate(70));
+	staging.ring.Submit(1);
+
+	const optional<StagingRing<TestOverflowBuffer>::Allocation> first = staging.Allocate(70);
+	const optional<StagingRing<TestOverflowBuffer>::Allocation> second = staging.Allocate(500);
+	TEST_CHECK(first && first->overflow_buffer && first->overflow_buffer->id == 0 && first->overflow_buffer->size == 70);
+	TEST_CHECK(second && second->overflow_buffer && second->overflow_buffer->id == 1 && second->overflow_buffer->size == 500);
+	TEST_CHECK(second->ring_allocation.offset == 0 && second->ring_allocation.size == 500);
+	TEST_CHECK(staging.waited_fence_values.empty());
+	TEST_CHECK(staging.ring.GetOverflowSize() == 570);
+	TEST_CHECK(staging.ring.GetUsedSize() == 70);
+
+	// Unsubmitted overflow buffers are kept however far retirement gets
+	staging.ring.Retire(1);
+	TEST_CHECK(staging.ring.GetUsedSize() == 0);
+	TEST_CHECK(staging.ring.GetOverflowBufferCount() == 2);
+
+	staging.ring.Submit(2);
+	const optional<StagingRing<TestOverflowBuffer>::Allocation> third = staging.Allocate(200);
+	TEST_CHECK(third && third->overflow_buffer && third->overflow_buffer->id == 2);
+	staging.ring.Submit(3);
+
+	staging.ring.Retire(2);
+	TEST_CHECK(staging.ring.GetOverflowBufferCount() == 1);
+	TEST_CHECK(staging.ring.GetOverflowSize() == 200);
+	TEST_CHECK(third->overflow_buffer->id == 2);
+
+	staging.ring.Retire(3);
+	TEST_CHECK(staging.ring.GetOverflowBufferCount() == 0);
+	TEST_CHECK(staging.ring.GetOverflowSize() == 0);
+
+	// Nothing to overflow for an empty allocation
+	TEST_CHECK(!staging.Allocate(0));
+	TEST_CHECK(staging.overflow_buffer_count == 3);
+}
+
+int main()
+{
+	TEST_RUN(TestBlockWaitsOldestFirst);
+	TEST_RUN(TestBlockFailures);
+	TEST_RUN(TestRetiresCompletedWithoutWaiting);
+	TEST_RUN(TestOverflow);
+	return 0;
+}
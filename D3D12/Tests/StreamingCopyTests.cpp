@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "StreamingCopy.h"
+#include "Test.h"
+
+using std::vector;
+
+static constexpr uint8_t GUARD_BYTE = 0xCD;
+static constexpr size_t GUARD_SIZE = 64;
+
+// Copies in_size bytes between the given misalignments and checks the copy, and that nothing either side of the destination was touched
+void CheckCopy(const vector<uint8_t>& in_source_data, const size_t in_source_misalignment, const size_t in_dest_misalignment, const size_t in_size)
+{
+	alignas(64) static uint8_t dest_buffer[2 * GUARD_SIZE + 64 + 1024 * 1024];
+	memset(dest_buffer, GUARD_BYTE, GUARD_SIZE + in_dest_misalignment + in_size + GUARD_SIZE);
+
+	uint8_t* dest = dest_buffer + GUARD_SIZE + in_dest_misalignment;
+	const uint8_t* source = in_source_data.data() + in_source_misalignment;
+	streaming_memcpy(dest, source, in_size);
+
+	TEST_CHECK(memcmp(dest, source, in_size) == 0);
+	for (size_t guard_idx = 0; guard_idx < GUARD_SIZE; ++guard_idx)
+	{
+		TEST_CHECK(*(dest - 1 - guard_idx) == GUARD_BYTE);
+		TEST_CHECK(dest[in_size + guard_idx] == GUARD_BYTE);
+	}
+}
+
+/*	Every size around the non-temporal threshold and the 64 and 16 byte loop boundaries, for every source and destination alignment.
+	Covers the plain memcpy path, the unaligned head, both loops and the tail
+*/
+void TestSizesAndAlignments()
+{
+	vector<uint8_t> source_data(64 + 1024);
+	std::mt19937 rng(11235);
+	for (uint8_t& byte : source_data)
+	{
+		byte = (uint8_t) rng();
+	}
+
+	for (size_t size = 0; size <= STREAMING_COPY_MIN_SIZE + 3 * 64; ++size)
+	{
+		for (size_t source_misalignment = 0; source_misalignment < 16; ++source_misalignment)
+		{
+			for (size_t dest_misalignment = 0; dest_misalignment < 16; ++dest_misalignment)
+			{
+				CheckCopy(source_data, source_misalignment, dest_misalignment, size);
+			}
+		}
+	}
+}
+
+// Large copies, where nearly everything goes through the cache line loop
+void TestLargeCopies()
+{
+	vector<uint8_t> source_data(16 + 1024 * 1024);
+	std::mt19937 rng(81321);
+	for (uint8_t& byte : source_data)
+	{
+		byte = (uint8_t) rng();
+	}
+
+	for (const size_t size : { (size_t) 4096, (size_t) 65536 + 7, (size_t) 1024 * 1024 })
+	{
+		CheckCopy(source_data, 0, 0, size);
+		CheckCopy(source_data, 3, 9, size - 16);
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestSizesAndAlignments);
+	TEST_RUN(TestLargeCopies);
+	return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+/*	Minimal checks for the headless unit tests. Each test is an executable of its own (see CMakeLists.txt) that runs its cases from main.
+	The first failing check reports itself and exits non-zero, which is what CTest goes by
+*/
+#define TEST_CHECK(expr) \
+{\
+	if (!(expr))\
+	{\
+		fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #expr);\
+		exit(1);\
+	}\
+}\
+
+#define TEST_CHECK_NEAR(a, b, tolerance) TEST_CHECK(std::abs((double) (a) - (double) (b)) <= (double) (tolerance))
+
+// Runs one test case, printing its name first so a failure can be traced back to it
+#define TEST_RUN(test_function) \
+{\
+	printf("%s\n", #test_function);\
+	test_function();\
+}\
+
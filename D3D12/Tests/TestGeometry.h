@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+
+#include "GltfConversion.h"
+
+// Helpers for the tests that check one way of getting converted geometry (a cache, a reload, the cooker) against another
+
+// A fresh directory for one test's files
+inline std::filesystem::path GetTestDirectory(const char* in_name)
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / in_name;
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	return directory;
+}
+
+inline bool BytesEqual(std::span<const uint8_t> in_a, std::span<const uint8_t> in_b)
+{
+	return in_a.size() == in_b.size() && (in_a.empty() || memcmp(in_a.data(), in_b.data(), in_a.size()) == 0);
+}
+
+// Everything about a mesh that ends up on the GPU
+inline bool MeshEqual(const GltfMeshView& in_a, const GltfMeshView& in_b)
+{
+	if (in_a.index_stride != in_b.index_stride || in_a.index_count != in_b.index_count || in_a.vertex_count != in_b.vertex_count
+		|| in_a.material_index != in_b.material_index || in_a.source_hash != in_b.source_hash)
+	{
+		return false;
+	}
+
+	const auto sections_a = in_a.GetSections();
+	const auto sections_b = in_b.GetSections();
+	for (size_t section_idx = 0; section_idx < GltfMeshView::SECTION_COUNT; ++section_idx)
+	{
+		if (!BytesEqual(sections_a[section_idx], sections_b[section_idx]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Everything about the meshes and instances that ends up on the GPU
+inline bool GeometryEqual(const GltfGeometry& in_a, const GltfGeometry& in_b)
+{
+	if (in_a.meshes.size() != in_b.meshes.size() || in_a.instances.size() != in_b.instances.size())
+	{
+		return false;
+	}
+
+	for (size_t mesh_idx = 0; mesh_idx < in_a.meshes.size(); ++mesh_idx)
+	{
+		if (!MeshEqual(in_a.meshes[mesh_idx], in_b.meshes[mesh_idx]))
+		{
+			return false;
+		}
+	}
+
+	return BytesEqual(GltfMeshView::AsBytes(in_a.instances), GltfMeshView::AsBytes(in_b.instances));
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*	Builds small synthetic gltfs (a .gltf plus an external .bin) for the tests and benchmarks that go through the file-based loading path.
+	Every primitive is a grid of quads over a height field, so it has real vertex sharing for the mesh processing passes to work with.
+	Only depends on the standard library, so it can be used alongside any of our headers
+*/
+struct TestGltfBuilder
+{
+	// Where one primitive's data lives in the buffer, so tests can change it
+	struct Primitive
+	{
+		uint32_t position_accessor = 0;
+		uint32_t normal_accessor = 0;
+		uint32_t texcoord_accessor = 0;
+		uint32_t index_accessor = 0;
+
+		size_t position_offset = 0;
+		size_t vertex_count = 0;
+		size_t index_count = 0;
+	};
+
+	struct Mesh
+	{
+		std::vector<uint32_t> primitives;
+	};
+
+	struct Node
+	{
+		uint32_t mesh = 0;
+		float translation[3] = {};
+	};
+
+	// Adds a primitive covering in_grid_size x in_grid_size quads. in_phase shifts the height field, so primitives with different phases differ.
+	// Indices are 16-bit when every vertex fits, 32-bit otherwise. Returns the primitive's index
+	uint32_t AddGridPrimitive(const uint32_t in_grid_size, const float in_phase)
+	{
+		const uint32_t side = in_grid_size + 1;
+		const size_t vertex_count = (size_t) side * side;
+
+		std::vector<float> positions;
+		std::vector<float> normals;
+		std::vector<float> texcoords;
+		positions.reserve(vertex_count * 3);
+		normals.reserve(vertex_count * 3);
+		texcoords.reserve(vertex_count * 2);
+		for (uint32_t y = 0; y < side; ++y)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const float u = (float) x / (float) in_grid_size;
+				const float v = (float) y / (float) in_grid_size;
+				const float height = 0.25f * std::sin(6.0f * u + in_phase) * std::cos(4.0f * v - in_phase);
+				positions.insert(positions.end(), { u * 10.0f, height, v * 10.0f });
+
+				// Normal of the height field, from its partial derivatives
+				const float dx = 1.5f * std::cos(6.0f * u + in_phase) * std::cos(4.0f * v - in_phase) / 10.0f;
+				const float dz = -1.0f * std::sin(6.0f * u + in_phase) * std::sin(4.0f * v - in_phase) / 10.0f;
+				const float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+				normals.insert(normals.end(), { -dx / length, 1.0f / length, -dz / length });
+				texcoords.insert(texcoords.end(), { u, v });
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		indices.reserve((size_t) in_grid_size * in_grid_size * 6);
+		for (uint32_t y = 0; y < in_grid_size; ++y)
+		{
+			for (uint32_t x = 0; x < in_grid_size; ++x)
+			{
+				const uint32_t corner = y * side + x;
+				indices.insert(indices.end(), { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 });
+			}
+		}
+
+		Primitive primitive;
+		primitive.vertex_count = vertex_count;
+		primitive.index_count = indices.size();
+		primitive.position_offset = buffer.size();
+		primitive.position_accessor = AddAccessor(positions.data(), positions.size() * sizeof(float), vertex_count, 5126, "VEC3");
+		primitive.normal_accessor = AddAccessor(normals.data(), normals.size() * sizeof(float), vertex_count, 5126, "VEC3");
+		primitive.texcoord_accessor = AddAccessor(texcoords.data(), texcoords.size() * sizeof(float), vertex_count, 5126, "VEC2");
+		if (vertex_count <= 65536)
+		{
+			std::vector<uint16_t> narrow_indices(indices.begin(), indices.end());
+			primitive.index_accessor = AddAccessor(narrow_indices.data(), narrow_indices.size() * sizeof(uint16_t), indices.size(), 5123, "SCALAR");
+		}
+		else
+		{
+			primitive.index_accessor = AddAccessor(indices.data(), indices.size() * sizeof(uint32_t), indices.size(), 5125, "SCALAR");
+		}
+
+		primitives.push_back(primitive);
+		return (uint32_t) primitives.size() - 1;
+	}
+
+	// Adds a primitive that reads the same accessors as in_primitive, i.e. identical data under another gltf primitive
+	uint32_t AddDuplicatePrimitive(const uint32_t in_primitive)
+	{
+		primitives.push_back(primitives[in_primitive]);
+		return (uint32_t) primitives.size() - 1;
+	}
+
+	uint32_t AddMesh(const std::vector<uint32_t>& in_primitives)
+	{
+		meshes.push_back(Mesh { .primitives = in_primitives });
+		return (uint32_t) meshes.size() - 1;
+	}
+
+	void AddNode(const uint32_t in_mesh, const float in_x = 0.0f, const float in_y = 0.0f, const float in_z = 0.0f)
+	{
+		nodes.push_back(Node { .mesh = in_mesh, .translation = { in_x, in_y, in_z } });
+	}
+
+	// Offsets the positions of in_primitive's first vertex, so only that primitive's data changes
+	void ChangePrimitive(const uint32_t in_primitive)
+	{
+		float position[3];
+		memcpy(position, buffer.data() + primitives[in_primitive].position_offset, sizeof(position));
+		position[1] += 1.0f;
+		memcpy(buffer.data() + primitives[in_primitive].position_offset, position, sizeof(position));
+	}
+
+	std::string GetJson(const std::string& in_buffer_uri) const
+	{
+		std::string json = "{\n\t\"asset\": { \"version\": \"2.0\" },\n\t\"scene\": 0,\n\t\"scenes\": [ { \"nodes\": [ ";
+		for (size_t node_idx = 0; node_idx < nodes.size(); ++node_idx)
+		{
+			json += (node_idx > 0 ? ", " : "") + std::to_string(node_idx);
+		}
+		json += " ] } ],\n\t\"nodes\": [\n";
+		for (size_t node_idx = 0; node_idx < nodes.size(); ++node_idx)
+		{
+			const Node& node = nodes[node_idx];
+			char node_json[256];
+			snprintf(node_json, sizeof(node_json), "\t\t{ \"mesh\": %u, \"translation\": [ %.9g, %.9g, %.9g ] }%s\n",
+				node.mesh, node.translation[0], node.translation[1], node.translation[2], node_idx + 1 < nodes.size() ? "," : "");
+			json += node_json;
+		}
+		json += "\t],\n\t\"meshes\": [\n";
+		for (size_t mesh_idx = 0; mesh_idx < meshes.size(); ++mesh_idx)
+		{
+			json += "\t\t{ \"primitives\": [ ";
+			const std::vector<uint32_t>& mesh_primitives = meshes[mesh_idx].primitives;
+			for (size_t primitive_idx = 0; primitive_idx < mesh_primitives.size(); ++primitive_idx)
+			{
+				const Primitive& primitive = primitives[mesh_primitives[primitive_idx]];
+				char primitive_json[256];
+				snprintf(primitive_json, sizeof(primitive_json), "%s{ \"attributes\": { \"POSITION\": %u, \"NORMAL\": %u, \"TEXCOORD_0\": %u }, \"indices\": %u }",
+					primitive_idx > 0 ? ", " : "", primitive.position_accessor, primitive.normal_accessor, primitive.texcoord_accessor, primitive.index_accessor);
+				json += primitive_json;
+			}
+			json += mesh_idx + 1 < meshes.size() ? " ] },\n" : " ] }\n";
+		}
+		json += "\t],\n\t\"accessors\": [\n";
+		for (size_t accessor_idx = 0; accessor_idx < accessors.size(); ++accessor_idx)
+		{
+			const Accessor& accessor = accessors[accessor_idx];
+			char accessor_json[256];
+			snprintf(accessor_json, sizeof(accessor_json), "\t\t{ \"bufferView\": %zu, \"count\": %zu, \"componentType\": %u, \"type\": \"%s\" }%s\n",
+				accessor_idx, accessor.count, accessor.component_type, accessor.type, accessor_idx + 1 < accessors.size() ? "," : "");
+			json += accessor_json;
+		}
+		json += "\t],\n\t\"bufferViews\": [\n";
+		for (size_t accessor_idx = 0; accessor_idx < accessors.size(); ++accessor_idx)
+		{
+			const Accessor& accessor = accessors[accessor_idx];
+			char buffer_view_json[256];
+			snprintf(buffer_view_json, sizeof(buffer_view_json), "\t\t{ \"buffer\": 0, \"byteOffset\": %zu, \"byteLength\": %zu }%s\n",
+				accessor.offset, accessor.size, accessor_idx + 1 < accessors.size() ? "," : "");
+			json += buffer_view_json;
+		}
+		json += "\t],\n\t\"buffers\": [ { \"uri\": \"" + in_buffer_uri + "\", \"byteLength\": " + std::to_string(buffer.size()) + " } ]\n}\n";
+		return json;
+	}
+
+	// Writes the gltf to in_gltf_path, with its buffer in a .bin next to it. Returns false if either file couldn't be written
+	bool Write(const std::filesystem::path& in_gltf_path) const
+	{
+		std::filesystem::path buffer_path = in_gltf_path;
+		buffer_path.replace_extension(".bin");
+		const std::string json = GetJson(buffer_path.filename().string());
+		return WriteBytes(in_gltf_path, json.data(), json.size()) && WriteBytes(buffer_path, buffer.data(), buffer.size());
+	}
+
+	std::vector<Primitive> primitives;
+	std::vector<Mesh> meshes;
+	std::vector<Node> nodes;
+	std::vector<uint8_t> buffer;
+
+protected:
+	// Each accessor gets a buffer view of its own
+	struct Accessor
+	{
+		size_t offset = 0;
+		size_t size = 0;
+		size_t count = 0;
+		uint32_t component_type = 0;
+		const char* type = nullptr;
+	};
+
+	uint32_t AddAccessor(const void* in_data, const size_t in_size, const size_t in_count, const uint32_t in_component_type, const char* in_type)
+	{
+		const size_t offset = buffer.size();
+		buffer.resize(offset + ((in_size + 3) & ~(size_t) 3));
+		memcpy(buffer.data() + offset, in_data, in_size);
+		accessors.push_back(Accessor { .offset = offset, .size = in_size, .count = in_count, .component_type = in_component_type, .type = in_type });
+		return (uint32_t) accessors.size() - 1;
+	}
+
+	static bool WriteBytes(const std::filesystem::path& in_path, const void* in_data, const size_t in_size)
+	{
+		FILE* file = fopen(in_path.string().c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+		const bool written = fwrite(in_data, 1, in_size, file) == in_size;
+		return fclose(file) == 0 && written;
+	}
+
+	std::vector<Accessor> accessors;
+};
@@ -0,0 +1,167 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "TextureCompression.h"
+#include "Test.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "microprofile/stb/stb_image.h"
+
+#define STB_DXT_IMPLEMENTATION
+#include "microprofile/stb/stb_dxt.h"
+
+// in_size x in_size texture of smooth color gradients, with a bit of per-texel noise so blocks aren't trivially flat
+TextureData MakeColorTexture(const uint32_t in_size, const bool in_alpha)
+{
+	TextureData texture;
+	texture.width = in_size;
+	texture.height = in_size;
+	texture.srgb = true;
+	allocate_texture_mips(texture, 1);
+
+	uint32_t noise = 12345;
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			const float u = (float) x / in_size;
+			const float v = (float) y / in_size;
+			uint8_t* texel = texture.data.data() + ((size_t) y * in_size + x) * TEXTURE_BYTES_PER_TEXEL;
+			texel[0] = (uint8_t) (127.5f + 127.5f * std::sin(5.0f * u + 1.0f));
+			texel[1] = (uint8_t) (127.5f + 127.5f * std::cos(3.0f * v));
+			texel[2] = (uint8_t) (64.0f + 128.0f * u * v + (noise >> 29));
+			texel[3] = in_alpha ? (uint8_t) (255.0f * (0.5f + 0.5f * std::sin(4.0f * (u + v)))) : 255;
+		}
+	}
+	return texture;
+}
+
+// in_size x in_size tangent space normal map of a bumpy surface, encoded to [0,255] like an exported normal map
+TextureData MakeNormalMap(const uint32_t in_size)
+{
+	TextureData texture;
+	texture.width = in_size;
+	texture.height = in_size;
+	allocate_texture_mips(texture, 1);
+	for (uint32_t y = 0; y < in_size; ++y)
+	{
+		for (uint32_t x = 0; x < in_size; ++x)
+		{
+			const float u = (float) x / in_size;
+			const float v = (float) y / in_size;
+			const float nx = 0.4f * std::cos(9.0f * u) * std::sin(6.0f * v);
+			const float ny = 0.4f * std::sin(9.0f * u) * std::cos(6.0f * v);
+			const float nz = std::sqrt(1.0f - nx * nx - ny * ny);
+			uint8_t* texel = texture.data.data() + ((size_t) y * in_size + x) * TEXTURE_BYTES_PER_TEXEL;
+			texel[0] = (uint8_t) std::lround((nx * 0.5f + 0.5f) * 255.0f);
+			texel[1] = (uint8_t) std::lround((ny * 0.5f + 0.5f) * 255.0f);
+			texel[2] = (uint8_t) std::lround((nz * 0.5f + 0.5f) * 255.0f);
+			texel[3] = 255;
+		}
+	}
+	return texture;
+}
+
+/*	Each format keeps the channels it stores above a PSNR floor on the top mip. The rest of the chain has to decode to the same layout,
+	but its smallest mips are a few blocks spanning the whole gradient, which says little about the encoders
+*/
+void TestCompressionQuality()
+{
+	struct FormatCase
+	{
+		TextureFormat format;
+		TextureData texture;
+		uint32_t channel_mask;
+		float min_psnr;
+	};
+
+	FormatCase cases[] =
+	{
+		{ TextureFormat::BC1, MakeColorTexture(64, false), 0x7, 35.0f },
+		{ TextureFormat::BC3, MakeColorTexture(64, true), 0xF, 36.0f },
+		{ TextureFormat::BC5, MakeNormalMap(64), 0x3, 46.0f },
+		{ TextureFormat::BC7, MakeColorTexture(64, false), 0xF, 38.0f },
+		{ TextureFormat::BC7, MakeColorTexture(64, true), 0xF, 36.0f },
+	};
+
+	for (FormatCase& format_case : cases)
+	{
+		generate_mips(format_case.texture);
+		const TextureData compressed = compress_texture(format_case.texture, format_case.format);
+		TEST_CHECK(compressed.format == format_case.format && compressed.mips.size() == format_case.texture.mips.size());
+		TEST_CHECK(compressed.mips[0].GetSize() == (64 / TEXTURE_BLOCK_DIM) * (64 / TEXTURE_BLOCK_DIM) * get_texture_block_size(format_case.format));
+
+		const TextureData decompressed = decompress_texture(compressed.GetView());
+		TEST_CHECK(decompressed.format == TextureFormat::RGBA8 && decompressed.data.size() == format_case.texture.data.size());
+		TEST_CHECK(calculate_psnr(format_case.texture.GetMipData(0), decompressed.GetMipData(0), format_case.channel_mask) > format_case.min_psnr);
+	}
+}
+
+// Whether every texel of two 4x4 RGBA8 blocks is within in_tolerance in the channels of in_channel_mask
+bool BlocksMatch(const uint8_t* in_block, const uint8_t* in_other_block, const uint32_t in_channel_mask, const int in_tolerance)
+{
+	for (uint32_t value_idx = 0; value_idx < 16 * TEXTURE_BYTES_PER_TEXEL; ++value_idx)
+	{
+		if ((in_channel_mask & (1u << (value_idx % 4))) && std::abs((int) in_block[value_idx] - (int) in_other_block[value_idx]) > in_tolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*	Flat blocks come back within a step through BC7 mode 6, whose endpoints are 7 bits plus a p-bit shared by all four channels,
+	so not every color is exact. BC1 gets within 565 rounding, and opaque stays opaque
+*/
+void TestSolidBlocks()
+{
+	const uint8_t colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 17, 130, 201, 255 }, { 254, 1, 128, 77 } };
+	for (const uint8_t (&color)[4] : colors)
+	{
+		uint8_t block[16 * TEXTURE_BYTES_PER_TEXEL];
+		for (uint32_t texel_idx = 0; texel_idx < 16; ++texel_idx)
+		{
+			memcpy(block + texel_idx * TEXTURE_BYTES_PER_TEXEL, color, TEXTURE_BYTES_PER_TEXEL);
+		}
+
+		uint8_t bc7_block[16];
+		uint8_t decoded[16 * TEXTURE_BYTES_PER_TEXEL];
+		encode_bc7_block(block, bc7_block);
+		decode_bc7_block(bc7_block, decoded);
+		TEST_CHECK(BlocksMatch(block, decoded, 0xF, 1));
+
+		if (color[3] == 255)
+		{
+			uint8_t bc1_block[8];
+			compress_block(TextureFormat::BC1, block, bc1_block);
+			decompress_block(TextureFormat::BC1, bc1_block, decoded);
+			TEST_CHECK(BlocksMatch(block, decoded, 0x7, 4) && BlocksMatch(block, decoded, 0x8, 0));
+		}
+	}
+}
+
+// Spreading block rows across a thread pool gives the exact same blocks
+void TestParallelCompression()
+{
+	TextureData texture = MakeColorTexture(64, true);
+	generate_mips(texture);
+
+	ThreadPool thread_pool(3);
+	for (const TextureFormat format : { TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC5, TextureFormat::BC7 })
+	{
+		const TextureData serial = compress_texture(texture, format);
+		const TextureData parallel = compress_texture(texture, format, &thread_pool);
+		TEST_CHECK(serial.data == parallel.data);
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestCompressionQuality);
+	TEST_RUN(TestSolidBlocks);
+	TEST_RUN(TestParallelCompression);
+	return 0;
+}
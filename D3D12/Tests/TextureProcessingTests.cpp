@@ -0,0 +1,228 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "TextureProcessing.h"
+#include "Test.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "microprofile/stb/stb_image.h"
+
+using std::vector;
+
+// An 8x4 RGBA PNG whose texels are GetPngTexel
+static const uint8_t TEST_PNG[] =
+{
+	0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x08,
+	0x00, 0x00, 0x00, 0x04, 0x08, 0x06, 0x00, 0x00, 0x00, 0xB3, 0xCD, 0x7E, 0xF0, 0x00, 0x00, 0x00, 0x65, 0x49, 0x44, 0x41,
+	0x54, 0x78, 0xDA, 0x63, 0x60, 0x30, 0xCD, 0x9A, 0xAF, 0x1A, 0xD5, 0x7F, 0xC4, 0xAB, 0x7E, 0xCB, 0xCB, 0xFC, 0x25, 0x37,
+	0xF9, 0xA6, 0x9C, 0xFC, 0x67, 0xBC, 0xF3, 0x9D, 0x72, 0xC4, 0x3D, 0x61, 0x8F, 0x5A, 0x66, 0x8B, 0xDC, 0x45, 0x0C, 0xD1,
+	0x13, 0x8E, 0xFE, 0x6A, 0xD8, 0xFA, 0x4A, 0x7E, 0xE9, 0x2D, 0x7E, 0x97, 0x53, 0xFF, 0x4D, 0x32, 0xDF, 0xAB, 0x44, 0xF6,
+	0x89, 0x78, 0xD6, 0x6D, 0xB6, 0xCC, 0x5B, 0x7C, 0x23, 0x6E, 0xF2, 0x89, 0xBF, 0x0C, 0xDB, 0x5E, 0x2B, 0x84, 0xDE, 0x16,
+	0x70, 0xAD, 0xC2, 0x65, 0x12, 0x83, 0xA0, 0x5B, 0xF5, 0x06, 0xB3, 0xEC, 0x05, 0x57, 0x71, 0x99, 0x04, 0x00, 0x89, 0x74,
+	0x40, 0xC1, 0x2C, 0x96, 0x82, 0x5B, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82,
+};
+static constexpr uint32_t TEST_PNG_WIDTH = 8;
+static constexpr uint32_t TEST_PNG_HEIGHT = 4;
+
+uint8_t GetPngTexel(const uint32_t in_x, const uint32_t in_y, const uint32_t in_channel)
+{
+	return (uint8_t) ((in_x * 37 + in_y * 91 + in_channel * 53) & 255);
+}
+
+/*	Reference mip chain for TEST_PNG: each level is a 2x2 box filter of the previous level's unquantized linear values, in double precision,
+	sRGB decoded and re-encoded when in_srgb is set. Returns every level's RGBA8 texels
+*/
+vector<vector<uint8_t>> GetReferenceMips(const bool in_srgb)
+{
+	uint32_t width = TEST_PNG_WIDTH;
+	uint32_t height = TEST_PNG_HEIGHT;
+	vector<double> level(width * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				const double value = GetPngTexel(x, y, channel) / 255.0;
+				level[(y * width + x) * 4 + channel] = in_srgb && channel < 3 ? srgb_to_linear((float) value) : value;
+			}
+		}
+	}
+
+	vector<vector<uint8_t>> mips;
+	while (true)
+	{
+		vector<uint8_t>& mip = mips.emplace_back(level.size());
+		for (size_t value_idx = 0; value_idx < level.size(); ++value_idx)
+		{
+			const double value = in_srgb && value_idx % 4 < 3 ? linear_to_srgb((float) level[value_idx]) : level[value_idx];
+			mip[value_idx] = (uint8_t) std::lround(value * 255.0);
+		}
+
+		if (width == 1 && height == 1)
+		{
+			return mips;
+		}
+
+		const uint32_t next_width = (std::max)(width / 2, 1u);
+		const uint32_t next_height = (std::max)(height / 2, 1u);
+		vector<double> next_level(next_width * next_height * 4);
+		for (uint32_t y = 0; y < next_height; ++y)
+		{
+			for (uint32_t x = 0; x < next_width; ++x)
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					double sum = 0.0;
+					for (const uint32_t source_y : { (std::min)(y * 2, height - 1), (std::min)(y * 2 + 1, height - 1) })
+					{
+						for (const uint32_t source_x : { (std::min)(x * 2, width - 1), (std::min)(x * 2 + 1, width - 1) })
+						{
+							sum += level[(source_y * width + source_x) * 4 + channel];
+						}
+					}
+					next_level[(y * next_width + x) * 4 + channel] = sum * 0.25;
+				}
+			}
+		}
+		level = std::move(next_level);
+		width = next_width;
+		height = next_height;
+	}
+}
+
+// Decoded texels can differ from the reference by a step where float and double round a half differently
+bool TexelsMatch(span<const uint8_t> in_texels, const vector<uint8_t>& in_reference)
+{
+	if (in_texels.size() != in_reference.size())
+	{
+		return false;
+	}
+	for (size_t value_idx = 0; value_idx < in_texels.size(); ++value_idx)
+	{
+		if (std::abs((int) in_texels[value_idx] - (int) in_reference[value_idx]) > 1)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// stb_image decodes the PNG to exactly its texels, as a single tightly packed RGBA8 mip. Data that isn't an image fails
+void TestDecodePng()
+{
+	const optional<TextureData> texture = decode_image(TEST_PNG, true);
+	TEST_CHECK(texture.has_value());
+	TEST_CHECK(texture->width == TEST_PNG_WIDTH && texture->height == TEST_PNG_HEIGHT);
+	TEST_CHECK(texture->format == TextureFormat::RGBA8 && texture->srgb);
+	TEST_CHECK(texture->mips.size() == 1);
+	TEST_CHECK(texture->mips[0].row_size == TEST_PNG_WIDTH * TEXTURE_BYTES_PER_TEXEL && texture->mips[0].row_count == TEST_PNG_HEIGHT);
+	TEST_CHECK(texture->data.size() == TEST_PNG_WIDTH * TEST_PNG_HEIGHT * TEXTURE_BYTES_PER_TEXEL);
+
+	bool texels_match = true;
+	for (uint32_t y = 0; y < TEST_PNG_HEIGHT; ++y)
+	{
+		for (uint32_t x = 0; x < TEST_PNG_WIDTH; ++x)
+		{
+			for (uint32_t channel = 0; channel < 4; ++channel)
+			{
+				texels_match &= texture->data[(y * TEST_PNG_WIDTH + x) * 4 + channel] == GetPngTexel(x, y, channel);
+			}
+		}
+	}
+	TEST_CHECK(texels_match);
+
+	const uint8_t not_an_image[] = { 0x89, 0x50, 0x4E, 0x47, 0x00, 0x01, 0x02, 0x03 };
+	TEST_CHECK(!decode_image(not_an_image, false).has_value());
+}
+
+// The chain goes down to 1x1, each level a box filter of the one above it, in linear space for both color spaces
+void TestMipChain()
+{
+	for (const bool srgb : { false, true })
+	{
+		optional<TextureData> texture = decode_image(TEST_PNG, srgb);
+		TEST_CHECK(texture.has_value());
+		generate_mips(*texture);
+
+		const uint32_t expected_sizes[][2] = { { 8, 4 }, { 4, 2 }, { 2, 1 }, { 1, 1 } };
+		TEST_CHECK(texture->mips.size() == 4);
+		TEST_CHECK(calculate_mip_count(TEST_PNG_WIDTH, TEST_PNG_HEIGHT) == 4);
+
+		const vector<vector<uint8_t>> reference_mips = GetReferenceMips(srgb);
+		size_t expected_offset = 0;
+		for (size_t mip_idx = 0; mip_idx < texture->mips.size(); ++mip_idx)
+		{
+			const TextureMip& mip = texture->mips[mip_idx];
+			TEST_CHECK(mip.width == expected_sizes[mip_idx][0] && mip.height == expected_sizes[mip_idx][1]);
+			TEST_CHECK(mip.offset == expected_offset);
+			TEST_CHECK(mip.row_size == mip.width * TEXTURE_BYTES_PER_TEXEL && mip.row_count == mip.height);
+			TEST_CHECK(TexelsMatch(texture->GetMipData(mip_idx), reference_mips[mip_idx]));
+			expected_offset += mip.GetSize();
+		}
+		TEST_CHECK(texture->data.size() == expected_offset);
+	}
+}
+
+// Black and white average to 50% linear, which is 188 in sRGB rather than the 128 a filter working on the encoded values gives
+void TestGammaCorrectFiltering()
+{
+	for (const bool srgb : { false, true })
+	{
+		TextureData texture;
+		texture.width = 2;
+		texture.height = 2;
+		texture.srgb = srgb;
+		allocate_texture_mips(texture, 1);
+		const uint8_t texels[] = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 };
+		memcpy(texture.data.data(), texels, sizeof(texels));
+
+		generate_mips(texture);
+		TEST_CHECK(texture.mips.size() == 2);
+		const span<const uint8_t> mip = texture.GetMipData(1);
+		const uint8_t expected_color = srgb ? 188 : 128;
+		TEST_CHECK(mip[0] == expected_color && mip[1] == expected_color && mip[2] == expected_color);
+		TEST_CHECK(mip[3] == 255);
+	}
+}
+
+// Odd sizes round down, never below 1. A side that's down to 1 texel clamps, so the other side keeps being averaged
+void TestOddSizes()
+{
+	TextureData odd_texture;
+	odd_texture.width = 5;
+	odd_texture.height = 3;
+	allocate_texture_mips(odd_texture, 1);
+	generate_mips(odd_texture);
+	TEST_CHECK(odd_texture.mips.size() == 3);
+	TEST_CHECK(odd_texture.mips[1].width == 2 && odd_texture.mips[1].height == 1);
+	TEST_CHECK(odd_texture.mips[2].width == 1 && odd_texture.mips[2].height == 1);
+
+	TextureData column_texture;
+	column_texture.width = 1;
+	column_texture.height = 4;
+	allocate_texture_mips(column_texture, 1);
+	const uint8_t rows[] = { 0, 100, 200, 40 };
+	for (uint32_t y = 0; y < column_texture.height; ++y)
+	{
+		memset(column_texture.data.data() + y * 4, rows[y], 4);
+	}
+
+	generate_mips(column_texture);
+	TEST_CHECK(column_texture.mips.size() == 3);
+	TEST_CHECK(column_texture.mips[1].width == 1 && column_texture.mips[1].height == 2);
+	TEST_CHECK(column_texture.GetMipData(1)[0] == 50 && column_texture.GetMipData(1)[4] == 120);
+	TEST_CHECK(column_texture.GetMipData(2)[0] == 85);
+}
+
+int main()
+{
+	TEST_RUN(TestDecodePng);
+	TEST_RUN(TestMipChain);
+	TEST_RUN(TestGammaCorrectFiltering);
+	TEST_RUN(TestOddSizes);
+	return 0;
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "TextureStreaming.h"
+#include "Test.h"
+
+using std::vector;
+
+// Sizes of a square RGBA8 texture's full mip chain, in_size texels across, most detailed first
+vector<uint64_t> GetMipSizes(const uint32_t in_size)
+{
+	vector<uint64_t> mip_sizes;
+	for (uint64_t size = in_size; size > 0; size /= 2)
+	{
+		mip_sizes.push_back(size * size * 4);
+	}
+	return mip_sizes;
+}
+
+// Carries out every change of an update right away, like uploads that land before the next frame
+void CompleteChanges(TextureStreamingPolicy& io_policy, const TextureStreamingUpdate& in_update)
+{
+	for (const vector<TextureStreamingChange>* changes : { &in_update.evictions, &in_update.loads })
+	{
+		for (const TextureStreamingChange& change : *changes)
+		{
+			io_policy.OnChangeComplete(change.texture);
+		}
+	}
+}
+
+// One mip level finer per doubling of screen size, sharper with a negative bias, clamped to the chain
+void TestEstimateRequestedMip()
+{
+	TEST_CHECK(estimate_requested_mip(1024, 1024.0f, 0.0f, 11) == 0);
+	TEST_CHECK(estimate_requested_mip(1024, 4096.0f, 0.0f, 11) == 0);
+	TEST_CHECK(estimate_requested_mip(1024, 512.0f, 0.0f, 11) == 1);
+	TEST_CHECK(estimate_requested_mip(1024, 300.0f, 0.0f, 11) == 1);
+	TEST_CHECK(estimate_requested_mip(1024, 100.0f, 0.0f, 11) == 3);
+	TEST_CHECK(estimate_requested_mip(1024, 100.0f, -1.0f, 11) == 2);
+	TEST_CHECK(estimate_requested_mip(1024, 0.5f, 0.0f, 11) == 10);
+	TEST_CHECK(estimate_requested_mip(1024, 0.0f, 0.0f, 11) == 10);
+}
+
+// A texture that's requested at a given screen size streams in one mip per update until it reaches that mip, and goes no further
+void TestStreamsToRequestedMip()
+{
+	TextureStreamingPolicy policy;
+	const vector<uint64_t> mip_sizes = GetMipSizes(1024);
+	const uint32_t texture = policy.AddTexture(mip_sizes, 6);
+	TEST_CHECK(policy.GetResidentMip(texture) == 6);
+	TEST_CHECK(policy.GetUsedSize() == 0);
+
+	const uint32_t requested_mip = estimate_requested_mip(1024, 300.0f, 0.0f, (uint32_t) mip_sizes.size());
+	for (uint64_t frame = 1; frame <= 10; ++frame)
+	{
+		policy.RequestMip(texture, requested_mip);
+		const TextureStreamingUpdate update = policy.Update(frame);
+		TEST_CHECK(update.evictions.empty());
+
+		const uint32_t resident_mip = policy.GetResidentMip(texture);
+		if (resident_mip > requested_mip)
+		{
+			TEST_CHECK(update.loads.size() == 1 && update.loads[0].texture == texture && update.loads[0].first_mip == resident_mip - 1);
+			TEST_CHECK(policy.IsInFlight(texture));
+
+			// Nothing more while the load is in flight
+			policy.RequestMip(texture, requested_mip);
+			TEST_CHECK(policy.Update(frame).loads.empty());
+		}
+		else
+		{
+			TEST_CHECK(update.loads.empty());
+		}
+		CompleteChanges(policy, update);
+	}
+
+	TEST_CHECK(policy.GetResidentMip(texture) == requested_mip);
+	uint64_t expected_size = 0;
+	for (uint32_t mip_idx = requested_mip; mip_idx < 6; ++mip_idx)
+	{
+		expected_size += mip_sizes[mip_idx];
+	}
+	TEST_CHECK(policy.GetUsedSize() == expected_size);
+}
+
+// Most starved first, and no more loads per update than max_loads_per_update
+void TestLoadOrder()
+{
+	TextureStreamingPolicy policy(TextureStreamingDesc { .max_loads_per_update = 2 });
+	const vector<uint64_t> mip_sizes = GetMipSizes(256);
+	const uint32_t near_texture = policy.AddTexture(mip_sizes, 4);
+	const uint32_t far_texture = policy.AddTexture(mip_sizes, 4);
+	const uint32_t nearest_texture = policy.AddTexture(mip_sizes, 4);
+
+	policy.RequestMip(near_texture, 1);
+	policy.RequestMip(far_texture, 3);
+	policy.RequestMip(nearest_texture, 0);
+	const TextureStreamingUpdate update = policy.Update(1);
+	TEST_CHECK(update.loads.size() == 2);
+	TEST_CHECK(update.loads[0].texture == nearest_texture && update.loads[1].texture == near_texture);
+}
+
+/*	Three textures whose two streamed mips take 500 bytes each, with room for two of them. Textures that stop being requested keep their mips
+	until something else needs the space, then the one unused for longest goes first, back down to its tail
+*/
+void TestLeastRecentlyUsedEviction()
+{
+	const uint64_t mip_sizes[] = { 400, 100, 25, 6 };
+	TextureStreamingPolicy policy(TextureStreamingDesc { .budget = 1000 });
+	const uint32_t a = policy.AddTexture(mip_sizes, 2);
+	const uint32_t b = policy.AddTexture(mip_sizes, 2);
+	const uint32_t c = policy.AddTexture(mip_sizes, 2);
+	TEST_CHECK(policy.GetTailSize() == 3 * 31);
+
+	uint64_t frame = 0;
+	const auto run_frames = [&](const vector<uint32_t>& in_requested_textures, const uint32_t in_frame_count)
+	{
+		vector<TextureStreamingChange> evictions;
+		for (uint32_t frame_idx = 0; frame_idx < in_frame_count; ++frame_idx)
+		{
+			for (const uint32_t texture : in_requested_textures)
+			{
+				policy.RequestMip(texture, 0);
+			}
+			const TextureStreamingUpdate update = policy.Update(++frame);
+			TEST_CHECK(policy.GetUsedSize() <= policy.GetBudget());
+			evictions.insert(evictions.end(), update.evictions.begin(), update.evictions.end());
+			CompleteChanges(policy, update);
+		}
+		return evictions;
+	};
+
+	// a is last used before b
+	TEST_CHECK(run_frames({ a }, 3).empty());
+	TEST_CHECK(run_frames({ b }, 3).empty());
+	TEST_CHECK(policy.GetResidentMip(a) == 0 && policy.GetResidentMip(b) == 0);
+	TEST_CHECK(policy.GetUsedSize() == 1000);
+
+	// Neither is requested now, but they stay resident while nothing needs the space
+	TEST_CHECK(run_frames({}, 3).empty());
+	TEST_CHECK(policy.GetUsedSize() == 1000);
+
+	vector<TextureStreamingChange> evictions = run_frames({ c }, 3);
+	TEST_CHECK(evictions.size() == 1 && evictions[0].texture == a && evictions[0].first_mip == 2);
+	TEST_CHECK(policy.GetResidentMip(a) == 2 && policy.GetResidentMip(b) == 0 && policy.GetResidentMip(c) == 0);
+
+	// Textures being sampled at their requested mip aren't LRU victims: a can only take b's space
+	evictions = run_frames({ a, c }, 3);
+	TEST_CHECK(evictions.size() == 1 && evictions[0].texture == b);
+	TEST_CHECK(policy.GetResidentMip(a) == 0 && policy.GetResidentMip(b) == 2 && policy.GetResidentMip(c) == 0);
+}
+
+// Shrinking the budget below what's requested drops the largest resident mips first, even requested ones
+void TestBudgetShrink()
+{
+	TextureStreamingPolicy policy(TextureStreamingDesc { .budget = 10000 });
+	const uint64_t large_mip_sizes[] = { 1600, 400, 100, 25 };
+	const uint64_t small_mip_sizes[] = { 400, 100, 25 };
+	const uint32_t large = policy.AddTexture(large_mip_sizes, 2);
+	const uint32_t small = policy.AddTexture(small_mip_sizes, 1);
+	for (uint64_t frame = 1; frame <= 4; ++frame)
+	{
+		policy.RequestMip(large, 0);
+		policy.RequestMip(small, 0);
+		CompleteChanges(policy, policy.Update(frame));
+	}
+	TEST_CHECK(policy.GetUsedSize() == 2400);
+
+	policy.SetBudget(1000);
+	policy.RequestMip(large, 0);
+	policy.RequestMip(small, 0);
+	const TextureStreamingUpdate update = policy.Update(5);
+	TEST_CHECK(update.evictions.size() == 1 && update.evictions[0].texture == large && update.evictions[0].first_mip == 1);
+	TEST_CHECK(update.loads.empty());
+	TEST_CHECK(policy.GetUsedSize() == 800);
+}
+
+/*	Random textures seen at random screen sizes, frame after frame, with changes landing a few frames late. The used size always matches the mips
+	the policy has targeted and stays within the budget, loads go one mip finer than what's resident, and evictions only go coarser
+*/
+void TestRandomScreenSizes()
+{
+	std::mt19937 rng(8642);
+	vector<vector<uint64_t>> texture_mip_sizes;
+	uint64_t streamed_size = 0;
+	TextureStreamingPolicy policy;
+	for (uint32_t texture_idx = 0; texture_idx < 32; ++texture_idx)
+	{
+		const uint32_t size = 64u << std::uniform_int_distribution<uint32_t>(0, 5)(rng);
+		const vector<uint64_t>& mip_sizes = texture_mip_sizes.emplace_back(GetMipSizes(size));
+		const uint32_t tail_mip = (uint32_t) mip_sizes.size() - 5;
+		policy.AddTexture(mip_sizes, tail_mip);
+		for (uint32_t mip_idx = 0; mip_idx < tail_mip; ++mip_idx)
+		{
+			streamed_size += mip_sizes[mip_idx];
+		}
+	}
+	policy.SetBudget(streamed_size / 4);
+
+	vector<float> screen_sizes(texture_mip_sizes.size());
+	vector<std::pair<uint64_t, uint32_t>> in_flight;
+	size_t load_count = 0;
+	size_t eviction_count = 0;
+	for (uint64_t frame = 1; frame <= 2000; ++frame)
+	{
+		// The camera moves every so often, and the budget occasionally shrinks or grows
+		if (frame % 50 == 1)
+		{
+			for (float& screen_size : screen_sizes)
+			{
+				screen_size = std::uniform_real_distribution<float>(0.0f, 2048.0f)(rng);
+			}
+		}
+		if (frame % 500 == 0)
+		{
+			policy.SetBudget(streamed_size / std::uniform_int_distribution<uint64_t>(2, 8)(rng));
+		}
+
+		for (uint32_t texture_idx = 0; texture_idx < texture_mip_sizes.size(); ++texture_idx)
+		{
+			const uint32_t mip_count = (uint32_t) texture_mip_sizes[texture_idx].size();
+			const uint32_t texture_size = 1u << (mip_count - 1);
+			policy.RequestMip(texture_idx, estimate_requested_mip(texture_size, screen_sizes[texture_idx], 0.0f, mip_count));
+		}
+
+		vector<uint32_t> previous_resident_mips(texture_mip_sizes.size());
+		for (uint32_t texture_idx = 0; texture_idx < texture_mip_sizes.size(); ++texture_idx)
+		{
+			previous_resident_mips[texture_idx] = policy.GetResidentMip(texture_idx);
+		}
+
+		const TextureStreamingUpdate update = policy.Update(frame);
+		TEST_CHECK(update.loads.size() <= TextureStreamingDesc().max_loads_per_update);
+		load_count += update.loads.size();
+		eviction_count += update.evictions.size();
+		for (const TextureStreamingChange& load : update.loads)
+		{
+			TEST_CHECK(load.first_mip + 1 == previous_resident_mips[load.texture]);
+			in_flight.emplace_back(frame, load.texture);
+		}
+		for (const TextureStreamingChange& eviction : update.evictions)
+		{
+			TEST_CHECK(eviction.first_mip > previous_resident_mips[eviction.texture]);
+			TEST_CHECK(eviction.first_mip <= policy.GetTailMip(eviction.texture));
+			in_flight.emplace_back(frame, eviction.texture);
+		}
+
+		// Only changes already in flight can hold the used size over a budget that just shrank
+		uint64_t targeted_size = 0;
+		uint64_t in_flight_size = 0;
+		for (uint32_t texture_idx = 0; texture_idx < texture_mip_sizes.size(); ++texture_idx)
+		{
+			for (uint32_t mip_idx = policy.GetTargetMip(texture_idx); mip_idx < policy.GetTailMip(texture_idx); ++mip_idx)
+			{
+				targeted_size += texture_mip_sizes[texture_idx][mip_idx];
+				in_flight_size += policy.IsInFlight(texture_idx) ? texture_mip_sizes[texture_idx][mip_idx] : 0;
+			}
+		}
+		TEST_CHECK(policy.GetUsedSize() == targeted_size);
+		TEST_CHECK(policy.GetUsedSize() <= (std::max)(policy.GetBudget(), in_flight_size));
+
+		// Changes land 3 frames after they're issued
+		while (!in_flight.empty() && in_flight.front().first + 3 <= frame)
+		{
+			policy.OnChangeComplete(in_flight.front().second);
+			in_flight.erase(in_flight.begin());
+		}
+	}
+	TEST_CHECK(load_count > 0 && eviction_count > 0);
+}
+
+int main()
+{
+	TEST_RUN(TestEstimateRequestedMip);
+	TEST_RUN(TestStreamsToRequestedMip);
+	TEST_RUN(TestLoadOrder);
+	TEST_RUN(TestLeastRecentlyUsedEviction);
+	TEST_RUN(TestBudgetShrink);
+	TEST_RUN(TestRandomScreenSizes);
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <vector>
+
+#include "TransientResourceCache.h"
+#include "Test.h"
+
+using std::vector;
+
+// Stands in for a render graph desc
+struct TestDesc
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	bool operator==(const TestDesc& in_other) const { return width == in_other.width && height == in_other.height; }
+	uint64_t Hash() const { return ((uint64_t) width << 32) | height; }
+
+	// As if it were an RGBA8 texture
+	uint64_t GetSize() const { return (uint64_t) width * height * 4; }
+};
+
+// Stands in for a pooled resource, numbered in creation order
+struct TestResource
+{
+	uint32_t id = 0;
+};
+
+using TestCache = TransientResourceCache<TestDesc, TestResource>;
+
+// Acquires in_desc for in_frame_index, adding a new resource on a miss like TransientResourcePool does
+TestCache::Entry* AcquireOrAdd(TestCache& in_cache, const TestDesc& in_desc, const uint64_t in_frame_index, const uint64_t in_completed_frame_index, uint32_t& io_next_id)
+{
+	if (TestCache::Entry* entry = in_cache.Acquire(in_desc.Hash(), in_desc, in_frame_index, in_completed_frame_index))
+	{
+		return entry;
+	}
+	return in_cache.Add(in_desc.Hash(), in_desc, TestResource { .id = io_next_id++ }, in_desc.GetSize(), in_frame_index);
+}
+
+// A later frame asking for an equal desc gets the same resource back once the frame that used it has completed. Different descs never match
+void TestDescReuse()
+{
+	TestCache cache(8);
+	uint32_t next_id = 0;
+	const TestDesc desc = { .width = 1920, .height = 1080 };
+	const TestDesc other_desc = { .width = 1280, .height = 720 };
+
+	TestCache::Entry* first = AcquireOrAdd(cache, desc, 1, 0, next_id);
+	TestCache::Entry* other = AcquireOrAdd(cache, other_desc, 1, 0, next_id);
+	TEST_CHECK(first->resource.id == 0 && other->resource.id == 1);
+
+	TestCache::Entry* reused = AcquireOrAdd(cache, desc, 2, 1, next_id);
+	TEST_CHECK(reused == first && reused->last_used_frame_index == 2);
+	TEST_CHECK(AcquireOrAdd(cache, other_desc, 2, 1, next_id) == other);
+
+	// Same hash, different desc: shares a bucket but doesn't match
+	TEST_CHECK(!cache.Acquire(desc.Hash(), other_desc, 3, 2));
+
+	const TransientResourceStats& stats = cache.GetStats();
+	TEST_CHECK(stats.acquire_count == 5);
+	TEST_CHECK(stats.hit_count == 2);
+	TEST_CHECK(stats.allocation_count == 2);
+	TEST_CHECK(stats.pooled_count == 2);
+	TEST_CHECK_NEAR(stats.GetHitRate(), 0.4f, 1e-6f);
+}
+
+// Entries are busy until the fence of the frame that last acquired them completes, and always busy for the frame that acquired them
+void TestInFlightGuard()
+{
+	TestCache cache(8);
+	uint32_t next_id = 0;
+	const TestDesc desc = { .width = 64, .height = 64 };
+
+	// Frame 0, with nothing signalled yet: two outputs with the same desc need two resources
+	TestCache::Entry* first = AcquireOrAdd(cache, desc, 0, 0, next_id);
+	TestCache::Entry* second = AcquireOrAdd(cache, desc, 0, 0, next_id);
+	TEST_CHECK(first != second);
+
+	// Same within any frame, even if the completed value has somehow caught up with it
+	TEST_CHECK(AcquireOrAdd(cache, desc, 1, 1, next_id) == first);
+	TEST_CHECK(AcquireOrAdd(cache, desc, 1, 1, next_id) == second);
+	TEST_CHECK(AcquireOrAdd(cache, desc, 1, 1, next_id)->resource.id == 2);
+
+	// Frame 1 is still in flight, so frame 2 can't have any of them
+	TEST_CHECK(!cache.Acquire(desc.Hash(), desc, 2, 0));
+
+	// Once frame 1 completes, all three come back
+	for (int acquire_idx = 0; acquire_idx < 3; ++acquire_idx)
+	{
+		TEST_CHECK(cache.Acquire(desc.Hash(), desc, 3, 1));
+	}
+	TEST_CHECK(!cache.Acquire(desc.Hash(), desc, 3, 1));
+	TEST_CHECK(cache.GetStats().allocation_count == 3);
+}
+
+// Entries no frame has acquired for more than max unused frames are evicted, but only once the frame that last used them has completed
+void TestEviction()
+{
+	TestCache cache(2);
+	uint32_t next_id = 0;
+	const TestDesc desc = { .width = 256, .height = 256 };
+	const TestDesc other_desc = { .width = 512, .height = 512 };
+
+	AcquireOrAdd(cache, desc, 1, 0, next_id);
+	AcquireOrAdd(cache, other_desc, 1, 0, next_id);
+
+	// Re-acquiring keeps other_desc alive
+	TEST_CHECK(AcquireOrAdd(cache, other_desc, 2, 1, next_id)->resource.id == 1);
+	TEST_CHECK(cache.Evict(3, 2) == 0);
+
+	vector<uint32_t> evicted_ids;
+	TEST_CHECK(cache.Evict(4, 2, [&](TestCache::Entry& in_entry) { evicted_ids.push_back(in_entry.resource.id); }) == 1);
+	TEST_CHECK((evicted_ids == vector<uint32_t> { 0 }));
+	TEST_CHECK(!cache.Acquire(desc.Hash(), desc, 4, 3));
+
+	// Unused for long enough, but its frame hasn't completed
+	TEST_CHECK(cache.Evict(10, 1) == 0);
+	TEST_CHECK(cache.Evict(10, 2) == 1);
+
+	const TransientResourceStats& stats = cache.GetStats();
+	TEST_CHECK(stats.eviction_count == 2);
+	TEST_CHECK(stats.pooled_count == 0);
+
+	// A new resource is created for the evicted desc
+	TEST_CHECK(AcquireOrAdd(cache, desc, 11, 10, next_id)->resource.id == 2);
+}
+
+// Hits count the bytes they saved allocating, and pooled bytes follow adds and evictions, keeping their peak
+void TestByteStats()
+{
+	TestCache cache(1);
+	uint32_t next_id = 0;
+	const TestDesc desc = { .width = 16, .height = 16 };
+	const TestDesc other_desc = { .width = 32, .height = 8 };
+	const TestDesc large_desc = { .width = 64, .height = 64 };
+
+	AcquireOrAdd(cache, desc, 1, 0, next_id);
+	AcquireOrAdd(cache, other_desc, 1, 0, next_id);
+	AcquireOrAdd(cache, desc, 2, 1, next_id);
+	AcquireOrAdd(cache, desc, 3, 2, next_id);
+	AcquireOrAdd(cache, other_desc, 3, 2, next_id);
+
+	const TransientResourceStats& stats = cache.GetStats();
+	TEST_CHECK(stats.GetMissCount() == 2 && stats.hit_count == 3);
+	TEST_CHECK(stats.allocated_bytes == desc.GetSize() + other_desc.GetSize());
+	TEST_CHECK(stats.hit_bytes == 2 * desc.GetSize() + other_desc.GetSize());
+	TEST_CHECK(stats.GetAcquiredBytes() == 3 * desc.GetSize() + 2 * other_desc.GetSize());
+	TEST_CHECK(stats.pooled_bytes == desc.GetSize() + other_desc.GetSize());
+
+	// Both are evicted once unused, the large one only peaks while they were still pooled
+	AcquireOrAdd(cache, large_desc, 4, 3, next_id);
+	const uint64_t peak_pooled_bytes = desc.GetSize() + other_desc.GetSize() + large_desc.GetSize();
+	TEST_CHECK(stats.pooled_bytes == peak_pooled_bytes && stats.peak_pooled_bytes == peak_pooled_bytes);
+
+	TEST_CHECK(cache.Evict(5, 4) == 2);
+	TEST_CHECK(stats.pooled_bytes == large_desc.GetSize() && stats.peak_pooled_bytes == peak_pooled_bytes);
+	TEST_CHECK(cache.Evict(6, 5) == 1);
+	TEST_CHECK(stats.pooled_bytes == 0 && stats.pooled_count == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestDescReuse);
+	TEST_RUN(TestInFlightGuard);
+	TEST_RUN(TestEviction);
+	TEST_RUN(TestByteStats);
+	return 0;
+}
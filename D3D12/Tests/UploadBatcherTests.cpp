@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "StagingRing.h"
+#include "UploadBatcher.h"
+#include "Test.h"
+
+using std::vector;
+
+// Tickets name the fence value of the batch their copies are recorded into, and only become waitable once that batch is submitted
+void TestTicketOrdering()
+{
+	UploadBatcher batcher(2, 100);
+	TEST_CHECK(!batcher.GetPendingTicket().IsValid());
+
+	const UploadTicket first = batcher.Record(10);
+	const UploadTicket second = batcher.Record(20);
+	TEST_CHECK(first.fence_value == 1 && second.fence_value == 1);
+	TEST_CHECK(batcher.GetPendingTicket().fence_value == 1);
+	TEST_CHECK(!batcher.IsSubmitted(first));
+
+	const UploadBatcher::Submission submission = batcher.Submit();
+	TEST_CHECK(submission.batch_index == 0 && submission.fence_value == 1);
+	TEST_CHECK(batcher.IsSubmitted(first));
+
+	// An empty open batch adds nothing to wait for
+	TEST_CHECK(batcher.GetPendingTicket().fence_value == 1);
+
+	const UploadTicket third = batcher.Record(100);
+	TEST_CHECK(third.fence_value == 2);
+	TEST_CHECK(batcher.IsOpenBatchFull());
+	TEST_CHECK(!batcher.IsSubmitted(third));
+	TEST_CHECK(batcher.GetPendingTicket().fence_value == 2);
+
+	batcher.Submit();
+	TEST_CHECK(batcher.IsSubmitted(third));
+	TEST_CHECK(batcher.GetLastSubmittedFenceValue() == 2);
+}
+
+// Batches are reused round robin, each only once the fence of its previous submission has completed
+void TestBatchReuseFences()
+{
+	UploadBatcher batcher(3, 100);
+	for (size_t batch_idx = 0; batch_idx < 3; ++batch_idx)
+	{
+		TEST_CHECK(batcher.GetOpenBatchIndex() == batch_idx);
+		TEST_CHECK(batcher.GetOpenBatchReuseFenceValue() == 0);
+		batcher.Record(1);
+		batcher.Submit();
+	}
+
+	for (uint64_t fence_value = 1; fence_value <= 6; ++fence_value)
+	{
+		TEST_CHECK(batcher.GetOpenBatchIndex() == (fence_value - 1) % 3);
+		TEST_CHECK(batcher.GetOpenBatchReuseFenceValue() == fence_value);
+		TEST_CHECK(batcher.Submit().fence_value == fence_value + 3);
+	}
+}
+
+/*	UploadManager's staging and batching without the device: a blocking StagingRing, an UploadBatcher, and a copy queue that only makes progress
+	when something waits on it. Checks the manager's invariants as it goes: batches are only recorded into once their previous submission has
+	completed, and only submitted fence values are waited on
+*/
+struct MockUploadManager
+{
+	MockUploadManager(const size_t in_batch_count, const size_t in_batch_size, const uint64_t in_ring_capacity)
+		: batcher(in_batch_count, in_batch_size)
+		, ring(in_ring_capacity, UploadRingFullBehavior::Block)
+	{
+	}
+
+	// Same loop as UploadManager::Upload
+	UploadTicket Upload(const size_t in_size, const size_t in_alignment)
+	{
+		UploadTicket ticket = batcher.GetPendingTicket();
+		size_t uploaded_size = 0;
+		while (uploaded_size < in_size)
+		{
+			if (batcher.IsOpenBatchFull())
+			{
+				SubmitBatch();
+			}
+
+			const size_t copy_size = (std::min)(in_size - uploaded_size, batcher.GetOpenBatchSpace());
+			const StagingRing<int>::Allocation staging = allocate_or_submit(copy_size, in_alignment,
+				[this](const size_t in_allocation_size, const size_t in_allocation_alignment)
+				{
+					++allocate_count;
+					return ring.Allocate(in_allocation_size, in_allocation_alignment, completed_fence_value,
+						[this](const uint64_t in_fence_value) { WaitForFence(in_fence_value); },
+						[](const uint64_t) { TEST_CHECK(false); return 0; });
+				},
+				[this]() { ++fallback_submit_count; SubmitBatch(); }
+			);
+			TEST_CHECK(staging.ring_allocation.offset % in_alignment == 0);
+
+			TEST_CHECK(completed_fence_value >= batcher.GetOpenBatchReuseFenceValue());
+			ticket = batcher.Record(copy_size);
+			uploaded_size += copy_size;
+		}
+		return ticket;
+	}
+
+	void SubmitBatch()
+	{
+		const UploadBatcher::Submission submission = batcher.Submit();
+		ring.Submit(submission.fence_value);
+		submitted_fence_values.push_back(submission.fence_value);
+
+		// BeginBatch
+		WaitForFence(batcher.GetOpenBatchReuseFenceValue());
+	}
+
+	void WaitForFence(const uint64_t in_fence_value)
+	{
+		TEST_CHECK(in_fence_value <= batcher.GetLastSubmittedFenceValue());
+		completed_fence_value = (std::max)(completed_fence_value, in_fence_value);
+	}
+
+	UploadBatcher batcher;
+	StagingRing<int> ring;
+	uint64_t completed_fence_value = 0;
+	vector<uint64_t> submitted_fence_values;
+	size_t allocate_count = 0;
+	size_t fallback_submit_count = 0;
+};
+
+// A ring too small for the open batch's copies fails to allocate, the batch is submitted, and the retry waits for it
+void TestAllocateSubmitRetry()
+{
+	MockUploadManager manager(2, 100, 100);
+	TEST_CHECK(manager.Upload(60, 1).fence_value == 1);
+	TEST_CHECK(manager.fallback_submit_count == 0);
+
+	// 60 bytes unsubmitted, so 40 more only fit once the first batch is submitted and waited on
+	const UploadTicket ticket = manager.Upload(40, 16);
+	TEST_CHECK(manager.fallback_submit_count == 1);
+	TEST_CHECK(manager.allocate_count == 3);
+	TEST_CHECK((manager.submitted_fence_values == vector<uint64_t> { 1 }));
+	TEST_CHECK(manager.completed_fence_value == 1);
+
+	// The copies went into the next batch
+	TEST_CHECK(ticket.fence_value == 2);
+	TEST_CHECK(manager.batcher.GetOpenBatchIndex() == 1);
+	TEST_CHECK(manager.batcher.GetOpenBatchSize() == 40);
+}
+
+/*	UploadManager's sizing, a ring of UPLOAD_MANAGER_BATCH_COUNT batches, with random uploads split across batches and texture alignments:
+	every allocation succeeds and tickets never go backwards
+*/
+void TestRandomizedUploads()
+{
+	const size_t batch_count = 4;
+	const size_t batch_size = 4096;
+	MockUploadManager manager(batch_count, batch_size, batch_count * batch_size);
+
+	std::mt19937 rng(31415);
+	UploadTicket last_ticket;
+	for (int upload_idx = 0; upload_idx < 5000; ++upload_idx)
+	{
+		const size_t size = 1 + rng() % (3 * batch_size);
+		const size_t alignment = rng() % 4 == 0 ? 512 : 1;
+		const UploadTicket ticket = manager.Upload(size, alignment);
+		TEST_CHECK(ticket.fence_value >= last_ticket.fence_value);
+		TEST_CHECK(ticket.fence_value == manager.batcher.GetPendingTicket().fence_value);
+		last_ticket = ticket;
+
+		if (rng() % 16 == 0 && !manager.batcher.IsOpenBatchEmpty())
+		{
+			manager.SubmitBatch();
+			TEST_CHECK(manager.batcher.IsSubmitted(ticket));
+		}
+	}
+
+	for (size_t submission_idx = 0; submission_idx < manager.submitted_fence_values.size(); ++submission_idx)
+	{
+		TEST_CHECK(manager.submitted_fence_values[submission_idx] == submission_idx + 1);
+	}
+}
+
+int main()
+{
+	TEST_RUN(TestTicketOrdering);
+	TEST_RUN(TestBatchReuseFences);
+	TEST_RUN(TestAllocateSubmitRetry);
+	TEST_RUN(TestRandomizedUploads);
+	return 0;
+}
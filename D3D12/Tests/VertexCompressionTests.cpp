@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+
+#include "../Shaders/HLSL_Types.h"
+#include "Test.h"
+
+// Round trips through half precision exactly where a half can represent the value, and otherwise within half an ulp (2^-11 relative)
+void TestHalfRoundTrip()
+{
+	for (const float exact_value : { 0.0f, 1.0f, -1.0f, 0.5f, 2.0f, 1024.0f, 65504.0f, -65504.0f, 0.000061035156f })
+	{
+		TEST_CHECK(half_to_float(float_to_half(exact_value)) == exact_value);
+	}
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> distribution(-60000.0f, 60000.0f);
+	for (int i = 0; i < 100000; ++i)
+	{
+		const float value = distribution(rng);
+		const float round_tripped = half_to_float(float_to_half(value));
+		TEST_CHECK(std::abs(round_tripped - value) <= std::abs(value) * std::ldexp(1.0f, -11));
+	}
+
+	// Texcoords mostly live in [0, 1], where a half is accurate to 2^-12 or better
+	std::uniform_real_distribution<float> texcoord_distribution(0.0f, 1.0f);
+	for (int i = 0; i < 100000; ++i)
+	{
+		const float value = texcoord_distribution(rng);
+		TEST_CHECK_NEAR(half_to_float(float_to_half(value)), value, std::ldexp(1.0f, -12));
+	}
+}
+
+void TestHalfSpecialValues()
+{
+	// Too large for a half becomes Inf, too small flushes to (signed) zero
+	TEST_CHECK(half_to_float(float_to_half(70000.0f)) == std::numeric_limits<float>::infinity());
+	TEST_CHECK(half_to_float(float_to_half(-70000.0f)) == -std::numeric_limits<float>::infinity());
+	TEST_CHECK(half_to_float(float_to_half(std::numeric_limits<float>::infinity())) == std::numeric_limits<float>::infinity());
+	TEST_CHECK(std::isnan(half_to_float(float_to_half(std::numeric_limits<float>::quiet_NaN()))));
+	TEST_CHECK(float_to_half(1e-10f) == 0);
+	TEST_CHECK(float_to_half(-1e-10f) == 0x8000);
+
+	// Half denormals survive, with an absolute error of at most half the smallest denormal
+	const float smallest_denormal = std::ldexp(1.0f, -24);
+	TEST_CHECK(half_to_float(float_to_half(smallest_denormal)) == smallest_denormal);
+	TEST_CHECK_NEAR(half_to_float(float_to_half(3.3e-6f)), 3.3e-6f, smallest_denormal * 0.5f);
+}
+
+// Positions are unorm16 across the mesh's extent, so each axis is within half a quantization step
+void TestPositionErrorBound()
+{
+	const float3 position_min(-10.0f, 2.0f, 100.0f);
+	const float3 position_extent(20.0f, 0.5f, 3000.0f);
+
+	std::mt19937 rng(5678);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	for (int i = 0; i < 100000; ++i)
+	{
+		const float3 position = position_min + float3(distribution(rng), distribution(rng), distribution(rng)) * position_extent;
+		const float3 decoded = DecodeCompactVertexPosition(EncodeCompactVertexPosition(position, position_min, position_extent), position_min, position_extent);
+
+		// Plus a little slack for float rounding in the decode
+		TEST_CHECK_NEAR(decoded.x, position.x, position_extent.x / 65535.0f * 0.5f + 1e-5f);
+		TEST_CHECK_NEAR(decoded.y, position.y, position_extent.y / 65535.0f * 0.5f + 1e-5f);
+		TEST_CHECK_NEAR(decoded.z, position.z, position_extent.z / 65535.0f * 0.5f + 1e-4f);
+	}
+
+	// The AABB's corners are exact
+	const float3 position_max = position_min + position_extent;
+	const float3 decoded_min = DecodeCompactVertexPosition(EncodeCompactVertexPosition(position_min, position_min, position_extent), position_min, position_extent);
+	const float3 decoded_max = DecodeCompactVertexPosition(EncodeCompactVertexPosition(position_max, position_min, position_extent), position_min, position_extent);
+	TEST_CHECK(decoded_min == position_min);
+	TEST_CHECK_NEAR(decoded_max.x, position_max.x, 1e-5f);
+	TEST_CHECK_NEAR(decoded_max.y, position_max.y, 1e-5f);
+	TEST_CHECK_NEAR(decoded_max.z, position_max.z, 1e-4f);
+}
+
+// Flat meshes have a zero extent axis, which must decode to the AABB's min rather than dividing by zero
+void TestPositionZeroExtent()
+{
+	const float3 position_min(1.0f, 2.0f, 3.0f);
+	const float3 position_extent(4.0f, 0.0f, 0.0f);
+	const float3 position(3.0f, 2.0f, 3.0f);
+
+	const CompactVertexPosition compact_position = EncodeCompactVertexPosition(position, position_min, position_extent);
+	TEST_CHECK((compact_position.position_xy >> 16) == 0);
+	TEST_CHECK(compact_position.position_z == 0);
+
+	const float3 decoded = DecodeCompactVertexPosition(compact_position, position_min, position_extent);
+	TEST_CHECK(std::isfinite(decoded.x) && std::isfinite(decoded.y) && std::isfinite(decoded.z));
+	TEST_CHECK(decoded.y == position_min.y);
+	TEST_CHECK(decoded.z == position_min.z);
+	TEST_CHECK_NEAR(decoded.x, position.x, position_extent.x / 65535.0f);
+}
+
+float3 RandomUnitVector(std::mt19937& in_rng)
+{
+	std::normal_distribution<float> distribution;
+	float3 result;
+	do
+	{
+		result = float3(distribution(in_rng), distribution(in_rng), distribution(in_rng));
+	} while (result.LengthSquared() < 1e-6f);
+	result.Normalize();
+	return result;
+}
+
+// In doubles, as acos of a float dot product can't resolve angles this small
+double AngleBetween(const float3& in_a, const float3& in_b)
+{
+	const double cross_x = (double) in_a.y * in_b.z - (double) in_a.z * in_b.y;
+	const double cross_y = (double) in_a.z * in_b.x - (double) in_a.x * in_b.z;
+	const double cross_z = (double) in_a.x * in_b.y - (double) in_a.y * in_b.x;
+	const double dot = (double) in_a.x * in_b.x + (double) in_a.y * in_b.y + (double) in_a.z * in_b.z;
+	return std::atan2(std::sqrt(cross_x * cross_x + cross_y * cross_y + cross_z * cross_z), dot);
+}
+
+// Octahedral snorm16 normals land within a small angle of the original, across both hemispheres and the octahedron's folds
+void TestNormalErrorBound()
+{
+	// Worst case for 2x16 bit octahedral encoding is around 6e-5 radians (0.004 degrees)
+	const float max_angle_radians = 0.0001f;
+
+	auto check_normal = [&](const float3& in_normal)
+	{
+		const VertexAttributes attributes = {
+			.normal = in_normal,
+			.color = float3(0.0f, 0.0f, 0.0f),
+			.texcoord = float2(0.0f, 0.0f),
+		};
+		const float3 decoded = DecodeCompactVertexAttributes(EncodeCompactVertexAttributes(attributes)).normal;
+		TEST_CHECK_NEAR(decoded.Length(), 1.0f, 1e-5f);
+		TEST_CHECK(AngleBetween(decoded, in_normal) <= max_angle_radians);
+	};
+
+	// Axes and the octahedron's edges, where the folding in oct_encode kicks in
+	for (const float3& axis_normal : {
+		float3(1.0f, 0.0f, 0.0f), float3(-1.0f, 0.0f, 0.0f),
+		float3(0.0f, 1.0f, 0.0f), float3(0.0f, -1.0f, 0.0f),
+		float3(0.0f, 0.0f, 1.0f), float3(0.0f, 0.0f, -1.0f),
+	})
+	{
+		check_normal(axis_normal);
+	}
+
+	std::mt19937 rng(91011);
+	for (int i = 0; i < 100000; ++i)
+	{
+		check_normal(RandomUnitVector(rng));
+	}
+}
+
+// Colors are unorm8 (within half a step), texcoords are halves
+void TestColorAndTexcoordErrorBound()
+{
+	std::mt19937 rng(121314);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::uniform_real_distribution<float> texcoord_distribution(-4.0f, 4.0f);
+	for (int i = 0; i < 100000; ++i)
+	{
+		const VertexAttributes attributes = {
+			.normal = float3(0.0f, 0.0f, 1.0f),
+			.color = float3(distribution(rng), distribution(rng), distribution(rng)),
+			.texcoord = float2(texcoord_distribution(rng), texcoord_distribution(rng)),
+		};
+		const VertexAttributes decoded = DecodeCompactVertexAttributes(EncodeCompactVertexAttributes(attributes));
+
+		const float color_tolerance = 0.5f / 255.0f + 1e-6f;
+		TEST_CHECK_NEAR(decoded.color.x, attributes.color.x, color_tolerance);
+		TEST_CHECK_NEAR(decoded.color.y, attributes.color.y, color_tolerance);
+		TEST_CHECK_NEAR(decoded.color.z, attributes.color.z, color_tolerance);
+
+		TEST_CHECK(decoded.texcoord.x == half_to_float(float_to_half(attributes.texcoord.x)));
+		TEST_CHECK(decoded.texcoord.y == half_to_float(float_to_half(attributes.texcoord.y)));
+		TEST_CHECK_NEAR(decoded.texcoord.x, attributes.texcoord.x, std::abs(attributes.texcoord.x) * std::ldexp(1.0f, -11));
+		TEST_CHECK_NEAR(decoded.texcoord.y, attributes.texcoord.y, std::abs(attributes.texcoord.y) * std::ldexp(1.0f, -11));
+	}
+
+	// Out of range colors clamp rather than wrapping around
+	const VertexAttributes out_of_range = {
+		.normal = float3(0.0f, 0.0f, 1.0f),
+		.color = float3(-0.5f, 1.5f, 1.0f),
+		.texcoord = float2(0.0f, 0.0f),
+	};
+	const CompactVertexAttributes compact_attributes = EncodeCompactVertexAttributes(out_of_range);
+	TEST_CHECK(compact_attributes.color == 0xFFFFFF00);
+}
+
+int main()
+{
+	TEST_RUN(TestHalfRoundTrip);
+	TEST_RUN(TestHalfSpecialValues);
+	TEST_RUN(TestPositionErrorBound);
+	TEST_RUN(TestPositionZeroExtent);
+	TEST_RUN(TestNormalErrorBound);
+	TEST_RUN(TestColorAndTexcoordErrorBound);
+	return 0;
+}
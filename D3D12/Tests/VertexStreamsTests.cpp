@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "VertexStreams.h"
+#include "Test.h"
+
+using std::vector;
+
+vector<Vertex> MakeRandomVertices(const size_t in_count)
+{
+	std::mt19937 rng(2468);
+	std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+
+	vector<Vertex> vertices;
+	for (size_t vertex_idx = 0; vertex_idx < in_count; ++vertex_idx)
+	{
+		Vertex vertex(
+			float3(distribution(rng), distribution(rng), distribution(rng)),
+			float3(distribution(rng), distribution(rng), distribution(rng)),
+			float3(distribution(rng), distribution(rng), distribution(rng))
+		);
+		vertex.texcoord = float2(distribution(rng), distribution(rng));
+		vertices.push_back(vertex);
+	}
+	return vertices;
+}
+
+// Each vertex's fields end up in the matching slot of their stream, in order
+void TestSplitLayout()
+{
+	const vector<Vertex> vertices = MakeRandomVertices(1000);
+	const VertexStreams streams = split_vertex_streams(vertices);
+
+	TEST_CHECK(streams.size() == vertices.size());
+	TEST_CHECK(streams.positions.size() == vertices.size());
+	TEST_CHECK(streams.attributes.size() == vertices.size());
+
+	for (size_t vertex_idx = 0; vertex_idx < vertices.size(); ++vertex_idx)
+	{
+		const Vertex& vertex = vertices[vertex_idx];
+		TEST_CHECK(streams.positions[vertex_idx] == vertex.position);
+		TEST_CHECK(streams.attributes[vertex_idx].normal == vertex.normal);
+		TEST_CHECK(streams.attributes[vertex_idx].color == vertex.color);
+		TEST_CHECK(streams.attributes[vertex_idx].texcoord == vertex.texcoord);
+	}
+}
+
+// The streams are uploaded as is, so their strides must match what the shaders load with
+void TestStreamStrides()
+{
+	const vector<Vertex> vertices = MakeRandomVertices(16);
+	const VertexStreams streams = split_vertex_streams(vertices);
+
+	const uint8_t* position_bytes = (const uint8_t*) streams.positions.data();
+	const uint8_t* attribute_bytes = (const uint8_t*) streams.attributes.data();
+	for (size_t vertex_idx = 0; vertex_idx < vertices.size(); ++vertex_idx)
+	{
+		float position[3];
+		memcpy(position, position_bytes + vertex_idx * GEOMETRY_POSITION_STRIDE, sizeof(position));
+		TEST_CHECK(position[0] == vertices[vertex_idx].position.x);
+		TEST_CHECK(position[1] == vertices[vertex_idx].position.y);
+		TEST_CHECK(position[2] == vertices[vertex_idx].position.z);
+
+		// normal, color, texcoord
+		float attributes[8];
+		memcpy(attributes, attribute_bytes + vertex_idx * GEOMETRY_ATTRIBUTE_STRIDE, sizeof(attributes));
+		TEST_CHECK(attributes[0] == vertices[vertex_idx].normal.x);
+		TEST_CHECK(attributes[3] == vertices[vertex_idx].color.x);
+		TEST_CHECK(attributes[6] == vertices[vertex_idx].texcoord.x);
+		TEST_CHECK(attributes[7] == vertices[vertex_idx].texcoord.y);
+	}
+}
+
+void TestAssembleRoundTrip()
+{
+	const vector<Vertex> vertices = MakeRandomVertices(1000);
+	const vector<Vertex> assembled = assemble_vertex_streams(split_vertex_streams(vertices));
+
+	TEST_CHECK(assembled.size() == vertices.size());
+	for (size_t vertex_idx = 0; vertex_idx < vertices.size(); ++vertex_idx)
+	{
+		TEST_CHECK(assembled[vertex_idx].position == vertices[vertex_idx].position);
+		TEST_CHECK(assembled[vertex_idx].normal == vertices[vertex_idx].normal);
+		TEST_CHECK(assembled[vertex_idx].color == vertices[vertex_idx].color);
+		TEST_CHECK(assembled[vertex_idx].texcoord == vertices[vertex_idx].texcoord);
+	}
+}
+
+void TestEmpty()
+{
+	const VertexStreams streams = split_vertex_streams({});
+	TEST_CHECK(streams.size() == 0);
+	TEST_CHECK(streams.attributes.empty());
+	TEST_CHECK(assemble_vertex_streams(streams).empty());
+}
+
+int main()
+{
+	TEST_RUN(TestSplitLayout);
+	TEST_RUN(TestStreamStrides);
+	TEST_RUN(TestAssembleRoundTrip);
+	TEST_RUN(TestEmpty);
+	return 0;
+}